@@ -60,6 +60,18 @@ rstatus_i dbuf_double(struct buf **buf); /* 2x size, slightly >2x capacity */
 /* shrink to initial size or content size, whichever is larger */
 rstatus_i dbuf_shrink(struct buf **buf);
 rstatus_i dbuf_fit(struct buf **buf, uint32_t cap); /* resize to fit cap */
+uint32_t dbuf_room(struct buf *buf); /* # bytes buf can take, growing to max */
+
+/*
+ * Shrink a connection's buffers after a write cycle, with hysteresis, as doing
+ * so after every write reallocates them back and forth under steady pipelined
+ * load. A buffer above size is shrunk right away, otherwise both are only
+ * shrunk after idle consecutive cycles that would have fit into buffers of
+ * the initial size, and shifted in between. *nidle counts those cycles across
+ * calls, and must start at 0 for a new connection.
+ */
+void dbuf_shrink_idle(struct buf **rbuf, struct buf **wbuf, uintptr_t *nidle,
+        uint32_t idle, uint32_t size);
 
 #ifdef __cplusplus
 }
@@ -158,8 +158,9 @@ int bstring_compare(const struct bstring *s1, const struct bstring *s2);
     bcmp((char *)(_s1), (char *)(_s2), (size_t)(_n))
 
 
-/* bstring to uint conversion */
+/* bstring to uint/int conversion */
 rstatus_i bstring_atou64(uint64_t *u64, struct bstring *str);
+rstatus_i bstring_atoi64(int64_t *i64, struct bstring *str);
 
 #ifdef __cplusplus
 }
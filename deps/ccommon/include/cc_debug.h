@@ -22,6 +22,7 @@ extern "C" {
 #endif
 
 #include <cc_define.h>
+#include <cc_metric.h>
 #include <cc_option.h>
 #include <cc_signal.h>
 
@@ -31,6 +32,12 @@ extern "C" {
 #define DEBUG_LOG_FILE  NULL    /* default log file */
 #define DEBUG_LOG_NBUF  0       /* default log buf size */
 
+/*
+ * With debug_log_nbuf at 0, every thread writes each message to the log file
+ * as it is logged, workers included. Servers should set it, which buffers
+ * messages per thread and has them flushed by a thread of their own.
+ */
+
 /*          name             type              default           description */
 #define DEBUG_OPTION(ACTION)                                                            \
     ACTION( debug_log_level, OPTION_TYPE_UINT, DEBUG_LOG_LEVEL,  "debug log level"     )\
@@ -41,6 +48,22 @@ typedef struct {
     DEBUG_OPTION(OPTION_DECLARE)
 } debug_options_st;
 
+/* messages dropped, e.g. when the log buffer is full, by level */
+/*          name                type            description */
+#define DEBUG_METRIC(ACTION)                                                \
+    ACTION( debug_skip_always,  METRIC_COUNTER, "# ALWAYS msgs dropped"    )\
+    ACTION( debug_skip_crit,    METRIC_COUNTER, "# CRIT msgs dropped"      )\
+    ACTION( debug_skip_error,   METRIC_COUNTER, "# ERROR msgs dropped"     )\
+    ACTION( debug_skip_warn,    METRIC_COUNTER, "# WARN msgs dropped"      )\
+    ACTION( debug_skip_info,    METRIC_COUNTER, "# INFO msgs dropped"      )\
+    ACTION( debug_skip_debug,   METRIC_COUNTER, "# DEBUG msgs dropped"     )\
+    ACTION( debug_skip_verb,    METRIC_COUNTER, "# VERB msgs dropped"      )\
+    ACTION( debug_skip_vverb,   METRIC_COUNTER, "# VVERB msgs dropped"     )
+
+typedef struct {
+    DEBUG_METRIC(METRIC_DECLARE)
+} debug_metrics_st;
+
 /**
  * the debug module override the following signal handlers:
  *
@@ -83,7 +106,7 @@ typedef struct {
 
 void debug_assert(const char *cond, const char *file, int line, int panic);
 
-rstatus_i debug_setup(debug_options_st *options);
+rstatus_i debug_setup(debug_options_st *options, debug_metrics_st *metrics);
 void debug_teardown(void);
 
 /**
@@ -222,6 +245,12 @@ void _log_hexdump(struct debug_logger *dl, int level, char *data, int datalen);
 
 void debug_log_flush(void *arg); /* compatible type: timeout_cb_fn */
 
+/**
+ * flush the debug log from a dedicated thread instead of debug_log_flush,
+ * waiting at most intvl (ms) between flushes, see log_flusher_start
+ */
+rstatus_i debug_log_flusher_start(uint64_t intvl);
+
 #ifdef __cplusplus
 }
 #endif
@@ -27,6 +27,10 @@ extern "C" {
 # define CC_HAVE_SIGNAME 1
 #endif
 
+#ifdef HAVE_EVENTFD
+# define CC_HAVE_EVENTFD 1
+#endif
+
 
 #ifdef HAVE_BIG_ENDIAN
 # define CC_BIG_ENDIAN 1
@@ -69,6 +69,14 @@ int event_add_read(struct event_base *evb, int fd, void *data);
 int event_add_write(struct event_base *evb, int fd, void *data);
 int event_del(struct event_base *evb, int fd);
 
+/**
+ * Edge-triggered read: the fd is only reported again after new data arrives,
+ * so the caller must either read until EAGAIN or keep track of the fd itself
+ * when it stops early. A backend without edge triggering may report the fd
+ * more often than that, which callers should tolerate.
+ */
+int event_add_read_edge(struct event_base *evb, int fd, void *data);
+
 /* event wait */
 int event_wait(struct event_base *evb, int timeout);
 
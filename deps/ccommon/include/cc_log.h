@@ -25,14 +25,33 @@ extern "C" {
 #include <cc_metric.h>
 #include <cc_util.h>
 
+#include <pthread.h>
 #include <stdbool.h>
 
 #define LOG_MAX_LEN 2560 /* max length of log message to STDOUT/STDERR */
 
+#define LOG_NBUF 16             /* max # ring buffers per logger */
+#define LOG_FLUSH_INTVL_MIN 1   /* min interval (ms) of the flusher thread */
+
+/*
+ * A buffered logger keeps one ring buffer per writing thread, created upon its
+ * first write, so writers never contend with each other or with the flusher.
+ * A thread's ring is handed over to the next new thread once it exits. Threads
+ * beyond LOG_NBUF - 1 alive at once share the last ring under a lock.
+ */
 struct logger {
-    char *name;                 /* log file name */
-    int  fd;                    /* log file descriptor */
-    struct rbuf *buf;           /* ring buffer for pauseless logging */
+    char            *name;          /* log file name */
+    int             fd;             /* log file descriptor */
+    uint32_t        buf_cap;        /* capacity of each ring buffer */
+    struct rbuf     *buf[LOG_NBUF]; /* ring buffers for pauseless logging */
+    pthread_mutex_t wlock;          /* guards writes to the shared ring */
+    pthread_mutex_t flock;          /* serializes flushes */
+    /* optional flusher thread */
+    pthread_t       flusher;
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    bool            flushing;       /* flusher thread running */
+    uint64_t        intvl;          /* max interval (ms) between flushes */
 };
 
 /*          name            type            description */
@@ -82,8 +101,18 @@ bool log_write(struct logger *logger, char *buf, uint32_t len);
 
 void _log_fd(int fd, const char *fmt, ...);
 
+/* flush all ring buffers of the logger, returns # bytes flushed */
 size_t log_flush(struct logger *logger);
 
+/**
+ * Start a thread flushing the logger, so no other thread has to. The interval
+ * adapts to the volume logged: it is halved (down to LOG_FLUSH_INTVL_MIN) when
+ * a flush finds rings over half full, and doubled back toward intvl (ms) when
+ * they stay nearly empty. The flusher is stopped by log_destroy.
+ */
+rstatus_i log_flusher_start(struct logger *logger, uint64_t intvl);
+void log_flusher_stop(struct logger *logger);
+
 #ifdef __cplusplus
 }
 #endif
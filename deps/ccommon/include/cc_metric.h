@@ -25,14 +25,34 @@ extern "C" {
 
 #include <inttypes.h>
 #include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Besides the value shared by all threads, counters and gauges can be counted
+ * per thread. A thread that has claimed a shard with metric_shard_claim() owns
+ * a block of METRIC_NSLOT values, one per metric, and counts into it without
+ * any bus-locked instruction. Each metric is given a slot, the same in every
+ * block, the first time a thread with a shard counts it. Threads without a
+ * shard, and metrics once all slots are given out, keep using the shared value
+ * atomically. Readers add up all of them, see metric_counter() and
+ * metric_gauge().
+ */
+#ifndef METRIC_NSHARD
+#define METRIC_NSHARD 4
+#endif
+#ifndef METRIC_NSLOT
+#define METRIC_NSLOT 4096
+#endif
+
+/* values of the calling thread by slot, NULL if it has not claimed a shard */
+extern __thread uint64_t *metric_block;
 
 #if defined CC_STATS && CC_STATS == 1
 
 #define metric_incr_n(_metric, _delta) do {                                 \
-    if ((_metric).type == METRIC_COUNTER) {                                 \
-         __atomic_add_fetch(&(_metric).counter, (_delta), __ATOMIC_RELAXED);\
-    } else if ((_metric).type == METRIC_GAUGE) {                            \
-         __atomic_add_fetch(&(_metric).gauge, (_delta), __ATOMIC_RELAXED);  \
+    if ((_metric).type == METRIC_COUNTER ||                                 \
+            (_metric).type == METRIC_GAUGE) {                               \
+         metric_add(&(_metric), (uint64_t)(_delta));                        \
     } else { /* error  */                                                   \
     }                                                                       \
 } while(0)
@@ -47,7 +67,7 @@ extern "C" {
 
 #define metric_decr_n(_metric, _delta) do {                                 \
     if ((_metric).type == METRIC_GAUGE) {                                   \
-         __atomic_sub_fetch(&(_metric).gauge, (_delta), __ATOMIC_RELAXED);  \
+         metric_add(&(_metric), -(uint64_t)(_delta));                       \
     } else { /* error  */                                                   \
     }                                                                       \
 } while(0)
@@ -64,16 +84,14 @@ extern "C" {
  * Note: there's no gcc built-in atomic primitives to do a straight-up store
  * atomically. But so far we only use the UPDATE_* macros for sys metrics, so
  * it doesn't matter much.
- * We can also use an extra variable to store the current value and use a CAS
- * primitive with the value read as well as the value to set, but the extra
- * variable is a headache.
- * Will revisit this later.
+ * Counters and gauges are set through metric_set(), which adjusts the shared
+ * value so that the sum over all shards becomes _val.
  */
 #define metric_update_val(_metric, _val) do {                               \
     if ((_metric).type == METRIC_COUNTER) {                                 \
-         (_metric).counter = (uint64_t)_val;                                \
+         metric_set(&(_metric), (uint64_t)_val);                            \
     } else if ((_metric).type == METRIC_GAUGE) {                            \
-         (_metric).gauge = (int64_t)_val;                                   \
+         metric_set(&(_metric), (uint64_t)(int64_t)_val);                   \
     } else if ((_metric).type == METRIC_FPN) {                              \
          (_metric).fpn = (double)_val;                                      \
     } else { /* error  */                                                   \
@@ -86,6 +104,19 @@ extern "C" {
     }                                                                       \
 } while(0)
 
+#define metric_record_val(_metric, _val) do {                               \
+    if ((_metric).type == METRIC_HISTOGRAM) {                               \
+         metric_record(&(_metric), (uint64_t)(_val));                       \
+    } else { /* error  */                                                   \
+    }                                                                       \
+} while(0)
+
+#define RECORD(_base, _metric, _val) do {                                   \
+    if ((_base) != NULL) {                                                  \
+         metric_record_val((_base)->_metric, _val);                         \
+    }                                                                       \
+} while(0)
+
 
 #define METRIC_DECLARE(_name, _type, _description)   \
     struct metric _name;
@@ -103,6 +134,7 @@ extern "C" {
 #define DECR(_base, _metric)
 #define DECR_N(_base, _metric, _delta)
 #define UPDATE_VAL(_base, _metric, _val)
+#define RECORD(_base, _metric, _val)
 
 #define METRIC_DECLARE(_name, _type, _description)
 #define METRIC_INIT(_name, _type, _description)
@@ -115,10 +147,30 @@ extern "C" {
 typedef enum metric_type {
     METRIC_COUNTER, /* supports INCR/INCR_N/UPDATE_VAL */
     METRIC_GAUGE,   /* supports INCR/INCR_N/DECR/DECR_N/UPDATE_VAL */
-    METRIC_FPN      /* supports UPDATE_VAL */
+    METRIC_FPN,     /* supports UPDATE_VAL */
+    METRIC_HISTOGRAM /* supports RECORD */
 } metric_type_e;
 
-extern char *metric_type_str[3];
+extern char *metric_type_str[4];
+
+/**
+ * A histogram keeps a count per bucket, HdrHistogram style: values below
+ * 2^HISTO_SUB_BITS get a bucket each, every power of two above that is cut
+ * into 2^HISTO_SUB_BITS equal buckets, so a bucket is never wider than ~3% of
+ * the values it holds. Values at or beyond 2^HISTO_MAX_BITS (~18 minutes if
+ * recorded in ns) land in the last bucket. Recording is a single relaxed
+ * atomic add, percentiles are computed when printed.
+ *
+ * The buckets are allocated on the first record, so histograms can be
+ * declared and initialized like any other metric.
+ */
+#define HISTO_SUB_BITS 5
+#define HISTO_MAX_BITS 40
+#define HISTO_NBUCKET ((HISTO_MAX_BITS - HISTO_SUB_BITS + 1) << HISTO_SUB_BITS)
+
+struct metric_histo {
+    uint64_t    bucket[HISTO_NBUCKET];
+};
 
 /* Note: anonymous union does not work with older (<gcc4.7) compilers */
 /* TODO(yao): determine if we should dynamically allocate the value field
@@ -128,15 +180,109 @@ struct metric {
     char *name;
     char *desc;
     metric_type_e type;
-    union {
+    uint32_t slot;      /* in per-thread blocks, 0 if not given one yet */
+    union {             /* shared value, counters/gauges exclude blocks */
         uint64_t    counter;
         int64_t     gauge;
         double      fpn;
+        struct metric_histo *histo;
     };
 };
 
+/*
+ * claim a shard for the calling thread, which should be done once by each
+ * long-running thread before it starts counting. Returns the shard id, or 0
+ * if all shards are taken and the thread stays on the shared value.
+ */
+unsigned int metric_shard_claim(void);
+
+/* the first count of a metric in a shard, or no shard: gives out slots */
+void _metric_add(struct metric *m, uint64_t delta);
+
+/* a few instructions, inlined even on cold paths where a call is no smaller */
+static inline __attribute__((always_inline)) void
+metric_add(struct metric *m, uint64_t delta)
+{
+    uint32_t slot = __atomic_load_n(&m->slot, __ATOMIC_RELAXED);
+    uint64_t *v;
+
+    if (metric_block == NULL || slot == 0) {
+        _metric_add(m, delta);
+        return;
+    }
+
+    /* single writer, a relaxed load/store pair keeps readers untorn */
+    v = &metric_block[slot];
+    __atomic_store_n(v, __atomic_load_n(v, __ATOMIC_RELAXED) + delta,
+            __ATOMIC_RELAXED);
+}
+
+void metric_set(struct metric *m, uint64_t val);
+/* current value of a counter/gauge, summed over the shared value and shards */
+uint64_t metric_counter(struct metric *m);
+int64_t metric_gauge(struct metric *m);
+
+static inline unsigned int
+metric_histo_bucket(uint64_t val)
+{
+    unsigned int msb;
+
+    if (val < (1ULL << HISTO_SUB_BITS)) {
+        return (unsigned int)val;
+    }
+
+    msb = 63 - __builtin_clzll(val);
+    if (msb >= HISTO_MAX_BITS) {
+        return HISTO_NBUCKET - 1;
+    }
+
+    return ((msb - HISTO_SUB_BITS + 1) << HISTO_SUB_BITS) +
+        ((val >> (msb - HISTO_SUB_BITS)) & ((1ULL << HISTO_SUB_BITS) - 1));
+}
+
+/* highest value that falls into bucket i */
+uint64_t metric_histo_value(unsigned int i);
+/* value at percentile p (0 < p <= 100), 0 if nothing has been recorded */
+uint64_t metric_histo_percentile(struct metric *m, double p);
+uint64_t metric_histo_count(struct metric *m);
+
+struct metric_histo *metric_histo_create(struct metric *m);
+
+static inline void
+metric_record(struct metric *m, uint64_t val)
+{
+    struct metric_histo *h = __atomic_load_n(&m->histo, __ATOMIC_ACQUIRE);
+
+    if (h == NULL && (h = metric_histo_create(m)) == NULL) {
+        return;
+    }
+
+    __atomic_add_fetch(&h->bucket[metric_histo_bucket(val)], 1,
+            __ATOMIC_RELAXED);
+}
+
+/* safe to call while other threads count into the same metrics */
 void metric_reset(struct metric sarr[], unsigned int nmetric);
+/* free histogram buckets, once no thread records into them any more */
+void metric_teardown(struct metric sarr[], unsigned int nmetric);
+/*
+ * print a metric with fmt, which takes the name and the value as strings.
+ * Histograms print a line for the count and one for each of the percentiles
+ * below, named with a suffix (e.g. get_lat_p99), hence metric_nline().
+ */
 size_t metric_print(char *buf, size_t nbuf, char *fmt, struct metric *m);
+unsigned int metric_nline(struct metric metrics[], unsigned int nmetric);
+/*
+ * write metrics as one compact JSON object, e.g. {"get":3,"get_lat":{"n":3,
+ * "p50":63,...}}, which is cheaper to produce and parse than metric_print.
+ * Only metrics whose name starts with prefix (of length plen) are included.
+ * If prev is not NULL it holds a value per metric from the last snapshot,
+ * only metrics that have changed since are included, and prev is updated.
+ * A snapshot that does not fit in buf is cut short, but still well-formed.
+ * Returns the # of bytes written, excluding the terminating nul.
+ */
+size_t metric_json(char *buf, size_t nbuf, struct metric metrics[],
+        unsigned int nmetric, const char *prefix, size_t plen, uint64_t prev[]);
 void metric_describe_all(struct metric metrics[], unsigned int nmetric);
 
 #ifdef __cplusplus
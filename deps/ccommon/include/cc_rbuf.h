@@ -16,7 +16,12 @@
  */
 
 /*
- * rbuf: a ring buffer designed for logging use (NOT THREADSAFE!)
+ * rbuf: a ring buffer designed for logging use
+ *
+ * Safe with one writer and one reader running concurrently: each side only
+ * moves its own offset, publishing it with release semantics after the data
+ * is copied, and loads the other side's offset with acquire semantics.
+ * Multiple writers or readers need to be serialized by the caller.
  */
 
 #pragma once
@@ -49,25 +54,25 @@ struct rbuf {
 static inline uint32_t
 get_rpos(struct rbuf *buf)
 {
-    return __atomic_load_n(&(buf->rpos), __ATOMIC_RELAXED);
+    return __atomic_load_n(&(buf->rpos), __ATOMIC_ACQUIRE);
 }
 
 static inline uint32_t
 get_wpos(struct rbuf *buf)
 {
-    return __atomic_load_n(&(buf->wpos), __ATOMIC_RELAXED);
+    return __atomic_load_n(&(buf->wpos), __ATOMIC_ACQUIRE);
 }
 
 static inline void
 set_rpos(struct rbuf *buf, uint32_t rpos)
 {
-    __atomic_store_n(&(buf->rpos), rpos, __ATOMIC_RELAXED);
+    __atomic_store_n(&(buf->rpos), rpos, __ATOMIC_RELEASE);
 }
 
 static inline void
 set_wpos(struct rbuf *buf, uint32_t wpos)
 {
-    __atomic_store_n(&(buf->wpos), wpos, __ATOMIC_RELAXED);
+    __atomic_store_n(&(buf->wpos), wpos, __ATOMIC_RELEASE);
 }
 
 /* setup/teardown */
@@ -63,6 +63,7 @@ extern "C" {
 #define CC_UINT32_MAXLEN    (10 + 1)
 #define CC_UINT64_MAXLEN    (20 + 1)
 #define CC_UINTMAX_MAXLEN   CC_UINT64_MAXLEN
+#define CC_INT64_MAXLEN     (1 + 19 + 1)
 
 /* alignment */
 /* Make data 'd' or pointer 'p', n-byte aligned, where n is a power of 2 */
@@ -0,0 +1,114 @@
+/*
+ * ccommon - a cache common library.
+ * Copyright (C) 2015 Twitter, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <cc_debug.h>
+#include <cc_metric.h>
+#include <channel/cc_channel.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <unistd.h>
+
+/**
+ * This implements a notification channel between threads, backed by eventfd
+ * where available. Instead of a byte stream, the channel carries a counter:
+ * each send adds to it, and a recv returns the sum of all sends since the
+ * previous recv and resets it to zero. So any number of notifications can be
+ * collected with a single read, and the channel never fills up the way a pipe
+ * does during a burst.
+ *
+ * On platforms without eventfd a pipe is used instead, each send writes the
+ * value as 8 bytes and a recv adds up all values pending in the pipe.
+ */
+
+/*          name                type            description */
+#define EFD_METRIC(ACTION)                                                      \
+    ACTION( efd_conn_create,    METRIC_COUNTER, "# efd connections created"    )\
+    ACTION( efd_conn_create_ex, METRIC_COUNTER, "# efd conn create exceptions" )\
+    ACTION( efd_conn_destroy,   METRIC_COUNTER, "# efd connections destroyed"  )\
+    ACTION( efd_conn_curr,      METRIC_GAUGE,   "# efd conn allocated"         )\
+    ACTION( efd_open,           METRIC_COUNTER, "# efd opened"                 )\
+    ACTION( efd_open_ex,        METRIC_COUNTER, "# efd open exceptions"        )\
+    ACTION( efd_close,          METRIC_COUNTER, "# efd closed"                 )\
+    ACTION( efd_recv,           METRIC_COUNTER, "# recv attempted"             )\
+    ACTION( efd_recv_ex,        METRIC_COUNTER, "# recv exceptions"            )\
+    ACTION( efd_send,           METRIC_COUNTER, "# send attempted"             )\
+    ACTION( efd_send_ex,        METRIC_COUNTER, "# send exceptions"            )\
+    ACTION( efd_flag_ex,        METRIC_COUNTER, "# efd flag exceptions"        )
+
+typedef struct {
+    EFD_METRIC(METRIC_DECLARE)
+} efd_metrics_st;
+
+struct efd_conn {
+    int                     fd[2];      /* read/write fds, same for eventfd */
+
+    uint64_t                recv_val;   /* sum of values received */
+    uint64_t                send_val;   /* sum of values sent */
+
+    unsigned                state:4;    /* channel state */
+
+    err_i                   err;        /* errno */
+};
+
+void efd_setup(efd_metrics_st *metrics);
+void efd_teardown(void);
+
+/* creation/destruction */
+struct efd_conn *efd_conn_create(void);
+void efd_conn_destroy(struct efd_conn **c);
+
+/* initialize an efd_conn struct for use */
+void efd_conn_reset(struct efd_conn *c);
+
+/* open/close, addr is only there to conform with channel_open_fn, use NULL */
+bool efd_open(void *addr, struct efd_conn *c);
+void efd_close(struct efd_conn *c);
+
+/*
+ * recv takes the counter, returns CC_OK with val set to the count, CC_EAGAIN
+ * if the count is zero (nonblocking mode only), or CC_ERROR.
+ * send adds val (which must be positive) to the counter, returns CC_OK,
+ * CC_EAGAIN if the counter cannot take the value now (nonblocking), or
+ * CC_ERROR.
+ */
+rstatus_i efd_recv(struct efd_conn *c, uint64_t *val);
+rstatus_i efd_send(struct efd_conn *c, uint64_t val);
+
+static inline ch_id_i efd_read_id(struct efd_conn *c)
+{
+    return c->fd[0];
+}
+
+static inline ch_id_i efd_write_id(struct efd_conn *c)
+{
+    return c->fd[1];
+}
+
+/* set efd flags */
+void efd_set_blocking(struct efd_conn *c);
+void efd_set_nonblocking(struct efd_conn *c);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,158 @@
+/*
+ * ccommon - a cache common library.
+ * Copyright (C) 2015 Twitter, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <cc_define.h>
+#include <cc_util.h>
+#include <channel/cc_channel.h>
+#include <channel/cc_eventfd.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/**
+ * This implements a channel over shared memory, for clients on the same host
+ * that cannot afford even the two system calls per request of a unix domain
+ * socket. The channel is a pair of byte rings in a shared mapping, requests
+ * flowing from client to server in one and responses back in the other. Like
+ * ring_array, each ring has exactly one producer and one consumer, and keeps
+ * one byte spare to tell full from empty, but the positions are published with
+ * release/acquire ordering since the two ends live in different processes.
+ *
+ * Each end has a doorbell, an efd_conn the other end rings to wake it up. An
+ * end about to block first raises a flag in the ring it waits on (see
+ * shm_wait_prepare), and an end only rings the doorbell if it finds that flag
+ * raised after moving data. As long as both ends are busy the doorbells are
+ * never touched, and data moves without entering the kernel.
+ *
+ * The client creates the channel and hands the shared memory and doorbells over
+ * a unix domain socket to the server, where they are picked up from the
+ * accepted connection. That connection stays open as long as the channel, so
+ * each end learns when the other one goes away, even without a clean close.
+ *
+ * The shared memory is a memfd sealed against resizing. The server insists on
+ * the seals, so channels are only available on Linux.
+ */
+
+#define SHM_CAP     (64 * KiB) /* default ring capacity in bytes, each way */
+#define SHM_CAP_MAX (64 * MiB)
+
+/* # times shm_wait checks the rings before it blocks on the doorbell */
+#define SHM_SPIN    1000
+
+/* the two ends of a channel */
+#define SHM_CLIENT  0
+#define SHM_SERVER  1
+
+struct shm_ring;
+struct shm_seg;
+
+struct shm_conn {
+    struct shm_seg          *seg;       /* the shared mapping */
+    size_t                  size;       /* size of the mapping */
+    uint32_t                cap;        /* of each ring, as validated */
+    struct shm_ring         *rx;        /* ring this end reads from */
+    struct shm_ring         *tx;        /* ring this end writes to */
+
+    struct efd_conn         bell;       /* rung by the peer to wake us up */
+    struct efd_conn         peer;       /* we ring this to wake the peer up */
+    int                     sd;         /* control socket, if owned */
+
+    size_t                  recv_nbyte; /* received (read) bytes */
+    size_t                  send_nbyte; /* sent (written) bytes */
+
+    unsigned                state:4;    /* channel state */
+    unsigned                end:1;      /* SHM_CLIENT or SHM_SERVER */
+
+    err_i                   err;        /* errno */
+};
+
+/* creation/destruction */
+struct shm_conn *shm_conn_create(void);
+void shm_conn_destroy(struct shm_conn **c);
+
+/* initialize a shm_conn struct for use */
+void shm_conn_reset(struct shm_conn *c);
+
+/*
+ * client: create a channel with rings of cap bytes and hand it to the server
+ * listening on the unix socket at path (see unix_listen), blocks until sent
+ */
+bool shm_connect(const char *path, uint32_t cap, struct shm_conn *c);
+
+/*
+ * server: pick up a channel sent over an accepted control connection sd,
+ * returns CC_OK, CC_EAGAIN if it hasn't fully arrived yet (sd nonblocking),
+ * or CC_ERROR. The control socket remains owned by the caller.
+ */
+rstatus_i shm_attach(int sd, struct shm_conn *c);
+
+/* marks the channel closed for the peer, then unmaps it */
+void shm_close(struct shm_conn *c);
+
+/*
+ * same semantics as tcp_recv/tcp_send: recv returns the number of bytes read,
+ * CC_EAGAIN if the ring is empty, or 0 once the ring is empty and the peer has
+ * closed; send returns the number of bytes written, possibly fewer than nbyte,
+ * or CC_EAGAIN if the ring is full, or CC_ERROR if the peer has closed.
+ */
+ssize_t shm_recv(struct shm_conn *c, void *buf, size_t nbyte);
+ssize_t shm_send(struct shm_conn *c, void *buf, size_t nbyte);
+
+/* # bytes that can be received/sent now without blocking */
+uint32_t shm_rsize(struct shm_conn *c);
+uint32_t shm_wsize(struct shm_conn *c);
+
+/* whether the peer has closed the channel */
+bool shm_peer_closed(struct shm_conn *c);
+
+/*
+ * Before blocking on the doorbell, an end calls shm_wait_prepare to ask to be
+ * woken up when there is data to receive, and if room is true also when room
+ * frees up to send. It returns false if that's the case already, and the end
+ * should not block. shm_wait_done withdraws the request; the doorbell itself
+ * is cleared with shm_bell_clear, once woken up by it.
+ */
+bool shm_wait_prepare(struct shm_conn *c, bool room);
+void shm_wait_done(struct shm_conn *c);
+void shm_bell_clear(struct shm_conn *c);
+
+/*
+ * client: wait until there is data to receive (or room to send, if room is
+ * true) or the peer closes, checking the rings SHM_SPIN times before blocking
+ * for up to timeout ms (-1 for no limit). Returns CC_OK if there is something
+ * to do, which includes finding out the peer closed by recv/send, CC_EAGAIN if
+ * timed out, or CC_ERROR.
+ */
+rstatus_i shm_wait(struct shm_conn *c, bool room, int timeout);
+
+/* the descriptor to watch for the doorbell */
+static inline ch_id_i shm_read_id(struct shm_conn *c)
+{
+    return efd_read_id(&c->bell);
+}
+
+#ifdef __cplusplus
+}
+#endif
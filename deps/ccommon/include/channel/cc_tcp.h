@@ -41,6 +41,10 @@ extern "C" {
 #define TCP_BACKLOG  128
 #define TCP_POOLSIZE 0 /* unlimited */
 
+/* tcp_conn flags */
+#define TCP_CONN_UNIX   0x1 /* unix domain socket, see cc_unix.h */
+#define TCP_CONN_SHM    0x2 /* control socket of a shm channel, see cc_shm.h */
+
 /*          name            type                default         description */
 #define TCP_OPTION(ACTION)                                                                \
     ACTION( tcp_backlog,    OPTION_TYPE_UINT,   TCP_BACKLOG,    "tcp conn backlog limit" )\
@@ -121,6 +125,7 @@ static inline ch_id_i tcp_write_id(struct tcp_conn *c)
 /* basic channel maintenance */
 bool tcp_connect(struct addrinfo *ai, struct tcp_conn *c);  /* channel_open_fn, client */
 bool tcp_listen(struct addrinfo *ai, struct tcp_conn *c);   /* channel_open_fn, server */
+bool tcp_listen_reuseport(struct addrinfo *ai, struct tcp_conn *c); /* channel_open_fn */
 void tcp_close(struct tcp_conn *c);                         /* channel_perm_fn */
 ssize_t tcp_recv(struct tcp_conn *c, void *buf, size_t nbyte); /* channel_recv_fn */
 ssize_t tcp_send(struct tcp_conn *c, void *buf, size_t nbyte); /* channel_send_fn */
@@ -134,12 +139,14 @@ void tcp_reject(struct tcp_conn *sc);                   /* channel_reject_fn */
 int tcp_set_blocking(int sd);
 int tcp_set_nonblocking(int sd);
 int tcp_set_reuseaddr(int sd);
+int tcp_set_reuseport(int sd);
 int tcp_set_tcpnodelay(int sd);
 int tcp_set_keepalive(int sd);
 int tcp_set_linger(int sd, int timeout);
 int tcp_unset_linger(int sd);
 int tcp_set_sndbuf(int sd, int size);
 int tcp_set_rcvbuf(int sd, int size);
+int tcp_set_busy_poll(int sd, int usec);
 int tcp_get_sndbuf(int sd);
 int tcp_get_rcvbuf(int sd);
 int tcp_get_soerror(int sd);
@@ -0,0 +1,56 @@
+/*
+ * ccommon - a cache common library.
+ * Copyright (C) 2015 Twitter, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <channel/cc_tcp.h>
+
+#include <stdbool.h>
+
+/**
+ * This implements listening on and connecting to unix domain stream sockets,
+ * for clients running on the same host, which then bypass the TCP/IP stack.
+ *
+ * The connections are regular tcp_conn, flagged with TCP_CONN_UNIX: once
+ * set up, they are accepted, read, written and closed with the tcp_* calls,
+ * so everything built on top of tcp_conn (e.g. buf_sock) works unchanged.
+ *
+ * A path starting with UNIX_ABSTRACT (on Linux) refers to the abstract socket
+ * namespace: the name following the prefix isn't backed by a file, and goes
+ * away when the last socket bound to it is closed.
+ */
+
+#define UNIX_ABSTRACT '@'
+
+/*
+ * listen on path, a stale socket file at path is removed first, but one that
+ * still has a listener fails with errno set to EADDRINUSE; the socket file is
+ * left behind on close, use unix_unlink to remove it
+ */
+bool unix_listen(const char *path, struct tcp_conn *c);
+bool unix_connect(const char *path, struct tcp_conn *c);
+
+/* remove the socket file at path, no-op for abstract names */
+void unix_unlink(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
@@ -45,6 +45,7 @@
 extern "C" {
 #endif
 
+#include <buffer/cc_buf.h>
 #include <cc_stream.h>
 
 #include <cc_define.h>
@@ -62,6 +63,9 @@ typedef struct {
     SOCKIO_OPTION(OPTION_DECLARE)
 } sockio_options_st;
 
+struct shm_conn;
+struct timeout_event;
+
 struct buf_sock {
     /* these fields are useful for resource managmenet */
     STAILQ_ENTRY(buf_sock)  next;
@@ -71,10 +75,19 @@ struct buf_sock {
     uint64_t                flag;   /* generic flag field to be used by app */
     void                    *data;  /* generic data field to be used by app */
     channel_handler_st       *hdl;   /* use can specify per-channel action */
+    struct timeout_event    *tev;   /* timeout event to be used by app */
+    uint32_t                atime;  /* last active, in a unit of app's choice */
 
     struct tcp_conn         *ch;
+    struct shm_conn         *shm;   /* shared memory channel, data goes over
+                                       it instead of ch when attached */
     struct buf              *rbuf;
     struct buf              *wbuf;
+    struct buf_sqh          rchain; /* read past a full rbuf, see
+                                       dbuf_tcp_readv */
+    uint32_t                nrchain;/* # bufs in rchain */
+    uint32_t                rspan;  /* # bytes at the end of rbuf copied
+                                       from the first buf in rchain */
 };
 
 STAILQ_HEAD(buf_sock_sqh, buf_sock); /* corresponding header type for the STAILQ */
@@ -95,6 +108,23 @@ rstatus_i buf_tcp_write(struct buf_sock *);
 
 rstatus_i dbuf_tcp_read(struct buf_sock *); /* buf_tcp_read with
                                                doubling buffer */
+/* reads at most budget bytes, CC_ERETRY if there may be more */
+rstatus_i dbuf_tcp_read_budget(struct buf_sock *, uint32_t budget);
+
+/*
+ * dbuf_tcp_readv reads like dbuf_tcp_read_budget, except that a full rbuf is
+ * not grown: what does not fit is read with readv into bufs from the pool,
+ * chained behind it. Once rbuf is parsed as far as it goes, dbuf_rnext moves
+ * on to what was read past it, and returns false when there is nothing more.
+ * A request that spans the end of rbuf is made contiguous by copying just
+ * enough of it, after which the next buf in the chain takes over as rbuf.
+ */
+rstatus_i dbuf_tcp_readv(struct buf_sock *, uint32_t budget);
+bool dbuf_rnext(struct buf_sock *);
+
+/* same as dbuf_tcp_read/buf_tcp_write, over the attached shm channel */
+rstatus_i dbuf_shm_read(struct buf_sock *);
+rstatus_i buf_shm_write(struct buf_sock *);
 
 #ifdef __cplusplus
 }
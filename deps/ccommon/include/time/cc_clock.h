@@ -0,0 +1,82 @@
+/*
+ * ccommon - a cache common library.
+ * Copyright (C) 2015 Twitter, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * clock: a process-wide cache of the wall clock.
+ *
+ * Event loops call clock_update once per iteration, everything else reads the
+ * cached value instead of making a time syscall per request or log line. The
+ * clock is read with CLOCK_REALTIME_COARSE where available, which costs little
+ * more than a memory load but only advances once per scheduler tick (1-4ms).
+ *
+ * Until clock_update is first called, all readers return 0.
+ */
+
+#define CLOCK_FMT_LEN 64
+
+/*
+ * A timestamp string, formatted by strftime with fmt in local time, that is
+ * only redone when the second changes. Each user keeps its own, e.g. one per
+ * thread, since formatting is not synchronized.
+ */
+struct clock_fmt {
+    const char  *fmt;                   /* strftime format */
+    time_t      sec;                    /* second last formatted */
+    size_t      len;                    /* 0 if never formatted */
+    char        str[CLOCK_FMT_LEN];
+};
+
+extern uint64_t clock_cached_ns;        /* unix time in ns */
+extern uint64_t clock_cached_ms;        /* unix time in ms */
+extern uint64_t clock_cached_sec;       /* unix time in seconds */
+
+void clock_update(void);
+
+static inline time_t
+clock_sec(void)
+{
+    return (time_t)__atomic_load_n(&clock_cached_sec, __ATOMIC_RELAXED);
+}
+
+static inline uint64_t
+clock_ms(void)
+{
+    return __atomic_load_n(&clock_cached_ms, __ATOMIC_RELAXED);
+}
+
+static inline uint64_t
+clock_ns(void)
+{
+    return __atomic_load_n(&clock_cached_ns, __ATOMIC_RELAXED);
+}
+
+/* copy the timestamp of sec into buf, returns its length, 0 if it won't fit */
+size_t clock_format(struct clock_fmt *cf, char *buf, size_t cap, time_t sec);
+
+#ifdef __cplusplus
+}
+#endif
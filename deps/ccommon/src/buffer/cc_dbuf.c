@@ -122,6 +122,14 @@ dbuf_fit(struct buf **buf, uint32_t cap)
     return status;
 }
 
+uint32_t
+dbuf_room(struct buf *buf)
+{
+    uint32_t used = buf_rsize(buf) + BUF_HDR_SIZE;
+
+    return used < max_size ? max_size - used : 0;
+}
+
 rstatus_i
 dbuf_shrink(struct buf **buf)
 {
@@ -146,3 +154,31 @@ dbuf_shrink(struct buf **buf)
 
     return status;
 }
+
+/* whether all data since the buffer was last shifted fits in the initial size */
+static inline bool
+_dbuf_fits_init(struct buf *buf)
+{
+    return (uint32_t)(buf->wpos - buf->begin) + BUF_HDR_SIZE <= buf_init_size;
+}
+
+void
+dbuf_shrink_idle(struct buf **rbuf, struct buf **wbuf, uintptr_t *nidle,
+        uint32_t idle, uint32_t size)
+{
+    if (_dbuf_fits_init(*rbuf) && _dbuf_fits_init(*wbuf)) {
+        (*nidle)++;
+    } else {
+        *nidle = 0;
+    }
+
+    if (*nidle >= idle || buf_size(*rbuf) > size ||
+            buf_size(*wbuf) > size) {
+        dbuf_shrink(rbuf);
+        dbuf_shrink(wbuf);
+        *nidle = 0;
+    } else {
+        buf_lshift(*rbuf);
+        buf_lshift(*wbuf);
+    }
+}
@@ -142,3 +142,42 @@ bstring_atou64(uint64_t *u64, struct bstring *str)
 
     return CC_OK;
 }
+
+rstatus_i
+bstring_atoi64(int64_t *i64, struct bstring *str)
+{
+    uint64_t u64;
+    struct bstring abs;
+
+    *i64 = 0LL;
+
+    if (str->len == 0) {
+        return CC_ERROR;
+    }
+
+    /* parse the magnitude, then check it fits into the signed range */
+    abs.len = str->len;
+    abs.data = str->data;
+    if (*str->data == '-') {
+        abs.len--;
+        abs.data++;
+    }
+
+    if (bstring_atou64(&u64, &abs) != CC_OK) {
+        return CC_ERROR;
+    }
+
+    if (abs.data == str->data) {
+        if (u64 > INT64_MAX) {
+            return CC_ERROR;
+        }
+        *i64 = (int64_t)u64;
+    } else {
+        if (u64 > (uint64_t)INT64_MAX + 1) {
+            return CC_ERROR;
+        }
+        *i64 = (int64_t)((uint64_t)0 - u64);
+    }
+
+    return CC_OK;
+}
@@ -20,6 +20,7 @@
 #include <cc_log.h>
 #include <cc_mm.h>
 #include <cc_print.h>
+#include <time/cc_clock.h>
 #include <time/cc_wheel.h>
 
 #include <ctype.h>
@@ -35,10 +36,13 @@
 
 #define BACKTRACE_DEPTH 64
 #define DEBUG_MODULE_NAME "ccommon::debug"
+#define DEBUG_TIME_FMT "%a %b %e %T %Y" /* same as asctime */
 
 struct debug_logger default_logger;
 struct debug_logger *dlog = &default_logger;
 static bool debug_init = false;
+static debug_metrics_st *debug_metrics = NULL;
+static __thread struct clock_fmt debug_time = { .fmt = DEBUG_TIME_FMT };
 static char * level_str[] = {
     "ALWAYS",
     "CRIT",
@@ -109,7 +113,17 @@ debug_log_flush(void *arg)
 }
 
 rstatus_i
-debug_setup(debug_options_st *options)
+debug_log_flusher_start(uint64_t intvl)
+{
+    if (dlog->logger == NULL) {
+        return CC_ERROR;
+    }
+
+    return log_flusher_start(dlog->logger, intvl);
+}
+
+rstatus_i
+debug_setup(debug_options_st *options, debug_metrics_st *metrics)
 {
     size_t log_nbuf = DEBUG_LOG_NBUF;
     char *filename = DEBUG_LOG_FILE;
@@ -124,6 +138,8 @@ debug_setup(debug_options_st *options)
         }
     }
 
+    debug_metrics = metrics;
+
     dlog->level = DEBUG_LOG_LEVEL;
     if (options != NULL) {
         filename = option_str(&options->debug_log_file);
@@ -168,17 +184,48 @@ debug_teardown(void)
     if (dlog->logger != NULL) {
         log_destroy(&dlog->logger);
     }
+    debug_metrics = NULL;
 
     debug_init = false;
 }
 
+static void
+_log_skip(int level)
+{
+    switch (level) {
+    case LOG_CRIT:
+        INCR(debug_metrics, debug_skip_crit);
+        break;
+    case LOG_ERROR:
+        INCR(debug_metrics, debug_skip_error);
+        break;
+    case LOG_WARN:
+        INCR(debug_metrics, debug_skip_warn);
+        break;
+    case LOG_INFO:
+        INCR(debug_metrics, debug_skip_info);
+        break;
+    case LOG_DEBUG:
+        INCR(debug_metrics, debug_skip_debug);
+        break;
+    case LOG_VERB:
+        INCR(debug_metrics, debug_skip_verb);
+        break;
+    case LOG_VVERB:
+        INCR(debug_metrics, debug_skip_vverb);
+        break;
+    default: /* LOG_ALWAYS, or -1 from loga_hexdump */
+        INCR(debug_metrics, debug_skip_always);
+        break;
+    }
+}
+
 void
 _log(struct debug_logger *dl, const char *file, int line, int level, const char *fmt, ...)
 {
     int len, size, errno_save;
-    char buf[LOG_MAX_LEN], *timestr;
+    char buf[LOG_MAX_LEN];
     va_list args;
-    struct tm *local;
     time_t t;
 
     if (dl == NULL || dl->logger == NULL || dl->level < level) {
@@ -189,12 +236,16 @@ _log(struct debug_logger *dl, const char *file, int line, int level, const char
     len = 0;            /* length of output buffer */
     size = LOG_MAX_LEN; /* size of output buffer */
 
-    t = time(NULL);
-    local = localtime(&t);
-    timestr = asctime(local);
+    /* processes that never update the clock read the time of day instead */
+    t = clock_sec();
+    if (t == 0) {
+        t = time(NULL);
+    }
 
-    len += cc_scnprintf(buf + len, size - len, "[%.*s][%s] %s:%d ",
-            strlen(timestr) - 1, timestr, level_str[level], file, line);
+    buf[len++] = '[';
+    len += clock_format(&debug_time, buf + len, size - len, t);
+    len += cc_scnprintf(buf + len, size - len, "][%s] %s:%d ",
+            level_str[level], file, line);
 
     va_start(args, fmt);
     len += cc_vscnprintf(buf + len, size - len, fmt, args);
@@ -202,7 +253,9 @@ _log(struct debug_logger *dl, const char *file, int line, int level, const char
 
     buf[len++] = '\n';
 
-    log_write(dl->logger, buf, len);
+    if (!log_write(dl->logger, buf, len)) {
+        _log_skip(level);
+    }
 
     errno = errno_save;
 }
@@ -262,7 +315,9 @@ _log_hexdump(struct debug_logger *dl, int level, char *data, int datalen)
         off += 16;
     }
 
-    log_write(dl->logger, buf, len);
+    if (!log_write(dl->logger, buf, len)) {
+        _log_skip(level);
+    }
 
     errno = errno_save;
 }
@@ -29,6 +29,7 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 #include <sys/stat.h>
 
@@ -37,6 +38,20 @@
 static log_metrics_st *log_metrics = NULL;
 static bool log_init = false;
 
+/*
+ * Threads take the first private ring index free upon their first write, and
+ * give it back when they exit, for the next thread to take over the ring.
+ */
+#define LOG_TID_SHARED (LOG_NBUF - 1)
+#define LOG_TID_ALL ((1U << LOG_TID_SHARED) - 1)
+
+static uint32_t log_tid_used = 0;       /* bitmap of private ring indices */
+static pthread_key_t log_tid_key;       /* releases the index on thread exit */
+static pthread_once_t log_tid_once = PTHREAD_ONCE_INIT;
+static bool log_tid_warned = false;
+static __thread int32_t log_tid = -1;   /* ring index of the thread */
+static __thread bool log_busy = false;  /* creating a ring, don't recurse */
+
 void
 log_setup(log_metrics_st *metrics)
 {
@@ -67,6 +82,7 @@ struct logger *
 log_create(char *filename, uint32_t buf_cap)
 {
     struct logger *logger;
+    pthread_condattr_t cattr;
 
     log_stderr("create logger with filename %s cap %u", filename, buf_cap);
 
@@ -77,18 +93,6 @@ log_create(char *filename, uint32_t buf_cap)
         return NULL;
     }
 
-    if (buf_cap > 0) {
-        logger->buf = rbuf_create(buf_cap);
-        if (logger->buf == NULL) {
-            cc_free(logger);
-            log_stderr("Could not create logger - buffer not allocated due to OOM");
-            INCR(log_metrics, log_create_ex);
-            return NULL;
-        }
-    } else {
-        logger->buf = NULL;
-    }
-
     logger->name = filename;
     if (filename != NULL) {
         logger->fd = open(filename, O_WRONLY | O_APPEND | O_CREAT, 0644);
@@ -106,6 +110,20 @@ log_create(char *filename, uint32_t buf_cap)
         logger->fd = STDERR_FILENO;
     }
 
+    /* rings are created by their writing threads, see log_write */
+    logger->buf_cap = buf_cap;
+    memset(logger->buf, 0, sizeof(logger->buf));
+    pthread_mutex_init(&logger->wlock, NULL);
+    pthread_mutex_init(&logger->flock, NULL);
+    pthread_mutex_init(&logger->lock, NULL);
+    /* the flusher waits on a clock that does not jump with the time of day */
+    pthread_condattr_init(&cattr);
+    pthread_condattr_setclock(&cattr, CLOCK_MONOTONIC);
+    pthread_cond_init(&logger->cond, &cattr);
+    pthread_condattr_destroy(&cattr);
+    logger->flushing = false;
+    logger->intvl = 0;
+
     INCR(log_metrics, log_create);
     INCR(log_metrics, log_curr);
 
@@ -116,11 +134,14 @@ void
 log_destroy(struct logger **l)
 {
     struct logger *logger = *l;
+    int i;
 
     if (logger == NULL) {
         return;
     }
 
+    log_flusher_stop(logger);
+
     /* flush first in case there's data left in the buffer */
     log_flush(logger);
 
@@ -129,7 +150,13 @@ log_destroy(struct logger **l)
         close(logger->fd);
     }
 
-    rbuf_destroy(&logger->buf);
+    for (i = 0; i < LOG_NBUF; i++) {
+        rbuf_destroy(&logger->buf[i]);
+    }
+    pthread_mutex_destroy(&logger->wlock);
+    pthread_mutex_destroy(&logger->flock);
+    pthread_mutex_destroy(&logger->lock);
+    pthread_cond_destroy(&logger->cond);
 
     cc_free(logger);
     *l = NULL;
@@ -168,19 +195,107 @@ log_reopen(struct logger *logger, char *target)
     return CC_OK;
 }
 
+/* ring of the calling thread, created upon its first write */
+static inline struct rbuf *
+_log_buf(struct logger *logger, int idx)
+{
+    struct rbuf *buf = __atomic_load_n(&logger->buf[idx], __ATOMIC_ACQUIRE);
+
+    if (buf == NULL && !log_busy) {
+        /* rbuf_create may log, which lands here again and gets skipped */
+        log_busy = true;
+        buf = rbuf_create(logger->buf_cap);
+        log_busy = false;
+        __atomic_store_n(&logger->buf[idx], buf, __ATOMIC_RELEASE);
+    }
+
+    return buf;
+}
+
+static void
+_log_tid_put(void *arg)
+{
+    uint32_t tid = (uint32_t)(uintptr_t)arg - 1;
+
+    /* release, so whoever takes the index next sees the ring as left */
+    __atomic_fetch_and(&log_tid_used, ~(1U << tid), __ATOMIC_RELEASE);
+}
+
+static void
+_log_tid_key_create(void)
+{
+    pthread_key_create(&log_tid_key, _log_tid_put);
+}
+
+/* take a free private ring index, or the shared one if all are in use */
+static int32_t
+_log_tid_get(void)
+{
+    uint32_t used = __atomic_load_n(&log_tid_used, __ATOMIC_ACQUIRE);
+    int32_t tid;
+
+    pthread_once(&log_tid_once, _log_tid_key_create);
+
+    do {
+        if (used == LOG_TID_ALL) {
+            if (!__atomic_exchange_n(&log_tid_warned, true, __ATOMIC_RELAXED)) {
+                log_stderr("over %d threads logging at once, the rest share a "
+                        "ring under a lock", LOG_TID_SHARED);
+            }
+            return LOG_TID_SHARED;
+        }
+        tid = __builtin_ctz(~used);
+    } while (!__atomic_compare_exchange_n(&log_tid_used, &used,
+                used | (1U << tid), false, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
+
+    pthread_setspecific(log_tid_key, (void *)(uintptr_t)(tid + 1));
+
+    return tid;
+}
+
+static bool
+_log_buf_write(struct logger *logger, char *buf, uint32_t len)
+{
+    struct rbuf *rbuf;
+    bool shared;
+    int idx;
+
+    if (log_tid < 0) {
+        log_tid = _log_tid_get();
+    }
+    idx = log_tid;
+    shared = idx == LOG_TID_SHARED;
+
+    if (shared) {
+        pthread_mutex_lock(&logger->wlock);
+    }
+
+    rbuf = _log_buf(logger, idx);
+    if (rbuf == NULL || rbuf_wcap(rbuf) < len) {
+        if (shared) {
+            pthread_mutex_unlock(&logger->wlock);
+        }
+        INCR(log_metrics, log_skip);
+        INCR_N(log_metrics, log_skip_byte, len);
+        return false;
+    }
+    rbuf_write(rbuf, buf, len);
+
+    if (shared) {
+        pthread_mutex_unlock(&logger->wlock);
+    }
+
+    INCR(log_metrics, log_write);
+    INCR_N(log_metrics, log_write_byte, len);
+
+    return true;
+}
+
 bool
 log_write(struct logger *logger, char *buf, uint32_t len)
 {
-    if (logger->buf != NULL) {
-        if (rbuf_wcap(logger->buf) >= len) {
-            rbuf_write(logger->buf, buf, len);
-            INCR(log_metrics, log_write);
-            INCR_N(log_metrics, log_write_byte, len);
-        } else {
-            INCR(log_metrics, log_skip);
-            INCR_N(log_metrics, log_skip_byte, len);
-            return false;
-        }
+    if (logger->buf_cap > 0) {
+        return _log_buf_write(logger, buf, len);
     } else {
         if (logger->fd < 0) {
             INCR(log_metrics, log_write_ex);
@@ -284,10 +399,13 @@ _rbuf_flush(struct rbuf *buf, int fd)
 size_t
 log_flush(struct logger *logger)
 {
+    struct rbuf *buf;
     ssize_t n;
-    size_t buf_len;
+    size_t buf_len, nbyte = 0;
+    bool error = false;
+    int i;
 
-    if (logger->buf == NULL) {
+    if (logger->buf_cap == 0) {
         return 0;
     }
 
@@ -297,14 +415,103 @@ log_flush(struct logger *logger)
         return 0;
     }
 
-    buf_len = rbuf_rcap(logger->buf);
-    n = _rbuf_flush(logger->buf, logger->fd);
+    pthread_mutex_lock(&logger->flock);
+    for (i = 0; i < LOG_NBUF; i++) {
+        buf = __atomic_load_n(&logger->buf[i], __ATOMIC_ACQUIRE);
+        if (buf == NULL) {
+            continue;
+        }
+
+        buf_len = rbuf_rcap(buf);
+        if (buf_len == 0) {
+            continue;
+        }
+        n = _rbuf_flush(buf, logger->fd);
+        if (n < (ssize_t)buf_len) {
+            error = true;
+        }
+        if (n > 0) {
+            nbyte += n;
+        }
+    }
+    pthread_mutex_unlock(&logger->flock);
 
-    if (n < (ssize_t)buf_len) {
+    if (error) {
         INCR(log_metrics, log_flush_ex);
     } else {
         INCR(log_metrics, log_flush);
     }
 
-    return n > 0 ? n : 0;
+    return nbyte;
+}
+
+static void *
+_log_flusher(void *arg)
+{
+    struct logger *logger = arg;
+    uint64_t intvl = logger->intvl;
+    struct timespec ts;
+    size_t n;
+
+    pthread_mutex_lock(&logger->lock);
+    while (logger->flushing) {
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        ts.tv_sec += intvl / 1000;
+        ts.tv_nsec += (intvl % 1000) * 1000000;
+        if (ts.tv_nsec >= 1000000000) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000;
+        }
+        pthread_cond_timedwait(&logger->cond, &logger->lock, &ts);
+        if (!logger->flushing) {
+            break;
+        }
+
+        n = log_flush(logger);
+        if (n > logger->buf_cap / 2) { /* rings filling up, flush sooner */
+            intvl = intvl / 2 > LOG_FLUSH_INTVL_MIN ? intvl / 2 :
+                LOG_FLUSH_INTVL_MIN;
+        } else if (n < logger->buf_cap / 8) { /* mostly idle, back off */
+            intvl = intvl * 2 < logger->intvl ? intvl * 2 : logger->intvl;
+        }
+    }
+    pthread_mutex_unlock(&logger->lock);
+
+    return NULL;
+}
+
+rstatus_i
+log_flusher_start(struct logger *logger, uint64_t intvl)
+{
+    int ret;
+
+    if (logger->buf_cap == 0 || logger->flushing) {
+        return CC_OK;
+    }
+
+    logger->intvl = intvl > LOG_FLUSH_INTVL_MIN ? intvl : LOG_FLUSH_INTVL_MIN;
+    logger->flushing = true;
+    ret = pthread_create(&logger->flusher, NULL, _log_flusher, logger);
+    if (ret != 0) {
+        log_stderr("Could not create log flusher thread: %s", strerror(ret));
+        logger->flushing = false;
+        return CC_ERROR;
+    }
+
+    return CC_OK;
+}
+
+void
+log_flusher_stop(struct logger *logger)
+{
+    if (!logger->flushing) {
+        return;
+    }
+
+    pthread_mutex_lock(&logger->lock);
+    logger->flushing = false;
+    pthread_cond_signal(&logger->cond);
+    pthread_mutex_unlock(&logger->lock);
+
+    pthread_join(logger->flusher, NULL);
 }
@@ -61,6 +61,44 @@ cc_print_uint64(char *buf, size_t size, uint64_t n)
     return d;
 }
 
+size_t
+cc_print_int64_unsafe(char *buf, int64_t n)
+{
+    uint64_t ab;
+
+    if (n >= 0) {
+        return cc_print_uint64_unsafe(buf, (uint64_t)n);
+    }
+
+    /* negate in unsigned space so INT64_MIN does not overflow */
+    ab = (uint64_t)0 - (uint64_t)n;
+    *buf = '-';
+
+    return 1 + cc_print_uint64_unsafe(buf + 1, ab);
+}
+
+size_t
+cc_print_int64(char *buf, size_t size, int64_t n)
+{
+    uint64_t ab;
+    size_t d;
+
+    if (n >= 0) {
+        return cc_print_uint64(buf, size, (uint64_t)n);
+    }
+
+    ab = (uint64_t)0 - (uint64_t)n;
+    d = digits(ab);
+    if (size < d + 1) {
+        return 0;
+    }
+
+    *buf = '-';
+    _print_uint64(buf + 1, d, ab);
+
+    return d + 1;
+}
+
 size_t
 _vscnprintf(char *buf, size_t size, const char *fmt, va_list args)
 {
@@ -0,0 +1,301 @@
+/*
+ * ccommon - a cache common library.
+ * Copyright (C) 2015 Twitter, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <channel/cc_eventfd.h>
+
+#include <cc_debug.h>
+#include <cc_mm.h>
+#include <channel/cc_channel.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef CC_HAVE_EVENTFD
+#include <sys/eventfd.h>
+#endif
+
+#define EFD_MODULE_NAME "ccommon::eventfd"
+
+/* # values read at once from the pipe, when eventfd is not available */
+#define EFD_NVAL 64
+
+static bool efd_init = false;
+static efd_metrics_st *efd_metrics = NULL;
+
+struct efd_conn *
+efd_conn_create(void)
+{
+    struct efd_conn *c = (struct efd_conn *)cc_alloc(sizeof(struct efd_conn));
+
+    if (c == NULL) {
+        log_info("efd connection creation failed due to OOM");
+        INCR(efd_metrics, efd_conn_create_ex);
+        return NULL;
+    }
+
+    log_verb("created efd conn %p", c);
+
+    efd_conn_reset(c);
+
+    INCR(efd_metrics, efd_conn_create);
+    INCR(efd_metrics, efd_conn_curr);
+
+    return c;
+}
+
+void
+efd_conn_destroy(struct efd_conn **c)
+{
+    if (c == NULL || *c == NULL) {
+        return;
+    }
+
+    log_verb("destroy conn %p", *c);
+
+    cc_free(*c);
+    *c = NULL;
+
+    INCR(efd_metrics, efd_conn_destroy);
+    DECR(efd_metrics, efd_conn_curr);
+}
+
+void
+efd_conn_reset(struct efd_conn *c)
+{
+    c->fd[0] = c->fd[1] = -1;
+
+    c->recv_val = 0;
+    c->send_val = 0;
+
+    c->state = CHANNEL_TERM;
+
+    c->err = 0;
+}
+
+bool
+efd_open(void *addr, struct efd_conn *c)
+{
+    ASSERT(addr == NULL);
+    ASSERT(c != NULL);
+
+#ifdef CC_HAVE_EVENTFD
+    c->fd[0] = c->fd[1] = eventfd(0, 0);
+    if (c->fd[0] < 0) {
+        log_error("eventfd() for conn %p failed: %s", c, strerror(errno));
+        goto error;
+    }
+#else
+    if (pipe(c->fd) < 0) {
+        log_error("pipe() for conn %p failed: %s", c, strerror(errno));
+        goto error;
+    }
+#endif
+
+    c->state = CHANNEL_LISTEN;
+    INCR(efd_metrics, efd_open);
+    return true;
+
+error:
+    c->err = errno;
+
+    INCR(efd_metrics, efd_open_ex);
+
+    return false;
+}
+
+void
+efd_close(struct efd_conn *c)
+{
+    if (c == NULL) {
+        return;
+    }
+
+    log_info("closing efd conn %p fd %d and %d", c, c->fd[0], c->fd[1]);
+
+    if (c->fd[0] >= 0) {
+        close(c->fd[0]);
+    }
+
+    if (c->fd[1] >= 0 && c->fd[1] != c->fd[0]) {
+        close(c->fd[1]);
+    }
+
+    c->fd[0] = c->fd[1] = -1;
+    c->state = CHANNEL_TERM;
+
+    INCR(efd_metrics, efd_close);
+}
+
+rstatus_i
+efd_recv(struct efd_conn *c, uint64_t *val)
+{
+    ssize_t n;
+#ifdef CC_HAVE_EVENTFD
+    uint64_t buf[1];
+#else
+    uint64_t buf[EFD_NVAL];
+    size_t i;
+#endif
+
+    ASSERT(c != NULL);
+    ASSERT(val != NULL);
+
+    for (;;) {
+        n = read(c->fd[0], buf, sizeof(buf));
+        INCR(efd_metrics, efd_recv);
+
+        if (n > 0) {
+            ASSERT(n % sizeof(uint64_t) == 0);
+#ifdef CC_HAVE_EVENTFD
+            *val = buf[0];
+#else
+            for (*val = 0, i = 0; i < (size_t)n / sizeof(uint64_t); i++) {
+                *val += buf[i];
+            }
+#endif
+            log_verb("value %"PRIu64" recv'd on efd fd %d", *val, c->fd[0]);
+            c->recv_val += *val;
+            return CC_OK;
+        }
+
+        if (n == 0) { /* pipe only, write end closed */
+            log_debug("eof recv'd on efd fd %d", c->fd[0]);
+            return CC_ERROR;
+        }
+
+        /* n < 0 */
+        if (errno == EINTR) {
+            log_debug("recv on efd fd %d not ready - EINTR", c->fd[0]);
+            continue;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            log_debug("recv on efd fd %d not ready - EAGAIN", c->fd[0]);
+            return CC_EAGAIN;
+        } else {
+            INCR(efd_metrics, efd_recv_ex);
+            c->err = errno;
+            log_error("recv on efd fd %d failed: %s", c->fd[0], strerror(errno));
+            return CC_ERROR;
+        }
+    }
+
+    NOT_REACHED();
+
+    return CC_ERROR;
+}
+
+rstatus_i
+efd_send(struct efd_conn *c, uint64_t val)
+{
+    ssize_t n;
+
+    ASSERT(c != NULL);
+    ASSERT(val > 0);
+
+    for (;;) {
+        n = write(c->fd[1], &val, sizeof(val));
+        INCR(efd_metrics, efd_send);
+
+        if (n == sizeof(val)) {
+            log_verb("value %"PRIu64" sent on efd fd %d", val, c->fd[1]);
+            c->send_val += val;
+            return CC_OK;
+        }
+
+        /* n < 0, a write of 8 bytes is never partial on eventfd or pipe */
+        if (errno == EINTR) {
+            log_debug("send on efd fd %d not ready - EINTR", c->fd[1]);
+            continue;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            log_debug("send on efd fd %d not ready - EAGAIN", c->fd[1]);
+            return CC_EAGAIN;
+        } else {
+            INCR(efd_metrics, efd_send_ex);
+            c->err = errno;
+            log_error("send on efd fd %d failed: %s", c->fd[1], strerror(errno));
+            return CC_ERROR;
+        }
+    }
+
+    NOT_REACHED();
+
+    return CC_ERROR;
+}
+
+static void
+_efd_set_flag(int fd, bool nonblocking)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+
+    if (flags < 0) {
+        log_error("efd set flag resulted in error");
+        INCR(efd_metrics, efd_flag_ex);
+    } else if (nonblocking) {
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    } else {
+        fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
+    }
+}
+
+void
+efd_set_blocking(struct efd_conn *c)
+{
+    ASSERT(c != NULL);
+    _efd_set_flag(efd_read_id(c), false);
+    if (efd_write_id(c) != efd_read_id(c)) {
+        _efd_set_flag(efd_write_id(c), false);
+    }
+}
+
+void
+efd_set_nonblocking(struct efd_conn *c)
+{
+    ASSERT(c != NULL);
+    _efd_set_flag(efd_read_id(c), true);
+    if (efd_write_id(c) != efd_read_id(c)) {
+        _efd_set_flag(efd_write_id(c), true);
+    }
+}
+
+void
+efd_setup(efd_metrics_st *metrics)
+{
+    log_info("set up the %s module", EFD_MODULE_NAME);
+
+    if (efd_init) {
+        log_warn("%s has already been setup, overwrite", EFD_MODULE_NAME);
+    }
+
+    efd_metrics = metrics;
+
+    efd_init = true;
+}
+
+void
+efd_teardown(void)
+{
+    log_info("tear down the %s module", EFD_MODULE_NAME);
+
+    if (!efd_init) {
+        log_warn("%s has never been setup", EFD_MODULE_NAME);
+    }
+
+    efd_metrics = NULL;
+
+    efd_init = false;
+}
@@ -0,0 +1,736 @@
+/*
+ * ccommon - a cache common library.
+ * Copyright (C) 2015 Twitter, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <channel/cc_shm.h>
+
+#include <cc_bstring.h>
+#include <cc_debug.h>
+#include <cc_mm.h>
+#include <channel/cc_tcp.h>
+#include <channel/cc_unix.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SHM_MAGIC   0x6d687363  /* "cshm" */
+#define SHM_ALIGN   64          /* cache line, ends don't share them */
+
+/* descriptors sent along with the handshake, in this order */
+#define SHM_FD_SEG      0
+#define SHM_FD_CBELL_R  1       /* client doorbell, rung by the server */
+#define SHM_FD_CBELL_W  2
+#define SHM_FD_SBELL_R  3       /* server doorbell, rung by the client */
+#define SHM_FD_SBELL_W  4
+#define SHM_NFD         5
+
+/* the request ring is written by the client, the response ring by the server */
+#define SHM_RING_REQ    0
+#define SHM_RING_RSP    1
+
+/*
+ * Positions are offsets into data, which holds cap + 1 bytes, exactly as in
+ * ring_array with single byte elements. Each position is only written by one
+ * end, along with the flag that end raises before blocking, and the two are
+ * kept on separate cache lines.
+ */
+struct shm_ring {
+    uint32_t    cap;                            /* usable # bytes */
+    uint32_t    rpos __attribute__((aligned(SHM_ALIGN)));   /* by consumer */
+    uint32_t    rwait;                          /* consumer waits for data */
+    uint32_t    wpos __attribute__((aligned(SHM_ALIGN)));   /* by producer */
+    uint32_t    wwait;                          /* producer waits for room */
+    uint8_t     data[] __attribute__((aligned(SHM_ALIGN)));
+};
+
+struct shm_seg {
+    uint32_t    magic;
+    uint32_t    cap;                            /* of each ring */
+    uint32_t    closed[2];                      /* by client, server */
+};
+
+/* sent by the client along with the descriptors */
+struct shm_hello {
+    uint32_t    magic;
+    uint32_t    size;                           /* of the mapping */
+};
+
+#define SHM_SEG_SIZE    ((sizeof(struct shm_seg) + SHM_ALIGN - 1) & \
+        ~(size_t)(SHM_ALIGN - 1))
+
+static inline size_t
+_shm_ring_size(uint32_t cap)
+{
+    return (offsetof(struct shm_ring, data) + cap + 1 + SHM_ALIGN - 1) &
+        ~(size_t)(SHM_ALIGN - 1);
+}
+
+static inline size_t
+_shm_size(uint32_t cap)
+{
+    return SHM_SEG_SIZE + 2 * _shm_ring_size(cap);
+}
+
+static inline struct shm_ring *
+_shm_ring(struct shm_seg *seg, uint32_t cap, int id)
+{
+    return (struct shm_ring *)((char *)seg + SHM_SEG_SIZE +
+            id * _shm_ring_size(cap));
+}
+
+static inline uint32_t
+_shm_nbyte(uint32_t rpos, uint32_t wpos, uint32_t cap)
+{
+    return rpos <= wpos ? wpos - rpos : wpos + (cap - rpos + 1);
+}
+
+static inline bool
+_shm_peer_closed(struct shm_conn *c)
+{
+    return c->state == CHANNEL_TERM ||
+        __atomic_load_n(&c->seg->closed[!c->end], __ATOMIC_ACQUIRE);
+}
+
+/* ring the peer if it is blocked waiting for what we just did */
+static inline void
+_shm_notify(struct shm_conn *c, uint32_t *wait)
+{
+    /* pairs with the fence in shm_wait_prepare: either the peer sees the new
+     * position before blocking, or we see its flag here
+     */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(wait, __ATOMIC_RELAXED)) {
+        efd_send(&c->peer, 1);
+    }
+}
+
+struct shm_conn *
+shm_conn_create(void)
+{
+    struct shm_conn *c = (struct shm_conn *)cc_alloc(sizeof(struct shm_conn));
+
+    if (c == NULL) {
+        log_info("shm connection creation failed due to OOM");
+        return NULL;
+    }
+
+    log_verb("created shm conn %p", c);
+
+    shm_conn_reset(c);
+
+    return c;
+}
+
+void
+shm_conn_destroy(struct shm_conn **c)
+{
+    if (c == NULL || *c == NULL) {
+        return;
+    }
+
+    log_verb("destroy shm conn %p", *c);
+
+    cc_free(*c);
+    *c = NULL;
+}
+
+void
+shm_conn_reset(struct shm_conn *c)
+{
+    c->seg = NULL;
+    c->size = 0;
+    c->cap = 0;
+    c->rx = NULL;
+    c->tx = NULL;
+
+    efd_conn_reset(&c->bell);
+    efd_conn_reset(&c->peer);
+    c->sd = -1;
+
+    c->recv_nbyte = 0;
+    c->send_nbyte = 0;
+
+    c->state = CHANNEL_TERM;
+    c->end = SHM_CLIENT;
+
+    c->err = 0;
+}
+
+static void
+_shm_map_rings(struct shm_conn *c, uint32_t cap, int end)
+{
+    c->cap = cap;
+    c->end = end;
+    if (end == SHM_CLIENT) {
+        c->rx = _shm_ring(c->seg, cap, SHM_RING_RSP);
+        c->tx = _shm_ring(c->seg, cap, SHM_RING_REQ);
+    } else {
+        c->rx = _shm_ring(c->seg, cap, SHM_RING_REQ);
+        c->tx = _shm_ring(c->seg, cap, SHM_RING_RSP);
+    }
+    c->state = CHANNEL_ESTABLISHED;
+}
+
+/*
+ * The server maps memory handed over by the client, which could shrink it
+ * afterwards and have the server fault on every access past the new end. So
+ * the segment is a memfd sealed against resizing, which the server checks.
+ */
+#if defined(MFD_ALLOW_SEALING) && defined(F_GET_SEALS)
+#define SHM_SEALS   (F_SEAL_SHRINK | F_SEAL_GROW)
+
+/* an anonymous shared memory object, only reachable through the descriptor */
+static int
+_shm_create(size_t size)
+{
+    int fd;
+
+    fd = memfd_create("cc_shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) {
+        log_error("memfd_create failed: %s", strerror(errno));
+        return -1;
+    }
+
+    if (ftruncate(fd, size) < 0 || fcntl(fd, F_ADD_SEALS, SHM_SEALS) < 0) {
+        log_error("sizing shm fd %d to %zu failed: %s", fd, size,
+                strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+static bool
+_shm_sealed(int fd)
+{
+    int seals = fcntl(fd, F_GET_SEALS);
+
+    return seals >= 0 && (seals & SHM_SEALS) == SHM_SEALS;
+}
+#else
+static int
+_shm_create(size_t size)
+{
+    log_error("shm channels need sealed memfds, not available here");
+    errno = ENOTSUP;
+
+    return -1;
+}
+
+static bool
+_shm_sealed(int fd)
+{
+    return false;
+}
+#endif
+
+static bool
+_shm_send_hello(int sd, struct shm_conn *c, int fd)
+{
+    struct shm_hello hello = {SHM_MAGIC, (uint32_t)c->size};
+    int fds[SHM_NFD];
+    union {
+        struct cmsghdr  align;
+        char            buf[CMSG_SPACE(sizeof(fds))];
+    } cmsg;
+    struct iovec iov = {&hello, sizeof(hello)};
+    struct msghdr msg;
+    struct cmsghdr *cm;
+    ssize_t n;
+
+    fds[SHM_FD_SEG] = fd;
+    fds[SHM_FD_CBELL_R] = efd_read_id(&c->bell);
+    fds[SHM_FD_CBELL_W] = efd_write_id(&c->bell);
+    fds[SHM_FD_SBELL_R] = efd_read_id(&c->peer);
+    fds[SHM_FD_SBELL_W] = efd_write_id(&c->peer);
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = cmsg.buf;
+    msg.msg_controllen = sizeof(cmsg.buf);
+    cm = CMSG_FIRSTHDR(&msg);
+    cm->cmsg_level = SOL_SOCKET;
+    cm->cmsg_type = SCM_RIGHTS;
+    cm->cmsg_len = CMSG_LEN(sizeof(fds));
+    cc_memcpy(CMSG_DATA(cm), fds, sizeof(fds));
+
+    do {
+        n = sendmsg(sd, &msg, 0);
+    } while (n < 0 && errno == EINTR);
+
+    if (n != sizeof(hello)) {
+        log_error("sending shm channel on sd %d failed: %s", sd,
+                n < 0 ? strerror(errno) : "short write");
+        return false;
+    }
+
+    return true;
+}
+
+bool
+shm_connect(const char *path, uint32_t cap, struct shm_conn *c)
+{
+    struct tcp_conn ctl;
+    int fd = -1;
+
+    ASSERT(path != NULL && c != NULL);
+
+    if (cap == 0) {
+        cap = SHM_CAP;
+    }
+    if (cap > SHM_CAP_MAX) {
+        log_error("shm ring capacity %"PRIu32" over max %"PRIu32, cap,
+                SHM_CAP_MAX);
+        return false;
+    }
+
+    c->size = _shm_size(cap);
+    fd = _shm_create(c->size);
+    if (fd < 0) {
+        goto error;
+    }
+    c->seg = mmap(NULL, c->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (c->seg == MAP_FAILED) {
+        log_error("mmap shm fd %d failed: %s", fd, strerror(errno));
+        c->seg = NULL;
+        goto error;
+    }
+    /* fresh from ftruncate, everything else is zero */
+    c->seg->magic = SHM_MAGIC;
+    c->seg->cap = cap;
+    _shm_ring(c->seg, cap, SHM_RING_REQ)->cap = cap;
+    _shm_ring(c->seg, cap, SHM_RING_RSP)->cap = cap;
+
+    if (!efd_open(NULL, &c->bell) || !efd_open(NULL, &c->peer)) {
+        goto error;
+    }
+    efd_set_nonblocking(&c->bell);
+    efd_set_nonblocking(&c->peer);
+
+    tcp_conn_reset(&ctl);
+    if (!unix_connect(path, &ctl)) {
+        goto error;
+    }
+    c->sd = ctl.sd;
+    if (tcp_set_blocking(c->sd) < 0 || !_shm_send_hello(c->sd, c, fd)) {
+        goto error;
+    }
+    close(fd);
+
+    _shm_map_rings(c, cap, SHM_CLIENT);
+    log_info("shm channel of %"PRIu32" bytes each way sent on sd %d", cap,
+            c->sd);
+
+    return true;
+
+error:
+    c->err = errno;
+    if (fd >= 0) {
+        close(fd);
+    }
+    shm_close(c);
+
+    return false;
+}
+
+/* closes all descriptors in a control message, those we don't want too */
+static void
+_shm_close_fds(struct msghdr *msg)
+{
+    struct cmsghdr *cm;
+    int *fd;
+    size_t i, nfd;
+
+    for (cm = CMSG_FIRSTHDR(msg); cm != NULL; cm = CMSG_NXTHDR(msg, cm)) {
+        if (cm->cmsg_level != SOL_SOCKET || cm->cmsg_type != SCM_RIGHTS) {
+            continue;
+        }
+        fd = (int *)CMSG_DATA(cm);
+        nfd = (cm->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for (i = 0; i < nfd; i++) {
+            close(fd[i]);
+        }
+    }
+}
+
+rstatus_i
+shm_attach(int sd, struct shm_conn *c)
+{
+    struct shm_hello hello;
+    int fds[SHM_NFD];
+    union {
+        struct cmsghdr  align;
+        char            buf[CMSG_SPACE(sizeof(fds))];
+    } cmsg;
+    struct iovec iov = {&hello, sizeof(hello)};
+    struct msghdr msg;
+    struct cmsghdr *cm;
+    struct stat st;
+    uint32_t cap;
+    ssize_t n;
+
+    ASSERT(c != NULL && c->seg == NULL);
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = cmsg.buf;
+    msg.msg_controllen = sizeof(cmsg.buf);
+
+    do {
+        n = recvmsg(sd, &msg, MSG_CMSG_CLOEXEC);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return CC_EAGAIN;
+    }
+    if (n < 0) {
+        log_error("recv shm channel on sd %d failed: %s", sd, strerror(errno));
+        c->err = errno;
+        return CC_ERROR;
+    }
+
+    cm = CMSG_FIRSTHDR(&msg);
+    if (n != sizeof(hello) || hello.magic != SHM_MAGIC ||
+            (msg.msg_flags & MSG_CTRUNC) || cm == NULL ||
+            cm->cmsg_level != SOL_SOCKET || cm->cmsg_type != SCM_RIGHTS ||
+            cm->cmsg_len != CMSG_LEN(sizeof(fds))) {
+        log_warn("invalid shm channel handshake on sd %d", sd);
+        _shm_close_fds(&msg);
+        return CC_ERROR;
+    }
+    cc_memcpy(fds, CMSG_DATA(cm), sizeof(fds));
+
+    /* the server rings the client's doorbell and waits on its own */
+    c->peer.fd[0] = fds[SHM_FD_CBELL_R];
+    c->peer.fd[1] = fds[SHM_FD_CBELL_W];
+    c->peer.state = CHANNEL_LISTEN;
+    c->bell.fd[0] = fds[SHM_FD_SBELL_R];
+    c->bell.fd[1] = fds[SHM_FD_SBELL_W];
+    c->bell.state = CHANNEL_LISTEN;
+    /* the worker never blocks on a doorbell, whatever the client set */
+    efd_set_nonblocking(&c->bell);
+    efd_set_nonblocking(&c->peer);
+
+    /* the client may not be trusted with the layout, check it fits for good */
+    c->size = hello.size;
+    if (!_shm_sealed(fds[SHM_FD_SEG])) {
+        log_warn("shm channel on sd %d can be resized by the client", sd);
+        goto error;
+    }
+    if (fstat(fds[SHM_FD_SEG], &st) < 0 || (size_t)st.st_size < c->size ||
+            c->size < _shm_size(0)) {
+        log_warn("shm channel on sd %d is smaller than announced", sd);
+        goto error;
+    }
+    c->seg = mmap(NULL, c->size, PROT_READ | PROT_WRITE, MAP_SHARED,
+            fds[SHM_FD_SEG], 0);
+    if (c->seg == MAP_FAILED) {
+        log_error("mmap shm channel on sd %d failed: %s", sd, strerror(errno));
+        c->seg = NULL;
+        goto error;
+    }
+    close(fds[SHM_FD_SEG]);
+    fds[SHM_FD_SEG] = -1;
+
+    /* the capacity is read once, the peer may change what's in the mapping */
+    cap = c->seg->cap;
+    if (c->seg->magic != SHM_MAGIC || cap > SHM_CAP_MAX ||
+            _shm_size(cap) != c->size) {
+        log_warn("invalid shm channel layout on sd %d", sd);
+        goto error;
+    }
+
+    _shm_map_rings(c, cap, SHM_SERVER);
+    log_info("shm channel of %"PRIu32" bytes each way attached on sd %d",
+            cap, sd);
+
+    return CC_OK;
+
+error:
+    if (fds[SHM_FD_SEG] >= 0) {
+        close(fds[SHM_FD_SEG]);
+    }
+    shm_close(c);
+
+    return CC_ERROR;
+}
+
+void
+shm_close(struct shm_conn *c)
+{
+    if (c == NULL) {
+        return;
+    }
+
+    log_info("closing shm conn %p", c);
+
+    if (c->seg != NULL) {
+        if (c->state == CHANNEL_ESTABLISHED) {
+            __atomic_store_n(&c->seg->closed[c->end], 1, __ATOMIC_RELEASE);
+            efd_send(&c->peer, 1);
+        }
+        munmap(c->seg, c->size);
+    }
+    if (c->bell.state != CHANNEL_TERM) {
+        efd_close(&c->bell);
+    }
+    if (c->peer.state != CHANNEL_TERM) {
+        efd_close(&c->peer);
+    }
+    if (c->sd >= 0) {
+        close(c->sd);
+    }
+
+    shm_conn_reset(c);
+}
+
+/*
+ * Load the positions of a ring once, the one owned by this end can be relaxed.
+ * The mapping is shared with the peer, so every access goes by the capacity
+ * kept locally, and a position out of range means the ring is corrupt.
+ */
+static inline bool
+_shm_pos_load(struct shm_conn *c, struct shm_ring *r, uint32_t *rpos,
+        uint32_t *wpos)
+{
+    if (r == c->rx) {
+        *rpos = __atomic_load_n(&r->rpos, __ATOMIC_RELAXED);
+        *wpos = __atomic_load_n(&r->wpos, __ATOMIC_ACQUIRE);
+    } else {
+        *rpos = __atomic_load_n(&r->rpos, __ATOMIC_ACQUIRE);
+        *wpos = __atomic_load_n(&r->wpos, __ATOMIC_RELAXED);
+    }
+
+    if (*rpos > c->cap || *wpos > c->cap) {
+        log_warn("shm conn %p ring positions %"PRIu32"/%"PRIu32" are corrupt",
+                c, *rpos, *wpos);
+        c->state = CHANNEL_ERROR;
+        return false;
+    }
+
+    return true;
+}
+
+uint32_t
+shm_rsize(struct shm_conn *c)
+{
+    uint32_t rpos, wpos;
+
+    if (!_shm_pos_load(c, c->rx, &rpos, &wpos)) {
+        return 0;
+    }
+
+    return _shm_nbyte(rpos, wpos, c->cap);
+}
+
+uint32_t
+shm_wsize(struct shm_conn *c)
+{
+    uint32_t rpos, wpos;
+
+    if (!_shm_pos_load(c, c->tx, &rpos, &wpos)) {
+        return 0;
+    }
+
+    return c->cap - _shm_nbyte(rpos, wpos, c->cap);
+}
+
+bool
+shm_peer_closed(struct shm_conn *c)
+{
+    return _shm_peer_closed(c);
+}
+
+ssize_t
+shm_recv(struct shm_conn *c, void *buf, size_t nbyte)
+{
+    struct shm_ring *r = c->rx;
+    uint32_t n, first, rpos, wpos;
+    bool closed;
+
+    ASSERT(buf != NULL);
+    ASSERT(nbyte > 0);
+
+    /* check before looking at the ring, data sent before closing is kept */
+    closed = _shm_peer_closed(c);
+    if (!_shm_pos_load(c, r, &rpos, &wpos)) {
+        return CC_ERROR;
+    }
+
+    n = _shm_nbyte(rpos, wpos, c->cap);
+    if (n == 0) {
+        if (closed) {
+            log_debug("eof recv'd on shm conn %p, total: rb %zu sb %zu", c,
+                    c->recv_nbyte, c->send_nbyte);
+            c->state = CHANNEL_TERM;
+            return 0;
+        }
+        return CC_EAGAIN;
+    }
+
+    if (n > nbyte) {
+        n = (uint32_t)nbyte;
+    }
+    first = c->cap + 1 - rpos;
+    if (first > n) {
+        first = n;
+    }
+    cc_memcpy(buf, r->data + rpos, first);
+    cc_memcpy((char *)buf + first, r->data, n - first);
+
+    __atomic_store_n(&r->rpos, (rpos + n) % (c->cap + 1), __ATOMIC_RELEASE);
+    _shm_notify(c, &r->wwait);
+
+    c->recv_nbyte += n;
+    log_verb("%"PRIu32" bytes recv'd on shm conn %p", n, c);
+
+    return n;
+}
+
+ssize_t
+shm_send(struct shm_conn *c, void *buf, size_t nbyte)
+{
+    struct shm_ring *r = c->tx;
+    uint32_t n, first, rpos, wpos;
+
+    ASSERT(buf != NULL);
+    ASSERT(nbyte > 0);
+
+    if (_shm_peer_closed(c)) {
+        log_debug("send on shm conn %p closed by peer", c);
+        return CC_ERROR;
+    }
+    if (!_shm_pos_load(c, r, &rpos, &wpos)) {
+        return CC_ERROR;
+    }
+
+    n = c->cap - _shm_nbyte(rpos, wpos, c->cap);
+    if (n == 0) {
+        return CC_EAGAIN;
+    }
+
+    if (n > nbyte) {
+        n = (uint32_t)nbyte;
+    }
+    first = c->cap + 1 - wpos;
+    if (first > n) {
+        first = n;
+    }
+    cc_memcpy(r->data + wpos, buf, first);
+    cc_memcpy(r->data, (char *)buf + first, n - first);
+
+    __atomic_store_n(&r->wpos, (wpos + n) % (c->cap + 1), __ATOMIC_RELEASE);
+    _shm_notify(c, &r->rwait);
+
+    c->send_nbyte += n;
+    log_verb("%"PRIu32" bytes sent on shm conn %p", n, c);
+
+    return n;
+}
+
+bool
+shm_wait_prepare(struct shm_conn *c, bool room)
+{
+    __atomic_store_n(&c->rx->rwait, 1, __ATOMIC_RELAXED);
+    if (room) {
+        __atomic_store_n(&c->tx->wwait, 1, __ATOMIC_RELAXED);
+    }
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    if (shm_rsize(c) > 0 || (room && shm_wsize(c) > 0) ||
+            _shm_peer_closed(c) || c->state == CHANNEL_ERROR) {
+        shm_wait_done(c);
+        return false;
+    }
+
+    return true;
+}
+
+void
+shm_wait_done(struct shm_conn *c)
+{
+    __atomic_store_n(&c->rx->rwait, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&c->tx->wwait, 0, __ATOMIC_RELAXED);
+}
+
+void
+shm_bell_clear(struct shm_conn *c)
+{
+    uint64_t val;
+
+    efd_recv(&c->bell, &val);
+}
+
+rstatus_i
+shm_wait(struct shm_conn *c, bool room, int timeout)
+{
+    struct pollfd pfd[2];
+    nfds_t nfd = 1;
+    int i, n;
+
+    for (i = 0; i < SHM_SPIN; i++) {
+        if (shm_rsize(c) > 0 || (room && shm_wsize(c) > 0) ||
+                _shm_peer_closed(c) || c->state == CHANNEL_ERROR) {
+            return CC_OK;
+        }
+    }
+
+    if (!shm_wait_prepare(c, room)) {
+        return CC_OK;
+    }
+
+    pfd[0].fd = shm_read_id(c);
+    pfd[0].events = POLLIN;
+    if (c->sd >= 0) { /* the server only ever closes the control socket */
+        pfd[1].fd = c->sd;
+        pfd[1].events = POLLIN;
+        nfd++;
+    }
+
+    do {
+        n = poll(pfd, nfd, timeout);
+    } while (n < 0 && errno == EINTR);
+
+    shm_wait_done(c);
+
+    if (n < 0) {
+        log_error("poll on shm conn %p failed: %s", c, strerror(errno));
+        c->err = errno;
+        return CC_ERROR;
+    }
+    if (n == 0) {
+        return CC_EAGAIN;
+    }
+
+    if (pfd[0].revents != 0) {
+        shm_bell_clear(c);
+    }
+    if (nfd > 1 && pfd[1].revents != 0) {
+        log_info("control socket of shm conn %p closed by peer", c);
+        c->state = CHANNEL_TERM;
+    }
+
+    return CC_OK;
+}
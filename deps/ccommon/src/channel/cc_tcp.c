@@ -195,12 +195,16 @@ tcp_connect(struct addrinfo *ai, struct tcp_conn *c)
         goto error;
     }
 
-    ret = tcp_set_tcpnodelay(c->sd);
-    if (ret < 0) {
-        log_error("set tcpnodelay on c %p sd %d failed: %s", c, c->sd,
-                strerror(errno));
+    if (ai->ai_family == AF_UNIX) {
+        c->flags |= TCP_CONN_UNIX;
+    } else {
+        ret = tcp_set_tcpnodelay(c->sd);
+        if (ret < 0) {
+            log_error("set tcpnodelay on c %p sd %d failed: %s", c, c->sd,
+                    strerror(errno));
 
-        goto error;
+            goto error;
+        }
     }
 
     ret = connect(c->sd, ai->ai_addr, ai->ai_addrlen);
@@ -243,8 +247,8 @@ error:
     return false;
 }
 
-bool
-tcp_listen(struct addrinfo *ai, struct tcp_conn *c)
+static bool
+_tcp_listen(struct addrinfo *ai, struct tcp_conn *c, bool reuseport)
 {
     int ret;
     int sd;
@@ -263,6 +267,14 @@ tcp_listen(struct addrinfo *ai, struct tcp_conn *c)
         goto error;
     }
 
+    if (reuseport) {
+        ret = tcp_set_reuseport(sd);
+        if (ret < 0) {
+            log_error("reuse port of sd %d failed: %s", sd, strerror(errno));
+            goto error;
+        }
+    }
+
     ret = bind(sd, ai->ai_addr, ai->ai_addrlen);
     if (ret < 0) {
         log_error("bind on sd %d failed: %s", sd, strerror(errno));
@@ -281,6 +293,9 @@ tcp_listen(struct addrinfo *ai, struct tcp_conn *c)
         goto error;
     }
 
+    if (ai->ai_family == AF_UNIX) {
+        c->flags |= TCP_CONN_UNIX;
+    }
     c->level = CHANNEL_META;
     c->state = CHANNEL_LISTEN;
     log_info("server listen setup on socket descriptor %d", c->sd);
@@ -295,6 +310,23 @@ error:
     return false;
 }
 
+bool
+tcp_listen(struct addrinfo *ai, struct tcp_conn *c)
+{
+    return _tcp_listen(ai, c, false);
+}
+
+/*
+ * Listen with SO_REUSEPORT, so several sockets (owned by different threads or
+ * processes) can bind to the same address, and the kernel spreads incoming
+ * connections among them.
+ */
+bool
+tcp_listen_reuseport(struct addrinfo *ai, struct tcp_conn *c)
+{
+    return _tcp_listen(ai, c, true);
+}
+
 void
 tcp_close(struct tcp_conn *c)
 {
@@ -313,7 +345,7 @@ tcp_close(struct tcp_conn *c)
     }
 }
 
-static inline int
+static int
 _tcp_accept(struct tcp_conn *sc)
 {
     int sd;
@@ -366,10 +398,16 @@ tcp_accept(struct tcp_conn *sc, struct tcp_conn *c)
                 strerror(errno));
     }
 
-    ret = tcp_set_tcpnodelay(sd);
-    if (ret < 0) {
-        log_warn("set tcp nodelay on sd %d failed, ignored: %s", sd,
-                 strerror(errno));
+    /* accepted connections are of the same kind as the listener, and those
+     * accepted on a unix domain socket have no tcp options
+     */
+    c->flags |= sc->flags;
+    if (!(sc->flags & TCP_CONN_UNIX)) {
+        ret = tcp_set_tcpnodelay(sd);
+        if (ret < 0) {
+            log_warn("set tcp nodelay on sd %d failed, ignored: %s", sd,
+                     strerror(errno));
+        }
     }
 
     log_info("accepted c %d on sd %d", c->sd, sc->sd);
@@ -435,6 +473,24 @@ tcp_set_reuseaddr(int sd)
     return setsockopt(sd, SOL_SOCKET, SO_REUSEADDR, &reuse, len);
 }
 
+int
+tcp_set_reuseport(int sd)
+{
+#ifdef SO_REUSEPORT
+    int reuse;
+    socklen_t len;
+
+    reuse = 1;
+    len = sizeof(reuse);
+
+    return setsockopt(sd, SOL_SOCKET, SO_REUSEPORT, &reuse, len);
+#else
+    errno = ENOTSUP;
+
+    return -1;
+#endif
+}
+
 /*
  * Disable Nagle algorithm on TCP socket.
  *
@@ -516,6 +572,23 @@ tcp_set_rcvbuf(int sd, int size)
     return setsockopt(sd, SOL_SOCKET, SO_RCVBUF, &size, len);
 }
 
+/* busy poll the device queue for up to usec on blocking reads and polls */
+int
+tcp_set_busy_poll(int sd, int usec)
+{
+#ifdef SO_BUSY_POLL
+    socklen_t len;
+
+    len = sizeof(usec);
+
+    return setsockopt(sd, SOL_SOCKET, SO_BUSY_POLL, &usec, len);
+#else
+    errno = ENOTSUP;
+
+    return -1;
+#endif
+}
+
 int
 tcp_get_sndbuf(int sd)
 {
@@ -673,12 +746,14 @@ tcp_recvv(struct tcp_conn *c, struct array *bufv, size_t nbyte)
 
         if (n > 0) {
             c->recv_nbyte += (size_t)n;
-            INCR_N(tcp_metrics, tcp_recv, n);
+            INCR_N(tcp_metrics, tcp_recv_byte, n);
             return n;
         }
 
         if (n == 0) {
-            log_warn("recvv on sd %d returned zero", c->sd);
+            c->state = CHANNEL_TERM;
+            log_debug("eof recv'd on sd %d, total: rb %zu sb %zu", c->sd,
+                      c->recv_nbyte, c->send_nbyte);
 
             return 0;
         }
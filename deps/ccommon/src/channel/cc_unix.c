@@ -0,0 +1,152 @@
+/*
+ * ccommon - a cache common library.
+ * Copyright (C) 2015 Twitter, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <channel/cc_unix.h>
+
+#include <cc_debug.h>
+
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/*
+ * fill in an addrinfo with a unix domain address, so the generic tcp calls
+ * can be used to listen and connect; returns false if path is too long
+ */
+static bool
+_unix_addrinfo(const char *path, struct sockaddr_un *un, struct addrinfo *ai)
+{
+    size_t len = strlen(path);
+
+    if (len == 0 || len >= sizeof(un->sun_path)) {
+        log_error("unix socket path '%s' is empty or too long", path);
+        return false;
+    }
+
+    memset(un, 0, sizeof(*un));
+    un->sun_family = AF_UNIX;
+    memcpy(un->sun_path, path, len);
+
+    memset(ai, 0, sizeof(*ai));
+    ai->ai_family = AF_UNIX;
+    ai->ai_socktype = SOCK_STREAM;
+    ai->ai_addr = (struct sockaddr *)un;
+    if (path[0] == UNIX_ABSTRACT) {
+        /* abstract names start with a nul, and are exactly len bytes long */
+        un->sun_path[0] = '\0';
+        ai->ai_addrlen = offsetof(struct sockaddr_un, sun_path) + len;
+    } else {
+        ai->ai_addrlen = sizeof(*un);
+    }
+
+    return true;
+}
+
+/*
+ * whether something still listens on the socket at ai, as opposed to a socket
+ * file left behind, which refuses connections; a full backlog counts as live
+ */
+static bool
+_unix_live(const struct addrinfo *ai)
+{
+    int sd, ret;
+
+    sd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sd < 0) {
+        return false;
+    }
+    if (tcp_set_nonblocking(sd) < 0) {
+        close(sd);
+        return false;
+    }
+
+    ret = connect(sd, ai->ai_addr, ai->ai_addrlen);
+    close(sd);
+
+    return ret == 0 || errno == EAGAIN || errno == EINPROGRESS;
+}
+
+bool
+unix_listen(const char *path, struct tcp_conn *c)
+{
+    struct sockaddr_un un;
+    struct addrinfo ai;
+
+    ASSERT(path != NULL && c != NULL);
+
+    if (!_unix_addrinfo(path, &un, &ai)) {
+        return false;
+    }
+
+    /*
+     * a socket file left behind by a previous run would fail bind, so it is
+     * removed, but never from under a running listener; and only sockets are
+     * removed: a typo in the path shouldn't cost a regular file
+     */
+    if (path[0] != UNIX_ABSTRACT && _unix_live(&ai)) {
+        log_error("unix socket '%s' is in use by another listener", path);
+        errno = EADDRINUSE;
+        return false;
+    }
+    unix_unlink(path);
+
+    if (!tcp_listen(&ai, c)) {
+        log_error("listen on unix socket '%s' failed", path);
+        return false;
+    }
+
+    log_info("listening on unix socket '%s' sd %d", path, c->sd);
+
+    return true;
+}
+
+bool
+unix_connect(const char *path, struct tcp_conn *c)
+{
+    struct sockaddr_un un;
+    struct addrinfo ai;
+
+    ASSERT(path != NULL && c != NULL);
+
+    if (!_unix_addrinfo(path, &un, &ai)) {
+        return false;
+    }
+
+    return tcp_connect(&ai, c);
+}
+
+void
+unix_unlink(const char *path)
+{
+    struct stat st;
+
+    if (path == NULL || path[0] == UNIX_ABSTRACT) {
+        return;
+    }
+
+    if (lstat(path, &st) < 0 || !S_ISSOCK(st.st_mode)) {
+        return;
+    }
+
+    if (unlink(path) < 0) {
+        log_warn("unlink unix socket '%s' failed, ignored: %s", path,
+                strerror(errno));
+    }
+}
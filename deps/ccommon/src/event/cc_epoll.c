@@ -151,6 +151,23 @@ int event_add_read(struct event_base *evb, int fd, void *data)
     return status;
 }
 
+int
+event_add_read_edge(struct event_base *evb, int fd, void *data)
+{
+    int status;
+
+    status = _event_update(evb, fd, EPOLL_CTL_ADD, EPOLLIN | EPOLLET, data);
+    if (status < 0 && errno != EEXIST) {
+        log_error("ctl (add read edge) w/ epoll fd %d on fd %d failed: %s",
+                evb->ep, fd, strerror(errno));
+    }
+
+    INCR(event_metrics, event_read);
+    log_verb("add edge read event to epoll fd %d on fd %d", evb->ep, fd);
+
+    return status;
+}
+
 int
 event_add_write(struct event_base *evb, int fd, void *data)
 {
@@ -0,0 +1,654 @@
+/*
+ * ccommon - a cache common library.
+ * Copyright (C) 2013 Twitter, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cc_event.h>
+
+#include <cc_debug.h>
+#include <cc_define.h>
+#include <cc_mm.h>
+
+#include <endian.h>
+#include <inttypes.h>
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/errno.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "cc_shared.h"
+
+/*
+ * An event backend built on io_uring, with the same level-triggered semantics
+ * as cc_epoll.c. Each registered fd has one one-shot poll request in flight;
+ * when it completes the callback is run and the poll is armed again if the fd
+ * is still registered. Registrations, re-arms and removals only queue entries
+ * on the submission ring, all of them are submitted together with the wait in
+ * a single io_uring_enter(2) per event_wait() call, instead of one epoll_ctl(2)
+ * per change.
+ *
+ * Edge-triggered reads use a multishot poll instead (5.13+), which stays in
+ * flight and completes once for every wakeup, like EPOLLET. Where the kernel
+ * rejects it, they fall back to level-triggered one-shot polls, with a warning.
+ *
+ * This backend is poll-only: only readiness goes through the ring. Callers
+ * still read and write with recv/send once told a socket is ready, there are
+ * no read/write submissions completing into registered buffers, which would
+ * take a completion-based interface above event_wait.
+ *
+ * liburing is not required, the rings are set up with raw syscalls. The kernel
+ * needs IORING_FEAT_EXT_ARG (5.11+) to wait with a timeout.
+ */
+
+/* user_data of a poll is (gen << 32 | fd), these values are never produced */
+#define EVENT_UD_REMOVE UINT64_MAX
+
+#define EVENT_NSLOT     64      /* initial size of the fd table */
+
+#ifdef IORING_POLL_ADD_MULTI
+#define EVENT_POLL_MULTI IORING_POLL_ADD_MULTI
+#define EVENT_CQE_MORE   IORING_CQE_F_MORE
+#else
+#define EVENT_POLL_MULTI 0      /* headers predate multishot poll */
+#define EVENT_CQE_MORE   0
+#endif
+
+struct event_slot {
+    void               *data;   /* passed to the callback */
+    uint32_t           mask;    /* POLLIN or POLLOUT, 0 if not registered */
+    uint32_t           gen;     /* bumped on every add/del */
+    bool               armed;   /* a poll request is in flight */
+    bool               edge;    /* polled multishot, see above */
+};
+
+struct event_base {
+    int                 ring;       /* io_uring descriptor */
+
+    /* submission queue */
+    uint32_t            *sq_khead;
+    uint32_t            *sq_ktail;
+    uint32_t            sq_mask;
+    uint32_t            sq_entries;
+    uint32_t            sq_tail;    /* local tail, published on submit */
+    struct io_uring_sqe *sqe;
+
+    /* completion queue */
+    uint32_t            *cq_khead;
+    uint32_t            *cq_ktail;
+    uint32_t            cq_mask;
+    struct io_uring_cqe *cqe;
+
+    /* mappings */
+    void                *sq_ring;
+    size_t              sq_ring_sz;
+    void                *cq_ring;   /* same as sq_ring with SINGLE_MMAP */
+    size_t              cq_ring_sz;
+    size_t              sqe_sz;
+
+    struct event_slot   *slot;      /* slot[fd] */
+    uint32_t            nslot;
+
+    int                 nevent;     /* max # events per wait */
+    event_cb_fn         cb;         /* event callback */
+    bool                multi;      /* multishot poll is supported */
+};
+
+static inline uint32_t
+_load_acquire(uint32_t *p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void
+_store_release(uint32_t *p, uint32_t v)
+{
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+static inline uint32_t
+_poll_mask(uint32_t mask)
+{
+#if __BYTE_ORDER == __BIG_ENDIAN
+    mask = (mask << 16) | (mask >> 16);
+#endif
+    return mask;
+}
+
+static void
+_event_unmap(struct event_base *evb)
+{
+    if (evb->sqe != NULL) {
+        munmap(evb->sqe, evb->sqe_sz);
+    }
+    if (evb->cq_ring != NULL && evb->cq_ring != evb->sq_ring) {
+        munmap(evb->cq_ring, evb->cq_ring_sz);
+    }
+    if (evb->sq_ring != NULL) {
+        munmap(evb->sq_ring, evb->sq_ring_sz);
+    }
+}
+
+static int
+_event_map(struct event_base *evb, struct io_uring_params *p)
+{
+    uint32_t *array;
+    uint32_t i;
+
+    evb->sq_ring_sz = p->sq_off.array + p->sq_entries * sizeof(uint32_t);
+    evb->cq_ring_sz = p->cq_off.cqes + p->cq_entries *
+        sizeof(struct io_uring_cqe);
+    if (p->features & IORING_FEAT_SINGLE_MMAP) {
+        if (evb->cq_ring_sz > evb->sq_ring_sz) {
+            evb->sq_ring_sz = evb->cq_ring_sz;
+        }
+        evb->cq_ring_sz = evb->sq_ring_sz;
+    }
+
+    evb->sq_ring = mmap(NULL, evb->sq_ring_sz, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, evb->ring, IORING_OFF_SQ_RING);
+    if (evb->sq_ring == MAP_FAILED) {
+        evb->sq_ring = NULL;
+        return -1;
+    }
+
+    if (p->features & IORING_FEAT_SINGLE_MMAP) {
+        evb->cq_ring = evb->sq_ring;
+    } else {
+        evb->cq_ring = mmap(NULL, evb->cq_ring_sz, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, evb->ring, IORING_OFF_CQ_RING);
+        if (evb->cq_ring == MAP_FAILED) {
+            evb->cq_ring = NULL;
+            return -1;
+        }
+    }
+
+    evb->sqe_sz = p->sq_entries * sizeof(struct io_uring_sqe);
+    evb->sqe = mmap(NULL, evb->sqe_sz, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, evb->ring, IORING_OFF_SQES);
+    if (evb->sqe == MAP_FAILED) {
+        evb->sqe = NULL;
+        return -1;
+    }
+
+    evb->sq_khead = (uint32_t *)((char *)evb->sq_ring + p->sq_off.head);
+    evb->sq_ktail = (uint32_t *)((char *)evb->sq_ring + p->sq_off.tail);
+    evb->sq_mask = *(uint32_t *)((char *)evb->sq_ring + p->sq_off.ring_mask);
+    evb->sq_entries = p->sq_entries;
+    evb->sq_tail = *evb->sq_ktail;
+
+    /* sqe index i always goes into array slot i */
+    array = (uint32_t *)((char *)evb->sq_ring + p->sq_off.array);
+    for (i = 0; i < p->sq_entries; i++) {
+        array[i] = i;
+    }
+
+    evb->cq_khead = (uint32_t *)((char *)evb->cq_ring + p->cq_off.head);
+    evb->cq_ktail = (uint32_t *)((char *)evb->cq_ring + p->cq_off.tail);
+    evb->cq_mask = *(uint32_t *)((char *)evb->cq_ring + p->cq_off.ring_mask);
+    evb->cqe = (struct io_uring_cqe *)((char *)evb->cq_ring + p->cq_off.cqes);
+
+    return 0;
+}
+
+struct event_base *
+event_base_create(int nevent, event_cb_fn cb)
+{
+    struct event_base *evb;
+    struct io_uring_params p;
+    int ring;
+
+    ASSERT(nevent > 0);
+
+    memset(&p, 0, sizeof(p));
+    ring = syscall(__NR_io_uring_setup, nevent, &p);
+    if (ring < 0) {
+        log_error("io_uring setup size %d failed: %s", nevent,
+                strerror(errno));
+        return NULL;
+    }
+
+    if (!(p.features & IORING_FEAT_EXT_ARG)) {
+        log_error("io_uring on this kernel cannot wait with a timeout");
+        close(ring);
+        return NULL;
+    }
+
+    evb = (struct event_base *)cc_zalloc(sizeof(*evb));
+    if (evb == NULL) {
+        close(ring);
+        return NULL;
+    }
+    evb->ring = ring;
+
+    evb->slot = (struct event_slot *)cc_calloc(EVENT_NSLOT,
+            sizeof(struct event_slot));
+    if (evb->slot == NULL) {
+        goto error;
+    }
+    evb->nslot = EVENT_NSLOT;
+
+    if (_event_map(evb, &p) < 0) {
+        log_error("io_uring fd %d mmap failed: %s", ring, strerror(errno));
+        goto error;
+    }
+
+    evb->nevent = nevent;
+    evb->cb = cb;
+    evb->multi = EVENT_POLL_MULTI != 0;
+
+    log_info("io_uring fd %d with nevent %d (sq %"PRIu32" cq %"PRIu32")",
+            evb->ring, evb->nevent, p.sq_entries, p.cq_entries);
+
+    return evb;
+
+error:
+    _event_unmap(evb);
+    cc_free(evb->slot);
+    close(ring);
+    cc_free(evb);
+
+    return NULL;
+}
+
+void
+event_base_destroy(struct event_base **evb)
+{
+    int status;
+    struct event_base *e = *evb;
+
+    if (e == NULL) {
+        return;
+    }
+
+    ASSERT(e->ring > 0);
+
+    _event_unmap(e);
+    cc_free(e->slot);
+
+    status = close(e->ring);
+    if (status < 0) {
+        log_warn("close io_uring fd %d failed, ignored: %s", e->ring,
+                strerror(errno));
+    }
+    e->ring = -1;
+
+    cc_free(e);
+
+    *evb = NULL;
+}
+
+/* publish queued entries, wait for min_complete completions or timeout */
+static int
+_event_enter(struct event_base *evb, uint32_t min_complete, int timeout)
+{
+    struct io_uring_getevents_arg arg;
+    struct __kernel_timespec ts;
+    uint32_t to_submit, flags = 0;
+
+    _store_release(evb->sq_ktail, evb->sq_tail);
+    to_submit = evb->sq_tail - _load_acquire(evb->sq_khead);
+
+    if (min_complete > 0) {
+        flags |= IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+        memset(&arg, 0, sizeof(arg));
+        if (timeout >= 0) {
+            ts.tv_sec = timeout / 1000;
+            ts.tv_nsec = (long long)(timeout % 1000) * 1000000;
+            arg.ts = (uint64_t)(uintptr_t)&ts;
+        }
+
+        return syscall(__NR_io_uring_enter, evb->ring, to_submit,
+                min_complete, flags, &arg, sizeof(arg));
+    }
+
+    if (to_submit == 0) {
+        return 0;
+    }
+
+    return syscall(__NR_io_uring_enter, evb->ring, to_submit, 0, 0, NULL, 0);
+}
+
+/* get an empty submission entry, flush the ring first if it is full */
+static struct io_uring_sqe *
+_event_sqe(struct event_base *evb)
+{
+    struct io_uring_sqe *sqe;
+
+    while (evb->sq_tail - _load_acquire(evb->sq_khead) >= evb->sq_entries) {
+        if (_event_enter(evb, 0, 0) < 0 && errno != EINTR) {
+            log_error("submit to io_uring fd %d failed: %s", evb->ring,
+                    strerror(errno));
+            return NULL;
+        }
+    }
+
+    sqe = &evb->sqe[evb->sq_tail & evb->sq_mask];
+    memset(sqe, 0, sizeof(*sqe));
+    evb->sq_tail++;
+
+    return sqe;
+}
+
+static struct event_slot *
+_event_slot(struct event_base *evb, int fd)
+{
+    struct event_slot *slot;
+    uint32_t nslot;
+
+    if ((uint32_t)fd < evb->nslot) {
+        return &evb->slot[fd];
+    }
+
+    for (nslot = evb->nslot; nslot <= (uint32_t)fd; nslot *= 2);
+    slot = (struct event_slot *)cc_realloc(evb->slot,
+            nslot * sizeof(struct event_slot));
+    if (slot == NULL) {
+        return NULL;
+    }
+    memset(slot + evb->nslot, 0,
+            (nslot - evb->nslot) * sizeof(struct event_slot));
+    evb->slot = slot;
+    evb->nslot = nslot;
+
+    return &evb->slot[fd];
+}
+
+static int
+_event_arm(struct event_base *evb, int fd, struct event_slot *slot)
+{
+    struct io_uring_sqe *sqe;
+
+    sqe = _event_sqe(evb);
+    if (sqe == NULL) {
+        return -1;
+    }
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = _poll_mask(slot->mask);
+    if (slot->edge && evb->multi) {
+        sqe->len = EVENT_POLL_MULTI;
+    }
+    sqe->user_data = (uint64_t)slot->gen << 32 | (uint32_t)fd;
+    slot->armed = true;
+
+    return 0;
+}
+
+static int
+_event_add(struct event_base *evb, int fd, uint32_t mask, bool edge,
+        void *data)
+{
+    struct event_slot *slot;
+
+    ASSERT(evb != NULL && evb->ring > 0);
+    ASSERT(fd > 0);
+
+    slot = _event_slot(evb, fd);
+    if (slot == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    /* same as EPOLL_CTL_ADD, an fd can only be registered once */
+    if (slot->mask != 0) {
+        errno = EEXIST;
+        return -1;
+    }
+
+    slot->data = data;
+    slot->mask = mask;
+    slot->edge = edge;
+    slot->gen++;
+
+    return _event_arm(evb, fd, slot);
+}
+
+int
+event_add_read(struct event_base *evb, int fd, void *data)
+{
+    int status;
+
+    status = _event_add(evb, fd, POLLIN, false, data);
+    if (status < 0 && errno != EEXIST) {
+        log_error("add read w/ io_uring fd %d on fd %d failed: %s", evb->ring,
+                fd, strerror(errno));
+    }
+
+    INCR(event_metrics, event_read);
+    log_verb("add read event to io_uring fd %d on fd %d", evb->ring, fd);
+
+    return status;
+}
+
+int
+event_add_read_edge(struct event_base *evb, int fd, void *data)
+{
+    int status;
+
+    status = _event_add(evb, fd, POLLIN, true, data);
+    if (status < 0 && errno != EEXIST) {
+        log_error("add read edge w/ io_uring fd %d on fd %d failed: %s",
+                evb->ring, fd, strerror(errno));
+    }
+
+    INCR(event_metrics, event_read);
+    log_verb("add read edge event to io_uring fd %d on fd %d", evb->ring, fd);
+
+    return status;
+}
+
+int
+event_add_write(struct event_base *evb, int fd, void *data)
+{
+    int status;
+
+    status = _event_add(evb, fd, POLLOUT, false, data);
+    if (status < 0 && errno != EEXIST) {
+        log_error("add write w/ io_uring fd %d on fd %d failed: %s", evb->ring,
+                fd, strerror(errno));
+    }
+
+    INCR(event_metrics, event_write);
+    log_verb("add write event to io_uring fd %d on fd %d", evb->ring, fd);
+
+    return status;
+}
+
+int
+event_del(struct event_base *evb, int fd)
+{
+    struct event_slot *slot;
+    struct io_uring_sqe *sqe;
+
+    ASSERT(evb != NULL && evb->ring > 0);
+    ASSERT(fd > 0);
+
+    if ((uint32_t)fd >= evb->nslot || evb->slot[fd].mask == 0) {
+        errno = ENOENT;
+        log_error("del w/ io_uring fd %d on fd %d failed: %s", evb->ring, fd,
+                strerror(errno));
+        return -1;
+    }
+
+    slot = &evb->slot[fd];
+    if (slot->armed) {
+        sqe = _event_sqe(evb);
+        if (sqe == NULL) {
+            return -1;
+        }
+        sqe->opcode = IORING_OP_POLL_REMOVE;
+        sqe->fd = -1;
+        sqe->addr = (uint64_t)slot->gen << 32 | (uint32_t)fd;
+        sqe->user_data = EVENT_UD_REMOVE;
+    }
+
+    /* any completion of the old poll still in the ring is now stale */
+    slot->data = NULL;
+    slot->mask = 0;
+    slot->armed = false;
+    slot->edge = false;
+    slot->gen++;
+
+    log_verb("del fd %d from io_uring fd %d", fd, evb->ring);
+
+    return 0;
+}
+
+/* run the callback for all completions ready, returns # events delivered */
+static int
+_event_reap(struct event_base *evb)
+{
+    struct io_uring_cqe *cqe;
+    struct event_slot *slot;
+    uint32_t head, tail, gen, flags;
+    uint64_t user_data;
+    int32_t res;
+    int fd, nreturned = 0;
+
+    head = *evb->cq_khead;
+    tail = _load_acquire(evb->cq_ktail);
+
+    while (head != tail && nreturned < evb->nevent) {
+        uint32_t events = 0;
+
+        cqe = &evb->cqe[head & evb->cq_mask];
+        user_data = cqe->user_data;
+        res = cqe->res;
+        flags = cqe->flags;
+        _store_release(evb->cq_khead, ++head);
+
+        if (user_data == EVENT_UD_REMOVE) {
+            continue;
+        }
+
+        fd = (int)(uint32_t)user_data;
+        gen = (uint32_t)(user_data >> 32);
+        if ((uint32_t)fd >= evb->nslot) {
+            continue;
+        }
+        slot = &evb->slot[fd];
+        if (slot->mask == 0 || slot->gen != gen) {
+            continue; /* removed or re-registered since */
+        }
+        /* a multishot poll stays in flight for as long as this is set */
+        if (!(flags & EVENT_CQE_MORE)) {
+            slot->armed = false;
+        }
+
+        if (res == -EINVAL && slot->edge && evb->multi) {
+            log_warn("io_uring fd %d has no multishot poll, edge-triggered "
+                    "reads are level-triggered", evb->ring);
+            evb->multi = EVENT_POLL_MULTI != 0;
+            _event_arm(evb, fd, slot);
+            continue;
+        }
+
+        log_verb("io_uring poll %"PRId32" on fd %d against data %p", res, fd,
+                slot->data);
+
+        if (res < 0) {
+            log_warn("poll on fd %d w/ io_uring fd %d failed: %s", fd,
+                    evb->ring, strerror(-res));
+            events |= EVENT_ERR;
+        } else {
+            if (res & (POLLERR | POLLHUP | POLLNVAL)) {
+                events |= EVENT_ERR;
+            }
+
+            if (res & POLLIN) {
+                events |= EVENT_READ;
+            }
+
+            if (res & POLLOUT) {
+                events |= EVENT_WRITE;
+            }
+        }
+
+        nreturned++;
+        if (evb->cb != NULL) {
+            evb->cb(slot->data, events);
+        }
+
+        /* the callback may have deleted the fd or grown the table */
+        slot = &evb->slot[fd];
+        if (slot->mask != 0 && slot->gen == gen && !slot->armed) {
+            _event_arm(evb, fd, slot);
+        }
+
+        tail = _load_acquire(evb->cq_ktail);
+    }
+
+    return nreturned;
+}
+
+/*
+ * create a timed event with event base function and timeout (in millisecond)
+ */
+int
+event_wait(struct event_base *evb, int timeout)
+{
+    int ring;
+
+    ASSERT(evb != NULL);
+
+    ring = evb->ring;
+
+    ASSERT(ring > 0);
+
+    for (;;) {
+        int status, nreturned;
+        uint32_t min_complete = 1;
+
+        /* completions left over from the last call need no waiting */
+        if (timeout == 0 || *evb->cq_khead != _load_acquire(evb->cq_ktail)) {
+            min_complete = 0;
+        }
+
+        status = _event_enter(evb, min_complete, timeout);
+        INCR(event_metrics, event_loop);
+        if (status < 0 && errno != ETIME && errno != EINTR) {
+            log_error("wait on io_uring fd %d with nevent %d and timeout %d "
+                    "failed: %s", ring, evb->nevent, timeout, strerror(errno));
+            return -1;
+        }
+
+        nreturned = _event_reap(evb);
+        if (nreturned > 0) {
+            INCR_N(event_metrics, event_total, nreturned);
+            log_verb("returned %d events from io_uring fd %d", nreturned,
+                    ring);
+
+            return nreturned;
+        }
+
+        if (status < 0 && errno == ETIME) {
+            log_vverb("wait on io_uring fd %d with nevent %d timeout %d "
+                    "returned no events", ring, evb->nevent, timeout);
+            return 0;
+        }
+
+        if (timeout == 0) {
+            return 0;
+        }
+
+        /* EINTR, or only stale completions were reaped: wait again */
+    }
+
+    NOT_REACHED();
+}
@@ -160,6 +160,17 @@ event_add_read(struct event_base *evb, int fd, void *data)
     return 0;
 }
 
+int
+event_add_read_edge(struct event_base *evb, int fd, void *data)
+{
+    _event_update(evb, fd, EVFILT_READ, EV_ADD | EV_CLEAR, data);
+    INCR(event_metrics, event_read);
+
+    log_verb("adding edge read event to fd %d", fd);
+
+    return 0;
+}
+
 int
 event_add_write(struct event_base *evb, int fd, void *data)
 {
@@ -17,22 +17,242 @@
 
 #include <cc_metric.h>
 
+#include <cc_bstring.h>
 #include <cc_debug.h>
 #include <cc_log.h>
+#include <cc_mm.h>
 #include <cc_print.h>
+#include <cc_util.h>
 
 #include <stdbool.h>
+#include <stdlib.h>
 
 #define VALUE_PRINT_LEN 30
+#define NAME_PRINT_LEN 64
+/* a JSON pair takes a name, and up to 6 values and their keys for histograms */
+#define JSON_PAIR_LEN (NAME_PRINT_LEN + 6 * VALUE_PRINT_LEN)
 #define METRIC_DESCRIBE_FMT  "%-31s %-15s %s"
+#define METRIC_BLOCK_ALIGN 64 /* cache line, blocks never share one */
 
-char *metric_type_str[] = {"counter", "gauge", "floating point"};
+char *metric_type_str[] = {"counter", "gauge", "floating point", "histogram"};
+
+/* percentiles printed for histograms, a max is printed after them */
+static const struct {
+    char    *suffix;
+    double  p;
+} histo_print[] = {
+    {"_p50",  50.0},
+    {"_p90",  90.0},
+    {"_p99",  99.0},
+    {"_p999", 99.9},
+};
+#define HISTO_NPRINT (sizeof(histo_print) / sizeof(histo_print[0]))
+
+__thread uint64_t *metric_block = NULL;
+static __thread unsigned int metric_shard_id = 0;
+/* blocks of all threads with a shard, each on cache lines of its own */
+static uint64_t *metric_blocks[METRIC_NSHARD];
+static unsigned int metric_nshard = 0; /* # shards claimed so far */
+static uint32_t metric_nslot = 0;      /* # slots given out, 0 is never used */
+
+unsigned int
+metric_shard_claim(void)
+{
+    unsigned int id;
+    uint64_t *block;
+
+    if (metric_shard_id > 0) {
+        return metric_shard_id;
+    }
+
+    id = __atomic_add_fetch(&metric_nshard, 1, __ATOMIC_RELAXED);
+    if (id > METRIC_NSHARD) {
+        log_warn("all %u metric shards are claimed, thread counts into the "
+                "shared value", METRIC_NSHARD);
+        return 0;
+    }
+
+    block = aligned_alloc(METRIC_BLOCK_ALIGN, METRIC_NSLOT * sizeof(uint64_t));
+    if (block == NULL) {
+        log_warn("cannot allocate metric shard %u, thread counts into the "
+                "shared value", id);
+        return 0;
+    }
+    cc_memset(block, 0, METRIC_NSLOT * sizeof(uint64_t));
+    __atomic_store_n(&metric_blocks[id - 1], block, __ATOMIC_RELEASE);
+
+    metric_block = block;
+    metric_shard_id = id;
+    log_info("metric shard %u claimed", id);
+
+    return id;
+}
 
 void
-metric_reset(struct metric sarr[], unsigned int n)
+_metric_add(struct metric *m, uint64_t delta)
+{
+    uint32_t slot = 0;
+
+    if (metric_block == NULL) {
+        __atomic_add_fetch(&m->counter, delta, __ATOMIC_RELAXED);
+        return;
+    }
+
+    /* racing threads both take a slot, the one that lost is never used */
+    if (__atomic_load_n(&metric_nslot, __ATOMIC_RELAXED) < METRIC_NSLOT - 1) {
+        slot = __atomic_add_fetch(&metric_nslot, 1, __ATOMIC_RELAXED);
+    }
+    if (slot == 0 || slot >= METRIC_NSLOT) {
+        __atomic_add_fetch(&m->counter, delta, __ATOMIC_RELAXED);
+        return;
+    }
+    __atomic_compare_exchange_n(&m->slot, &(uint32_t){0}, slot, false,
+            __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+
+    metric_add(m, delta);
+}
+
+static inline uint64_t
+_metric_shard_sum(struct metric *m)
 {
+    uint32_t slot = __atomic_load_n(&m->slot, __ATOMIC_RELAXED);
+    uint64_t *block, sum = 0;
     unsigned int i;
 
+    if (slot == 0) {
+        return 0;
+    }
+
+    for (i = 0; i < METRIC_NSHARD; i++) {
+        block = __atomic_load_n(&metric_blocks[i], __ATOMIC_ACQUIRE);
+        if (block != NULL) {
+            sum += __atomic_load_n(&block[slot], __ATOMIC_RELAXED);
+        }
+    }
+
+    return sum;
+}
+
+void
+metric_set(struct metric *m, uint64_t val)
+{
+    __atomic_store_n(&m->counter, val - _metric_shard_sum(m),
+            __ATOMIC_RELAXED);
+}
+
+uint64_t
+metric_counter(struct metric *m)
+{
+    return __atomic_load_n(&m->counter, __ATOMIC_RELAXED) +
+        _metric_shard_sum(m);
+}
+
+int64_t
+metric_gauge(struct metric *m)
+{
+    return (int64_t)metric_counter(m);
+}
+
+struct metric_histo *
+metric_histo_create(struct metric *m)
+{
+    struct metric_histo *h, *expected = NULL;
+
+    h = cc_zalloc(sizeof(struct metric_histo));
+    if (h == NULL) {
+        log_error("cannot allocate buckets for histogram %s", m->name);
+        return NULL;
+    }
+
+    /* another thread may have beaten us to it, use theirs */
+    if (!__atomic_compare_exchange_n(&m->histo, &expected, h, false,
+                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        cc_free(h);
+        return expected;
+    }
+
+    return h;
+}
+
+uint64_t
+metric_histo_value(unsigned int i)
+{
+    unsigned int shift;
+
+    if (i < (1U << HISTO_SUB_BITS)) {
+        return i;
+    }
+
+    shift = (i >> HISTO_SUB_BITS) - 1;
+    return (((uint64_t)(i & ((1U << HISTO_SUB_BITS) - 1)) +
+                (1U << HISTO_SUB_BITS) + 1) << shift) - 1;
+}
+
+uint64_t
+metric_histo_count(struct metric *m)
+{
+    struct metric_histo *h = __atomic_load_n(&m->histo, __ATOMIC_ACQUIRE);
+    uint64_t count = 0;
+    unsigned int i;
+
+    if (h == NULL) {
+        return 0;
+    }
+
+    for (i = 0; i < HISTO_NBUCKET; i++) {
+        count += __atomic_load_n(&h->bucket[i], __ATOMIC_RELAXED);
+    }
+
+    return count;
+}
+
+uint64_t
+metric_histo_percentile(struct metric *m, double p)
+{
+    struct metric_histo *h = __atomic_load_n(&m->histo, __ATOMIC_ACQUIRE);
+    uint64_t count, rank, seen = 0;
+    unsigned int i;
+
+    count = metric_histo_count(m);
+    if (count == 0) {
+        return 0;
+    }
+
+    /* smallest bucket covering at least p percent of all records */
+    rank = (uint64_t)(p / 100.0 * count + 0.5);
+    if (rank == 0) {
+        rank = 1;
+    }
+    for (i = 0; i < HISTO_NBUCKET; i++) {
+        seen += __atomic_load_n(&h->bucket[i], __ATOMIC_RELAXED);
+        if (seen >= rank) {
+            return metric_histo_value(i);
+        }
+    }
+
+    /* records came in while counting, report the highest bucket in use */
+    for (i = HISTO_NBUCKET; i > 0; i--) {
+        if (__atomic_load_n(&h->bucket[i - 1], __ATOMIC_RELAXED) > 0) {
+            return metric_histo_value(i - 1);
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Shards are only ever written by the thread owning them, so they are left
+ * alone: counters and gauges are reset through the shared value, the same way
+ * metric_set() does, and histogram buckets, which all threads add to
+ * atomically, are cleared one by one with atomic stores.
+ */
+void
+metric_reset(struct metric sarr[], unsigned int n)
+{
+    struct metric_histo *h;
+    double zero = 0.0;
+    unsigned int i, j;
+
     if (sarr == NULL) {
         return;
     }
@@ -40,15 +260,21 @@ metric_reset(struct metric sarr[], unsigned int n)
     for (i = 0; i < n; i++) {
         switch (sarr[i].type) {
         case METRIC_COUNTER:
-            sarr[i].counter = 0;
-            break;
-
         case METRIC_GAUGE:
-            sarr[i].gauge = 0;
+            metric_set(&sarr[i], 0);
             break;
 
         case METRIC_FPN:
-            sarr[i].fpn = 0.0;
+            __atomic_store(&sarr[i].fpn, &zero, __ATOMIC_RELAXED);
+            break;
+
+        case METRIC_HISTOGRAM:
+            h = __atomic_load_n(&sarr[i].histo, __ATOMIC_ACQUIRE);
+            if (h != NULL) {
+                for (j = 0; j < HISTO_NBUCKET; j++) {
+                    __atomic_store_n(&h->bucket[j], 0, __ATOMIC_RELAXED);
+                }
+            }
             break;
 
         default:
@@ -58,6 +284,50 @@ metric_reset(struct metric sarr[], unsigned int n)
     }
 }
 
+void
+metric_teardown(struct metric sarr[], unsigned int n)
+{
+    unsigned int i;
+
+    if (sarr == NULL) {
+        return;
+    }
+
+    for (i = 0; i < n; i++) {
+        if (sarr[i].type == METRIC_HISTOGRAM && sarr[i].histo != NULL) {
+            cc_free(sarr[i].histo);
+            sarr[i].histo = NULL;
+        }
+    }
+}
+
+static size_t
+_metric_print_histo(char *buf, size_t nbuf, char *fmt, struct metric *m)
+{
+    char name_buf[NAME_PRINT_LEN];
+    char val_buf[VALUE_PRINT_LEN];
+    size_t len;
+    unsigned int i;
+
+    cc_scnprintf(val_buf, VALUE_PRINT_LEN, "%llu", metric_histo_count(m));
+    len = cc_scnprintf(buf, nbuf, fmt, m->name, val_buf);
+
+    for (i = 0; i < HISTO_NPRINT; i++) {
+        cc_scnprintf(name_buf, NAME_PRINT_LEN, "%s%s", m->name,
+                histo_print[i].suffix);
+        cc_scnprintf(val_buf, VALUE_PRINT_LEN, "%llu",
+                metric_histo_percentile(m, histo_print[i].p));
+        len += cc_scnprintf(buf + len, nbuf - len, fmt, name_buf, val_buf);
+    }
+
+    cc_scnprintf(name_buf, NAME_PRINT_LEN, "%s_max", m->name);
+    cc_scnprintf(val_buf, VALUE_PRINT_LEN, "%llu",
+            metric_histo_percentile(m, 100.0));
+    len += cc_scnprintf(buf + len, nbuf - len, fmt, name_buf, val_buf);
+
+    return len;
+}
+
 size_t
 metric_print(char *buf, size_t nbuf, char *fmt, struct metric *m)
 {
@@ -74,19 +344,20 @@ metric_print(char *buf, size_t nbuf, char *fmt, struct metric *m)
          * and negatively impact readability, and since this function should not
          * be called often enough to make it absolutely performance critical.
          */
-        cc_scnprintf(val_buf, VALUE_PRINT_LEN, "%llu", __atomic_load_n(
-                    &m->counter, __ATOMIC_RELAXED));
+        cc_scnprintf(val_buf, VALUE_PRINT_LEN, "%llu", metric_counter(m));
         break;
 
     case METRIC_GAUGE:
-        cc_scnprintf(val_buf, VALUE_PRINT_LEN, "%lld", __atomic_load_n(
-                    &m->gauge, __ATOMIC_RELAXED));
+        cc_scnprintf(val_buf, VALUE_PRINT_LEN, "%lld", metric_gauge(m));
         break;
 
     case METRIC_FPN:
         cc_scnprintf(val_buf, VALUE_PRINT_LEN, "%f", m->fpn);
         break;
 
+    case METRIC_HISTOGRAM:
+        return _metric_print_histo(buf, nbuf, fmt, m);
+
     default:
         NOT_REACHED();
     }
@@ -94,6 +365,138 @@ metric_print(char *buf, size_t nbuf, char *fmt, struct metric *m)
     return cc_scnprintf(buf, nbuf, fmt, m->name, val_buf);
 }
 
+/* value compared by metric_json to tell whether a metric has changed */
+static uint64_t
+_metric_snapshot(struct metric *m)
+{
+    uint64_t val = 0;
+
+    switch (m->type) {
+    case METRIC_COUNTER:
+    case METRIC_GAUGE:
+        val = metric_counter(m);
+        break;
+
+    case METRIC_FPN:
+        cc_memcpy(&val, &m->fpn, sizeof(val));
+        break;
+
+    case METRIC_HISTOGRAM:
+        val = metric_histo_count(m);
+        break;
+
+    default:
+        NOT_REACHED();
+    }
+
+    return val;
+}
+
+/* write one "name":value pair into buf, which must have JSON_PAIR_LEN bytes */
+static size_t
+_metric_json_pair(char *buf, struct metric *m)
+{
+    size_t len;
+    unsigned int i;
+
+    len = cc_scnprintf(buf, NAME_PRINT_LEN, "\"%s\":", m->name);
+
+    switch (m->type) {
+    case METRIC_COUNTER:
+        len += cc_print_uint64_unsafe(buf + len, metric_counter(m));
+        break;
+
+    case METRIC_GAUGE:
+        len += cc_print_int64_unsafe(buf + len, metric_gauge(m));
+        break;
+
+    case METRIC_FPN:
+        len += cc_scnprintf(buf + len, VALUE_PRINT_LEN, "%f", m->fpn);
+        break;
+
+    case METRIC_HISTOGRAM:
+        len += cc_scnprintf(buf + len, VALUE_PRINT_LEN, "{\"n\":");
+        len += cc_print_uint64_unsafe(buf + len, metric_histo_count(m));
+        for (i = 0; i < HISTO_NPRINT; i++) {
+            /* the suffix without its leading underscore */
+            len += cc_scnprintf(buf + len, VALUE_PRINT_LEN, ",\"%s\":",
+                    histo_print[i].suffix + 1);
+            len += cc_print_uint64_unsafe(buf + len,
+                    metric_histo_percentile(m, histo_print[i].p));
+        }
+        len += cc_scnprintf(buf + len, VALUE_PRINT_LEN, ",\"max\":");
+        len += cc_print_uint64_unsafe(buf + len,
+                metric_histo_percentile(m, 100.0));
+        buf[len++] = '}';
+        break;
+
+    default:
+        NOT_REACHED();
+    }
+
+    return len;
+}
+
+size_t
+metric_json(char *buf, size_t nbuf, struct metric metrics[],
+        unsigned int nmetric, const char *prefix, size_t plen, uint64_t prev[])
+{
+    char pair[JSON_PAIR_LEN];
+    size_t len = 0, npair;
+    uint64_t val = 0;
+    unsigned int i;
+
+    /* room for the braces and the nul is always kept */
+    if (nbuf < 3) {
+        return 0;
+    }
+
+    buf[len++] = '{';
+    for (i = 0; i < nmetric; i++) {
+        if (plen > 0 && cc_strncmp(metrics[i].name, prefix, plen) != 0) {
+            continue;
+        }
+
+        if (prev != NULL) {
+            val = _metric_snapshot(&metrics[i]);
+            if (val == prev[i]) {
+                continue;
+            }
+        }
+
+        npair = _metric_json_pair(pair, &metrics[i]);
+        if (len + npair + 3 > nbuf) {
+            log_warn("json snapshot is cut short at metric %s, %zu bytes "
+                    "buffer is too small", metrics[i].name, nbuf);
+            break;
+        }
+        if (len > 1) {
+            buf[len++] = ',';
+        }
+        cc_memcpy(buf + len, pair, npair);
+        len += npair;
+        if (prev != NULL) {
+            prev[i] = val;
+        }
+    }
+    buf[len++] = '}';
+    buf[len] = '\0';
+
+    return len;
+}
+
+unsigned int
+metric_nline(struct metric metrics[], unsigned int nmetric)
+{
+    unsigned int i, nline = 0;
+
+    for (i = 0; i < nmetric; i++) {
+        nline += metrics[i].type == METRIC_HISTOGRAM ? HISTO_NPRINT + 2 : 1;
+    }
+
+    return nline;
+}
+
 void
 metric_describe_all(struct metric metrics[], unsigned int nmetric)
 {
@@ -24,6 +24,7 @@
 #include <cc_mm.h>
 #include <cc_pool.h>
 #include <cc_util.h>
+#include <channel/cc_shm.h>
 #include <channel/cc_tcp.h>
 
 #include <limits.h>
@@ -39,6 +40,9 @@
 
 #define SOCKIO_MODULE_NAME "ccommon::sockio"
 
+#define SOCKIO_NCHUNK   8       /* max # bufs read into with one readv */
+#define SOCKIO_NSPAN    KiB     /* min # bytes copied to join a request */
+
 FREEPOOL(buf_sock_pool, buf_sockq, buf_sock);
 struct buf_sock_pool bsp;
 
@@ -140,8 +144,15 @@ buf_tcp_write(struct buf_sock *s)
 
 rstatus_i
 dbuf_tcp_read(struct buf_sock *s)
+{
+    return dbuf_tcp_read_budget(s, UINT32_MAX);
+}
+
+rstatus_i
+dbuf_tcp_read_budget(struct buf_sock *s, uint32_t budget)
 {
     ASSERT(s != NULL);
+    ASSERT(budget > 0);
 
     struct tcp_conn *c = (struct tcp_conn *)s->ch;
     channel_handler_st *h = s->hdl;
@@ -162,6 +173,8 @@ dbuf_tcp_read(struct buf_sock *s)
          *   - if n == 0, set to close and return
          *   - otherwise, increment wpos, total_n and loop again
          *     if n == cap
+         * 3. never ask for more than what is left of the budget, once it is
+         *   used up while there may be more to read, return CC_ERETRY
          */
         cap = buf_wsize(s->rbuf);
         if (cap == 0) {
@@ -174,6 +187,9 @@ dbuf_tcp_read(struct buf_sock *s)
             }
             cap = buf_wsize(s->rbuf);
         }
+        if (cap > budget - (uint32_t)total_n) {
+            cap = budget - (uint32_t)total_n;
+        }
 
         n = h->recv(c, s->rbuf->wpos, cap);
 
@@ -195,7 +211,12 @@ dbuf_tcp_read(struct buf_sock *s)
             s->rbuf->wpos += n;
             total_n += n;
         }
-    } while (n == cap);
+    } while (n == cap && (uint32_t)total_n < budget);
+
+    if (n == cap) {
+        log_verb("read budget %"PRIu32" used up on buf_sock %p", budget, s);
+        status = CC_ERETRY;
+    }
 
 done:
     if (total_n > 0) {
@@ -205,6 +226,336 @@ done:
     return status;
 }
 
+/*
+ * readv into the room left in the last buf of the read chain, then into new
+ * bufs from the pool, which are chained once data arrives in them. The chain
+ * holds no more than rbuf could still grow by. *cap is set to the number of
+ * bytes asked for, 0 if there is no room for any.
+ */
+static ssize_t
+_dbuf_tcp_recvv(struct buf_sock *s, uint32_t *cap)
+{
+    struct iovec iov[SOCKIO_NCHUNK];
+    struct buf *chunk[SOCKIO_NCHUNK];
+    struct array bufv;
+    struct buf *b = STAILQ_LAST(&s->rchain, buf, next);
+    uint32_t i, len, nchunk = 0, nnew = 0, nbyte = 0;
+    uint32_t nmax = dbuf_room(s->rbuf) / buf_init_size;
+    ssize_t n, left;
+
+    if (b != NULL && buf_wsize(b) == 0) {
+        b = NULL;
+    }
+    while (nchunk < SOCKIO_NCHUNK && nbyte < *cap) {
+        if (b == NULL) {
+            if (s->nrchain + nnew >= nmax || (b = buf_borrow()) == NULL) {
+                break;
+            }
+            nnew++;
+        }
+        len = buf_wsize(b);
+        if (len > *cap - nbyte) {
+            len = *cap - nbyte;
+        }
+        chunk[nchunk] = b;
+        iov[nchunk].iov_base = b->wpos;
+        iov[nchunk].iov_len = len;
+        nbyte += len;
+        nchunk++;
+        b = NULL;
+    }
+    *cap = nbyte;
+    if (nchunk == 0) {
+        return CC_ENOMEM;
+    }
+
+    array_data_assign(&bufv, nchunk, sizeof(struct iovec), iov);
+    bufv.nelem = nchunk;
+    n = tcp_recvv(s->ch, &bufv, nbyte);
+
+    /* only the bufs borrowed above, which come last, are not chained yet */
+    for (i = 0, left = n; i < nchunk; i++) {
+        len = 0;
+        if (left > 0) {
+            len = (uint32_t)left < iov[i].iov_len ? (uint32_t)left :
+                iov[i].iov_len;
+            chunk[i]->wpos += len;
+            left -= len;
+        }
+        if (i < nchunk - nnew) {
+            continue;
+        }
+        if (len > 0) {
+            STAILQ_INSERT_TAIL(&s->rchain, chunk[i], next);
+            s->nrchain++;
+        } else {
+            buf_return(&chunk[i]);
+        }
+    }
+
+    return n;
+}
+
+rstatus_i
+dbuf_tcp_readv(struct buf_sock *s, uint32_t budget)
+{
+    ASSERT(s != NULL);
+    ASSERT(budget > 0);
+
+    struct tcp_conn *c = (struct tcp_conn *)s->ch;
+    channel_handler_st *h = s->hdl;
+    rstatus_i status = CC_OK;
+    uint32_t cap;
+    ssize_t n, total_n = 0;
+
+    ASSERT(c != NULL && h != NULL && s->rbuf != NULL);
+    ASSERT(h->recv != NULL);
+
+    do {
+        /*
+         * Try to recv:
+         * 1. into rbuf while nothing is chained behind it and it has room,
+         *   which it all has again once it is parsed through
+         * 2. otherwise readv into the chain (see above)
+         *   - if it cannot take any more, return CC_ERETRY
+         * 3. the rest is as in dbuf_tcp_read_budget
+         */
+        cap = 0;
+        if (STAILQ_EMPTY(&s->rchain)) {
+            if (buf_rsize(s->rbuf) == 0) {
+                buf_lshift(s->rbuf);
+            }
+            cap = buf_wsize(s->rbuf);
+        }
+
+        if (cap > 0) {
+            if (cap > budget - (uint32_t)total_n) {
+                cap = budget - (uint32_t)total_n;
+            }
+            n = h->recv(c, s->rbuf->wpos, cap);
+            if (n > 0) {
+                s->rbuf->wpos += n;
+            }
+        } else {
+            cap = budget - (uint32_t)total_n;
+            n = _dbuf_tcp_recvv(s, &cap);
+            if (cap == 0) {
+                log_verb("no room to read past rbuf on buf_sock %p", s);
+                status = CC_ERETRY;
+
+                goto done;
+            }
+        }
+
+        if (n < 0) {
+            if (n == CC_EAGAIN) {
+                status = CC_OK;
+            } else {
+                log_info("recv on conn %p returns other error: %d", c, n);
+                status = CC_ERROR;
+                c->state = CHANNEL_ERROR;
+            }
+            goto done;
+        } else if (n == 0) {
+            status = CC_ERDHUP;
+            c->state = CHANNEL_TERM;
+
+            goto done;
+        } else {
+            total_n += n;
+        }
+    } while (n == cap && (uint32_t)total_n < budget);
+
+    if (n == cap) {
+        log_verb("read budget %"PRIu32" used up on buf_sock %p", budget, s);
+        status = CC_ERETRY;
+    }
+
+done:
+    if (total_n > 0) {
+        log_verb("recv %zd bytes on conn %p", total_n, c);
+    }
+
+    return status;
+}
+
+/*
+ * What is left of rbuf is the start of a request that goes on in the read
+ * chain. If all of it was copied from the first buf in the chain, that buf
+ * takes the place of rbuf, rewound to where the request starts. Otherwise
+ * the request is made contiguous by copying on from the chain, twice as much
+ * each time it still turns out incomplete.
+ */
+bool
+dbuf_rnext(struct buf_sock *s)
+{
+    struct buf *b;
+    uint32_t left, len;
+
+    while ((b = STAILQ_FIRST(&s->rchain)) != NULL) {
+        left = buf_rsize(s->rbuf);
+
+        if (left <= s->rspan || buf_rsize(b) == 0) {
+            STAILQ_REMOVE_HEAD(&s->rchain, next);
+            s->nrchain--;
+            if (left <= s->rspan) {
+                b->rpos -= left;
+                dbuf_shrink(&s->rbuf);
+                buf_return(&s->rbuf);
+                s->rbuf = b;
+            } else { /* all of it has been copied into rbuf */
+                buf_return(&b);
+            }
+            s->rspan = 0;
+            if (buf_rsize(s->rbuf) > left) {
+                return true;
+            }
+            continue;
+        }
+
+        len = left > SOCKIO_NSPAN ? left : SOCKIO_NSPAN;
+        if (len > buf_rsize(b)) {
+            len = buf_rsize(b);
+        }
+        if (len > buf_wsize(s->rbuf)) {
+            buf_lshift(s->rbuf);
+        }
+        if (len > buf_wsize(s->rbuf) &&
+                dbuf_fit(&s->rbuf, left + len) != CC_OK) {
+            len = buf_wsize(s->rbuf);
+            if (len == 0) {
+                log_warn("request on buf_sock %p is larger than rbuf can be",
+                        s);
+                return false;
+            }
+        }
+        cc_memcpy(s->rbuf->wpos, b->rpos, len);
+        s->rbuf->wpos += len;
+        b->rpos += len;
+        s->rspan += len;
+
+        return true;
+    }
+
+    return false;
+}
+
+static void
+_buf_sock_rchain_return(struct buf_sock *s)
+{
+    struct buf *b;
+
+    while ((b = STAILQ_FIRST(&s->rchain)) != NULL) {
+        STAILQ_REMOVE_HEAD(&s->rchain, next);
+        buf_return(&b);
+    }
+    s->nrchain = 0;
+    s->rspan = 0;
+}
+
+/*
+ * Everything pending on the ring is already in memory, so instead of reading
+ * in rounds rbuf is grown up front to take all of it, if it can.
+ */
+rstatus_i
+dbuf_shm_read(struct buf_sock *s)
+{
+    ASSERT(s != NULL);
+
+    struct shm_conn *c = s->shm;
+    struct buf *buf;
+    rstatus_i status = CC_OK;
+    uint32_t nbyte, room;
+    ssize_t n;
+
+    ASSERT(c != NULL && s->rbuf != NULL);
+
+    nbyte = shm_rsize(c);
+    if (nbyte > buf_wsize(s->rbuf)) {
+        buf_lshift(s->rbuf);
+    }
+    if (nbyte > buf_wsize(s->rbuf)) {
+        /* up to max size, what doesn't fit is left for later */
+        room = dbuf_room(s->rbuf);
+        if (dbuf_fit(&s->rbuf, buf_rsize(s->rbuf) +
+                    (nbyte < room ? nbyte : room)) != CC_OK) {
+            log_warn("growing rbuf on buf_sock %p failed", s);
+        }
+    }
+    buf = s->rbuf;
+
+    if (buf_wsize(buf) == 0) {
+        log_verb("rbuf on buf_sock %p is at max size", s);
+        return nbyte > 0 ? CC_ERETRY : CC_OK;
+    }
+
+    n = shm_recv(c, buf->wpos, buf_wsize(buf));
+    if (n < 0) {
+        if (n == CC_EAGAIN) {
+            status = CC_OK;
+        } else {
+            log_info("recv on shm conn %p returns other error: %d", c, n);
+            status = CC_ERROR;
+            s->ch->state = CHANNEL_ERROR;
+        }
+    } else if (n == 0) {
+        status = CC_ERDHUP;
+        s->ch->state = CHANNEL_TERM;
+    } else {
+        buf->wpos += n;
+        log_verb("recv %zd bytes on shm conn %p", n, c);
+        status = (uint32_t)n < nbyte ? CC_ERETRY : CC_OK;
+    }
+
+    return status;
+}
+
+rstatus_i
+buf_shm_write(struct buf_sock *s)
+{
+    ASSERT(s != NULL);
+
+    struct shm_conn *c = s->shm;
+    struct buf *buf = s->wbuf;
+    rstatus_i status = CC_OK;
+    size_t cap;
+    ssize_t n;
+
+    ASSERT(c != NULL && buf != NULL);
+
+    cap = buf_rsize(buf);
+
+    if (cap == 0) {
+        log_verb("no data to send in buf at %p ", buf);
+
+        return CC_EEMPTY;
+    }
+
+    n = shm_send(c, buf->rpos, cap);
+    if (n < 0) {
+        if (n == CC_EAGAIN) {
+            log_verb("send on shm conn %p returns rescuable error: EAGAIN", c);
+            status = CC_EAGAIN;
+        } else {
+            log_info("send on shm conn %p returns other error: %d", c, n);
+            status = CC_ERROR;
+            s->ch->state = CHANNEL_ERROR;
+        }
+    } else if ((size_t)n < cap) {
+        log_debug("unwritten data remain on shm conn %p, should retry", c);
+        status = CC_ERETRY;
+    } else {
+        status = CC_OK;
+    }
+
+    if (n > 0) {
+        buf->rpos += n;
+        log_verb("send %zd bytes on shm conn %p", n, c);
+    }
+
+    return status;
+}
+
 struct buf_sock *
 buf_sock_create(void)
 {
@@ -219,8 +570,12 @@ buf_sock_create(void)
     s->free = false;
     s->hdl = NULL;
     s->ch = NULL;
+    s->shm = NULL;
     s->rbuf = NULL;
     s->wbuf = NULL;
+    STAILQ_INIT(&s->rchain);
+    s->nrchain = 0;
+    s->rspan = 0;
 
     s->ch = tcp_conn_create();
     if (s->ch == NULL) {
@@ -255,6 +610,7 @@ buf_sock_destroy(struct buf_sock **s)
 
     log_verb("destroy buffered socket %p", *s);
 
+    _buf_sock_rchain_return(*s);
     tcp_conn_destroy(&(*s)->ch);
     buf_destroy(&(*s)->rbuf);
     buf_destroy(&(*s)->wbuf);
@@ -317,8 +673,12 @@ buf_sock_reset(struct buf_sock *s)
     s->flag = 0;
     s->data = NULL;
     s->hdl = NULL;
+    s->tev = NULL;
+    s->atime = 0;
+    s->shm = NULL;
 
     tcp_conn_reset(s->ch);
+    _buf_sock_rchain_return(s);
     buf_reset(s->rbuf);
     buf_reset(s->wbuf);
 }
@@ -350,6 +710,7 @@ buf_sock_return(struct buf_sock **s)
 
     log_verb("return buffered socket %p", *s);
 
+    _buf_sock_rchain_return(*s);
     (*s)->free = true;
     FREEPOOL_RETURN(*s, &bsp, next);
 
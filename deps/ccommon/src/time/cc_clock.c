@@ -0,0 +1,52 @@
+#include <time/cc_clock.h>
+
+#include <cc_bstring.h>
+
+/* coarse clocks are Linux specific, elsewhere use the regular one */
+#ifdef CLOCK_REALTIME_COARSE
+#define CLOCK_SOURCE CLOCK_REALTIME_COARSE
+#else
+#define CLOCK_SOURCE CLOCK_REALTIME
+#endif
+
+uint64_t clock_cached_ns = 0;
+uint64_t clock_cached_ms = 0;
+uint64_t clock_cached_sec = 0;
+
+void
+clock_update(void)
+{
+    struct timespec ts;
+    uint64_t ns;
+
+    if (clock_gettime(CLOCK_SOURCE, &ts) < 0) {
+        return;
+    }
+
+    /* readers may see fields from two updates apart, they differ by a tick */
+    ns = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+    __atomic_store_n(&clock_cached_ns, ns, __ATOMIC_RELAXED);
+    __atomic_store_n(&clock_cached_ms, ns / 1000000, __ATOMIC_RELAXED);
+    __atomic_store_n(&clock_cached_sec, (uint64_t)ts.tv_sec, __ATOMIC_RELAXED);
+}
+
+size_t
+clock_format(struct clock_fmt *cf, char *buf, size_t cap, time_t sec)
+{
+    struct tm tm;
+
+    if (cf->len == 0 || cf->sec != sec) {
+        if (localtime_r(&sec, &tm) == NULL) {
+            return 0;
+        }
+        cf->len = strftime(cf->str, CLOCK_FMT_LEN, cf->fmt, &tm);
+        cf->sec = sec;
+    }
+
+    if (cf->len == 0 || cf->len >= cap) {
+        return 0;
+    }
+    cc_memcpy(buf, cf->str, cf->len);
+
+    return cf->len;
+}
@@ -0,0 +1,202 @@
+#include <channel/cc_eventfd.h>
+
+#include <check.h>
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#define SUITE_NAME "eventfd"
+#define DEBUG_LOG  SUITE_NAME ".log"
+
+struct send_task {
+    struct efd_conn *efd;
+    uint64_t val;
+    int n;
+};
+
+/*
+ * utilities
+ */
+static void
+test_setup(void)
+{
+    efd_setup(NULL);
+}
+
+static void
+test_teardown(void)
+{
+    efd_teardown();
+}
+
+static void
+test_reset(void)
+{
+    test_teardown();
+    test_setup();
+}
+
+static void *do_send(void *_send_task)
+{
+    struct send_task *task = _send_task;
+    int i;
+
+    for (i = 0; i < task->n; i++) {
+        ck_assert_int_eq(efd_send(task->efd, task->val), CC_OK);
+    }
+    return NULL;
+}
+
+START_TEST(test_send_recv)
+{
+    struct efd_conn *efd;
+    uint64_t val;
+
+    test_reset();
+
+    efd = efd_conn_create();
+    ck_assert_ptr_ne(efd, NULL);
+
+    ck_assert_int_eq(efd_open(NULL, efd), true);
+
+    ck_assert_int_eq(efd_send(efd, 3), CC_OK);
+    ck_assert_int_eq(efd_recv(efd, &val), CC_OK);
+    ck_assert_int_eq(val, 3);
+
+    efd_close(efd);
+    efd_conn_destroy(&efd);
+    ck_assert_ptr_eq(efd, NULL);
+}
+END_TEST
+
+START_TEST(test_coalesce)
+{
+#define NSEND 1000
+    struct efd_conn *efd;
+    uint64_t val, total = 0;
+
+    test_reset();
+
+    efd = efd_conn_create();
+    ck_assert_ptr_ne(efd, NULL);
+
+    ck_assert_int_eq(efd_open(NULL, efd), true);
+    efd_set_nonblocking(efd);
+
+    /* many more sends than a pipe read would take at once, none is lost */
+    struct send_task task = {efd, 1, NSEND};
+    do_send(&task);
+
+    while (efd_recv(efd, &val) == CC_OK) {
+        total += val;
+    }
+    ck_assert_int_eq(total, NSEND);
+    ck_assert_int_eq(efd->recv_val, efd->send_val);
+
+    efd_close(efd);
+    efd_conn_destroy(&efd);
+#undef NSEND
+}
+END_TEST
+
+START_TEST(test_recv_blocking)
+{
+#define NSEND 100
+    struct efd_conn *efd;
+    struct send_task task;
+    pthread_t thread;
+    uint64_t val, total = 0;
+
+    test_reset();
+
+    efd = efd_conn_create();
+    ck_assert_ptr_ne(efd, NULL);
+
+    ck_assert_int_eq(efd_open(NULL, efd), true);
+
+    task.efd = efd;
+    task.val = 2;
+    task.n = NSEND;
+    pthread_create(&thread, NULL, do_send, &task);
+    while (total < 2 * NSEND) {
+        ck_assert_int_eq(efd_recv(efd, &val), CC_OK);
+        total += val;
+    }
+    pthread_join(thread, NULL);
+
+    ck_assert_int_eq(total, 2 * NSEND);
+
+    efd_close(efd);
+    efd_conn_destroy(&efd);
+#undef NSEND
+}
+END_TEST
+
+START_TEST(test_recv_nonblocking)
+{
+    struct efd_conn *efd;
+    uint64_t val;
+
+    test_reset();
+
+    efd = efd_conn_create();
+    ck_assert_ptr_ne(efd, NULL);
+
+    ck_assert_int_eq(efd_open(NULL, efd), true);
+    efd_set_nonblocking(efd);
+
+    ck_assert_int_eq(efd_recv(efd, &val), CC_EAGAIN);
+    ck_assert_int_eq(efd_send(efd, 1), CC_OK);
+    ck_assert_int_eq(efd_send(efd, 1), CC_OK);
+    ck_assert_int_eq(efd_recv(efd, &val), CC_OK);
+    ck_assert_int_eq(val, 2);
+    ck_assert_int_eq(efd_recv(efd, &val), CC_EAGAIN);
+
+    efd_close(efd);
+    efd_conn_destroy(&efd);
+}
+END_TEST
+
+/*
+ * test suite
+ */
+static Suite *
+eventfd_suite(void)
+{
+    Suite *s = suite_create(SUITE_NAME);
+
+    TCase *tc_efd = tcase_create("eventfd test");
+    tcase_add_test(tc_efd, test_send_recv);
+    tcase_add_test(tc_efd, test_coalesce);
+    tcase_add_test(tc_efd, test_recv_blocking);
+    tcase_add_test(tc_efd, test_recv_nonblocking);
+    suite_add_tcase(s, tc_efd);
+
+    return s;
+}
+/**************
+ * test cases *
+ **************/
+
+int
+main(void)
+{
+    int nfail;
+
+    /* setup */
+    test_setup();
+
+    Suite *suite = eventfd_suite();
+    SRunner *srunner = srunner_create(suite);
+    srunner_set_log(srunner, DEBUG_LOG);
+    srunner_run_all(srunner, CK_ENV); /* set CK_VEBOSITY in ENV to customize */
+    nfail = srunner_ntests_failed(srunner);
+    srunner_free(srunner);
+
+    /* teardown */
+    test_teardown();
+
+    return (nfail == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
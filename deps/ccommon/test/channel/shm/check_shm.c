@@ -0,0 +1,525 @@
+#include <channel/cc_shm.h>
+#include <channel/cc_tcp.h>
+#include <channel/cc_unix.h>
+
+#include <check.h>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define SUITE_NAME "shm"
+#define DEBUG_LOG  SUITE_NAME ".log"
+
+#define CAP 100
+#define MAGIC 0x6d687363 /* of the handshake */
+
+/*
+ * utilities
+ */
+static void
+test_setup(void)
+{
+    tcp_setup(0, NULL);
+}
+
+static void
+test_teardown(void)
+{
+    tcp_teardown();
+}
+
+static void
+test_reset(void)
+{
+    test_teardown();
+    test_setup();
+}
+
+struct pair {
+    struct tcp_conn listen;
+    struct tcp_conn ctl;        /* server end of the control socket */
+    struct shm_conn client;
+    struct shm_conn server;
+};
+
+/* a client and a server end of the same channel */
+static void
+pair_open(struct pair *p, uint32_t cap)
+{
+    char path[64];
+
+    test_reset();
+
+    snprintf(path, sizeof(path), "/tmp/check_shm.%d.sock", (int)getpid());
+    tcp_conn_reset(&p->listen);
+    tcp_conn_reset(&p->ctl);
+    shm_conn_reset(&p->client);
+    shm_conn_reset(&p->server);
+
+    ck_assert_int_eq(unix_listen(path, &p->listen), true);
+    ck_assert_int_eq(shm_connect(path, cap, &p->client), true);
+    ck_assert_int_eq(tcp_accept(&p->listen, &p->ctl), true);
+    ck_assert_int_eq(shm_attach(p->ctl.sd, &p->server), CC_OK);
+
+    tcp_close(&p->listen);
+    unix_unlink(path);
+}
+
+static void
+pair_close(struct pair *p)
+{
+    shm_close(&p->client);
+    shm_close(&p->server);
+    tcp_close(&p->ctl);
+}
+
+/* hand over segment fd announced as size, as shm_connect would */
+static void
+send_segment(int sd, int fd, uint32_t size, struct efd_conn *bell)
+{
+    uint32_t hello[2] = {MAGIC, size};
+    int fds[5] = {fd, efd_read_id(bell), efd_write_id(bell),
+        efd_read_id(bell), efd_write_id(bell)};
+    union {
+        struct cmsghdr  align;
+        char            buf[CMSG_SPACE(sizeof(fds))];
+    } cmsg;
+    struct iovec iov = {hello, sizeof(hello)};
+    struct msghdr msg;
+    struct cmsghdr *cm;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = cmsg.buf;
+    msg.msg_controllen = sizeof(cmsg.buf);
+    cm = CMSG_FIRSTHDR(&msg);
+    cm->cmsg_level = SOL_SOCKET;
+    cm->cmsg_type = SCM_RIGHTS;
+    cm->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cm), fds, sizeof(fds));
+
+    ck_assert_int_eq(sendmsg(sd, &msg, 0), sizeof(hello));
+}
+
+/* take the segment handed over on sd, close the doorbells that come along */
+static int
+recv_segment(int sd, uint32_t *size)
+{
+    uint32_t hello[2];
+    int fds[5], i;
+    union {
+        struct cmsghdr  align;
+        char            buf[CMSG_SPACE(sizeof(fds))];
+    } cmsg;
+    struct iovec iov = {hello, sizeof(hello)};
+    struct msghdr msg;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = cmsg.buf;
+    msg.msg_controllen = sizeof(cmsg.buf);
+
+    ck_assert_int_eq(recvmsg(sd, &msg, 0), sizeof(hello));
+    ck_assert_int_eq(hello[0], MAGIC);
+    memcpy(fds, CMSG_DATA(CMSG_FIRSTHDR(&msg)), sizeof(fds));
+    for (i = 1; i < 5; i++) {
+        close(fds[i]);
+    }
+    *size = hello[1];
+
+    return fds[0];
+}
+
+/*
+ * tests
+ */
+START_TEST(test_send_recv)
+{
+    struct pair p;
+    char req[] = "get foo\r\n", rsp[] = "END\r\n";
+    char buf[CAP];
+
+    pair_open(&p, CAP);
+
+    ck_assert_int_eq(shm_recv(&p.server, buf, CAP), CC_EAGAIN);
+    ck_assert_int_eq(shm_send(&p.client, req, sizeof(req)), sizeof(req));
+    ck_assert_int_eq(shm_rsize(&p.server), sizeof(req));
+    ck_assert_int_eq(shm_recv(&p.server, buf, CAP), sizeof(req));
+    ck_assert_str_eq(buf, req);
+
+    ck_assert_int_eq(shm_send(&p.server, rsp, sizeof(rsp)), sizeof(rsp));
+    ck_assert_int_eq(shm_recv(&p.client, buf, CAP), sizeof(rsp));
+    ck_assert_str_eq(buf, rsp);
+    ck_assert_int_eq(shm_recv(&p.client, buf, CAP), CC_EAGAIN);
+
+    ck_assert_int_eq(p.client.send_nbyte, sizeof(req));
+    ck_assert_int_eq(p.server.recv_nbyte, sizeof(req));
+
+    pair_close(&p);
+}
+END_TEST
+
+START_TEST(test_full_wrap)
+{
+#define LEN 30
+    struct pair p;
+    char out[LEN], in[LEN];
+    int i, j;
+
+    pair_open(&p, CAP);
+
+    /* a ring takes exactly cap bytes */
+    memset(out, 'x', LEN);
+    ck_assert_int_eq(shm_wsize(&p.client), CAP);
+    for (i = 0; i < CAP / LEN; i++) {
+        ck_assert_int_eq(shm_send(&p.client, out, LEN), LEN);
+    }
+    ck_assert_int_eq(shm_send(&p.client, out, LEN), CAP % LEN);
+    ck_assert_int_eq(shm_send(&p.client, out, LEN), CC_EAGAIN);
+    ck_assert_int_eq(shm_wsize(&p.client), 0);
+    while (shm_recv(&p.server, in, LEN) > 0);
+
+    /* and data going around the end of the ring comes out in order */
+    for (i = 0; i < 10; i++) {
+        for (j = 0; j < LEN; j++) {
+            out[j] = (char)(i * LEN + j);
+        }
+        ck_assert_int_eq(shm_send(&p.client, out, LEN), LEN);
+        ck_assert_int_eq(shm_recv(&p.server, in, LEN), LEN);
+        ck_assert_int_eq(memcmp(out, in, LEN), 0);
+    }
+
+    pair_close(&p);
+#undef LEN
+}
+END_TEST
+
+START_TEST(test_wait_prepare)
+{
+    struct pair p;
+    char c = 'x';
+
+    pair_open(&p, CAP);
+
+    /* nothing to receive, ok to block, and the sender rings the doorbell */
+    ck_assert_int_eq(shm_wait_prepare(&p.server, false), true);
+    ck_assert_int_eq(shm_send(&p.client, &c, 1), 1);
+    ck_assert_int_eq(shm_wait(&p.server, false, 0), CC_OK);
+    shm_wait_done(&p.server);
+    shm_bell_clear(&p.server);
+
+    /* something to receive, don't block */
+    ck_assert_int_eq(shm_wait_prepare(&p.server, false), false);
+    ck_assert_int_eq(shm_recv(&p.server, &c, 1), 1);
+
+    /* nobody waiting, nothing rung */
+    ck_assert_int_eq(shm_send(&p.client, &c, 1), 1);
+    ck_assert_int_eq(shm_recv(&p.server, &c, 1), 1);
+    ck_assert_int_eq(shm_wait(&p.server, false, 0), CC_EAGAIN);
+
+    pair_close(&p);
+}
+END_TEST
+
+static void *
+do_echo(void *arg)
+{
+    struct shm_conn *c = arg;
+    char buf[CAP];
+    ssize_t n;
+
+    for (;;) {
+        n = shm_recv(c, buf, CAP);
+        if (n == 0) {
+            break;
+        }
+        if (n == CC_EAGAIN) {
+            ck_assert_int_eq(shm_wait(c, false, -1), CC_OK);
+            continue;
+        }
+        ck_assert_int_gt(n, 0);
+        while (shm_send(c, buf, n) == CC_EAGAIN) {
+            shm_wait(c, true, -1);
+        }
+    }
+
+    return NULL;
+}
+
+START_TEST(test_threads)
+{
+#define NREQ 10000
+    struct pair p;
+    pthread_t thread;
+    uint32_t i, val;
+
+    pair_open(&p, CAP);
+    pthread_create(&thread, NULL, do_echo, &p.server);
+
+    /* in lock step, so both ends go to sleep between requests all the time */
+    for (i = 0; i < NREQ; i++) {
+        ck_assert_int_eq(shm_send(&p.client, &i, sizeof(i)), sizeof(i));
+        while (shm_recv(&p.client, &val, sizeof(val)) == CC_EAGAIN) {
+            ck_assert_int_eq(shm_wait(&p.client, false, 1000), CC_OK);
+        }
+        ck_assert_int_eq(val, i);
+    }
+
+    shm_close(&p.client);
+    pthread_join(thread, NULL);
+    shm_close(&p.server);
+    tcp_close(&p.ctl);
+#undef NREQ
+}
+END_TEST
+
+START_TEST(test_close)
+{
+    struct pair p;
+    char c = 'x';
+
+    pair_open(&p, CAP);
+
+    /* data sent before closing is still received */
+    ck_assert_int_eq(shm_send(&p.client, &c, 1), 1);
+    shm_close(&p.client);
+    ck_assert_int_eq(shm_peer_closed(&p.server), true);
+    ck_assert_int_eq(shm_recv(&p.server, &c, 1), 1);
+    ck_assert_int_eq(shm_recv(&p.server, &c, 1), 0);
+    ck_assert_int_eq(shm_send(&p.server, &c, 1), CC_ERROR);
+
+    shm_close(&p.server);
+    tcp_close(&p.ctl);
+}
+END_TEST
+
+START_TEST(test_server_gone)
+{
+    struct pair p;
+
+    pair_open(&p, CAP);
+
+    /* the client finds out from the control socket even without a close */
+    tcp_close(&p.ctl);
+    ck_assert_int_eq(shm_wait(&p.client, false, 1000), CC_OK);
+    ck_assert_int_eq(shm_peer_closed(&p.client), true);
+
+    shm_close(&p.client);
+    shm_close(&p.server);
+}
+END_TEST
+
+START_TEST(test_attach_invalid)
+{
+    struct tcp_conn listen, client, ctl;
+    struct shm_conn c;
+    char path[64], junk[] = "get foo\r\n";
+
+    test_reset();
+
+    snprintf(path, sizeof(path), "@check_shm.%d", (int)getpid());
+    tcp_conn_reset(&listen);
+    tcp_conn_reset(&client);
+    tcp_conn_reset(&ctl);
+    shm_conn_reset(&c);
+
+    ck_assert_int_eq(unix_listen(path, &listen), true);
+    ck_assert_int_eq(unix_connect(path, &client), true);
+    ck_assert_int_eq(tcp_accept(&listen, &ctl), true);
+
+    ck_assert_int_eq(shm_attach(ctl.sd, &c), CC_EAGAIN);
+    ck_assert_int_eq(tcp_send(&client, junk, sizeof(junk) - 1),
+            sizeof(junk) - 1);
+    ck_assert_int_eq(shm_attach(ctl.sd, &c), CC_ERROR);
+
+    tcp_close(&client);
+    tcp_close(&ctl);
+    tcp_close(&listen);
+}
+END_TEST
+
+/* a copy of segment fd of size bytes, sealed as given, announced as size */
+static int
+copy_segment(int fd, uint32_t size, uint32_t nbyte, int seals)
+{
+    char buf[CAP * 16];
+    int copy;
+
+    ck_assert_int_le(size, sizeof(buf));
+    ck_assert_int_eq(pread(fd, buf, size, 0), size);
+
+    copy = memfd_create("check_shm", MFD_ALLOW_SEALING);
+    ck_assert_int_ge(copy, 0);
+    ck_assert_int_eq(ftruncate(copy, nbyte), 0);
+    ck_assert_int_eq(pwrite(copy, buf, nbyte < size ? nbyte : size, 0),
+            nbyte < size ? nbyte : size);
+    ck_assert_int_eq(fcntl(copy, F_ADD_SEALS, seals), 0);
+
+    return copy;
+}
+
+START_TEST(test_attach_resizable)
+{
+    struct tcp_conn listen, client, ctl;
+    struct shm_conn c, genuine;
+    struct efd_conn bell;
+    char path[64];
+    uint32_t size;
+    int fd, copy;
+
+    test_reset();
+
+    snprintf(path, sizeof(path), "@check_shm.%d", (int)getpid());
+    tcp_conn_reset(&listen);
+    tcp_conn_reset(&client);
+    tcp_conn_reset(&ctl);
+    shm_conn_reset(&c);
+    shm_conn_reset(&genuine);
+    efd_conn_reset(&bell);
+
+    /* take a genuine segment from the client instead of attaching it */
+    ck_assert_int_eq(unix_listen(path, &listen), true);
+    ck_assert_int_eq(shm_connect(path, CAP, &genuine), true);
+    ck_assert_int_eq(tcp_accept(&listen, &ctl), true);
+    fd = recv_segment(ctl.sd, &size);
+    tcp_close(&ctl);
+    ck_assert_int_eq(efd_open(NULL, &bell), true);
+
+    /* which the client cannot resize any more */
+    ck_assert_int_eq(ftruncate(fd, size / 2), -1);
+
+    /* the same segment but not sealed, the client could still shrink it */
+    copy = copy_segment(fd, size, size, 0);
+    ck_assert_int_eq(unix_connect(path, &client), true);
+    ck_assert_int_eq(tcp_accept(&listen, &ctl), true);
+    send_segment(client.sd, copy, size, &bell);
+    ck_assert_int_eq(shm_attach(ctl.sd, &c), CC_ERROR);
+    tcp_close(&client);
+    tcp_close(&ctl);
+    close(copy);
+
+    /* sealed, but shrunk below the size announced before that */
+    copy = copy_segment(fd, size, size / 2, F_SEAL_SHRINK | F_SEAL_GROW);
+    ck_assert_int_eq(unix_connect(path, &client), true);
+    ck_assert_int_eq(tcp_accept(&listen, &ctl), true);
+    send_segment(client.sd, copy, size, &bell);
+    ck_assert_int_eq(shm_attach(ctl.sd, &c), CC_ERROR);
+    tcp_close(&client);
+    tcp_close(&ctl);
+    close(copy);
+
+    /* a sealed copy of the right size is as good as the genuine one */
+    copy = copy_segment(fd, size, size, F_SEAL_SHRINK | F_SEAL_GROW);
+    ck_assert_int_eq(unix_connect(path, &client), true);
+    ck_assert_int_eq(tcp_accept(&listen, &ctl), true);
+    send_segment(client.sd, copy, size, &bell);
+    ck_assert_int_eq(shm_attach(ctl.sd, &c), CC_OK);
+    shm_close(&c);
+    tcp_close(&client);
+    tcp_close(&ctl);
+    close(copy);
+
+    close(fd);
+    efd_close(&bell);
+    shm_close(&genuine);
+    tcp_close(&listen);
+}
+END_TEST
+
+START_TEST(test_attach_blocking_bell)
+{
+    struct tcp_conn listen;
+    struct tcp_conn ctl;
+    struct shm_conn client, server;
+    char path[64];
+    int fd;
+
+    test_reset();
+
+    snprintf(path, sizeof(path), "@check_shm.%d", (int)getpid());
+    tcp_conn_reset(&listen);
+    tcp_conn_reset(&ctl);
+    shm_conn_reset(&client);
+    shm_conn_reset(&server);
+
+    ck_assert_int_eq(unix_listen(path, &listen), true);
+    ck_assert_int_eq(shm_connect(path, CAP, &client), true);
+
+    /* a client handing over doorbells in blocking mode */
+    fd = efd_read_id(&client.peer);
+    ck_assert_int_eq(fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK), 0);
+    fd = efd_read_id(&client.bell);
+    ck_assert_int_eq(fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK), 0);
+
+    ck_assert_int_eq(tcp_accept(&listen, &ctl), true);
+    ck_assert_int_eq(shm_attach(ctl.sd, &server), CC_OK);
+
+    ck_assert(fcntl(efd_read_id(&server.bell), F_GETFL) & O_NONBLOCK);
+    ck_assert(fcntl(efd_write_id(&server.peer), F_GETFL) & O_NONBLOCK);
+
+    /* clearing a doorbell nobody rang returns right away */
+    alarm(5);
+    shm_bell_clear(&server);
+    alarm(0);
+
+    shm_close(&client);
+    shm_close(&server);
+    tcp_close(&ctl);
+    tcp_close(&listen);
+}
+END_TEST
+
+/*
+ * test suite
+ */
+static Suite *
+shm_suite(void)
+{
+    Suite *s = suite_create(SUITE_NAME);
+
+    TCase *tc_shm = tcase_create("shm test");
+    tcase_add_test(tc_shm, test_send_recv);
+    tcase_add_test(tc_shm, test_full_wrap);
+    tcase_add_test(tc_shm, test_wait_prepare);
+    tcase_add_test(tc_shm, test_threads);
+    tcase_add_test(tc_shm, test_close);
+    tcase_add_test(tc_shm, test_server_gone);
+    tcase_add_test(tc_shm, test_attach_invalid);
+    tcase_add_test(tc_shm, test_attach_resizable);
+    tcase_add_test(tc_shm, test_attach_blocking_bell);
+    suite_add_tcase(s, tc_shm);
+
+    return s;
+}
+/**************
+ * test cases *
+ **************/
+
+int
+main(void)
+{
+    int nfail;
+
+    /* setup */
+    test_setup();
+
+    Suite *suite = shm_suite();
+    SRunner *srunner = srunner_create(suite);
+    srunner_set_log(srunner, DEBUG_LOG);
+    srunner_run_all(srunner, CK_ENV); /* set CK_VEBOSITY in ENV to customize */
+    nfail = srunner_ntests_failed(srunner);
+    srunner_free(srunner);
+
+    /* teardown */
+    test_teardown();
+
+    return (nfail == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
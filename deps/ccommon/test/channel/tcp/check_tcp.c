@@ -133,6 +133,40 @@ START_TEST(test_listen_listen)
 }
 END_TEST
 
+START_TEST(test_listen_reuseport)
+{
+    struct tcp_conn *conn_listen, *conn_listen1, *conn_listen2, *conn_client;
+    struct addrinfo *ai;
+
+    test_reset();
+
+    /* find a free port, then release it for the reuseport listeners */
+    find_port_listen(&conn_listen, &ai, NULL);
+    tcp_close(conn_listen);
+    tcp_conn_destroy(&conn_listen);
+
+    conn_listen1 = tcp_conn_create();
+    ck_assert_ptr_ne(conn_listen1, NULL);
+    conn_listen2 = tcp_conn_create();
+    ck_assert_ptr_ne(conn_listen2, NULL);
+    conn_client = tcp_conn_create();
+    ck_assert_ptr_ne(conn_client, NULL);
+
+    ck_assert_int_eq(tcp_listen_reuseport(ai, conn_listen1), true);
+    ck_assert_int_eq(tcp_listen_reuseport(ai, conn_listen2), true);
+    ck_assert_int_eq(tcp_connect(ai, conn_client), true);
+
+    tcp_close(conn_client);
+    tcp_close(conn_listen1);
+    tcp_close(conn_listen2);
+
+    tcp_conn_destroy(&conn_client);
+    tcp_conn_destroy(&conn_listen1);
+    tcp_conn_destroy(&conn_listen2);
+    freeaddrinfo(ai);
+}
+END_TEST
+
 START_TEST(test_client_send_server_recv)
 {
 #define LEN 20
@@ -361,6 +395,7 @@ log_suite(void)
 
     tcase_add_test(tc_log, test_listen_connect);
     tcase_add_test(tc_log, test_listen_listen);
+    tcase_add_test(tc_log, test_listen_reuseport);
     tcase_add_test(tc_log, test_client_send_server_recv);
     tcase_add_test(tc_log, test_server_send_client_recv);
     tcase_add_test(tc_log, test_client_sendv_server_recvv);
@@ -0,0 +1,244 @@
+#include <channel/cc_unix.h>
+#include <cc_util.h>
+
+#include <check.h>
+
+#include <errno.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define SUITE_NAME "unix"
+#define DEBUG_LOG  SUITE_NAME ".log"
+
+/*
+ * utilities
+ */
+static void
+test_setup(void)
+{
+    tcp_setup(0, NULL);
+}
+
+static void
+test_teardown(void)
+{
+    tcp_teardown();
+}
+
+static void
+test_reset(void)
+{
+    test_teardown();
+    test_setup();
+}
+
+static void
+unix_path(char *path, size_t len, bool abstract)
+{
+    snprintf(path, len, "%s/check_unix.%d.sock", abstract ? "@" : "/tmp",
+            (int)getpid());
+}
+
+static void
+send_recv(const char *path)
+{
+#define LEN 20
+    struct tcp_conn *conn_listen, *conn_client, *conn_server;
+    char send_data[LEN];
+    char recv_data[LEN + 1];
+    size_t i;
+    ssize_t recv;
+
+    for (i = 0; i < LEN; i++) {
+        send_data[i] = i % CHAR_MAX;
+    }
+
+    conn_listen = tcp_conn_create();
+    ck_assert_ptr_ne(conn_listen, NULL);
+    conn_client = tcp_conn_create();
+    ck_assert_ptr_ne(conn_client, NULL);
+    conn_server = tcp_conn_create();
+    ck_assert_ptr_ne(conn_server, NULL);
+
+    ck_assert_int_eq(unix_listen(path, conn_listen), true);
+    ck_assert(conn_listen->flags & TCP_CONN_UNIX);
+    ck_assert_int_eq(unix_connect(path, conn_client), true);
+
+    ck_assert_int_eq(tcp_accept(conn_listen, conn_server), true);
+    ck_assert(conn_server->flags & TCP_CONN_UNIX);
+    ck_assert_int_eq(tcp_send(conn_client, send_data, LEN), LEN);
+    while ((recv = tcp_recv(conn_server, recv_data, LEN + 1)) == CC_EAGAIN) {}
+    ck_assert_int_eq(recv, LEN);
+    ck_assert_int_eq(memcmp(send_data, recv_data, LEN), 0);
+
+    tcp_close(conn_listen);
+    tcp_close(conn_client);
+    tcp_close(conn_server);
+
+    tcp_conn_destroy(&conn_listen);
+    tcp_conn_destroy(&conn_client);
+    tcp_conn_destroy(&conn_server);
+#undef LEN
+}
+
+/*
+ * tests
+ */
+START_TEST(test_path)
+{
+    char path[CC_UNIX_ADDRSTRLEN];
+    struct stat st;
+
+    test_reset();
+
+    unix_path(path, sizeof(path), false);
+    send_recv(path);
+
+    /* the socket file outlives the listener, and is replaced by the next */
+    ck_assert_int_eq(stat(path, &st), 0);
+    send_recv(path);
+
+    unix_unlink(path);
+    ck_assert_int_eq(stat(path, &st), -1);
+}
+END_TEST
+
+START_TEST(test_path_in_use)
+{
+    char path[CC_UNIX_ADDRSTRLEN];
+    struct tcp_conn *conn_listen, *conn_other, *conn_client;
+
+    test_reset();
+
+    unix_path(path, sizeof(path), false);
+    conn_listen = tcp_conn_create();
+    ck_assert_ptr_ne(conn_listen, NULL);
+    conn_other = tcp_conn_create();
+    ck_assert_ptr_ne(conn_other, NULL);
+    conn_client = tcp_conn_create();
+    ck_assert_ptr_ne(conn_client, NULL);
+
+    /* a live listener keeps its socket file */
+    ck_assert_int_eq(unix_listen(path, conn_listen), true);
+    ck_assert_int_eq(unix_listen(path, conn_other), false);
+    ck_assert_int_eq(errno, EADDRINUSE);
+    ck_assert_int_eq(unix_connect(path, conn_client), true);
+
+    tcp_close(conn_listen);
+    tcp_close(conn_client);
+    unix_unlink(path);
+
+    tcp_conn_destroy(&conn_listen);
+    tcp_conn_destroy(&conn_other);
+    tcp_conn_destroy(&conn_client);
+}
+END_TEST
+
+START_TEST(test_path_not_socket)
+{
+    char path[CC_UNIX_ADDRSTRLEN];
+    struct tcp_conn *conn_listen;
+    FILE *fp;
+
+    test_reset();
+
+    unix_path(path, sizeof(path), false);
+    fp = fopen(path, "w");
+    ck_assert_ptr_ne(fp, NULL);
+    fclose(fp);
+
+    /* a regular file in the way is neither removed nor listened on */
+    conn_listen = tcp_conn_create();
+    ck_assert_ptr_ne(conn_listen, NULL);
+    ck_assert_int_eq(unix_listen(path, conn_listen), false);
+    ck_assert_int_eq(access(path, F_OK), 0);
+
+    unlink(path);
+    tcp_conn_destroy(&conn_listen);
+}
+END_TEST
+
+START_TEST(test_path_too_long)
+{
+    char path[CC_UNIX_ADDRSTRLEN + 1];
+    struct tcp_conn *conn_listen;
+
+    test_reset();
+
+    memset(path, 'a', CC_UNIX_ADDRSTRLEN);
+    path[CC_UNIX_ADDRSTRLEN] = '\0';
+
+    conn_listen = tcp_conn_create();
+    ck_assert_ptr_ne(conn_listen, NULL);
+    ck_assert_int_eq(unix_listen(path, conn_listen), false);
+    ck_assert_int_eq(unix_listen("", conn_listen), false);
+
+    tcp_conn_destroy(&conn_listen);
+}
+END_TEST
+
+#ifdef OS_LINUX
+START_TEST(test_abstract)
+{
+    char path[CC_UNIX_ADDRSTRLEN];
+
+    test_reset();
+
+    unix_path(path, sizeof(path), true);
+    send_recv(path);
+
+    /* nothing left on the filesystem, and the name is free again */
+    ck_assert_int_eq(access(path + 1, F_OK), -1);
+    send_recv(path);
+}
+END_TEST
+#endif
+
+/*
+ * test suite
+ */
+static Suite *
+unix_suite(void)
+{
+    Suite *s = suite_create(SUITE_NAME);
+
+    TCase *tc_unix = tcase_create("unix test");
+    tcase_add_test(tc_unix, test_path);
+    tcase_add_test(tc_unix, test_path_in_use);
+    tcase_add_test(tc_unix, test_path_not_socket);
+    tcase_add_test(tc_unix, test_path_too_long);
+#ifdef OS_LINUX
+    tcase_add_test(tc_unix, test_abstract);
+#endif
+    suite_add_tcase(s, tc_unix);
+
+    return s;
+}
+/**************
+ * test cases *
+ **************/
+
+int
+main(void)
+{
+    int nfail;
+
+    /* setup */
+    test_setup();
+
+    Suite *suite = unix_suite();
+    SRunner *srunner = srunner_create(suite);
+    srunner_set_log(srunner, DEBUG_LOG);
+    srunner_run_all(srunner, CK_ENV); /* set CK_VEBOSITY in ENV to customize */
+    nfail = srunner_ntests_failed(srunner);
+    srunner_free(srunner);
+
+    /* teardown */
+    test_teardown();
+
+    return (nfail == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
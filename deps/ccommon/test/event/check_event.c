@@ -84,6 +84,90 @@ START_TEST(test_read)
 }
 END_TEST
 
+START_TEST(test_read_edge)
+{
+#define DATA "foo bar baz"
+    struct event_base *event_base;
+    int random_pointer[1] = {1};
+    struct pipe_conn *pipe;
+    char buf[sizeof(DATA)];
+
+    test_reset();
+
+    event_base = event_base_create(1024, log_event);
+
+    pipe = pipe_conn_create();
+    ck_assert_int_eq(pipe_open(NULL, pipe), true);
+    ck_assert_int_eq(pipe_send(pipe, DATA, sizeof(DATA)), sizeof(DATA));
+
+    event_add_read_edge(event_base, pipe_read_id(pipe), random_pointer);
+
+    event_wait(event_base, -1);
+
+    ck_assert_int_eq(event_log_count, 1);
+    ck_assert_ptr_eq(event_log[0].arg, random_pointer);
+    ck_assert_int_eq(event_log[0].events, EVENT_READ);
+
+    /* drained, new data is reported again */
+    ck_assert_int_eq(pipe_recv(pipe, buf, sizeof(buf)), sizeof(DATA));
+    ck_assert_int_eq(pipe_send(pipe, DATA, sizeof(DATA)), sizeof(DATA));
+    event_log_count = 0;
+    event_wait(event_base, 1000);
+
+    ck_assert_int_eq(event_log_count, 1);
+    ck_assert_int_eq(event_log[0].events, EVENT_READ);
+
+    ck_assert_int_eq(event_del(event_base, pipe_read_id(pipe)), 0);
+    event_base_destroy(&event_base);
+    pipe_close(pipe);
+    pipe_conn_destroy(&pipe);
+#undef DATA
+}
+END_TEST
+
+START_TEST(test_read_edge_undrained)
+{
+#define DATA "foo bar baz"
+    struct event_base *event_base;
+    int random_pointer[1] = {1};
+    struct pipe_conn *pipe;
+
+    test_reset();
+
+    event_base = event_base_create(1024, log_event);
+
+    pipe = pipe_conn_create();
+    ck_assert_int_eq(pipe_open(NULL, pipe), true);
+    ck_assert_int_eq(pipe_send(pipe, DATA, sizeof(DATA)), sizeof(DATA));
+
+    event_add_read_edge(event_base, pipe_read_id(pipe), random_pointer);
+
+    event_wait(event_base, -1);
+
+    ck_assert_int_eq(event_log_count, 1);
+
+    /* left unread, and nothing new: unlike level-triggered, no event */
+    event_log_count = 0;
+    event_wait(event_base, 100);
+
+    ck_assert_int_eq(event_log_count, 0);
+
+    /* more data is a new edge */
+    ck_assert_int_eq(pipe_send(pipe, DATA, sizeof(DATA)), sizeof(DATA));
+    event_wait(event_base, 1000);
+
+    ck_assert_int_eq(event_log_count, 1);
+    ck_assert_ptr_eq(event_log[0].arg, random_pointer);
+    ck_assert_int_eq(event_log[0].events, EVENT_READ);
+
+    ck_assert_int_eq(event_del(event_base, pipe_read_id(pipe)), 0);
+    event_base_destroy(&event_base);
+    pipe_close(pipe);
+    pipe_conn_destroy(&pipe);
+#undef DATA
+}
+END_TEST
+
 START_TEST(test_cannot_read)
 {
     struct event_base *event_base;
@@ -155,6 +239,8 @@ event_suite(void)
     suite_add_tcase(s, tc_event);
 
     tcase_add_test(tc_event, test_read);
+    tcase_add_test(tc_event, test_read_edge);
+    tcase_add_test(tc_event, test_read_edge_undrained);
     tcase_add_test(tc_event, test_cannot_read);
     tcase_add_test(tc_event, test_write);
 
@@ -2,8 +2,11 @@
 
 #include <check.h>
 
+#include <pthread.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #define SUITE_NAME "log"
 #define DEBUG_LOG  SUITE_NAME ".log"
@@ -240,6 +243,135 @@ START_TEST(test_write_skip_metrics)
 }
 END_TEST
 
+#define NTHREAD 4
+#define NWRITE  100
+#define LOGSTR  "foo bar baz\n"
+
+static pthread_barrier_t *write_barrier = NULL;
+
+static void *
+_write_thread(void *arg)
+{
+    struct logger *logger = arg;
+    int i;
+
+    for (i = 0; i < NWRITE; i++) {
+        log_write(logger, LOGSTR, sizeof(LOGSTR) - 1);
+    }
+
+    /* stay alive until all have written, if asked to */
+    if (write_barrier != NULL) {
+        pthread_barrier_wait(write_barrier);
+    }
+
+    return NULL;
+}
+
+static off_t
+_file_size(const char *tmpname)
+{
+    struct stat st;
+
+    ck_assert_int_eq(stat(tmpname, &st), 0);
+
+    return st.st_size;
+}
+
+START_TEST(test_write_threads)
+{
+    struct logger *logger;
+    pthread_t tid[NTHREAD];
+    pthread_barrier_t barrier;
+    char *tmpname = tmpname_create();
+    int i, nbuf = 0;
+
+    test_reset();
+
+    logger = log_create(tmpname, NTHREAD * NWRITE * sizeof(LOGSTR));
+    pthread_barrier_init(&barrier, NULL, NTHREAD);
+    write_barrier = &barrier;
+    for (i = 0; i < NTHREAD; i++) {
+        pthread_create(&tid[i], NULL, _write_thread, logger);
+    }
+    for (i = 0; i < NTHREAD; i++) {
+        pthread_join(tid[i], NULL);
+    }
+    write_barrier = NULL;
+    pthread_barrier_destroy(&barrier);
+
+    /* each thread wrote to a ring of its own */
+    for (i = 0; i < LOG_NBUF; i++) {
+        nbuf += logger->buf[i] != NULL;
+    }
+    ck_assert_int_eq(nbuf, NTHREAD);
+    ck_assert_uint_eq(metrics.log_skip.counter, 0);
+
+    ck_assert_uint_eq(log_flush(logger), NTHREAD * NWRITE * (sizeof(LOGSTR) - 1));
+    ck_assert_int_eq(_file_size(tmpname), NTHREAD * NWRITE * (sizeof(LOGSTR) - 1));
+
+    log_destroy(&logger);
+    tmpname_destroy(tmpname);
+}
+END_TEST
+
+START_TEST(test_write_threads_reuse)
+{
+    struct logger *logger;
+    pthread_t tid;
+    char *tmpname = tmpname_create();
+    int i;
+
+    test_reset();
+
+    /* threads that have exited hand their ring over to the next one */
+    logger = log_create(tmpname, 2 * LOG_NBUF * NWRITE * sizeof(LOGSTR));
+    for (i = 0; i < 2 * LOG_NBUF; i++) {
+        pthread_create(&tid, NULL, _write_thread, logger);
+        pthread_join(tid, NULL);
+    }
+
+    ck_assert_ptr_ne(logger->buf[0], NULL);
+    for (i = 1; i < LOG_NBUF; i++) {
+        ck_assert_ptr_eq(logger->buf[i], NULL);
+    }
+    ck_assert_uint_eq(log_flush(logger),
+            2 * LOG_NBUF * NWRITE * (sizeof(LOGSTR) - 1));
+
+    log_destroy(&logger);
+    tmpname_destroy(tmpname);
+}
+END_TEST
+
+START_TEST(test_flusher)
+{
+    struct logger *logger;
+    char *tmpname = tmpname_create();
+    int i;
+
+    test_reset();
+
+    logger = log_create(tmpname, 1024);
+    ck_assert_int_eq(log_flusher_start(logger, 10), CC_OK);
+
+    ck_assert_int_eq(log_write(logger, LOGSTR, sizeof(LOGSTR) - 1), 1);
+    for (i = 0; i < 100 && _file_size(tmpname) == 0; i++) {
+        usleep(10000);
+    }
+    assert_file_contents(tmpname, LOGSTR, sizeof(LOGSTR) - 1);
+
+    /* destroy stops the flusher and flushes what is left */
+    ck_assert_int_eq(log_write(logger, LOGSTR, sizeof(LOGSTR) - 1), 1);
+    log_destroy(&logger);
+    ck_assert_int_eq(_file_size(tmpname), 2 * (sizeof(LOGSTR) - 1));
+
+    tmpname_destroy(tmpname);
+}
+END_TEST
+
+#undef LOGSTR
+#undef NWRITE
+#undef NTHREAD
+
 /*
  * test suite
  */
@@ -261,6 +393,9 @@ log_suite(void)
     tcase_add_test(tc_log, test_write_metrics_file_nobuf);
     tcase_add_test(tc_log, test_write_metrics_stderr_nobuf);
     tcase_add_test(tc_log, test_write_skip_metrics);
+    tcase_add_test(tc_log, test_write_threads);
+    tcase_add_test(tc_log, test_write_threads_reuse);
+    tcase_add_test(tc_log, test_flusher);
 
     return s;
 }
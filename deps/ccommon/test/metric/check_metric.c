@@ -2,8 +2,10 @@
 
 #include <check.h>
 
+#include <pthread.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #define SUITE_NAME "metric"
 #define DEBUG_LOG  SUITE_NAME ".log"
@@ -11,7 +13,8 @@
 #define TEST_METRIC(ACTION)                                \
     ACTION( c,       METRIC_COUNTER, "# counter"    )\
     ACTION( g,       METRIC_GAUGE,   "# gauge"      )\
-    ACTION( f,       METRIC_FPN,     "value"        )
+    ACTION( f,       METRIC_FPN,     "value"        )\
+    ACTION( h,       METRIC_HISTOGRAM, "latency"    )
 
 typedef struct {
         TEST_METRIC(METRIC_DECLARE)
@@ -36,6 +39,8 @@ test_setup(void)
 static void
 test_teardown(void)
 {
+    metric_teardown((struct metric *)test_metrics,
+            METRIC_CARDINALITY(*test_metrics));
 }
 
 static void
@@ -94,6 +99,257 @@ START_TEST(test_fpn)
 }
 END_TEST
 
+START_TEST(test_histogram_bucket)
+{
+    uint64_t v;
+    unsigned int i;
+
+    /* small values are exact */
+    for (v = 0; v < (1 << HISTO_SUB_BITS); v++) {
+        ck_assert_uint_eq(metric_histo_bucket(v), v);
+        ck_assert_uint_eq(metric_histo_value(v), v);
+    }
+
+    /* buckets are contiguous and never wider than 1/2^HISTO_SUB_BITS */
+    for (i = 1 << HISTO_SUB_BITS; i < HISTO_NBUCKET; i++) {
+        v = metric_histo_value(i - 1) + 1;
+        ck_assert_uint_eq(metric_histo_bucket(v), i);
+        ck_assert_uint_eq(metric_histo_bucket(metric_histo_value(i)), i);
+        ck_assert_uint_le((metric_histo_value(i) - v) << HISTO_SUB_BITS, v);
+    }
+
+    /* values out of range end up in the last bucket */
+    ck_assert_uint_eq(metric_histo_bucket(UINT64_MAX), HISTO_NBUCKET - 1);
+}
+END_TEST
+
+START_TEST(test_histogram)
+{
+#define BUF_LEN 512
+    char buf[BUF_LEN];
+    uint64_t v;
+
+    test_reset();
+
+    ck_assert_uint_eq(metric_histo_count(&test_metrics->h), 0);
+    ck_assert_uint_eq(metric_histo_percentile(&test_metrics->h, 99.0), 0);
+
+    for (v = 1; v <= 10000; v++) {
+        RECORD(test_metrics, h, v);
+    }
+    /* wrong type, ignored */
+    RECORD(test_metrics, c, 1);
+    INCR(test_metrics, h);
+
+    ck_assert_uint_eq(metric_histo_count(&test_metrics->h), 10000);
+    v = metric_histo_percentile(&test_metrics->h, 50.0);
+    ck_assert_uint_ge(v, 5000);
+    ck_assert_uint_le(v, 5000 + 5000 / (1 << HISTO_SUB_BITS));
+    v = metric_histo_percentile(&test_metrics->h, 99.9);
+    ck_assert_uint_ge(v, 9990);
+    ck_assert_uint_le(v, 9990 + 9990 / (1 << HISTO_SUB_BITS));
+    ck_assert_uint_ge(metric_histo_percentile(&test_metrics->h, 100.0), 10000);
+    ck_assert_uint_eq(metric_counter(&test_metrics->c), 0);
+
+    ck_assert_uint_eq(metric_nline((struct metric *)test_metrics,
+            METRIC_CARDINALITY(*test_metrics)), 9);
+    metric_print(buf, BUF_LEN, "%s %s\n", &test_metrics->h);
+    ck_assert_str_eq(buf, "h 10000\nh_p50 5119\nh_p90 9215\nh_p99 9983\n"
+            "h_p999 10239\nh_max 10239\n");
+
+    metric_reset((struct metric *)test_metrics,
+            METRIC_CARDINALITY(*test_metrics));
+    ck_assert_uint_eq(metric_histo_count(&test_metrics->h), 0);
+
+    /* buckets are freed, and come back on the next record */
+    metric_teardown((struct metric *)test_metrics,
+            METRIC_CARDINALITY(*test_metrics));
+    ck_assert_ptr_eq(test_metrics->h.histo, NULL);
+    ck_assert_uint_eq(metric_histo_count(&test_metrics->h), 0);
+    RECORD(test_metrics, h, 1);
+    ck_assert_ptr_ne(test_metrics->h.histo, NULL);
+    ck_assert_uint_eq(metric_histo_count(&test_metrics->h), 1);
+#undef BUF_LEN
+}
+END_TEST
+
+START_TEST(test_json)
+{
+#define BUF_LEN 256
+    char buf[BUF_LEN];
+    uint64_t prev[METRIC_CARDINALITY(test_metrics_st)] = {0};
+    struct metric *metrics = (struct metric *)test_metrics;
+    unsigned int n = METRIC_CARDINALITY(*test_metrics);
+
+    test_reset();
+
+    INCR_N(test_metrics, c, 3);
+    DECR(test_metrics, g);
+    UPDATE_VAL(test_metrics, f, 1.5);
+    RECORD(test_metrics, h, 7);
+
+    ck_assert_uint_eq(metric_json(buf, BUF_LEN, metrics, n, NULL, 0, NULL),
+            strlen(buf));
+    ck_assert_str_eq(buf, "{\"c\":3,\"g\":-1,\"f\":1.500000,\"h\":{\"n\":1,"
+            "\"p50\":7,\"p90\":7,\"p99\":7,\"p999\":7,\"max\":7}}");
+
+    metric_json(buf, BUF_LEN, metrics, n, "g", 1, NULL);
+    ck_assert_str_eq(buf, "{\"g\":-1}");
+
+    /* delta: everything that moved off zero, then only what changed */
+    metric_json(buf, BUF_LEN, metrics, n, "c", 1, prev);
+    ck_assert_str_eq(buf, "{\"c\":3}");
+    metric_json(buf, BUF_LEN, metrics, n, NULL, 0, prev);
+    ck_assert_str_eq(buf, "{\"g\":-1,\"f\":1.500000,\"h\":{\"n\":1,"
+            "\"p50\":7,\"p90\":7,\"p99\":7,\"p999\":7,\"max\":7}}");
+    metric_json(buf, BUF_LEN, metrics, n, NULL, 0, prev);
+    ck_assert_str_eq(buf, "{}");
+    INCR(test_metrics, c);
+    metric_json(buf, BUF_LEN, metrics, n, NULL, 0, prev);
+    ck_assert_str_eq(buf, "{\"c\":4}");
+
+    /* too small a buffer cuts the object short, and the rest stays pending */
+    INCR(test_metrics, c);
+    INCR(test_metrics, g);
+    ck_assert_uint_eq(metric_json(buf, 10, metrics, n, NULL, 0, prev), 7);
+    ck_assert_str_eq(buf, "{\"c\":5}");
+    metric_json(buf, BUF_LEN, metrics, n, NULL, 0, prev);
+    ck_assert_str_eq(buf, "{\"g\":0}");
+#undef BUF_LEN
+}
+END_TEST
+
+static void *
+do_count(void *arg)
+{
+    int i, n = *(int *)arg;
+
+    ck_assert_uint_ne(metric_shard_claim(), 0);
+    for (i = 0; i < n; i++) {
+        INCR(test_metrics, c);
+        INCR_N(test_metrics, g, 2);
+        DECR(test_metrics, g);
+    }
+
+    return NULL;
+}
+
+START_TEST(test_shard)
+{
+#define NTHREAD 3
+#define NCOUNT 100000
+#define BUF_LEN 64
+    pthread_t thread[NTHREAD];
+    int i, n = NCOUNT;
+    char buf[BUF_LEN];
+
+    test_reset();
+
+    /* the test thread stays on the shared value */
+    INCR(test_metrics, c);
+    DECR(test_metrics, g);
+    for (i = 0; i < NTHREAD; i++) {
+        pthread_create(&thread[i], NULL, do_count, &n);
+    }
+    for (i = 0; i < NTHREAD; i++) {
+        pthread_join(thread[i], NULL);
+    }
+
+    ck_assert_int_eq(test_metrics->c.counter, 1);
+    ck_assert_uint_ne(test_metrics->c.slot, 0);
+    ck_assert_uint_ne(test_metrics->g.slot, test_metrics->c.slot);
+    ck_assert_uint_eq(metric_counter(&test_metrics->c), NTHREAD * NCOUNT + 1);
+    ck_assert_int_eq(metric_gauge(&test_metrics->g), NTHREAD * NCOUNT - 1);
+
+    metric_print(buf, BUF_LEN, "%s %s", &test_metrics->g);
+    ck_assert_str_eq(buf, "g 299999");
+
+    /* an update sets the total, regardless of what is in the shards */
+    UPDATE_VAL(test_metrics, g, -2);
+    ck_assert_int_eq(metric_gauge(&test_metrics->g), -2);
+    INCR(test_metrics, g);
+    ck_assert_int_eq(metric_gauge(&test_metrics->g), -1);
+
+    metric_reset((struct metric *)test_metrics,
+            METRIC_CARDINALITY(*test_metrics));
+    ck_assert_uint_eq(metric_counter(&test_metrics->c), 0);
+    ck_assert_int_eq(metric_gauge(&test_metrics->g), 0);
+#undef NTHREAD
+#undef NCOUNT
+#undef BUF_LEN
+}
+END_TEST
+
+struct reset_step {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int step;
+};
+
+static void
+reset_step_wait(struct reset_step *s, int step)
+{
+    pthread_mutex_lock(&s->lock);
+    while (s->step < step) {
+        pthread_cond_wait(&s->cond, &s->lock);
+    }
+    pthread_mutex_unlock(&s->lock);
+}
+
+static void
+reset_step_next(struct reset_step *s)
+{
+    pthread_mutex_lock(&s->lock);
+    s->step++;
+    pthread_cond_broadcast(&s->cond);
+    pthread_mutex_unlock(&s->lock);
+}
+
+/* count into a shard, then again once the other thread has reset */
+static void *
+do_count_reset(void *arg)
+{
+    struct reset_step *s = arg;
+
+    ck_assert_uint_ne(metric_shard_claim(), 0);
+    INCR_N(test_metrics, c, 10);
+    INCR_N(test_metrics, g, 10);
+    reset_step_next(s);
+    reset_step_wait(s, 2);
+    INCR_N(test_metrics, c, 3);
+    DECR(test_metrics, g);
+
+    return NULL;
+}
+
+/*
+ * a reset from a thread other than the shard owner leaves the shard alone,
+ * what the owner counts afterwards adds up from zero
+ */
+START_TEST(test_reset_shard)
+{
+    struct reset_step s = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER,
+        0};
+    pthread_t thread;
+
+    test_reset();
+
+    pthread_create(&thread, NULL, do_count_reset, &s);
+    reset_step_wait(&s, 1);
+    ck_assert_uint_eq(metric_counter(&test_metrics->c), 10);
+
+    metric_reset((struct metric *)test_metrics,
+            METRIC_CARDINALITY(*test_metrics));
+    ck_assert_uint_eq(metric_counter(&test_metrics->c), 0);
+    ck_assert_int_eq(metric_gauge(&test_metrics->g), 0);
+    reset_step_next(&s);
+    pthread_join(thread, NULL);
+
+    ck_assert_uint_eq(metric_counter(&test_metrics->c), 3);
+    ck_assert_int_eq(metric_gauge(&test_metrics->g), -1);
+}
+END_TEST
+
 /*
  * test suite
  */
@@ -109,6 +365,11 @@ metric_suite(void)
     tcase_add_test(tc_metric, test_counter);
     tcase_add_test(tc_metric, test_gauge);
     tcase_add_test(tc_metric, test_fpn);
+    tcase_add_test(tc_metric, test_shard);
+    tcase_add_test(tc_metric, test_reset_shard);
+    tcase_add_test(tc_metric, test_histogram_bucket);
+    tcase_add_test(tc_metric, test_histogram);
+    tcase_add_test(tc_metric, test_json);
 
     return s;
 }
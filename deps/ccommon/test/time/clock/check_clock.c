@@ -0,0 +1,121 @@
+#include <time/cc_clock.h>
+
+#include <check.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define SUITE_NAME "clock"
+#define DEBUG_LOG  SUITE_NAME ".log"
+
+/*
+ * utilities
+ */
+static void
+test_setup(void)
+{
+}
+
+static void
+test_teardown(void)
+{
+}
+
+/*
+ * tests
+ */
+START_TEST(test_update)
+{
+    time_t t;
+
+    clock_update();
+    t = time(NULL);
+
+    /* the coarse clock may lag the regular one by a tick */
+    ck_assert_int_le(clock_sec(), t);
+    ck_assert_int_ge(clock_sec(), t - 1);
+    ck_assert_uint_eq(clock_ms() / 1000, (uint64_t)clock_sec());
+    ck_assert_uint_eq(clock_ns() / 1000000, clock_ms());
+}
+END_TEST
+
+START_TEST(test_cached)
+{
+    uint64_t ns;
+
+    clock_update();
+    ns = clock_ns();
+    ck_assert_uint_eq(clock_ns(), ns);
+
+    nanosleep(&(struct timespec){0, 20000000}, NULL);
+    ck_assert_uint_eq(clock_ns(), ns);
+
+    clock_update();
+    ck_assert_uint_gt(clock_ns(), ns);
+}
+END_TEST
+
+START_TEST(test_format)
+{
+    struct clock_fmt cf = { .fmt = "%Y-%m-%d %T" };
+    char buf[CLOCK_FMT_LEN], expect[CLOCK_FMT_LEN];
+    time_t t = 1000000000;
+    size_t len;
+
+    len = strftime(expect, CLOCK_FMT_LEN, cf.fmt, localtime(&t));
+    ck_assert_uint_eq(clock_format(&cf, buf, sizeof(buf), t), len);
+    ck_assert_int_eq(memcmp(buf, expect, len), 0);
+
+    /* reused within the same second, redone for the next */
+    ck_assert_uint_eq(cf.sec, t);
+    ck_assert_uint_eq(clock_format(&cf, buf, sizeof(buf), t), len);
+    ck_assert_uint_eq(clock_format(&cf, buf, sizeof(buf), t + 1), len);
+    ck_assert_uint_eq(cf.sec, t + 1);
+    len = strftime(expect, CLOCK_FMT_LEN, cf.fmt, localtime(&(time_t){t + 1}));
+    ck_assert_int_eq(memcmp(buf, expect, len), 0);
+
+    /* no room */
+    ck_assert_uint_eq(clock_format(&cf, buf, len, t + 1), 0);
+}
+END_TEST
+
+/*
+ * test suite
+ */
+static Suite *
+clock_suite(void)
+{
+    Suite *s = suite_create(SUITE_NAME);
+
+    TCase *tc_clock = tcase_create("clock test");
+    suite_add_tcase(s, tc_clock);
+
+    tcase_add_test(tc_clock, test_update);
+    tcase_add_test(tc_clock, test_cached);
+    tcase_add_test(tc_clock, test_format);
+
+    return s;
+}
+
+int
+main(void)
+{
+    int nfail;
+
+    /* setup */
+    test_setup();
+
+    Suite *suite = clock_suite();
+    SRunner *srunner = srunner_create(suite);
+    srunner_set_log(srunner, DEBUG_LOG);
+    srunner_run_all(srunner, CK_ENV); /* set CK_VEBOSITY in ENV to customize */
+    nfail = srunner_ntests_failed(srunner);
+    srunner_free(srunner);
+
+    /* teardown */
+    test_teardown();
+
+    return (nfail == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -8,6 +8,7 @@
 #include <buffer/cc_buf.h>
 #include <buffer/cc_dbuf.h>
 #include <cc_event.h>
+#include <cc_metric.h>
 #include <channel/cc_channel.h>
 #include <channel/cc_tcp.h>
 #include <stream/cc_sockio.h>
@@ -330,6 +331,8 @@ _admin_evwait(void)
 void *
 core_admin_evloop(void *arg)
 {
+    metric_shard_claim();
+
     for(;;) {
         if (_admin_evwait() != CC_OK) {
             log_crit("admin loop exited due to failure");
@@ -0,0 +1,79 @@
+#include <core/admin/stats_json.h>
+
+#include <protocol/admin/admin_include.h>
+#include <util/procinfo.h>
+
+#include <cc_debug.h>
+#include <cc_mm.h>
+
+#define STATS_JSON_MODULE_NAME "core::admin::stats_json"
+
+static bool stats_json_init = false;
+static struct metric *stats_metrics = NULL;
+static unsigned int stats_nmetric = 0;
+static uint64_t *stats_prev = NULL; /* values at the last stats delta */
+
+void
+admin_stats_json_setup(struct metric *metrics, unsigned int nmetric)
+{
+    log_info("set up the %s module", STATS_JSON_MODULE_NAME);
+    if (stats_json_init) {
+        log_warn("%s has already been setup, overwrite",
+                 STATS_JSON_MODULE_NAME);
+        cc_free(stats_prev);
+    }
+
+    stats_metrics = metrics;
+    stats_nmetric = nmetric;
+    stats_prev = cc_zalloc(nmetric * sizeof(uint64_t));
+    /* TODO: check return status of cc_zalloc */
+
+    stats_json_init = true;
+}
+
+void
+admin_stats_json_teardown(void)
+{
+    log_info("tear down the %s module", STATS_JSON_MODULE_NAME);
+    if (!stats_json_init) {
+        log_warn("%s has never been setup", STATS_JSON_MODULE_NAME);
+    }
+
+    cc_free(stats_prev);
+    stats_prev = NULL;
+    stats_metrics = NULL;
+    stats_nmetric = 0;
+    stats_json_init = false;
+}
+
+bool
+admin_stats_json(struct response *rsp, struct bstring *sub, struct bstring *arg,
+        char *buf, size_t cap)
+{
+    struct bstring prefix;
+    bool delta;
+    size_t len;
+
+    ASSERT(cap > CRLF_LEN);
+
+    if (bstring_compare(sub, &str2bstr(STATS_JSON)) == 0) {
+        delta = false;
+    } else if (bstring_compare(sub, &str2bstr(STATS_DELTA)) == 0) {
+        delta = true;
+    } else {
+        return false;
+    }
+
+    admin_parse_arg(arg, &prefix);
+
+    procinfo_update();
+    len = metric_json(buf, cap - CRLF_LEN, stats_metrics, stats_nmetric,
+            prefix.data, prefix.len, delta ? stats_prev : NULL);
+    cc_memcpy(buf + len, CRLF, CRLF_LEN);
+
+    rsp->type = RSP_GENERIC;
+    rsp->data.data = buf;
+    rsp->data.len = len + CRLF_LEN;
+
+    return true;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+/*
+ * The JSON snapshots of stats shared by all servers on the admin port:
+ *
+ * stats json [prefix]: all metrics, or those named with the prefix, in JSON
+ * stats delta [prefix]: same, but only metrics changed since the last delta
+ */
+
+#include <cc_bstring.h>
+#include <cc_metric.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define STATS_JSON "json"
+#define STATS_DELTA "delta"
+
+struct response;
+
+void admin_stats_json_setup(struct metric *metrics, unsigned int nmetric);
+void admin_stats_json_teardown(void);
+
+/*
+ * Reply to stats sub with a snapshot written to buf of size cap, taking the
+ * prefix from what is left of the arguments in arg. Returns false, leaving rsp
+ * alone, if sub is neither json nor delta.
+ */
+bool admin_stats_json(struct response *rsp, struct bstring *sub,
+        struct bstring *arg, char *buf, size_t cap);
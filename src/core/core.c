@@ -4,7 +4,7 @@
 
 #include <cc_debug.h>
 #include <cc_ring_array.h>
-#include <channel/cc_pipe.h>
+#include <channel/cc_eventfd.h>
 
 #include <errno.h>
 #include <fcntl.h>
@@ -31,23 +31,38 @@ core_setup(admin_options_st *opt_admin,
         server_options_st *opt_server, worker_options_st *opt_worker,
         server_metrics_st *smetrics, worker_metrics_st *wmetrics)
 {
-    pipe_c = pipe_conn_create();
-    if (pipe_c == NULL) {
-        log_error("Could not create connection for pipe, abort");
-        goto error;
-    }
+    bool reuseport = false;
+    bool unix_sock = false;
 
-    if (!pipe_open(NULL, pipe_c)) {
-        log_error("Could not open pipe connection: %s", strerror(pipe_c->err));
-        goto error;
+    if (opt_server != NULL) {
+        reuseport = option_bool(&opt_server->server_reuseport);
+        unix_sock = option_str(&opt_server->server_unix_path) != NULL ||
+            option_str(&opt_server->server_shm_path) != NULL;
     }
 
-    pipe_set_nonblocking(pipe_c);
-
-    conn_arr = ring_array_create(sizeof(struct buf_sock *), RING_ARRAY_DEFAULT_CAP);
-    if (conn_arr == NULL) {
-        log_error("core setup failed: could not allocate conn array");
-        goto error;
+    /* in reuseport mode the worker accepts connections on its own listener,
+     * so there is no connection handoff between the server and the worker,
+     * unless the server also listens on a unix domain socket
+     */
+    if (!reuseport || unix_sock) {
+        efd_c = efd_conn_create();
+        if (efd_c == NULL) {
+            log_error("Could not create connection for eventfd, abort");
+            goto error;
+        }
+
+        if (!efd_open(NULL, efd_c)) {
+            log_error("Could not open eventfd connection: %s", strerror(efd_c->err));
+            goto error;
+        }
+
+        efd_set_nonblocking(efd_c);
+
+        conn_arr = ring_array_create(sizeof(struct buf_sock *), RING_ARRAY_DEFAULT_CAP);
+        if (conn_arr == NULL) {
+            log_error("core setup failed: could not allocate conn array");
+            goto error;
+        }
     }
 
     core_server_setup(opt_server, smetrics);
@@ -70,7 +85,9 @@ core_teardown(void)
     core_server_teardown();
 
     ring_array_destroy(conn_arr);
-    pipe_conn_destroy(&pipe_c);
+    conn_arr = NULL;
+    efd_close(efd_c);
+    efd_conn_destroy(&efd_c);
 
     core_init = false;
 }
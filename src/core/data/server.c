@@ -8,10 +8,12 @@
 
 #include <cc_debug.h>
 #include <cc_event.h>
+#include <cc_metric.h>
 #include <cc_ring_array.h>
 #include <channel/cc_channel.h>
-#include <channel/cc_pipe.h>
+#include <channel/cc_eventfd.h>
 #include <channel/cc_tcp.h>
+#include <channel/cc_unix.h>
 #include <stream/cc_sockio.h>
 
 #include <errno.h>
@@ -31,6 +33,12 @@ static channel_handler_st *hdl = &handlers;
 
 static struct addrinfo *server_ai;
 static struct buf_sock *server_sock; /* server buf_sock */
+static struct buf_sock *server_unix_sock; /* unix domain socket listener */
+static char *server_unix_path;
+static struct buf_sock *server_shm_sock; /* listener for shm channels */
+static char *server_shm_path;
+static uint64_t nconn_pending = 0; /* # conns the worker is yet to be told of */
+static bool notify_retry = false; /* retry the notification on the next loop */
 
 static inline void
 _server_close(struct buf_sock *s)
@@ -43,28 +51,44 @@ _server_close(struct buf_sock *s)
     buf_sock_return(&s);
 }
 
+/*
+ * Notify the worker of n new connections. Notifications add up in the eventfd
+ * counter until the worker reads it, so a burst of accepts costs one write. If
+ * the write cannot be done now, the count is kept and retried on write event,
+ * or if it failed outright, after the next event wait returns, which is at most
+ * the server timeout away: the connections are already queued for the worker,
+ * and only it can take them off the queue.
+ */
 static inline void
-_server_pipe_write(void)
+_server_notify(uint64_t n)
 {
-    ASSERT(pipe_c != NULL);
+    rstatus_i status;
 
-    ssize_t status = pipe_send(pipe_c, "", 1);
+    ASSERT(efd_c != NULL);
 
-    if (status == 0 || status == CC_EAGAIN) {
-        /* retry write */
-        log_verb("server core: retry send on pipe");
-        event_add_write(ctx->evb, pipe_write_id(pipe_c), NULL);
-    } else if (status == CC_ERROR) {
-        /* other reasn write can't be done */
-        log_error("could not write to pipe - %s", strerror(pipe_c->err));
+    nconn_pending += n;
+    if (nconn_pending == 0) {
+        return;
     }
 
-    /* else, pipe write succeeded and no action needs to be taken */
+    status = efd_send(efd_c, nconn_pending);
+    if (status == CC_OK) {
+        nconn_pending = 0;
+    } else if (status == CC_EAGAIN) {
+        /* retry write */
+        log_verb("server core: retry send on eventfd");
+        event_add_write(ctx->evb, efd_write_id(efd_c), NULL);
+    } else {
+        log_error("could not write to eventfd - %s, %"PRIu64" conns pending, "
+                "retry in %d ms", strerror(efd_c->err), nconn_pending,
+                ctx->timeout);
+        notify_retry = true;
+    }
 }
 
 /* returns true if a connection is present, false if no more pending */
 static inline bool
-_tcp_accept(struct buf_sock *ss)
+_tcp_accept(struct buf_sock *ss, uint64_t *nconn)
 {
     struct buf_sock *s;
     struct tcp_conn *sc = ss->ch;
@@ -78,13 +102,18 @@ _tcp_accept(struct buf_sock *ss)
     }
 
     if (!ss->hdl->accept(sc, s->ch)) {
+        buf_sock_return(&s);
         return false;
     }
 
     /* push buf_sock to queue */
-    ring_array_push(&s, conn_arr);
-
-    _server_pipe_write();
+    if (ring_array_push(&s, conn_arr) != CC_OK) {
+        log_warn("connection queue is full, close new connection");
+        ss->hdl->term(s->ch);
+        buf_sock_return(&s);
+        return true;
+    }
+    (*nconn)++;
 
     return true;
 }
@@ -94,9 +123,16 @@ _server_event_read(struct buf_sock *s)
 {
     struct tcp_conn *c = s->ch;
 
+    uint64_t nconn = 0;
+
     ASSERT(c->level == CHANNEL_META);
 
-    while (_tcp_accept(s));
+    /* accept all pending connections, then ring the worker once for all */
+    while (_tcp_accept(s, &nconn));
+
+    if (nconn > 0) {
+        _server_notify(nconn);
+    }
 }
 
 static void
@@ -121,15 +157,58 @@ _server_event(void *arg, uint32_t events)
     }
 
     if (events & EVENT_WRITE) {
-        /* the only server write event is write on pipe */
+        /* the only server write event is write on eventfd */
 
         log_verb("processing server write event");
-        _server_pipe_write();
+        event_del(ctx->evb, efd_write_id(efd_c));
+        _server_notify(0);
 
         INCR(server_metrics, server_event_write);
     }
 }
 
+/*
+ * Listen on a unix domain socket. Connections accepted on it are tcp_conn as
+ * well, with the listener's flags, and are handed to the worker the same way
+ * regardless of reuseport.
+ */
+static struct buf_sock *
+_server_listen_unix(const char *path, unsigned flags)
+{
+    struct buf_sock *s;
+
+    s = buf_sock_borrow();
+    if (s == NULL) {
+        log_crit("failed to setup server core; could not get buf_sock");
+        return NULL;
+    }
+
+    s->hdl = hdl;
+    if (!unix_listen(path, s->ch)) {
+        log_crit("server unix socket setup on '%s' failed", path);
+        buf_sock_return(&s);
+        return NULL;
+    }
+    s->ch->flags |= flags;
+    s->ch->level = CHANNEL_META;
+    event_add_read(ctx->evb, hdl->rid(s->ch), s);
+
+    return s;
+}
+
+static void
+_server_close_unix(struct buf_sock **s, char **path)
+{
+    if (*s == NULL) {
+        return;
+    }
+
+    tcp_close((*s)->ch);
+    unix_unlink(*path);
+    buf_sock_return(s);
+    *path = NULL;
+}
+
 void
 core_server_setup(server_options_st *options, server_metrics_st *metrics)
 {
@@ -138,6 +217,9 @@ core_server_setup(server_options_st *options, server_metrics_st *metrics)
     char *port = SERVER_PORT;
     int timeout = SERVER_TIMEOUT;
     int nevent = SERVER_NEVENT;
+    bool reuseport = SERVER_REUSEPORT;
+    char *unix_path = SERVER_UNIX_PATH;
+    char *shm_path = SERVER_SHM_PATH;
 
     log_info("set up the %s module", SERVER_MODULE_NAME);
 
@@ -153,6 +235,9 @@ core_server_setup(server_options_st *options, server_metrics_st *metrics)
         port = option_str(&options->server_port);
         timeout = option_uint(&options->server_timeout);
         nevent = option_uint(&options->server_nevent);
+        reuseport = option_bool(&options->server_reuseport);
+        unix_path = option_str(&options->server_unix_path);
+        shm_path = option_str(&options->server_shm_path);
     }
 
     ctx->timeout = timeout;
@@ -164,7 +249,11 @@ core_server_setup(server_options_st *options, server_metrics_st *metrics)
 
     hdl->accept = (channel_accept_fn)tcp_accept;
     hdl->reject = (channel_reject_fn)tcp_reject;
-    hdl->open = (channel_open_fn)tcp_listen;
+    if (reuseport) {
+        hdl->open = (channel_open_fn)tcp_listen_reuseport;
+    } else {
+        hdl->open = (channel_open_fn)tcp_listen;
+    }
     hdl->term = (channel_term_fn)tcp_close;
     hdl->recv = (channel_recv_fn)tcp_recv;
     hdl->send = (channel_send_fn)tcp_send;
@@ -198,7 +287,36 @@ core_server_setup(server_options_st *options, server_metrics_st *metrics)
     }
     c->level = CHANNEL_META;
 
-    event_add_read(ctx->evb, hdl->rid(c), server_sock);
+    /* In reuseport mode the listener is handed over to the worker, which
+     * accepts and serves connections on its own thread. Other listeners, e.g.
+     * of other processes, can bind to the same address with SO_REUSEPORT and
+     * the kernel spreads new connections among them.
+     */
+    if (reuseport) {
+        log_info("server listener on sd %d handed to worker", c->sd);
+        worker_listener = server_sock;
+    } else {
+        event_add_read(ctx->evb, hdl->rid(c), server_sock);
+    }
+
+    if (unix_path != NULL) {
+        server_unix_sock = _server_listen_unix(unix_path, 0);
+        if (server_unix_sock == NULL) {
+            goto error;
+        }
+        server_unix_path = unix_path;
+    }
+
+    /* clients of shm channels connect here to hand them over, the worker
+     * picks them up from the accepted connections, see cc_shm.h
+     */
+    if (shm_path != NULL) {
+        server_shm_sock = _server_listen_unix(shm_path, TCP_CONN_SHM);
+        if (server_shm_sock == NULL) {
+            goto error;
+        }
+        server_shm_path = shm_path;
+    }
 
     server_init = true;
 
@@ -221,6 +339,11 @@ core_server_teardown(void)
         freeaddrinfo(server_ai);
         buf_sock_return(&server_sock);
     }
+    _server_close_unix(&server_unix_sock, &server_unix_path);
+    _server_close_unix(&server_shm_sock, &server_shm_path);
+    worker_listener = NULL;
+    nconn_pending = 0;
+    notify_retry = false;
     server_metrics = NULL;
     server_init = false;
 }
@@ -239,12 +362,19 @@ _server_evwait(void)
     INCR_N(server_metrics, server_event_total, n);
     time_update();
 
+    if (notify_retry) {
+        notify_retry = false;
+        _server_notify(0);
+    }
+
     return CC_OK;
 }
 
 void
 core_server_evloop(void)
 {
+    metric_shard_claim();
+
     for(;;) {
         if (_server_evwait() != CC_OK) {
             log_crit("server core event loop exited due to failure");
@@ -8,13 +8,19 @@
 #define SERVER_PORT     "12321"
 #define SERVER_TIMEOUT  100     /* in ms */
 #define SERVER_NEVENT   1024
-
-/*          name            type                default         description */
-#define SERVER_OPTION(ACTION)                                                                   \
-    ACTION( server_host,    OPTION_TYPE_STR,    SERVER_HOST,    "interfaces listening on"      )\
-    ACTION( server_port,    OPTION_TYPE_STR,    SERVER_PORT,    "port listening on"            )\
-    ACTION( server_timeout, OPTION_TYPE_UINT,   SERVER_TIMEOUT, "evwait timeout"               )\
-    ACTION( server_nevent,  OPTION_TYPE_UINT,   SERVER_NEVENT,  "evwait max nevent returned"   )
+#define SERVER_REUSEPORT false
+#define SERVER_UNIX_PATH NULL  /* no unix domain socket listener */
+#define SERVER_SHM_PATH  NULL  /* no shared memory channels */
+
+/*          name                type                default             description */
+#define SERVER_OPTION(ACTION)                                                                           \
+    ACTION( server_host,        OPTION_TYPE_STR,    SERVER_HOST,        "interfaces listening on"      )\
+    ACTION( server_port,        OPTION_TYPE_STR,    SERVER_PORT,        "port listening on"            )\
+    ACTION( server_timeout,     OPTION_TYPE_UINT,   SERVER_TIMEOUT,     "evwait timeout"               )\
+    ACTION( server_nevent,      OPTION_TYPE_UINT,   SERVER_NEVENT,      "evwait max nevent returned"   )\
+    ACTION( server_reuseport,   OPTION_TYPE_BOOL,   SERVER_REUSEPORT,   "worker listens with reuseport" )\
+    ACTION( server_unix_path,   OPTION_TYPE_STR,    SERVER_UNIX_PATH,   "unix socket path, @ abstract" )\
+    ACTION( server_shm_path,    OPTION_TYPE_STR,    SERVER_SHM_PATH,    "unix socket for shm channels" )
 
 typedef struct {
     SERVER_OPTION(OPTION_DECLARE)
@@ -3,6 +3,10 @@
 #include <stdlib.h>             /* for NULL */
 
 /* needs to be initialized to avoid linker issues due to being optimized out */
-struct pipe_conn *pipe_c = NULL;
+struct efd_conn *efd_c = NULL;
 
 struct ring_array *conn_arr = NULL;
+
+struct buf_sock *worker_listener = NULL;
+
+uint32_t worker_wbuf_hwm = 0;
@@ -1,10 +1,30 @@
 #pragma once
 
-struct pipe_conn;
+#include <buffer/cc_buf.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct buf_sock;
+struct efd_conn;
 struct ring_array;
 
-/* pipe for server/worker thread communication */
-extern struct pipe_conn *pipe_c;
+/* counter of connections handed from server to worker thread */
+extern struct efd_conn *efd_c;
 
 /* array holding accepted connections */
 extern struct ring_array *conn_arr;
+
+/* listener the worker accepts on directly, only set in reuseport mode */
+extern struct buf_sock *worker_listener;
+
+/* replies held in wbuf past which post_read leaves requests unparsed in rbuf,
+ * set by the worker, 0 for no limit
+ */
+extern uint32_t worker_wbuf_hwm;
+
+static inline bool
+worker_wbuf_full(struct buf *wbuf)
+{
+    return worker_wbuf_hwm > 0 && buf_rsize(wbuf) >= worker_wbuf_hwm;
+}
@@ -7,22 +7,74 @@
 
 #include <buffer/cc_buf.h>
 #include <buffer/cc_dbuf.h>
+#include <cc_array.h>
 #include <cc_debug.h>
 #include <cc_event.h>
+#include <cc_metric.h>
 #include <cc_ring_array.h>
 #include <channel/cc_channel.h>
-#include <channel/cc_pipe.h>
+#include <channel/cc_eventfd.h>
+#include <channel/cc_shm.h>
 #include <channel/cc_tcp.h>
+#include <time/cc_timer.h>
+#include <time/cc_wheel.h>
 
 #include <stream/cc_sockio.h>
 
+#include <errno.h>
+#include <string.h>
 #include <sysexits.h>
 
 #define WORKER_MODULE_NAME "core::worker"
 
+/* buf_sock flags */
+#define WORKER_SOCK_READY       0x1     /* on the ready list */
+#define WORKER_SOCK_THROTTLED   0x2     /* not read until wbuf drains */
+#define WORKER_SOCK_BACKLOG     0x4     /* requests left unparsed on wbuf hwm */
+
+/* initial # of shm channels tracked, grows as needed */
+#define WORKER_SHM_NSOCK 16
+
+/* timing wheel for idle timeouts, covering up to a minute at 1s granularity */
+#define WORKER_TW_TICK  1000    /* in ms */
+#define WORKER_TW_CAP   64      /* # ticks in the wheel */
+#define WORKER_TW_NTICK 64      /* max # ticks processed at once */
+
 static bool worker_init = false;
 worker_metrics_st *worker_metrics = NULL;
 
+static bool worker_cork = WORKER_CORK;
+static uint32_t worker_flush_size = WORKER_FLUSH_SIZE;
+static uint32_t worker_spin = WORKER_SPIN;
+static uint32_t worker_busy_poll = WORKER_BUSY_POLL;
+static bool worker_edge = WORKER_EDGE;
+static uint32_t worker_read_budget = WORKER_READ_BUDGET;
+static uint32_t worker_idle_sec = WORKER_IDLE_SEC;
+
+/* only created when idle connections are to be closed */
+static struct timing_wheel *worker_tw = NULL;
+
+/* connections whose read stopped on the budget with data possibly left, in
+ * edge-triggered mode they get no new event for it, and connections with
+ * requests left unparsed, which get no event at all: the worker revisits them
+ * on the next loop iteration
+ */
+static struct buf_sock_sqh ready_q = STAILQ_HEAD_INITIALIZER(ready_q);
+
+/* connections with a shm channel attached, whose rings are checked on every
+ * loop iteration, and only rung when the worker is about to block
+ */
+static struct array *shm_socks = NULL;
+
+/* the worker polls without blocking until this deadline, see _worker_evwait */
+static struct timeout spin_until;
+
+/* start of the work done in the current loop iteration. Events are handled
+ * from within event_wait, so this is set on the first one and sleeping in
+ * event_wait is not counted as busy time.
+ */
+static struct timeout loop_busy;
+
 static struct context context;
 static struct context *ctx = &context;
 
@@ -41,11 +93,77 @@ _worker_write(struct buf_sock *s)
     ASSERT(s != NULL);
     ASSERT(s->wbuf != NULL && s->rbuf != NULL);
 
-    status = buf_tcp_write(s);
+    if (s->shm != NULL) {
+        status = buf_shm_write(s);
+    } else {
+        status = buf_tcp_write(s);
+    }
 
     return status;
 }
 
+static inline void
+_worker_ready(struct buf_sock *s)
+{
+    if (!(s->flag & WORKER_SOCK_READY)) {
+        STAILQ_INSERT_TAIL(&ready_q, s, next);
+        s->flag |= WORKER_SOCK_READY;
+    }
+}
+
+static inline void
+_worker_add_read(struct buf_sock *s)
+{
+    if (worker_edge) {
+        event_add_read_edge(ctx->evb, hdl->rid(s->ch), s);
+    } else {
+        event_add_read(ctx->evb, hdl->rid(s->ch), s);
+    }
+}
+
+/*
+ * A client that sends requests but does not read the replies would have wbuf
+ * grow without bound, since every request read adds to it. Past the high-water
+ * mark, the processor stops taking requests from rbuf. Once replies are left
+ * over with no more input to wait for, the worker stops reading from the
+ * connection and waits for it to become writable instead, then resumes with
+ * the requests left over once everything held is sent.
+ */
+static inline void
+_worker_throttle(struct buf_sock *s)
+{
+    log_verb("throttle buf_sock %p with %"PRIu32" bytes of replies held", s,
+            buf_rsize(s->wbuf));
+
+    event_del(ctx->evb, hdl->rid(s->ch));
+    event_add_write(ctx->evb, hdl->wid(s->ch), s);
+
+    if (s->flag & WORKER_SOCK_READY) {
+        STAILQ_REMOVE(&ready_q, s, buf_sock, next);
+        s->flag &= ~WORKER_SOCK_READY;
+    }
+    s->flag |= WORKER_SOCK_THROTTLED;
+
+    INCR(worker_metrics, worker_throttle);
+    INCR(worker_metrics, worker_throttle_curr);
+}
+
+static inline void
+_worker_unthrottle(struct buf_sock *s)
+{
+    log_verb("unthrottle buf_sock %p", s);
+
+    event_del(ctx->evb, hdl->wid(s->ch));
+    _worker_add_read(s);
+
+    s->flag &= ~WORKER_SOCK_THROTTLED;
+    if (s->flag & WORKER_SOCK_BACKLOG) {
+        _worker_ready(s);
+    }
+
+    DECR(worker_metrics, worker_throttle_curr);
+}
+
 static inline void
 _worker_event_write(struct buf_sock *s)
 {
@@ -54,7 +172,10 @@ _worker_event_write(struct buf_sock *s)
 
     status = _worker_write(s);
     if (status == CC_ERETRY || status == CC_EAGAIN) { /* retry write */
-        event_add_write(ctx->evb, hdl->wid(c), s);
+        /* shm rings with replies left are retried on the next iteration */
+        if (s->shm == NULL) {
+            event_add_write(ctx->evb, hdl->wid(c), s);
+        }
     } else if (status == CC_ERROR) {
         c->state = CHANNEL_TERM;
     }
@@ -64,9 +185,25 @@ _worker_event_write(struct buf_sock *s)
         s->ch->state = CHANNEL_TERM;
         return;
     }
+
+    /* shm channels take no new requests while replies are held, instead */
+    if (c->state == CHANNEL_TERM || worker_wbuf_hwm == 0 || s->shm != NULL) {
+        return;
+    }
+    /* a read event only comes with more input, so replies left over are
+     * waited out, unless a partial request in rbuf has more on its way
+     */
+    if (s->flag & WORKER_SOCK_THROTTLED) {
+        if (buf_rsize(s->wbuf) == 0) {
+            _worker_unthrottle(s);
+        }
+    } else if (buf_rsize(s->wbuf) > 0 && (worker_wbuf_full(s->wbuf) ||
+                (s->flag & WORKER_SOCK_BACKLOG) || buf_rsize(s->rbuf) == 0)) {
+        _worker_throttle(s);
+    }
 }
 
-static inline void
+static inline rstatus_i
 _worker_read(struct buf_sock *s)
 {
     log_verb("reading on buf_sock %p", s);
@@ -76,14 +213,62 @@ _worker_read(struct buf_sock *s)
 
     /* TODO(kyang): consider refactoring dbuf_tcp_read and buf_tcp_read to have no return status
        at all, since the return status is already given by the connection state */
-    dbuf_tcp_read(s);
+    return dbuf_tcp_readv(s, worker_read_budget > 0 ? worker_read_budget :
+            UINT32_MAX);
 }
 
-static inline void
+/* parse rbuf, then what was read past it, until the high-water mark */
+static inline int
+_worker_post_read(struct buf_sock *s)
+{
+    do {
+        if (processor->post_read(&s->rbuf, &s->wbuf, &s->data) < 0) {
+            return -1;
+        }
+    } while (!worker_wbuf_full(s->wbuf) && dbuf_rnext(s));
+
+    return 0;
+}
+
+static void
+_worker_shm_detach(struct buf_sock *s)
+{
+    struct buf_sock **sp;
+    uint32_t i;
+
+    for (i = 0; i < array_nelem(shm_socks); i++) {
+        sp = array_get(shm_socks, i);
+        if (*sp == s) {
+            *sp = *(struct buf_sock **)array_pop(shm_socks);
+            break;
+        }
+    }
+
+    event_del(ctx->evb, shm_read_id(s->shm));
+    shm_close(s->shm);
+    shm_conn_destroy(&s->shm);
+
+    DECR(worker_metrics, worker_shm_curr);
+}
+
+static void
 worker_close(struct buf_sock *s)
 {
     log_info("worker core close on buf_sock %p", s);
 
+    if (s->flag & WORKER_SOCK_READY) {
+        STAILQ_REMOVE(&ready_q, s, buf_sock, next);
+        s->flag &= ~WORKER_SOCK_READY;
+    }
+    if (s->flag & WORKER_SOCK_THROTTLED) {
+        DECR(worker_metrics, worker_throttle_curr);
+    }
+    if (s->tev != NULL) {
+        timing_wheel_remove(worker_tw, &s->tev);
+    }
+    if (s->shm != NULL) {
+        _worker_shm_detach(s);
+    }
     event_del(ctx->evb, hdl->rid(s->ch));
     hdl->term(s->ch);
     buf_sock_return(&s);
@@ -93,57 +278,324 @@ worker_close(struct buf_sock *s)
 static inline void
 _worker_event_read(struct buf_sock *s)
 {
+    uint32_t backlog;
+
     ASSERT(s != NULL);
 
-    _worker_read(s);
-    if (processor->post_read(&s->rbuf, &s->wbuf, &s->data) < 0) {
+    if (s->flag & WORKER_SOCK_THROTTLED) {
+        return;
+    }
+    backlog = s->flag & WORKER_SOCK_BACKLOG;
+
+    /* requests left over on the high-water mark are parsed before anything
+     * more is read, so input does not pile up while replies are held back.
+     * Those reads are made up for on the next iteration.
+     *
+     * stopping early leaves the rest to the next iteration, so one busy
+     * connection cannot hold up the others ready in the same batch
+     */
+    if (backlog) {
+        s->flag &= ~WORKER_SOCK_BACKLOG;
+    } else if (_worker_read(s) == CC_ERETRY) {
+        INCR(worker_metrics, worker_read_requeue);
+        if (worker_edge) {
+            _worker_ready(s);
+        }
+    }
+    if (_worker_post_read(s) < 0) {
         log_debug("handler signals channel termination");
         s->ch->state = CHANNEL_TERM;
         return;
     }
+    if ((buf_rsize(s->rbuf) > 0 || !STAILQ_EMPTY(&s->rchain)) &&
+            worker_wbuf_full(s->wbuf)) {
+        s->flag |= WORKER_SOCK_BACKLOG;
+    } else if (backlog) {
+        _worker_ready(s);
+    }
+    if (buf_rsize(s->wbuf) == 0) {
+        return;
+    }
+
+    /* cork: a partial request left in rbuf means the peer is in the middle of
+     * sending a pipelined burst, whose remainder is already on its way. Hold
+     * on to the replies so the whole burst is answered with a single send,
+     * unless enough of them have piled up already.
+     */
+    if (worker_cork && !(s->flag & WORKER_SOCK_BACKLOG) &&
+            buf_rsize(s->rbuf) > 0 && buf_rsize(s->wbuf) < worker_flush_size) {
+        log_verb("hold %"PRIu32" bytes of replies on buf_sock %p",
+                buf_rsize(s->wbuf), s);
+        INCR(worker_metrics, worker_cork);
+        return;
+    }
+
+    log_verb("attempt to write");
+    _worker_event_write(s);
+
+    /* replies drained below the mark without throttling, carry on next time */
+    if ((s->flag & (WORKER_SOCK_BACKLOG | WORKER_SOCK_THROTTLED)) ==
+            WORKER_SOCK_BACKLOG && s->ch->state == CHANNEL_ESTABLISHED) {
+        _worker_ready(s);
+    }
+}
+
+/*
+ * A connection accepted for a shm channel carries nothing but the channel
+ * itself, which may take more than one read event to arrive. Once attached,
+ * requests and replies go over the rings, and the connection is only watched
+ * for the client going away.
+ */
+static inline void
+_worker_shm_attach(struct buf_sock *s)
+{
+    struct shm_conn *c;
+    struct buf_sock **sp;
+    rstatus_i status;
+
+    c = shm_conn_create();
+    if (c == NULL) {
+        INCR(worker_metrics, worker_oom_ex);
+        s->ch->state = CHANNEL_TERM;
+        return;
+    }
+
+    status = shm_attach(hdl->rid(s->ch), c);
+    if (status != CC_OK) {
+        if (status != CC_EAGAIN) {
+            log_warn("shm channel on buf_sock %p cannot be attached", s);
+            s->ch->state = CHANNEL_TERM;
+        }
+        shm_conn_destroy(&c);
+        return;
+    }
+
+    sp = array_push(shm_socks);
+    if (sp == NULL) {
+        INCR(worker_metrics, worker_oom_ex);
+        shm_close(c);
+        shm_conn_destroy(&c);
+        s->ch->state = CHANNEL_TERM;
+        return;
+    }
+    *sp = s;
+    s->shm = c;
+    event_add_read(ctx->evb, shm_read_id(c), s);
+
+    INCR(worker_metrics, worker_shm_attach);
+    INCR(worker_metrics, worker_shm_curr);
+}
+
+/*
+ * take requests off the ring and reply to them, anything left on the ring is
+ * picked up by the next poll, and replies are never held back for more. The
+ * processor stops on the wbuf high-water mark, and goes on with the requests
+ * left in rbuf for as long as the client takes all the replies.
+ */
+static void
+_worker_shm_read(struct buf_sock *s)
+{
+    bool full;
+
+    if (dbuf_shm_read(s) == CC_ERETRY) {
+        INCR(worker_metrics, worker_read_requeue);
+    }
+    do {
+        if (processor->post_read(&s->rbuf, &s->wbuf, &s->data) < 0) {
+            log_debug("handler signals channel termination");
+            s->ch->state = CHANNEL_TERM;
+            return;
+        }
+        full = worker_wbuf_full(s->wbuf);
+        if (buf_rsize(s->wbuf) > 0) {
+            _worker_event_write(s);
+        }
+    } while (full && buf_rsize(s->wbuf) == 0 &&
+            s->ch->state == CHANNEL_ESTABLISHED);
+}
+
+/* serve a shm channel, requests are only taken once all replies are out,
+ * those left in rbuf on the high-water mark first
+ */
+static inline void
+_worker_shm_serve(struct buf_sock *s)
+{
     if (buf_rsize(s->wbuf) > 0) {
-        log_verb("attempt to write");
         _worker_event_write(s);
     }
+    if (buf_rsize(s->wbuf) == 0 && s->ch->state == CHANNEL_ESTABLISHED) {
+        _worker_shm_read(s);
+    }
+}
+
+/*
+ * Woken up on a shm channel: either by the doorbell, or by the connection it
+ * came over, which the client only ever closes.
+ */
+static inline void
+_worker_event_shm(struct buf_sock *s)
+{
+    char c;
+
+    if (s->ch->state != CHANNEL_ESTABLISHED) {
+        return;
+    }
+
+    if (s->shm == NULL) {
+        _worker_shm_attach(s);
+        if (s->shm == NULL) {
+            return;
+        }
+    } else {
+        shm_bell_clear(s->shm);
+        if (tcp_recv(s->ch, &c, 1) != CC_EAGAIN) {
+            s->ch->state = CHANNEL_TERM;
+            return;
+        }
+    }
+
+    _worker_shm_serve(s);
+}
+
+static void _worker_idle(void *arg);
+
+/*
+ * Activity on a connection only updates s->atime, which is cheap. The timeout
+ * event is rescheduled lazily: when it fires, the connection is closed if it
+ * has really been idle long enough, otherwise the event is inserted again for
+ * the remaining time. Delays longer than the wheel are split the same way.
+ */
+static inline void
+_worker_idle_schedule(struct buf_sock *s, uint32_t sec)
+{
+    struct timeout delay;
+
+    if (sec >= WORKER_TW_CAP * WORKER_TW_TICK / 1000) {
+        sec = WORKER_TW_CAP * WORKER_TW_TICK / 1000 - 1;
+    }
+    timeout_set_sec(&delay, sec);
+
+    s->tev = timing_wheel_insert(worker_tw, &delay, false, _worker_idle, s);
+    if (s->tev == NULL) {
+        log_warn("buf_sock %p will not be closed when idle: cannot schedule "
+                "timeout", s);
+    }
+}
+
+static void
+_worker_idle(void *arg)
+{
+    struct buf_sock *s = arg;
+    uint32_t idle = time_now() - s->atime;
+
+    s->tev = NULL; /* fired, the wheel recycles it */
+
+    if (idle >= worker_idle_sec) {
+        log_info("closing buf_sock %p, idle for %"PRIu32" seconds", s, idle);
+        INCR(worker_metrics, worker_idle_close);
+        worker_close(s);
+        return;
+    }
+
+    _worker_idle_schedule(s, worker_idle_sec - idle);
+}
+
+static void
+_worker_add_sock(struct buf_sock *s)
+{
+    log_verb("Adding new buf_sock %p to worker thread", s);
+
+    s->owner = ctx;
+    s->hdl = hdl;
+
+    if (worker_busy_poll > 0 && tcp_set_busy_poll(hdl->rid(s->ch),
+                (int)worker_busy_poll) < 0) {
+        log_warn("set busy poll on buf_sock %p failed, ignored: %s", s,
+                strerror(errno));
+    }
+
+    if (worker_tw != NULL) {
+        s->atime = time_now();
+        _worker_idle_schedule(s, worker_idle_sec);
+    }
+
+    _worker_add_read(s);
 }
 
 static void
 worker_add_conn(void)
 {
     struct buf_sock *s;
-    char buf[RING_ARRAY_DEFAULT_CAP]; /* buffer for discarding pipe data */
-    int i;
+    uint64_t i;
     rstatus_i status;
 
-    /* server pushes connection on to the ring array before writing to the pipe,
-     * therefore, we should read from the pipe first and take the connections
-     * off the ring array to match the number of bytes received.
+    /* server pushes connections on to the ring array before adding their
+     * number to the eventfd counter, therefore, we should read the counter
+     * first and take the connections off the ring array to match the count.
      *
      * Once we move server to its own thread, it is possible that there are more
      * connections added to the queue when we are processing, it is OK to wait
      * for the next read event in that case.
      */
 
-    i = pipe_recv(pipe_c, buf, RING_ARRAY_DEFAULT_CAP);
-    if (i < 0) { /* errors, do not read from ring array */
-        log_warn("not adding new connections due to pipe error");
+    status = efd_recv(efd_c, &i);
+    if (status != CC_OK) { /* errors, do not read from ring array */
+        if (status != CC_EAGAIN) {
+            log_warn("not adding new connections due to eventfd error");
+        }
         return;
     }
 
-    /* each byte in the pipe corresponds to a new connection, which we will
-     * now get from the ring array
+    /* the counter is the number of new connections, which we will now get
+     * from the ring array
      */
     for (; i > 0; --i) {
         status = ring_array_pop(&s, conn_arr);
         if (status != CC_OK) {
-            log_warn("event number does not match conn queue: missing %d conns",
-                    i);
+            log_warn("event number does not match conn queue: missing %"PRIu64
+                    " conns", i);
             return;
         }
-        log_verb("Adding new buf_sock %p to worker thread", s);
-        s->owner = ctx;
-        s->hdl = hdl;
-        event_add_read(ctx->evb, hdl->rid(s->ch), s);
+        _worker_add_sock(s);
+    }
+}
+
+/* returns true if a connection is present, false if no more pending */
+static inline bool
+_worker_accept(struct buf_sock *ss)
+{
+    struct buf_sock *s;
+    struct tcp_conn *sc = ss->ch;
+
+    s = buf_sock_borrow();
+    if (s == NULL) {
+        log_error("establish connection failed: cannot allocate buf_sock, "
+                "reject connection request");
+        INCR(worker_metrics, worker_oom_ex);
+        hdl->reject(sc);
+        return true;
+    }
+
+    if (!hdl->accept(sc, s->ch)) {
+        buf_sock_return(&s);
+        return false;
+    }
+
+    _worker_add_sock(s);
+
+    return true;
+}
+
+/* the loop iteration starts doing work, after possibly sleeping in event_wait
+ * for up to worker_timeout: refresh the clock first so expiry is computed and
+ * checked against the current time
+ */
+static inline void
+_worker_loop_busy(void)
+{
+    if (!loop_busy.is_set) {
+        time_update();
+        timeout_add_ns(&loop_busy, 0);
     }
 }
 
@@ -153,23 +605,40 @@ _worker_event(void *arg, uint32_t events)
     struct buf_sock *s = arg;
     log_verb("worker event %06"PRIX32" on buf_sock %p", events, s);
 
+    _worker_loop_busy();
+
     if (s == NULL) {
-        /* event on pipe_c, new connection */
+        /* event on efd_c, new connection */
         if (events & EVENT_READ) {
             worker_add_conn();
         } else if (events & EVENT_ERR) {
-            log_error("error event received on conn_fds pipe");
+            log_error("error event received on conn eventfd");
+        } else {
+            /* there should never be any write events on the eventfd from worker */
+            NOT_REACHED();
+        }
+    } else if (s == worker_listener) {
+        /* event on the worker's own listener, new connection(s) */
+        if (events & EVENT_READ) {
+            while (_worker_accept(s));
+        } else if (events & EVENT_ERR) {
+            log_error("error event received on worker listener");
+            INCR(worker_metrics, worker_event_error);
         } else {
-            /* there should never be any write events on the pipe from worker */
             NOT_REACHED();
         }
     } else {
         /* event on one of the connections */
+        s->atime = time_now();
 
         if (events & EVENT_READ) {
             log_verb("processing worker read event on buf_sock %p", s);
             INCR(worker_metrics, worker_event_read);
-            _worker_event_read(s);
+            if (s->ch->flags & TCP_CONN_SHM) {
+                _worker_event_shm(s);
+            } else {
+                _worker_event_read(s);
+            }
         } else if (events & EVENT_WRITE) {
             log_verb("processing worker write event on buf_sock %p", s);
             INCR(worker_metrics, worker_event_write);
@@ -190,12 +659,98 @@ _worker_event(void *arg, uint32_t events)
          * their responses. This is not as nice as the TCP half-close behavior,
          * but simpler to implement and probably fine initially.
          */
-        if (s->ch->state == CHANNEL_TERM || s->ch->state == CHANNEL_ERROR) {
+        /* both the doorbell and the connection of a shm channel may be in
+         * the same batch of events, so those are closed after it instead
+         */
+        if ((s->ch->state == CHANNEL_TERM || s->ch->state == CHANNEL_ERROR) &&
+                s->shm == NULL) {
             worker_close(s);
         }
     }
 }
 
+/* go through connections left on the ready list by the previous iteration */
+static void
+_worker_event_ready(void)
+{
+    struct buf_sock_sqh q = STAILQ_HEAD_INITIALIZER(q);
+    struct buf_sock *s;
+
+    /* connections re-queued while at it wait for the next iteration */
+    STAILQ_CONCAT(&q, &ready_q);
+    while (!STAILQ_EMPTY(&q)) {
+        s = STAILQ_FIRST(&q);
+        STAILQ_REMOVE_HEAD(&q, next);
+        s->flag &= ~WORKER_SOCK_READY;
+        _worker_event(s, EVENT_READ);
+    }
+}
+
+/* serve shm channels with anything to do, returns how many there were */
+static uint32_t
+_worker_shm_poll(void)
+{
+    struct buf_sock *s;
+    uint32_t i, n = 0;
+
+    /* backwards, as closing one moves the last in its place */
+    for (i = array_nelem(shm_socks); i > 0; i--) {
+        s = *(struct buf_sock **)array_get(shm_socks, i - 1);
+        if (s->ch->state == CHANNEL_ESTABLISHED) {
+            if (shm_rsize(s->shm) == 0 && buf_rsize(s->wbuf) == 0 &&
+                    !shm_peer_closed(s->shm) &&
+                    s->shm->state != CHANNEL_ERROR) {
+                continue;
+            }
+            n++;
+            s->atime = time_now();
+            _worker_shm_serve(s);
+        }
+
+        if (s->ch->state != CHANNEL_ESTABLISHED ||
+                s->shm->state != CHANNEL_ESTABLISHED) {
+            worker_close(s);
+        }
+    }
+
+    return n;
+}
+
+/*
+ * Ask every shm channel's client to ring the doorbell when it sends, or frees
+ * room for replies held back. Returns false, and asks nothing, if there is
+ * something to do already, then the worker must not block.
+ */
+static bool
+_worker_shm_sleep(void)
+{
+    struct buf_sock *s;
+    uint32_t i;
+
+    for (i = 0; i < array_nelem(shm_socks); i++) {
+        s = *(struct buf_sock **)array_get(shm_socks, i);
+        if (!shm_wait_prepare(s->shm, buf_rsize(s->wbuf) > 0)) {
+            while (i-- > 0) {
+                s = *(struct buf_sock **)array_get(shm_socks, i);
+                shm_wait_done(s->shm);
+            }
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void
+_worker_shm_wake(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < array_nelem(shm_socks); i++) {
+        shm_wait_done((*(struct buf_sock **)array_get(shm_socks, i))->shm);
+    }
+}
+
 void
 core_worker_setup(worker_options_st *options, worker_metrics_st *metrics)
 {
@@ -210,12 +765,24 @@ core_worker_setup(worker_options_st *options, worker_metrics_st *metrics)
     }
 
     worker_metrics = metrics;
+    worker_wbuf_hwm = WORKER_WBUF_HWM;
 
     if (options != NULL) {
         timeout = option_uint(&options->worker_timeout);
         nevent = option_uint(&options->worker_nevent);
+        worker_cork = option_bool(&options->worker_cork);
+        worker_flush_size = option_uint(&options->worker_flush_size);
+        worker_spin = option_uint(&options->worker_spin);
+        worker_busy_poll = option_uint(&options->worker_busy_poll);
+        worker_edge = option_bool(&options->worker_edge);
+        worker_read_budget = option_uint(&options->worker_read_budget);
+        worker_wbuf_hwm = option_uint(&options->worker_wbuf_hwm);
+        worker_idle_sec = option_uint(&options->worker_idle_sec);
     }
 
+    /* start out blocking, the first events returned begin a spin window */
+    timeout_add_us(&spin_until, 0);
+
     ctx->timeout = timeout;
     ctx->evb = event_base_create(nevent, _worker_event);
     if (ctx->evb == NULL) {
@@ -223,6 +790,26 @@ core_worker_setup(worker_options_st *options, worker_metrics_st *metrics)
         exit(EX_CONFIG);
     }
 
+    if (array_create(&shm_socks, WORKER_SHM_NSOCK, sizeof(struct buf_sock *))
+            != CC_OK) {
+        log_crit("failed to setup worker thread core; could not create shm "
+                "channel array");
+        exit(EX_CONFIG);
+    }
+
+    if (worker_idle_sec > 0) {
+        struct timeout tick;
+
+        timeout_set_ms(&tick, WORKER_TW_TICK);
+        worker_tw = timing_wheel_create(&tick, WORKER_TW_CAP, WORKER_TW_NTICK);
+        if (worker_tw == NULL) {
+            log_crit("failed to setup worker thread core; could not create "
+                    "timing wheel");
+            exit(EX_CONFIG);
+        }
+        timing_wheel_start(worker_tw);
+    }
+
     hdl->accept = (channel_accept_fn)tcp_accept;
     hdl->reject = (channel_reject_fn)tcp_reject;
     hdl->open = (channel_open_fn)tcp_listen;
@@ -232,7 +819,14 @@ core_worker_setup(worker_options_st *options, worker_metrics_st *metrics)
     hdl->rid = (channel_id_fn)tcp_read_id;
     hdl->wid = (channel_id_fn)tcp_write_id;
 
-    event_add_read(ctx->evb, pipe_read_id(pipe_c), NULL);
+    if (worker_listener != NULL) {
+        worker_listener->owner = ctx;
+        worker_listener->hdl = hdl;
+        event_add_read(ctx->evb, hdl->rid(worker_listener->ch), worker_listener);
+    }
+    if (efd_c != NULL) {
+        event_add_read(ctx->evb, efd_read_id(efd_c), NULL);
+    }
 
     worker_init = true;
 }
@@ -246,7 +840,23 @@ core_worker_teardown(void)
         log_warn("%s has never been setup", WORKER_MODULE_NAME);
     } else {
         event_base_destroy(&(ctx->evb));
+        array_destroy(&shm_socks);
+        if (worker_tw != NULL) {
+            timing_wheel_stop(worker_tw);
+            timing_wheel_destroy(&worker_tw);
+        }
     }
+    worker_cork = WORKER_CORK;
+    worker_flush_size = WORKER_FLUSH_SIZE;
+    worker_spin = WORKER_SPIN;
+    worker_busy_poll = WORKER_BUSY_POLL;
+    worker_edge = WORKER_EDGE;
+    worker_read_budget = WORKER_READ_BUDGET;
+    worker_wbuf_hwm = 0; /* processors hold nothing back without a worker */
+    worker_idle_sec = WORKER_IDLE_SEC;
+    STAILQ_INIT(&ready_q);
+    metric_teardown((struct metric *)worker_metrics,
+            METRIC_CARDINALITY(worker_metrics_st));
     worker_metrics = NULL;
     worker_init = false;
 }
@@ -254,16 +864,62 @@ core_worker_teardown(void)
 static rstatus_i
 _worker_evwait(void)
 {
-    int n;
+    int n, timeout = ctx->timeout;
+    uint32_t nshm;
+
+    /* adaptive spin: for worker_spin us after the last events, wait with a
+     * zero timeout so requests arriving shortly after are picked up without
+     * paying for a sleep and wakeup. Once the window passes without events,
+     * go back to blocking. This burns a core while traffic trickles in, in
+     * exchange for lower tail latency.
+     */
+    if (worker_spin > 0 && !timeout_expired(&spin_until)) {
+        timeout = 0;
+        INCR(worker_metrics, worker_event_spin);
+    }
+
+    /* connections are waiting on the ready list, only poll for others */
+    if (!STAILQ_EMPTY(&ready_q)) {
+        timeout = 0;
+    }
+
+    /* shm channels only get events while the worker blocks */
+    if (timeout != 0 && !_worker_shm_sleep()) {
+        timeout = 0;
+    }
 
-    n = event_wait(ctx->evb, ctx->timeout);
+    n = event_wait(ctx->evb, timeout);
+    if (timeout != 0) {
+        _worker_shm_wake();
+    }
     if (n < 0) {
         return n;
     }
 
+    if (!STAILQ_EMPTY(&ready_q)) {
+        _worker_loop_busy();
+    } else if (!loop_busy.is_set) { /* no events, shm channels may have work */
+        time_update();
+    }
+
+    _worker_event_ready();
+    nshm = _worker_shm_poll();
+
+    if (worker_spin > 0 && (n > 0 || nshm > 0)) {
+        timeout_add_us(&spin_until, worker_spin);
+    }
+
+    if (worker_tw != NULL) {
+        timing_wheel_execute(worker_tw);
+    }
+
+    if (loop_busy.is_set) {
+        RECORD(worker_metrics, worker_event_lat, -timeout_ns(&loop_busy));
+        timeout_reset(&loop_busy);
+    }
+
     INCR(worker_metrics, worker_event_loop);
     INCR_N(worker_metrics, worker_event_total, n);
-    time_update();
 
     return CC_OK;
 }
@@ -272,6 +928,7 @@ void *
 core_worker_evloop(void *arg)
 {
     processor = arg;
+    metric_shard_claim();
 
     for(;;) {
         if (_worker_evwait() != CC_OK) {
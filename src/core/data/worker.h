@@ -3,14 +3,31 @@
 #include <cc_define.h>
 #include <cc_metric.h>
 #include <cc_option.h>
+#include <cc_util.h>
 
-#define WORKER_TIMEOUT   100     /* in ms */
-#define WORKER_NEVENT    1024
+#define WORKER_TIMEOUT      100     /* in ms */
+#define WORKER_NEVENT       1024
+#define WORKER_CORK         false
+#define WORKER_FLUSH_SIZE   (16 * KiB)
+#define WORKER_SPIN         0       /* in us, 0 to always block */
+#define WORKER_BUSY_POLL    0       /* in us, 0 to leave sockets as is */
+#define WORKER_EDGE         false
+#define WORKER_READ_BUDGET  0       /* in bytes, 0 for no limit */
+#define WORKER_WBUF_HWM     MiB     /* in bytes, 0 for no limit */
+#define WORKER_IDLE_SEC     0       /* 0 to keep idle conns open */
 
-/*          name            type                default         description */
-#define WORKER_OPTION(ACTION)                                                                   \
-    ACTION( worker_timeout, OPTION_TYPE_UINT,   WORKER_TIMEOUT, "evwait timeout"               )\
-    ACTION( worker_nevent,  OPTION_TYPE_UINT,   WORKER_NEVENT,  "evwait max nevent returned"   )
+/*          name                type                default             description */
+#define WORKER_OPTION(ACTION)                                                                           \
+    ACTION( worker_timeout,     OPTION_TYPE_UINT,   WORKER_TIMEOUT,     "evwait timeout"               )\
+    ACTION( worker_nevent,      OPTION_TYPE_UINT,   WORKER_NEVENT,      "evwait max nevent returned"   )\
+    ACTION( worker_cork,        OPTION_TYPE_BOOL,   WORKER_CORK,        "hold replies mid-pipeline"    )\
+    ACTION( worker_flush_size,  OPTION_TYPE_UINT,   WORKER_FLUSH_SIZE,  "flush held replies above this")\
+    ACTION( worker_spin,        OPTION_TYPE_UINT,   WORKER_SPIN,        "us to spin after activity"    )\
+    ACTION( worker_busy_poll,   OPTION_TYPE_UINT,   WORKER_BUSY_POLL,   "SO_BUSY_POLL (us) on conns"   )\
+    ACTION( worker_edge,        OPTION_TYPE_BOOL,   WORKER_EDGE,        "edge-triggered conn reads"    )\
+    ACTION( worker_read_budget, OPTION_TYPE_UINT,   WORKER_READ_BUDGET, "max bytes read per conn event")\
+    ACTION( worker_wbuf_hwm,    OPTION_TYPE_UINT,   WORKER_WBUF_HWM,    "stop parsing above this wbuf" )\
+    ACTION( worker_idle_sec,    OPTION_TYPE_UINT,   WORKER_IDLE_SEC,    "close conns idle for this long")
 
 typedef struct {
     WORKER_OPTION(OPTION_DECLARE)
@@ -23,6 +40,15 @@ typedef struct {
     ACTION( worker_event_read,      METRIC_COUNTER, "# worker core_read events"     )\
     ACTION( worker_event_write,     METRIC_COUNTER, "# worker core_write events"    )\
     ACTION( worker_event_error,     METRIC_COUNTER, "# worker core_error events"    )\
+    ACTION( worker_cork,            METRIC_COUNTER, "# worker writes held by cork"  )\
+    ACTION( worker_event_spin,      METRIC_COUNTER, "# worker waits w/o blocking"   )\
+    ACTION( worker_read_requeue,    METRIC_COUNTER, "# conn reads left unfinished"  )\
+    ACTION( worker_throttle,        METRIC_COUNTER, "# conns throttled on wbuf"     )\
+    ACTION( worker_throttle_curr,   METRIC_GAUGE,   "# conns currently throttled"   )\
+    ACTION( worker_idle_close,      METRIC_COUNTER, "# conns closed when idle"      )\
+    ACTION( worker_shm_attach,      METRIC_COUNTER, "# shm channels attached"       )\
+    ACTION( worker_shm_curr,        METRIC_GAUGE,   "# shm channels open"           )\
+    ACTION( worker_event_lat,       METRIC_HISTOGRAM, "busy event loop time (ns)"   )\
     ACTION( worker_oom_ex,          METRIC_COUNTER, "# worker error due to oom"     )
 
 typedef struct {
@@ -38,6 +64,10 @@ extern worker_metrics_st *worker_metrics;
  *
  * Applications should set and pass their instance of post_processor as argument
  * to core_worker_evloop().
+ *
+ * post_read should stop taking requests off rbuf once worker_wbuf_full(wbuf),
+ * see core/data/shared.h, and leave the rest there: it is called again with
+ * them once the replies have drained.
  */
 struct buf;
 typedef int (*post_process_fn)(struct buf **, struct buf **, void **);
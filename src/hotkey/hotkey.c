@@ -0,0 +1,347 @@
+#include <hotkey/hotkey.h>
+
+#include <cc_bstring.h>
+#include <cc_debug.h>
+#include <cc_hash.h>
+#include <cc_mm.h>
+#include <cc_print.h>
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <sysexits.h>
+#include <time.h>
+
+#define HOTKEY_MODULE_NAME "hotkey"
+
+struct hotkey_entry {
+    uint64_t    count;              /* # sampled accesses */
+    uint64_t    error;              /* count inherited when taking over */
+    uint32_t    pos;                /* position in heap */
+    uint8_t     klen;
+    char        key[HOTKEY_KLEN_MAX];
+};
+
+/*
+ * entries never move once taken; table is an open-addressing (linear probing)
+ * hash table of entry index + 1, 0 for an empty bucket, at most half full, so
+ * a lookup checks a couple of buckets whatever hotkey_nkey is; hv keeps the
+ * hash of each entry to find its bucket again when it is taken over; heap
+ * holds entry indices ordered by count, smallest on top, which is the counter
+ * to take over when a new key comes in
+ */
+static struct hotkey_entry *entry = NULL;
+static struct hotkey_entry *snapshot = NULL; /* sorted copy for printing */
+static uint32_t *hv = NULL;
+static uint32_t *heap = NULL;
+static uint32_t *table = NULL;
+static uint32_t nbucket;                /* power of 2, >= 2 * hotkey_nkey */
+static uint32_t nused;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t hotkey_nkey = HOTKEY_NKEY;
+static uint32_t hotkey_sample = HOTKEY_SAMPLE;
+
+/*
+ * accesses are sampled at random intervals averaging hotkey_sample, drawn per
+ * thread, rather than every hotkey_sample-th one: a fixed stride aliases with
+ * clients that cycle through a set of keys and would always count the same
+ * ones and never the others
+ */
+static __thread uint64_t hotkey_rng = 0;  /* xorshift64* state, 0 to seed */
+static __thread uint32_t hotkey_left = 0; /* # accesses to skip */
+
+bool hotkey_enabled = false;
+
+static bool hotkey_init = false;
+static hotkey_metrics_st *hotkey_metrics = NULL;
+
+void
+hotkey_setup(hotkey_options_st *options, hotkey_metrics_st *metrics)
+{
+    log_info("set up the %s module", HOTKEY_MODULE_NAME);
+
+    if (hotkey_init) {
+        log_warn("%s has already been setup, overwrite", HOTKEY_MODULE_NAME);
+        hotkey_teardown();
+    }
+
+    hotkey_metrics = metrics;
+
+    if (options == NULL || !option_bool(&options->hotkey_enable)) {
+        hotkey_enabled = false;
+        return;
+    }
+
+    hotkey_nkey = option_uint(&options->hotkey_nkey);
+    hotkey_sample = option_uint(&options->hotkey_sample);
+    if (hotkey_nkey == 0 || hotkey_sample == 0) {
+        log_crit("hotkey_nkey and hotkey_sample cannot be 0");
+        exit(EX_CONFIG);
+    }
+
+    entry = cc_alloc(hotkey_nkey * sizeof(struct hotkey_entry));
+    snapshot = cc_alloc(hotkey_nkey * sizeof(struct hotkey_entry));
+    hv = cc_alloc(hotkey_nkey * sizeof(uint32_t));
+    heap = cc_alloc(hotkey_nkey * sizeof(uint32_t));
+    for (nbucket = 2; nbucket < 2 * hotkey_nkey; nbucket <<= 1);
+    table = cc_zalloc(nbucket * sizeof(uint32_t));
+    if (entry == NULL || snapshot == NULL || hv == NULL || heap == NULL ||
+            table == NULL) {
+        log_crit("cannot track %"PRIu32" hotkeys, OOM", hotkey_nkey);
+        exit(EX_CONFIG);
+    }
+    nused = 0;
+
+    hotkey_enabled = true;
+
+    hotkey_init = true;
+}
+
+void
+hotkey_teardown(void)
+{
+    log_info("tear down the %s module", HOTKEY_MODULE_NAME);
+
+    if (!hotkey_init) {
+        log_warn("%s has never been setup", HOTKEY_MODULE_NAME);
+    }
+
+    hotkey_enabled = false;
+    cc_free(entry);
+    cc_free(snapshot);
+    cc_free(hv);
+    cc_free(heap);
+    cc_free(table);
+    entry = snapshot = NULL;
+    hv = heap = table = NULL;
+    nbucket = 0;
+    nused = 0;
+    hotkey_nkey = HOTKEY_NKEY;
+    hotkey_sample = HOTKEY_SAMPLE;
+    hotkey_metrics = NULL;
+
+    hotkey_init = false;
+}
+
+static inline void
+_heap_set(uint32_t pos, uint32_t idx)
+{
+    heap[pos] = idx;
+    entry[idx].pos = pos;
+}
+
+static void
+_heap_up(uint32_t pos)
+{
+    uint32_t idx = heap[pos], parent;
+
+    for (; pos > 0; pos = parent) {
+        parent = (pos - 1) / 2;
+        if (entry[heap[parent]].count <= entry[idx].count) {
+            break;
+        }
+        _heap_set(pos, heap[parent]);
+    }
+    _heap_set(pos, idx);
+}
+
+static void
+_heap_down(uint32_t pos)
+{
+    uint32_t idx = heap[pos], child;
+
+    for (; (child = 2 * pos + 1) < nused; pos = child) {
+        if (child + 1 < nused &&
+                entry[heap[child + 1]].count < entry[heap[child]].count) {
+            child++;
+        }
+        if (entry[idx].count <= entry[heap[child]].count) {
+            break;
+        }
+        _heap_set(pos, heap[child]);
+    }
+    _heap_set(pos, idx);
+}
+
+/* bucket holding key if tracked, otherwise the empty bucket to put it in */
+static inline uint32_t
+_hotkey_bucket(const struct bstring *key, uint32_t h)
+{
+    uint32_t b, i;
+
+    for (b = h & (nbucket - 1); table[b] != 0; b = (b + 1) & (nbucket - 1)) {
+        i = table[b] - 1;
+        if (hv[i] == h && entry[i].klen == key->len &&
+                cc_memcmp(entry[i].key, key->data, key->len) == 0) {
+            break;
+        }
+    }
+
+    return b;
+}
+
+/*
+ * empty the bucket of entry i, moving later buckets of the same probe run back
+ * into the hole so every key stays reachable from its home bucket
+ */
+static void
+_hotkey_unindex(uint32_t i)
+{
+    uint32_t hole, b, home;
+
+    for (hole = hv[i] & (nbucket - 1); table[hole] != i + 1;
+            hole = (hole + 1) & (nbucket - 1));
+
+    for (b = (hole + 1) & (nbucket - 1); table[b] != 0;
+            b = (b + 1) & (nbucket - 1)) {
+        home = hv[table[b] - 1] & (nbucket - 1);
+        /* b can move to hole unless its home lies cyclically in (hole, b] */
+        if (((b - home) & (nbucket - 1)) >= ((b - hole) & (nbucket - 1))) {
+            table[hole] = table[b];
+            hole = b;
+        }
+    }
+    table[hole] = 0;
+}
+
+/* # accesses to skip before the next sampled one, hotkey_sample - 1 on avg */
+static inline uint32_t
+_hotkey_gap(void)
+{
+    if (hotkey_sample == 1) {
+        return 0;
+    }
+
+    if (hotkey_rng == 0) {
+        hotkey_rng = ((uint64_t)time(NULL) << 32 ^ (uintptr_t)&hotkey_rng) | 1;
+    }
+    hotkey_rng ^= hotkey_rng >> 12;
+    hotkey_rng ^= hotkey_rng << 25;
+    hotkey_rng ^= hotkey_rng >> 27;
+
+    return (hotkey_rng * 0x2545f4914f6cdd1dULL >> 32) %
+        (2 * hotkey_sample - 1);
+}
+
+void
+_hotkey_count(const struct bstring *key)
+{
+    uint32_t h, b;
+    int32_t i;
+    struct hotkey_entry *e;
+
+    /* a skip drawn for a larger hotkey_sample before setup is dropped */
+    if (hotkey_left > 0 && hotkey_left < 2 * hotkey_sample - 1) {
+        hotkey_left--;
+        return;
+    }
+    hotkey_left = _hotkey_gap();
+
+    if (key->len > HOTKEY_KLEN_MAX) {
+        INCR(hotkey_metrics, hotkey_skip);
+        return;
+    }
+
+    INCR(hotkey_metrics, hotkey_count);
+    h = hash(key->data, key->len, 0);
+
+    pthread_mutex_lock(&lock);
+
+    b = _hotkey_bucket(key, h);
+    if (table[b] != 0) {
+        i = table[b] - 1;
+        entry[i].count++;
+        _heap_down(entry[i].pos);
+        pthread_mutex_unlock(&lock);
+        return;
+    }
+
+    if (nused < hotkey_nkey) { /* a free counter, count starts from scratch */
+        i = nused++;
+        e = &entry[i];
+        e->count = 1;
+        e->error = 0;
+        heap[nused - 1] = i;
+        e->pos = nused - 1;
+    } else { /* take over the smallest counter */
+        i = heap[0];
+        e = &entry[i];
+        e->error = e->count;
+        e->count++;
+        _hotkey_unindex(i);
+        b = _hotkey_bucket(key, h); /* the hole may have moved b back */
+        INCR(hotkey_metrics, hotkey_replace);
+    }
+    table[b] = i + 1;
+    hv[i] = h;
+    e->klen = key->len;
+    cc_memcpy(e->key, key->data, key->len);
+    if (e->error == 0) {
+        _heap_up(e->pos);
+    } else {
+        _heap_down(e->pos);
+    }
+
+    pthread_mutex_unlock(&lock);
+}
+
+uint32_t
+hotkey_nslot(void)
+{
+    return hotkey_enabled ? hotkey_nkey : 0;
+}
+
+void
+hotkey_reset(void)
+{
+    pthread_mutex_lock(&lock);
+    if (nused > 0) {
+        cc_memset(table, 0, nbucket * sizeof(uint32_t));
+    }
+    nused = 0;
+    pthread_mutex_unlock(&lock);
+}
+
+static int
+_hotkey_cmp(const void *a, const void *b)
+{
+    const struct hotkey_entry *x = a, *y = b;
+
+    if (x->count != y->count) {
+        return x->count < y->count ? 1 : -1;
+    }
+
+    return 0;
+}
+
+size_t
+hotkey_print(char *buf, size_t nbuf, char *fmt, uint32_t n)
+{
+    uint32_t i, nsnap;
+    size_t len, offset = 0;
+
+    if (!hotkey_enabled) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&lock);
+    nsnap = nused;
+    cc_memcpy(snapshot, entry, nsnap * sizeof(struct hotkey_entry));
+    pthread_mutex_unlock(&lock);
+
+    qsort(snapshot, nsnap, sizeof(struct hotkey_entry), _hotkey_cmp);
+
+    for (i = 0; i < nsnap && i < n; i++) {
+        len = cc_scnprintf(buf + offset, nbuf - offset, fmt,
+                (int)snapshot[i].klen, snapshot[i].key,
+                snapshot[i].count * hotkey_sample,
+                snapshot[i].error * hotkey_sample);
+        if (len >= nbuf - offset - 1) { /* possibly truncated, drop the line */
+            buf[offset] = '\0';
+            break;
+        }
+        offset += len;
+    }
+
+    return offset;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cc_bstring.h>
+#include <cc_metric.h>
+#include <cc_option.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * hotkey finds the most frequently accessed keys with the space-saving
+ * algorithm (Metwally et al.): a fixed number of counters each owned by a key,
+ * and a key that does not own one takes over the smallest counter, inheriting
+ * its count as the error bound of its own. Any key accessed more often than
+ * 1/hotkey_nkey of all (counted) accesses is guaranteed to own a counter.
+ *
+ * Only one out of hotkey_sample accesses on average is counted, at random
+ * intervals, so the reported counts are estimates, scaled back up by the
+ * sample ratio. Counters only grow, use hotkey_reset to start over, e.g. when
+ * polling for keys that are hot now.
+ *
+ * Counting happens on the worker thread and reporting on the admin thread,
+ * both take a lock, which is only ever taken by a sampled access. Keys are
+ * found through a hash table, so a sampled access costs the same however
+ * many keys are tracked.
+ */
+
+#define HOTKEY_NKEY     64
+#define HOTKEY_SAMPLE   100
+#define HOTKEY_KLEN_MAX UINT8_MAX /* longer keys are not counted */
+
+/*          name            type                default         description */
+#define HOTKEY_OPTION(ACTION)                                                          \
+    ACTION( hotkey_enable,  OPTION_TYPE_BOOL,   false,          "track hottest keys"  )\
+    ACTION( hotkey_nkey,    OPTION_TYPE_UINT,   HOTKEY_NKEY,    "# keys tracked"      )\
+    ACTION( hotkey_sample,  OPTION_TYPE_UINT,   HOTKEY_SAMPLE,  "hotkey sample ratio" )
+
+typedef struct {
+    HOTKEY_OPTION(OPTION_DECLARE)
+} hotkey_options_st;
+
+/*          name                type            description */
+#define HOTKEY_METRIC(ACTION)                                                \
+    ACTION( hotkey_count,       METRIC_COUNTER, "# key accesses counted"    )\
+    ACTION( hotkey_replace,     METRIC_COUNTER, "# tracked keys replaced"   )\
+    ACTION( hotkey_skip,        METRIC_COUNTER, "# keys too long to track"  )
+
+typedef struct {
+    HOTKEY_METRIC(METRIC_DECLARE)
+} hotkey_metrics_st;
+
+extern bool hotkey_enabled;
+
+void hotkey_setup(hotkey_options_st *options, hotkey_metrics_st *metrics);
+void hotkey_teardown(void);
+
+#define hotkey_count(key) do {      \
+    if (hotkey_enabled) {           \
+        _hotkey_count(key);         \
+    }                               \
+} while (0)
+
+void _hotkey_count(const struct bstring *key);
+
+/* # keys that can be tracked, 0 if disabled */
+uint32_t hotkey_nslot(void);
+
+/* forget all keys tracked so far */
+void hotkey_reset(void);
+
+/*
+ * print up to n tracked keys, hottest first, one line per key with fmt, which
+ * takes the key length (int), key (char *), estimated # accesses and the error
+ * bound of the estimate (both uint64_t); returns # bytes written, lines that
+ * do not fit are left out
+ */
+size_t hotkey_print(char *buf, size_t nbuf, char *fmt, uint32_t n);
@@ -0,0 +1,321 @@
+#include <mrc/mrc.h>
+
+#include <cc_debug.h>
+#include <cc_hash.h>
+#include <cc_mm.h>
+#include <cc_print.h>
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <sysexits.h>
+
+#define MRC_MODULE_NAME "mrc"
+
+#define MRC_NONE UINT32_MAX
+
+struct mrc_entry {
+    uint64_t    hv;                 /* key hash, stands in for the key */
+    uint32_t    time;               /* logical time of the last access */
+};
+
+/*
+ * Each tracked key owns a logical time, that of its last access, and bit is a
+ * Fenwick tree flagging the times owned, so the # distinct keys accessed since
+ * a given time is the difference of two prefix sums. Times run up to ntime,
+ * then those still owned are renumbered from 0 in order. table maps key hashes
+ * to entries, with linear probing.
+ */
+static struct mrc_entry *entry = NULL;
+static uint32_t *table = NULL;      /* entry index, MRC_NONE if empty */
+static uint32_t *owner = NULL;      /* time -> entry index, MRC_NONE if none */
+static uint32_t *bit = NULL;        /* 1-based, ntime + 1 counters */
+static uint64_t hist[MRC_NBUCKET + 1]; /* last: first access or out of range */
+static uint32_t nbucket;            /* MRC_NBUCKET, or mrc_nkey if fewer */
+static uint32_t nentry;
+static uint32_t ntable;             /* power of 2 */
+static uint32_t ntime;
+static uint32_t mrc_time;           /* next logical time */
+static uint32_t oldest;             /* no earlier time is owned */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t mrc_nkey = MRC_NKEY;
+static uint32_t mrc_sample = MRC_SAMPLE;
+
+bool mrc_enabled = false;
+
+static bool mrc_init = false;
+static mrc_metrics_st *mrc_metrics = NULL;
+
+static void
+_mrc_clear(void)
+{
+    cc_memset(table, 0xff, ntable * sizeof(uint32_t));
+    cc_memset(owner, 0xff, ntime * sizeof(uint32_t));
+    cc_memset(bit, 0, (ntime + 1) * sizeof(uint32_t));
+    cc_memset(hist, 0, sizeof(hist));
+    nentry = 0;
+    mrc_time = 0;
+    oldest = 0;
+}
+
+void
+mrc_setup(mrc_options_st *options, mrc_metrics_st *metrics)
+{
+    log_info("set up the %s module", MRC_MODULE_NAME);
+
+    if (mrc_init) {
+        log_warn("%s has already been setup, overwrite", MRC_MODULE_NAME);
+        mrc_teardown();
+    }
+
+    mrc_metrics = metrics;
+
+    if (options == NULL || !option_bool(&options->mrc_enable)) {
+        mrc_enabled = false;
+        return;
+    }
+
+    mrc_nkey = option_uint(&options->mrc_nkey);
+    mrc_sample = option_uint(&options->mrc_sample);
+    if (mrc_nkey == 0 || mrc_nkey > UINT32_MAX / 4 || mrc_sample == 0) {
+        log_crit("mrc_nkey must be within (0, %"PRIu32"], mrc_sample above 0",
+                UINT32_MAX / 4);
+        exit(EX_CONFIG);
+    }
+
+    nbucket = mrc_nkey < MRC_NBUCKET ? mrc_nkey : MRC_NBUCKET;
+    ntime = 2 * mrc_nkey;
+    for (ntable = 1; ntable < 2 * mrc_nkey; ntable <<= 1);
+
+    entry = cc_alloc(mrc_nkey * sizeof(struct mrc_entry));
+    table = cc_alloc(ntable * sizeof(uint32_t));
+    owner = cc_alloc(ntime * sizeof(uint32_t));
+    bit = cc_alloc((ntime + 1) * sizeof(uint32_t));
+    if (entry == NULL || table == NULL || owner == NULL || bit == NULL) {
+        log_crit("cannot track %"PRIu32" keys for mrc, OOM", mrc_nkey);
+        exit(EX_CONFIG);
+    }
+    _mrc_clear();
+
+    mrc_enabled = true;
+
+    mrc_init = true;
+}
+
+void
+mrc_teardown(void)
+{
+    log_info("tear down the %s module", MRC_MODULE_NAME);
+
+    if (!mrc_init) {
+        log_warn("%s has never been setup", MRC_MODULE_NAME);
+    }
+
+    mrc_enabled = false;
+    cc_free(entry);
+    cc_free(table);
+    cc_free(owner);
+    cc_free(bit);
+    entry = NULL;
+    table = owner = bit = NULL;
+    mrc_nkey = MRC_NKEY;
+    mrc_sample = MRC_SAMPLE;
+    mrc_metrics = NULL;
+
+    mrc_init = false;
+}
+
+static inline void
+_bit_add(uint32_t t, int32_t delta)
+{
+    uint32_t i;
+
+    for (i = t + 1; i <= ntime; i += i & -i) {
+        bit[i] += delta;
+    }
+}
+
+/* # times owned in [0, t) */
+static inline uint32_t
+_bit_sum(uint32_t t)
+{
+    uint32_t i, sum = 0;
+
+    for (i = t; i > 0; i -= i & -i) {
+        sum += bit[i];
+    }
+
+    return sum;
+}
+
+/* renumber owned times from 0, keeping their order */
+static void
+_mrc_renumber(void)
+{
+    uint32_t t, i, j, e;
+
+    for (t = 0, i = 0; t < ntime; t++) {
+        if (owner[t] == MRC_NONE) {
+            continue;
+        }
+        e = owner[t];
+        owner[t] = MRC_NONE;
+        owner[i] = e;
+        entry[e].time = i++;
+    }
+
+    /* rebuild in linear time: set the leaves, then push sums up */
+    cc_memset(bit, 0, (ntime + 1) * sizeof(uint32_t));
+    for (t = 0; t < i; t++) {
+        bit[t + 1] = 1;
+    }
+    for (t = 1; t <= ntime; t++) {
+        j = t + (t & -t);
+        if (j <= ntime) {
+            bit[j] += bit[t];
+        }
+    }
+
+    mrc_time = i;
+    oldest = 0;
+}
+
+/* slot holding hv, or the empty slot where it would go */
+static inline uint32_t
+_table_find(uint64_t hv)
+{
+    uint32_t pos, mask = ntable - 1;
+
+    for (pos = hv & mask; table[pos] != MRC_NONE &&
+            entry[table[pos]].hv != hv; pos = (pos + 1) & mask);
+
+    return pos;
+}
+
+/* empty a slot, shifting back later entries so none is cut off its home */
+static void
+_table_delete(uint32_t pos)
+{
+    uint32_t i = pos, j = pos, home, mask = ntable - 1;
+
+    table[i] = MRC_NONE;
+    for (;;) {
+        j = (j + 1) & mask;
+        if (table[j] == MRC_NONE) {
+            return;
+        }
+        home = entry[table[j]].hv & mask;
+        /* move j into the hole at i unless home lies cyclically in (i, j] */
+        if ((i < j) ? (home <= i || home > j) : (home <= i && home > j)) {
+            table[i] = table[j];
+            table[j] = MRC_NONE;
+            i = j;
+        }
+    }
+}
+
+void
+_mrc_count(const struct bstring *key)
+{
+    uint32_t h, pos, e, d;
+    uint64_t hv;
+
+    h = hash(key->data, key->len, 0);
+    if (h % mrc_sample != 0) {
+        return;
+    }
+    /* the sampled half of the hash is biased, index the table by the other */
+    hv = ((uint64_t)h << 32) | hash(key->data, key->len, 1);
+
+    INCR(mrc_metrics, mrc_access);
+
+    pthread_mutex_lock(&lock);
+
+    if (mrc_time == ntime) {
+        _mrc_renumber();
+    }
+
+    pos = _table_find(hv);
+    if (table[pos] != MRC_NONE) {
+        e = table[pos];
+        d = _bit_sum(mrc_time) - _bit_sum(entry[e].time + 1);
+        hist[(uint64_t)d * nbucket / mrc_nkey]++;
+        _bit_add(entry[e].time, -1);
+        owner[entry[e].time] = MRC_NONE;
+    } else {
+        INCR(mrc_metrics, mrc_cold);
+        hist[MRC_NBUCKET]++;
+        if (nentry < mrc_nkey) {
+            e = nentry++;
+        } else { /* drop the least recently accessed key */
+            while (owner[oldest] == MRC_NONE) {
+                oldest++;
+            }
+            e = owner[oldest];
+            _bit_add(oldest, -1);
+            owner[oldest] = MRC_NONE;
+            _table_delete(_table_find(entry[e].hv));
+            pos = _table_find(hv);
+            INCR(mrc_metrics, mrc_drop);
+        }
+        entry[e].hv = hv;
+        table[pos] = e;
+    }
+
+    entry[e].time = mrc_time;
+    owner[mrc_time] = e;
+    _bit_add(mrc_time, 1);
+    mrc_time++;
+
+    pthread_mutex_unlock(&lock);
+}
+
+void
+mrc_reset(void)
+{
+    if (!mrc_enabled) {
+        return;
+    }
+
+    pthread_mutex_lock(&lock);
+    _mrc_clear();
+    pthread_mutex_unlock(&lock);
+}
+
+size_t
+mrc_print(char *buf, size_t nbuf, char *fmt)
+{
+    uint64_t count[MRC_NBUCKET + 1], total = 0, miss;
+    size_t len, offset = 0;
+    uint32_t i;
+
+    if (!mrc_enabled) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&lock);
+    cc_memcpy(count, hist, sizeof(count));
+    pthread_mutex_unlock(&lock);
+
+    for (i = 0; i <= MRC_NBUCKET; i++) {
+        total += count[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    /* distances within a bucket count as hits at the smallest size fitting all */
+    for (miss = total, i = 0; i < nbucket; i++) {
+        miss -= count[i];
+        len = cc_scnprintf(buf + offset, nbuf - offset, fmt,
+                ((uint64_t)(i + 1) * mrc_nkey + nbucket - 1) / nbucket * mrc_sample,
+                (double)miss / total);
+        if (len >= nbuf - offset - 1) { /* possibly truncated, drop the line */
+            buf[offset] = '\0';
+            break;
+        }
+        offset += len;
+    }
+
+    return offset;
+}
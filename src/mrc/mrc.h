@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cc_bstring.h>
+#include <cc_metric.h>
+#include <cc_option.h>
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * mrc estimates the miss ratio curve of an LRU cache, i.e. the miss ratio for
+ * any cache size, from the keys accessed, following SHARDS (Waldspurger et al.
+ * FAST'15). Keys are sampled spatially, one out of mrc_sample by key hash, so
+ * a sampled key has all its accesses seen. For each access to a sampled key,
+ * the reuse distance is the number of distinct sampled keys accessed since the
+ * previous access to the same key, scaled up by mrc_sample it is the smallest
+ * LRU cache (in # keys) in which the access would have been a hit.
+ *
+ * Up to mrc_nkey sampled keys are tracked, the least recently accessed one is
+ * dropped to make room, so the curve covers cache sizes up to
+ * mrc_nkey * mrc_sample keys, anything beyond counts as a miss. Distances are
+ * counted into MRC_NBUCKET (at most mrc_nkey) buckets of equal width across
+ * that range.
+ *
+ * Accesses are counted on the worker thread and the curve is read on the admin
+ * thread, under a lock only taken for sampled accesses.
+ */
+
+#define MRC_NKEY        65536
+#define MRC_SAMPLE      1000
+#define MRC_NBUCKET     32
+
+/*          name            type                default         description */
+#define MRC_OPTION(ACTION)                                                                 \
+    ACTION( mrc_enable,     OPTION_TYPE_BOOL,   false,          "estimate miss ratio curve" )\
+    ACTION( mrc_nkey,       OPTION_TYPE_UINT,   MRC_NKEY,       "# sampled keys tracked"    )\
+    ACTION( mrc_sample,     OPTION_TYPE_UINT,   MRC_SAMPLE,     "mrc key sample ratio"      )
+
+typedef struct {
+    MRC_OPTION(OPTION_DECLARE)
+} mrc_options_st;
+
+/*          name                type            description */
+#define MRC_METRIC(ACTION)                                                   \
+    ACTION( mrc_access,         METRIC_COUNTER, "# sampled accesses"        )\
+    ACTION( mrc_cold,           METRIC_COUNTER, "# sampled first accesses"  )\
+    ACTION( mrc_drop,           METRIC_COUNTER, "# sampled keys dropped"    )
+
+typedef struct {
+    MRC_METRIC(METRIC_DECLARE)
+} mrc_metrics_st;
+
+extern bool mrc_enabled;
+
+void mrc_setup(mrc_options_st *options, mrc_metrics_st *metrics);
+void mrc_teardown(void);
+
+#define mrc_count(key) do {         \
+    if (mrc_enabled) {              \
+        _mrc_count(key);            \
+    }                               \
+} while (0)
+
+void _mrc_count(const struct bstring *key);
+
+/* forget all accesses seen so far */
+void mrc_reset(void);
+
+/*
+ * print the curve, one line per bucket with fmt, which takes the cache size in
+ * # keys (uint64_t) and the estimated miss ratio at that size (double); returns
+ * # bytes written, lines that do not fit are left out
+ */
+size_t mrc_print(char *buf, size_t nbuf, char *fmt);
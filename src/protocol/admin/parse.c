@@ -27,6 +27,14 @@ _get_req_type(struct request *req, struct bstring *type)
     ASSERT(req->type == REQ_UNKNOWN);
 
     switch (type->len) {
+    case 3:
+        if (str3cmp(type->data, 'm', 'r', 'c')) {
+            req->type = REQ_MRC;
+            break;
+        }
+
+        break;
+
     case 4:
         if (str4cmp(type->data, 'q', 'u', 'i', 't')) {
             req->type = REQ_QUIT;
@@ -49,6 +57,11 @@ _get_req_type(struct request *req, struct bstring *type)
             break;
         }
 
+        if (str7cmp(type->data, 'h', 'o', 't', 'k', 'e', 'y', 's')) {
+            req->type = REQ_HOTKEYS;
+            break;
+        }
+
         break;
     }
 
@@ -83,7 +96,7 @@ admin_parse_req(struct request *req, struct buf *buf)
 
     type.data = buf->rpos;
     type.len = q - buf->rpos;
-    if (p < q) { /* intentional: pointing to the leading space */
+    if (q < p) { /* intentional: pointing to the leading space */
         req->arg.len = p - q;
         req->arg.data = q;
     }
@@ -91,3 +104,19 @@ admin_parse_req(struct request *req, struct buf *buf)
     buf->rpos = p + CRLF_LEN;
     return _get_req_type(req, &type);
 }
+
+bool
+admin_parse_arg(struct bstring *arg, struct bstring *token)
+{
+    char *p = arg->data, *end = arg->data + arg->len;
+
+    for (; p < end && *p == ' '; p++);
+    token->data = p;
+    for (; p < end && *p != ' '; p++);
+    token->len = p - token->data;
+
+    arg->len = end - p;
+    arg->data = p;
+
+    return token->len > 0;
+}
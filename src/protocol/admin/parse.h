@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdbool.h>
+
 typedef enum parse_rstatus {
     PARSE_OK        = 0,
     PARSE_EUNFIN    = -1,
@@ -7,7 +9,15 @@ typedef enum parse_rstatus {
     PARSE_EOTHER    = -3,
 } parse_rstatus_t;
 
+struct bstring;
 struct buf;
 struct request;
 
 parse_rstatus_t admin_parse_req(struct request *req, struct buf *buf);
+
+/*
+ * take the next space-separated token off arg, which is the argument blob of
+ * a parsed request, e.g. "json" then "worker_" out of " json worker_".
+ * Returns false if there are no tokens left.
+ */
+bool admin_parse_arg(struct bstring *arg, struct bstring *token);
@@ -25,6 +25,8 @@
     ACTION( REQ_UNKNOWN,       ""          )\
     ACTION( REQ_STATS,         "stats"     )\
     ACTION( REQ_VERSION,       "version"   )\
+    ACTION( REQ_HOTKEYS,       "hotkeys"   )\
+    ACTION( REQ_MRC,           "mrc"       )\
     ACTION( REQ_QUIT,          "quit"      )
 
 #define GET_TYPE(_name, _str) _name,
@@ -11,6 +11,8 @@
 
 #define NOREPLY " noreply"
 #define NOREPLY_LEN (sizeof(NOREPLY) - 1)
+#define EXPIRY_MS "ms"
+#define EXPIRY_MS_LEN (sizeof(EXPIRY_MS) - 1)
 
 static bool compose_init = false;
 static compose_req_metrics_st *compose_req_metrics = NULL;
@@ -176,7 +178,8 @@ compose_req(struct buf **buf, struct request *req)
          * estimate the int size based on max value
          */
         if (_check_buf_size(buf, str->len + key->len + CC_UINT32_MAXLEN * 3 +
-                    cas_len + req->vstr.len + noreply_len + CRLF_LEN * 2)
+                    EXPIRY_MS_LEN + cas_len + req->vstr.len + noreply_len +
+                    CRLF_LEN * 2)
                 != COMPOSE_OK) {
             goto error;
         }
@@ -186,6 +189,9 @@ compose_req(struct buf **buf, struct request *req)
         n += _write_uint64(buf, req->flag);
         n += _delim(buf);
         n += _write_uint64(buf, req->expiry);
+        if (req->expiry_ms) {
+            n += buf_write(*buf, EXPIRY_MS, EXPIRY_MS_LEN);
+        }
         n += _delim(buf);
         n += _write_uint64(buf, req->vstr.len);
         if (type == REQ_CAS) {
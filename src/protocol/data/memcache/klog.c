@@ -8,6 +8,7 @@
 #include <cc_debug.h>
 #include <cc_log.h>
 #include <cc_print.h>
+#include <time/cc_clock.h>
 #include <time/cc_timer.h>
 #include <time/cc_wheel.h>
 
@@ -20,12 +21,12 @@
 #define KLOG_MAX_LEN       KiB
 
 /* TODO(yao): Use a cheaper way to format the command logs, e.g. print_uint64 */
-/* TODO(yao): timestamp can be optimized by not reformatting within a second */
 #define KLOG_TIME_FMT      "[%d/%b/%Y:%T %z] "
-#define KLOG_STORE_FMT     "\"%.*s%.*s %u %u %u\" %d %u\n"
-#define KLOG_CAS_FMT       "\"%.*s%.*s %u %u %u %llu\" %d %u\n"
+#define KLOG_STORE_FMT     "\"%.*s%.*s %u %u%s %u\" %d %u\n"
+#define KLOG_CAS_FMT       "\"%.*s%.*s %u %u%s %u %llu\" %d %u\n"
 #define KLOG_GET_FMT       "\"%.*s %.*s\" %d %u\n"
 #define KLOG_DELTA_FMT     "\"%.*s%.*s %llu\" %d %u\n"
+#define KLOG_EXPIRY_MS     "ms" /* suffix of expiry in ms, as in requests */
 
 static struct logger *klogger;
 static uint64_t klog_cmds;
@@ -35,6 +36,7 @@ static char *klog_backup = NULL;
 static uint32_t klog_sample = KLOG_SAMPLE;
 static size_t klog_max = KLOG_MAX;
 static size_t klog_size;
+static bool klog_binary = KLOG_BINARY;
 
 bool klog_enabled = false;
 
@@ -92,6 +94,7 @@ klog_setup(klog_options_st *options, klog_metrics_st *metrics)
             goto error;
         }
         klog_max =  option_uint(&options->klog_max);
+        klog_binary = option_bool(&options->klog_binary);
     }
 
     if (filename == NULL) { /* no klog filename provided, do not log */
@@ -129,6 +132,7 @@ klog_teardown(void)
     klog_backup = NULL;
     klog_sample = KLOG_SAMPLE;
     klog_max = KLOG_MAX;
+    klog_binary = KLOG_BINARY;
     if (klog_backup != NULL) {
         cc_free(klog_backup);
     }
@@ -147,108 +151,149 @@ _get_val_rsp_len(struct response *rsp, struct bstring *key)
         + (rsp->num ? digits(rsp->vint) : rsp->vstr.len) + CRLF_LEN;
 }
 
-static inline void
-_klog_write_get(struct request *req, struct response *rsp, char *buf, int len)
-{
-    struct response *nr = rsp;
-    int suffix_len;
-    uint32_t i;
-    struct bstring *key;
+/*
+ * The timestamp only changes once a second, so the formatted string is cached
+ * and reused for all records of the same second. This is only ever used from
+ * one thread: the worker when logging, or the decoder.
+ */
+static struct clock_fmt klog_time = { .fmt = KLOG_TIME_FMT };
 
-    for (i = 0; i < array_nelem(req->keys); ++i) {
-        key = array_get(req->keys, i);
+/* TODO(kyang): update peer to log the peer instead of placeholder (CACHE-3492) */
+int
+klog_fmt_rec(char *buf, size_t cap, const struct klog_rec *rec, const char *key)
+{
+    int len, time_len;
+    char *peer = "-";
+    const struct bstring *op;
 
-        if (nr->type != RSP_END && bstring_compare(key, &nr->key) == 0) {
-            /* key was found, rsp at nr */
-            suffix_len = cc_scnprintf(buf + len, KLOG_MAX_LEN - len, KLOG_GET_FMT,
-                                      req_strings[req->type].len, req_strings[req->type].data,
-                                      key->len, key->data, rsp->type, _get_val_rsp_len(nr, key));
-            nr = STAILQ_NEXT(nr, next);
-        } else {
-            /* key not found */
-            suffix_len = cc_scnprintf(buf + len, KLOG_MAX_LEN - len, KLOG_GET_FMT,
-                                      req_strings[req->type].len, req_strings[req->type].data,
-                                      key->len, key->data, RSP_UNKNOWN, 0);
-        }
+    if (rec->op >= REQ_SENTINEL) {
+        return 0;
+    }
+    op = &req_strings[rec->op];
 
-        ASSERT(len + suffix_len <= KLOG_MAX_LEN);
+    len = cc_scnprintf(buf, cap, "%s - ", peer);
+    time_len = clock_format(&klog_time, buf + len, cap - len, rec->time);
+    if (time_len == 0) {
+        return 0;
+    }
+    len += time_len;
 
-        if (log_write(klogger, buf, len + suffix_len)) {
-            INCR(klog_metrics, klog_logged);
-        } else {
-            INCR(klog_metrics, klog_discard);
-        }
+    switch (rec->op) {
+    case REQ_GET:
+    case REQ_GETS:
+    case REQ_DELETE:
+        len += cc_scnprintf(buf + len, cap - len, KLOG_GET_FMT, op->len,
+                            op->data, rec->klen, key, rec->status, rec->rlen);
+        break;
+    case REQ_SET:
+    case REQ_ADD:
+    case REQ_REPLACE:
+    case REQ_APPEND:
+    case REQ_PREPEND:
+        len += cc_scnprintf(buf + len, cap - len, KLOG_STORE_FMT, op->len,
+                            op->data, rec->klen, key, rec->flag, rec->expiry,
+                            rec->expiry_ms ? KLOG_EXPIRY_MS : "", rec->vlen,
+                            rec->status, rec->rlen);
+        break;
+    case REQ_CAS:
+        len += cc_scnprintf(buf + len, cap - len, KLOG_CAS_FMT, op->len,
+                            op->data, rec->klen, key, rec->flag, rec->expiry,
+                            rec->expiry_ms ? KLOG_EXPIRY_MS : "", rec->vlen,
+                            (unsigned long long)rec->aux,
+                            rec->status, rec->rlen);
+        break;
+    case REQ_INCR:
+    case REQ_DECR:
+        len += cc_scnprintf(buf + len, cap - len, KLOG_DELTA_FMT, op->len,
+                            op->data, rec->klen, key,
+                            (unsigned long long)rec->aux, rec->status,
+                            rec->rlen);
+        break;
+    default:
+        return 0;
     }
 
-    ASSERT(nr ->type == RSP_END);
+    return len;
 }
 
-static inline int
-_klog_fmt_delete(struct request *req, struct response *rsp, char *buf, int len)
+/* write one record, in binary or as formatted text */
+static void
+_klog_write_rec(struct klog_rec *rec, const struct bstring *key)
 {
-    struct bstring *key = array_get(req->keys, 0);
+    char buf[KLOG_MAX_LEN];
+    int len;
 
-    len += cc_scnprintf(buf + len, KLOG_MAX_LEN - len, KLOG_GET_FMT, req_strings[req->type].len,
-                        req_strings[req->type].data, key->len, key->data, rsp->type,
-                        req->noreply ? 0 : rsp_strings[rsp->type].len);
+    ASSERT(key->len <= UINT8_MAX);
+    ASSERT(sizeof(*rec) + key->len <= KLOG_MAX_LEN);
 
-    return len;
-}
-
-static inline int
-_klog_fmt_store(struct request *req, struct response *rsp, char *buf, int len)
-{
-    struct bstring *key = array_get(req->keys, 0);
+    rec->klen = (uint8_t)key->len;
+    if (klog_binary) {
+        len = sizeof(*rec) + key->len;
+        cc_memcpy(buf, rec, sizeof(*rec));
+        cc_memcpy(buf + sizeof(*rec), key->data, key->len);
+    } else {
+        len = klog_fmt_rec(buf, KLOG_MAX_LEN, rec, key->data);
+        if (len == 0) {
+            return;
+        }
+    }
 
-    len += cc_scnprintf(buf + len, KLOG_MAX_LEN - len, KLOG_STORE_FMT, req_strings[req->type].len,
-                        req_strings[req->type].data, key->len, key->data, req->flag,
-                        req->expiry, req->vstr.len, rsp->type,
-                        req->noreply ? 0 : rsp_strings[rsp->type].len);
+    ASSERT(len <= KLOG_MAX_LEN);
 
-    return len;
+    if (log_write(klogger, buf, len)) {
+        INCR(klog_metrics, klog_logged);
+    } else {
+        INCR(klog_metrics, klog_discard);
+    }
 }
 
-static inline int
-_klog_fmt_cas(struct request *req, struct response *rsp, char *buf, int len)
+static inline void
+_klog_write_get(struct request *req, struct response *rsp, struct klog_rec *rec)
 {
-    struct bstring *key = array_get(req->keys, 0);
+    struct response *nr = rsp;
+    uint32_t i;
+    struct bstring *key;
 
-    len += cc_scnprintf(buf + len, KLOG_MAX_LEN - len, KLOG_CAS_FMT, req_strings[req->type].len,
-                        req_strings[req->type].data, key->len, key->data, req->flag,
-                        req->expiry, req->vstr.len, req->vcas, rsp->type,
-                        req->noreply ? 0 : rsp_strings[rsp->type].len);
+    for (i = 0; i < array_nelem(req->keys); ++i) {
+        key = array_get(req->keys, i);
 
-    return len;
+        if (nr->type != RSP_END && bstring_compare(key, &nr->key) == 0) {
+            /* key was found, rsp at nr */
+            rec->status = nr->type;
+            rec->rlen = _get_val_rsp_len(nr, key);
+            nr = STAILQ_NEXT(nr, next);
+        } else {
+            /* key not found */
+            rec->status = RSP_UNKNOWN;
+            rec->rlen = 0;
+        }
+
+        _klog_write_rec(rec, key);
+    }
+
+    ASSERT(nr->type == RSP_END);
 }
 
-static inline int
-_klog_fmt_delta(struct request *req, struct response *rsp, char *buf, int len)
+static inline void
+_klog_write_delta(struct request *req, struct response *rsp, struct klog_rec *rec)
 {
-    uint32_t rsp_len;
-    struct bstring *key = array_get(req->keys, 0);
-
     if (req->noreply) {
-        rsp_len = 0;
+        rec->rlen = 0;
     } else if (rsp->type == RSP_NUMERIC) {
-        rsp_len = digits(rsp->vint) + CRLF_LEN;
+        rec->rlen = digits(rsp->vint) + CRLF_LEN;
     } else {
-        rsp_len = rsp_strings[rsp->type].len;
+        rec->rlen = rsp_strings[rsp->type].len;
     }
+    rec->aux = req->delta;
 
-    len += cc_scnprintf(buf + len, KLOG_MAX_LEN - len, KLOG_DELTA_FMT, req_strings[req->type].len,
-                        req_strings[req->type].data, key->len, key->data, req->delta,
-                        rsp->type, rsp_len);
-
-    return len;
+    _klog_write_rec(rec, array_first(req->keys));
 }
 
-/* TODO(kyang): update peer to log the peer instead of placeholder (CACHE-3492) */
 void
 _klog_write(struct request *req, struct response *rsp)
 {
-    int len, time_len, errno_save;
-    char buf[KLOG_MAX_LEN], *peer = "-";
-    time_t t;
+    int errno_save;
+    struct klog_rec rec;
 
     if (klogger == NULL) {
         return;
@@ -263,50 +308,42 @@ _klog_write(struct request *req, struct response *rsp)
 
     errno_save = errno;
 
-    t = time_now_abs();
-    len = cc_scnprintf(buf, KLOG_MAX_LEN, "%s - ", peer);
-    time_len = strftime(buf + len, KLOG_MAX_LEN - len, KLOG_TIME_FMT, localtime(&t));
-    if (time_len == 0) {
-        log_error("strftime failed: %s", strerror(errno));
-        goto done;
-    }
-    len += time_len;
+    cc_memset(&rec, 0, sizeof(rec));
+    rec.time = (uint32_t)time_now_abs();
+    rec.magic = KLOG_REC_MAGIC;
+    rec.op = req->type;
+    rec.status = rsp->type;
+    rec.rlen = req->noreply ? 0 : rsp_strings[rsp->type].len;
 
     switch (req->type) {
     case REQ_GET:
     case REQ_GETS:
-        _klog_write_get(req, rsp, buf, len);
-        goto done;
+        _klog_write_get(req, rsp, &rec);
         break;
     case REQ_DELETE:
-        len = _klog_fmt_delete(req, rsp, buf, len);
+        _klog_write_rec(&rec, array_first(req->keys));
         break;
+    case REQ_CAS:
+        rec.aux = req->vcas;
+        /* fall through */
     case REQ_SET:
     case REQ_ADD:
     case REQ_REPLACE:
     case REQ_APPEND:
     case REQ_PREPEND:
-        len = _klog_fmt_store(req, rsp, buf, len);
-        break;
-    case REQ_CAS:
-        len = _klog_fmt_cas(req, rsp, buf, len);
+        rec.flag = req->flag;
+        rec.expiry = req->expiry;
+        rec.expiry_ms = req->expiry_ms;
+        rec.vlen = req->vstr.len;
+        _klog_write_rec(&rec, array_first(req->keys));
         break;
     case REQ_INCR:
     case REQ_DECR:
-        len = _klog_fmt_delta(req, rsp, buf, len);
+        _klog_write_delta(req, rsp, &rec);
         break;
     default:
-        goto done;
-    }
-
-    ASSERT(len <= KLOG_MAX_LEN);
-
-    if (log_write(klogger, buf, len)) {
-        INCR(klog_metrics, klog_logged);
-    } else {
-        INCR(klog_metrics, klog_discard);
+        break;
     }
 
-done:
     errno = errno_save;
 }
@@ -4,12 +4,14 @@
 #include <cc_metric.h>
 #include <cc_option.h>
 
+#include <stddef.h>
 #include <stdint.h>
 
 #define KLOG_NBUF   2 * MiB    /* default log buf size */
 #define KLOG_INTVL  100        /* flush every 100 milliseconds */
 #define KLOG_SAMPLE 100        /* log one in every 100 commands */
 #define KLOG_MAX    GiB        /* max klog file size */
+#define KLOG_BINARY false      /* log formatted text by default */
 
 /*          name         type              default       description */
 #define KLOG_OPTION(ACTION)                                                                     \
@@ -17,7 +19,8 @@
     ACTION( klog_backup, OPTION_TYPE_STR,  NULL,         "command log backup file"             )\
     ACTION( klog_nbuf,   OPTION_TYPE_UINT, KLOG_NBUF,    "command log buf size"                )\
     ACTION( klog_sample, OPTION_TYPE_UINT, KLOG_SAMPLE,  "command log sample ratio"            )\
-    ACTION( klog_max,    OPTION_TYPE_UINT, KLOG_MAX,     "klog file size to trigger rotation"  )
+    ACTION( klog_max,    OPTION_TYPE_UINT, KLOG_MAX,     "klog file size to trigger rotation"  )\
+    ACTION( klog_binary, OPTION_TYPE_BOOL, KLOG_BINARY,  "log binary records instead of text"  )
 
 typedef struct {
     KLOG_OPTION(OPTION_DECLARE)
@@ -33,6 +36,31 @@ typedef struct {
     KLOG_METRIC(METRIC_DECLARE)
 } klog_metrics_st;
 
+/**
+ * With klog_binary set, each logged command is written as a fixed-size record
+ * followed by the raw key, instead of a formatted line. Records are in host
+ * byte order and are meant to be decoded offline on a similar machine, e.g.
+ * with pelikan_klog_decode, which renders them in the same text format.
+ *
+ * op and status are the request and response types of the memcache protocol,
+ * aux holds the cas value of cas, and the delta of incr/decr commands.
+ */
+#define KLOG_REC_MAGIC 0x4b    /* 'K' */
+
+struct klog_rec {
+    uint32_t    time;       /* absolute unix time in seconds */
+    uint8_t     magic;      /* KLOG_REC_MAGIC */
+    uint8_t     op;         /* request type */
+    uint8_t     status;     /* response type */
+    uint8_t     klen;       /* key length, the key follows the record */
+    uint32_t    vlen;       /* value length of storage commands */
+    uint32_t    rlen;       /* response length */
+    uint32_t    flag;       /* flag of storage commands */
+    uint32_t    expiry;     /* expiry of storage commands */
+    uint64_t    aux;        /* cas value or delta */
+    uint8_t     expiry_ms;  /* 1 if expiry is in ms (extension) */
+};
+
 struct request;
 struct response;
 
@@ -50,3 +78,6 @@ void klog_teardown(void);
 void _klog_write(struct request *req, struct response *rsp);
 
 void klog_flush(void *arg); /* compatible type: timeout_cb_fn */
+
+/* render a record as a line of text into buf, returns 0 if it cannot */
+int klog_fmt_rec(char *buf, size_t cap, const struct klog_rec *rec, const char *key);
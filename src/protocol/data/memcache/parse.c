@@ -272,6 +272,52 @@ _chase_uint(uint64_t *num, struct buf *buf, bool *end, uint64_t max)
     return PARSE_EUNFIN;
 }
 
+/*
+ * exptime, in seconds as the protocol has it, or in milliseconds when suffixed
+ * with "ms" (an extension), e.g. "100ms"
+ */
+static parse_rstatus_t
+_chase_expiry(uint64_t *num, bool *ms, struct buf *buf, bool *end)
+{
+    char *p;
+    parse_rstatus_t status;
+    size_t len = 0;
+
+    *num = 0;
+    *ms = false;
+    for (p = buf->rpos; p < buf->wpos; p++) {
+        if (_token_oversize(buf, p)) {
+            return PARSE_EOVERSIZE;
+        }
+
+        if (*p == 'm' && len > 0 && !*ms) {
+            if (p + 1 == buf->wpos) {
+                return PARSE_EUNFIN;
+            }
+            if (*(++p) != 's') {
+                log_warn("ill formatted request: bad suffix in integer field");
+
+                return PARSE_EINVALID;
+            }
+            *ms = true;
+            continue;
+        }
+        if (*ms && isdigit(*p)) {
+            log_warn("ill formatted request: digit after suffix in integer "
+                    "field");
+
+            return PARSE_EINVALID;
+        }
+
+        status = _check_uint(num, buf, end, &len, p, UINT32_MAX);
+        if (status != PARSE_EUNFIN) {
+            return status;
+        }
+    }
+
+    return PARSE_EUNFIN;
+}
+
 static parse_rstatus_t
 _parse_val(struct bstring *val, struct buf *buf, uint32_t vlen)
 {
@@ -607,6 +653,7 @@ _subrequest_store(struct request *req, struct buf *buf, bool *end, bool cas)
 {
     parse_rstatus_t status;
     uint64_t n;
+    bool ms;
     struct bstring t;
 
     /* parsing order:
@@ -642,11 +689,12 @@ _subrequest_store(struct request *req, struct buf *buf, bool *end, bool cas)
         goto incomplete;
     }
     n = 0;
-    status = _chase_uint(&n, buf, end, UINT32_MAX);
+    status = _chase_expiry(&n, &ms, buf, end);
     if (status != PARSE_OK) {
         return status;
     }
     req->expiry = (uint32_t)n;
+    req->expiry_ms = ms;
     /* VLEN */
     if (*end) {
         goto incomplete;
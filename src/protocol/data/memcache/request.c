@@ -1,5 +1,7 @@
 #include <protocol/data/memcache/request.h>
 
+#include <time/time.h>
+
 #include <cc_debug.h>
 #include <cc_pool.h>
 
@@ -39,6 +41,7 @@ request_reset(struct request *req)
     req->delta = 0;
     req->vcas = 0;
 
+    req->expiry_ms = 0;
     req->noreply = 0;
     req->val = 0;
     req->serror = 0;
@@ -117,6 +120,16 @@ request_pool_create(uint32_t max)
     UPDATE_VAL(request_metrics, request_free, max);
 }
 
+uint64_t
+request_expire_at(const struct request *req)
+{
+    if (req->expiry_ms) {
+        return time_reltime_ms(req->expiry);
+    }
+
+    return time_sec2ms(time_reltime(req->expiry));
+}
+
 struct request *
 request_borrow(void)
 {
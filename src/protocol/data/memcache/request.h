@@ -89,6 +89,7 @@ struct request {
     uint64_t                delta;
     uint64_t                vcas;
 
+    unsigned                expiry_ms:1;/* expiry in ms (extension) */
     unsigned                noreply:1;
     unsigned                val:1;      /* value needed? */
     unsigned                serror:1;   /* server error */
@@ -102,5 +103,11 @@ struct request *request_create(void);
 void request_destroy(struct request **req);
 void request_reset(struct request *req);
 
+/*
+ * expiry of a storage command as a rel_time_ms_t (see time/time.h), whether it
+ * was given in seconds or in ms (extension)
+ */
+uint64_t request_expire_at(const struct request *req);
+
 struct request *request_borrow(void);
 void request_return(struct request **req);
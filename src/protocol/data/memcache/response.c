@@ -172,6 +172,94 @@ response_return_all(struct response **response)
     *response = NULL;
 }
 
+struct response_vec *
+response_vec_create(uint32_t nalloc)
+{
+    struct response_vec *vec;
+
+    vec = cc_alloc(sizeof(struct response_vec));
+    if (vec == NULL) {
+        return NULL;
+    }
+
+    vec->nused = 0;
+    vec->nalloc = nalloc > 0 ? nalloc : 1;
+    vec->rsp = cc_alloc(sizeof(struct response) * vec->nalloc);
+    if (vec->rsp == NULL) {
+        cc_free(vec);
+        return NULL;
+    }
+
+    log_vverb("created rsp vector %p of %"PRIu32" responses", vec, vec->nalloc);
+
+    return vec;
+}
+
+void
+response_vec_destroy(struct response_vec **response_vec)
+{
+    struct response_vec *vec = *response_vec;
+
+    if (vec == NULL) {
+        return;
+    }
+
+    cc_free(vec->rsp);
+    cc_free(vec);
+    *response_vec = NULL;
+}
+
+/*
+ * Hand out n responses from the head of the vector, chained through `next'
+ * the same way as a chain of borrowed responses. The vector grows if needed.
+ */
+struct response *
+response_vec_borrow(struct response_vec *vec, uint32_t n)
+{
+    struct response *rsp;
+    uint32_t i, nalloc;
+
+    ASSERT(vec != NULL);
+    ASSERT(vec->nused == 0);
+    ASSERT(n > 0);
+
+    if (n > vec->nalloc) {
+        for (nalloc = vec->nalloc; nalloc < n; nalloc *= 2);
+        rsp = cc_realloc(vec->rsp, sizeof(struct response) * nalloc);
+        if (rsp == NULL) {
+            log_debug("grow rsp vector to %"PRIu32" failed: OOM", nalloc);
+
+            return NULL;
+        }
+        vec->rsp = rsp;
+        vec->nalloc = nalloc;
+
+        INCR(response_metrics, response_vec_grow);
+        log_verb("grew rsp vector %p to %"PRIu32" responses", vec, nalloc);
+    }
+
+    for (i = 0; i < n; i++) {
+        response_reset(&vec->rsp[i]);
+        if (i > 0) {
+            STAILQ_NEXT(&vec->rsp[i - 1], next) = &vec->rsp[i];
+        }
+    }
+    vec->nused = n;
+
+    return vec->rsp;
+}
+
+/*
+ * Return all responses handed out by the vector
+ */
+void
+response_vec_return(struct response_vec *vec)
+{
+    ASSERT(vec != NULL);
+
+    vec->nused = 0;
+}
+
 void
 response_setup(response_options_st *options, response_metrics_st *metrics)
 {
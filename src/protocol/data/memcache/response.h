@@ -8,6 +8,7 @@
 #include <cc_util.h>
 
 #define RSP_POOLSIZE 0
+#define RSP_VEC_INIT 16
 
 /*          name                type                default         description */
 #define RESPONSE_OPTION(ACTION)                                                             \
@@ -23,7 +24,8 @@ typedef struct {
     ACTION( response_borrow,    METRIC_COUNTER, "# rsps borrowed"      )\
     ACTION( response_return,    METRIC_COUNTER, "# rsps returned"      )\
     ACTION( response_create,    METRIC_COUNTER, "# rsps created"       )\
-    ACTION( response_destroy,   METRIC_COUNTER, "# rsps destroyed"     )
+    ACTION( response_destroy,   METRIC_COUNTER, "# rsps destroyed"     )\
+    ACTION( response_vec_grow,  METRIC_COUNTER, "# rsp vector resizes" )
 
 typedef struct {
     RESPONSE_METRIC(METRIC_DECLARE)
@@ -93,6 +95,22 @@ struct response {
     unsigned                error:1;    /* error */
 };
 
+/*
+ * A response vector is a contiguous, grow-only array of response objects owned
+ * by a single thread. It serves requests that need many responses at once
+ * (e.g. multi-key get): a batch is handed out by resetting and chaining the
+ * leading slots, and is returned as a whole by clearing the counter, so there
+ * is no per-response pool traffic.
+ *
+ * Since the vector may be reallocated when it grows, only one batch can be
+ * outstanding at any time.
+ */
+struct response_vec {
+    struct response         *rsp;       /* contiguous response objects */
+    uint32_t                nalloc;     /* # responses allocated */
+    uint32_t                nused;      /* # responses handed out */
+};
+
 void response_setup(response_options_st *options, response_metrics_st *metrics);
 void response_teardown(void);
 
@@ -103,3 +121,8 @@ void response_reset(struct response *rsp);
 struct response *response_borrow(void);
 void response_return(struct response **rsp);
 void response_return_all(struct response **rsp); /* return all responses in chain */
+
+struct response_vec *response_vec_create(uint32_t nalloc);
+void response_vec_destroy(struct response_vec **vec);
+struct response *response_vec_borrow(struct response_vec *vec, uint32_t n);
+void response_vec_return(struct response_vec *vec);
@@ -0,0 +1,216 @@
+#include <protocol/data/redis/compose.h>
+
+#include <protocol/data/redis/request.h>
+#include <protocol/data/redis/response.h>
+
+#include <cc_debug.h>
+#include <cc_print.h>
+
+#define COMPOSE_MODULE_NAME "protocol::redis::compose"
+
+#define NIL_STR "$-1\r\n"
+#define NIL_LEN (sizeof(NIL_STR) - 1)
+
+static bool compose_init = false;
+static compose_req_metrics_st *compose_req_metrics = NULL;
+static compose_rsp_metrics_st *compose_rsp_metrics = NULL;
+
+void
+compose_setup(compose_req_metrics_st *req, compose_rsp_metrics_st *rsp)
+{
+    log_info("set up the %s module", COMPOSE_MODULE_NAME);
+
+    if (compose_init) {
+        log_warn("%s has already been setup, overwrite", COMPOSE_MODULE_NAME);
+    }
+
+    compose_req_metrics = req;
+    compose_rsp_metrics = rsp;
+
+    compose_init = true;
+}
+
+void
+compose_teardown(void)
+{
+    log_info("tear down the %s module", COMPOSE_MODULE_NAME);
+
+    if (!compose_init) {
+        log_warn("%s has never been setup", COMPOSE_MODULE_NAME);
+    }
+    compose_req_metrics = NULL;
+    compose_rsp_metrics = NULL;
+    compose_init = false;
+}
+
+/*
+ * common functions
+ */
+
+static inline compose_rstatus_t
+_check_buf_size(struct buf **buf, uint32_t n)
+{
+    while (n > buf_wsize(*buf)) {
+        if (dbuf_double(buf) != CC_OK) {
+            log_debug("failed to write  %u bytes to buf %p: insufficient "
+                    "buffer space", n, *buf);
+
+            return COMPOSE_ENOMEM;
+        }
+    }
+
+    return CC_OK;
+}
+
+/* the caller is expected to have checked there are CC_INT64_MAXLEN bytes */
+static inline int
+_write_int64(struct buf **buf, int64_t val)
+{
+    size_t n;
+    struct buf *b = *buf;
+
+    n = cc_print_int64_unsafe((char *)b->wpos, val);
+    b->wpos += n;
+
+    log_vverb("wrote int %"PRId64" to buf %p", val, b);
+
+    return n;
+}
+
+static inline int
+_write_bstring(struct buf **buf, const struct bstring *str)
+{
+    return buf_write(*buf, str->data, str->len);
+}
+
+static inline int
+_crlf(struct buf **buf)
+{
+    return buf_write(*buf, CRLF, CRLF_LEN);
+}
+
+/* type byte followed by an integer, e.g. "*2\r\n", "$3\r\n" or ":1\r\n" */
+static inline int
+_write_int_line(struct buf **buf, element_type_t type, int64_t val)
+{
+    int n = 0;
+
+    n += _write_bstring(buf, &elem_strings[type]);
+    n += _write_int64(buf, val);
+    n += _crlf(buf);
+
+    return n;
+}
+
+static inline int
+_write_bulk(struct buf **buf, const struct bstring *str)
+{
+    int n = 0;
+
+    n += _write_int_line(buf, ELEM_BULK, str->len);
+    n += _write_bstring(buf, str);
+    n += _crlf(buf);
+
+    return n;
+}
+
+/* bytes needed for the header of a bulk string or an array, CRLF included */
+#define HDR_MAXLEN (1 + CC_INT64_MAXLEN + CRLF_LEN)
+
+/*
+ * request specific functions
+ */
+
+/* requests are always composed as an array of bulk strings */
+int
+compose_req(struct buf **buf, struct request *req)
+{
+    struct bstring *t;
+    uint32_t i, ntoken = array_nelem(req->token);
+    uint32_t sz = HDR_MAXLEN;
+    int n = 0;
+
+    for (i = 0; i < ntoken; i++) {
+        t = array_get(req->token, i);
+        sz += HDR_MAXLEN + t->len + CRLF_LEN;
+    }
+    if (_check_buf_size(buf, sz) != COMPOSE_OK) {
+        INCR(compose_req_metrics, request_compose_ex);
+
+        return COMPOSE_ENOMEM;
+    }
+
+    n += _write_int_line(buf, ELEM_ARRAY, ntoken);
+    for (i = 0; i < ntoken; i++) {
+        n += _write_bulk(buf, array_get(req->token, i));
+    }
+
+    INCR(compose_req_metrics, request_compose);
+
+    return n;
+}
+
+/*
+ * response specific functions
+ */
+
+int
+compose_rsp(struct buf **buf, struct response *rsp)
+{
+    int n = 0;
+    element_type_t type = rsp->type;
+    struct bstring *str = &elem_strings[type];
+
+    log_verb("composing rsp into buf %p from rsp object %p", *buf, rsp);
+
+    switch (type) {
+    case ELEM_STR:
+    case ELEM_ERR:
+        if (_check_buf_size(buf, str->len + rsp->vstr.len + CRLF_LEN) !=
+                COMPOSE_OK) {
+            goto error;
+        }
+        n += _write_bstring(buf, str);
+        n += _write_bstring(buf, &rsp->vstr);
+        n += _crlf(buf);
+        break;
+
+    case ELEM_INT:
+    case ELEM_ARRAY:
+        if (_check_buf_size(buf, HDR_MAXLEN) != COMPOSE_OK) {
+            goto error;
+        }
+        n += _write_int_line(buf, type, rsp->vint);
+        break;
+
+    case ELEM_BULK:
+        if (_check_buf_size(buf, HDR_MAXLEN + rsp->vstr.len + CRLF_LEN) !=
+                COMPOSE_OK) {
+            goto error;
+        }
+        n += _write_bulk(buf, &rsp->vstr);
+        break;
+
+    case ELEM_NIL:
+        if (_check_buf_size(buf, NIL_LEN) != COMPOSE_OK) {
+            goto error;
+        }
+        n += buf_write(*buf, NIL_STR, NIL_LEN);
+        break;
+
+    default:
+        NOT_REACHED();
+        break;
+    }
+
+    log_verb("response type %d, total length %d", rsp->type, n);
+
+    INCR(compose_rsp_metrics, response_compose);
+
+    return n;
+
+error:
+    INCR(compose_rsp_metrics, response_compose_ex);
+
+    return COMPOSE_ENOMEM;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#define MAX_KEY_LEN     250     /* limited by the 1-byte key length in storage */
+#define MAX_TOKEN_LEN   32      /* type byte, length/integer and CRLF */
+#define MAX_INLINE_LEN  (64 * KiB)
+#define MAX_BULK_LEN    (512 * MiB)
+#define MAX_NTOKEN      1024    /* # elements in a request array */
+#define NTOKEN_INIT     4       /* initial # of tokens allocated per request */
@@ -0,0 +1,437 @@
+#include <protocol/data/redis/parse.h>
+
+#include <protocol/data/redis/request.h>
+#include <protocol/data/redis/response.h>
+
+#include <buffer/cc_buf.h>
+#include <cc_array.h>
+#include <cc_bstring.h>
+#include <cc_debug.h>
+#include <cc_define.h>
+#include <cc_util.h>
+
+#include <strings.h>
+
+#define PARSE_MODULE_NAME "protocol::redis::parse"
+
+static bool parse_init = false;
+static parse_req_metrics_st *parse_req_metrics = NULL;
+static parse_rsp_metrics_st *parse_rsp_metrics = NULL;
+
+void
+parse_setup(parse_req_metrics_st *req, parse_rsp_metrics_st *rsp)
+{
+    log_info("set up the %s module", PARSE_MODULE_NAME);
+
+    if (parse_init) {
+        log_warn("%s has already been setup, overwrite", PARSE_MODULE_NAME);
+    }
+
+    parse_req_metrics = req;
+    parse_rsp_metrics = rsp;
+
+    parse_init = true;
+}
+
+void
+parse_teardown(void)
+{
+    log_info("tear down the %s module", PARSE_MODULE_NAME);
+
+    if (!parse_init) {
+        log_warn("%s has never been setup", PARSE_MODULE_NAME);
+    }
+    parse_req_metrics = NULL;
+    parse_rsp_metrics = NULL;
+    parse_init = false;
+}
+
+/*
+ * common functions
+ */
+
+/*
+ * Read a line starting at rpos into line (without the line ending), and move
+ * rpos past it. Lines of the RESP protocol must end with CRLF (strict), while
+ * inline commands are also allowed to end with a bare LF.
+ */
+static parse_rstatus_t
+_read_line(struct bstring *line, struct buf *buf, uint32_t max, bool strict)
+{
+    char *lf;
+    uint32_t size = buf_rsize(buf);
+
+    lf = cc_memchr(buf->rpos, LF, MIN(size, max));
+    if (lf == NULL) {
+        return (size >= max) ? PARSE_EOVERSIZE : PARSE_EUNFIN;
+    }
+
+    line->data = buf->rpos;
+    line->len = lf - buf->rpos;
+    if (line->len > 0 && *(lf - 1) == CR) {
+        line->len--;
+    } else if (strict) {
+        log_warn("ill formatted line: LF without CR");
+        return PARSE_EINVALID;
+    }
+    buf->rpos = lf + 1;
+
+    return PARSE_OK;
+}
+
+/* read a line such as ":1", "$3" or "*2" into its integer value */
+static parse_rstatus_t
+_read_int(int64_t *val, struct buf *buf, char type)
+{
+    parse_rstatus_t status;
+    struct bstring line;
+
+    if (buf_rsize(buf) == 0) {
+        return PARSE_EUNFIN;
+    }
+    if (*buf->rpos != type) {
+        log_warn("ill formatted element: expecting type '%c'", type);
+        return PARSE_EINVALID;
+    }
+
+    status = _read_line(&line, buf, MAX_TOKEN_LEN, true);
+    if (status != PARSE_OK) {
+        return status;
+    }
+
+    line.data++;
+    line.len--;
+    if (bstring_atoi64(val, &line) != CC_OK) {
+        log_warn("ill formatted element: not an integer");
+        return PARSE_EINVALID;
+    }
+
+    return PARSE_OK;
+}
+
+/* read a bulk string, a length of -1 denotes a null (nil) bulk string */
+static parse_rstatus_t
+_read_bulk(struct bstring *str, bool *nil, struct buf *buf)
+{
+    parse_rstatus_t status;
+    int64_t len;
+
+    status = _read_int(&len, buf, '$');
+    if (status != PARSE_OK) {
+        return status;
+    }
+
+    *nil = (len == -1);
+    if (*nil) {
+        bstring_init(str);
+        return PARSE_OK;
+    }
+    if (len < 0) {
+        log_warn("ill formatted bulk string: negative length %"PRId64, len);
+        return PARSE_EINVALID;
+    }
+    if (len > MAX_BULK_LEN) {
+        log_warn("bulk string of %"PRId64" bytes is oversized", len);
+        return PARSE_EOVERSIZE;
+    }
+
+    if (buf_rsize(buf) < len + CRLF_LEN) {
+        return PARSE_EUNFIN;
+    }
+    if (*(buf->rpos + len) != CR || *(buf->rpos + len + 1) != LF) {
+        log_warn("ill formatted bulk string: no CRLF after data");
+        return PARSE_EINVALID;
+    }
+
+    str->data = buf->rpos;
+    str->len = (uint32_t)len;
+    buf->rpos += len + CRLF_LEN;
+
+    return PARSE_OK;
+}
+
+
+/*
+ * request specific functions
+ */
+
+static inline parse_rstatus_t
+_push_token(struct request *req, char *data, uint32_t len)
+{
+    struct bstring *t;
+
+    if (array_nelem(req->token) >= MAX_NTOKEN) {
+        log_warn("request has too many tokens");
+        return PARSE_EOVERSIZE;
+    }
+
+    t = array_push(req->token);
+    if (t == NULL) {
+        log_warn("cannot allocate token: OOM");
+        return PARSE_EOTHER;
+    }
+    t->data = data;
+    t->len = len;
+
+    return PARSE_OK;
+}
+
+/* an array of bulk strings, e.g. "*2\r\n$3\r\nget\r\n$3\r\nfoo\r\n" */
+static parse_rstatus_t
+_parse_req_array(struct request *req, struct buf *buf)
+{
+    parse_rstatus_t status;
+    struct bstring t;
+    int64_t i, n;
+    bool nil;
+
+    status = _read_int(&n, buf, '*');
+    if (status != PARSE_OK) {
+        return status;
+    }
+    if (n <= 0) {
+        return PARSE_EEMPTY;
+    }
+    if (n > MAX_NTOKEN) {
+        log_warn("request array has %"PRId64" elements, too many", n);
+        return PARSE_EOVERSIZE;
+    }
+
+    for (i = 0; i < n; i++) {
+        status = _read_bulk(&t, &nil, buf);
+        if (status != PARSE_OK) {
+            return status;
+        }
+        if (nil) {
+            log_warn("ill formatted request: null bulk string");
+            return PARSE_EINVALID;
+        }
+
+        status = _push_token(req, t.data, t.len);
+        if (status != PARSE_OK) {
+            return status;
+        }
+    }
+
+    return PARSE_OK;
+}
+
+/* an inline command, tokens are separated by spaces, e.g. "get foo\r\n" */
+static parse_rstatus_t
+_parse_req_inline(struct request *req, struct buf *buf)
+{
+    parse_rstatus_t status;
+    struct bstring line;
+    char *p, *begin, *end;
+
+    status = _read_line(&line, buf, MAX_INLINE_LEN, false);
+    if (status != PARSE_OK) {
+        return status;
+    }
+
+    end = line.data + line.len;
+    for (p = line.data; p < end; p++) {
+        if (*p == ' ') {
+            continue;
+        }
+
+        for (begin = p; p < end && *p != ' '; p++);
+        status = _push_token(req, begin, p - begin);
+        if (status != PARSE_OK) {
+            return status;
+        }
+    }
+
+    return (array_nelem(req->token) == 0) ? PARSE_EEMPTY : PARSE_OK;
+}
+
+static void
+_lookup_type(struct request *req)
+{
+    struct bstring *cmd = array_first(req->token);
+    request_type_t type;
+
+    for (type = REQ_UNKNOWN + 1; type < REQ_SENTINEL; type++) {
+        if (cmd->len == req_strings[type].len &&
+                strncasecmp(cmd->data, req_strings[type].data, cmd->len) == 0) {
+            req->type = type;
+            return;
+        }
+    }
+
+    log_verb("unknown command of %"PRIu32" bytes", cmd->len);
+    req->type = REQ_UNKNOWN;
+}
+
+/*
+ * An unknown command or one with the wrong number of arguments still parses,
+ * since the connection can continue after an error reply. Only requests that
+ * cannot be delimited are treated as parsing errors.
+ */
+parse_rstatus_t
+parse_req(struct request *req, struct buf *buf)
+{
+    parse_rstatus_t status = PARSE_EUNFIN;
+    char *old_rpos = buf->rpos;
+
+    ASSERT(req->rstate == REQ_PARSING);
+
+    log_verb("parsing buf %p into req %p", buf, req);
+
+    if (buf_rsize(buf) == 0) {
+        return PARSE_EUNFIN;
+    }
+
+    if (*buf->rpos == '*') {
+        status = _parse_req_array(req, buf);
+    } else {
+        status = _parse_req_inline(req, buf);
+    }
+
+    if (status == PARSE_EUNFIN) {
+        log_verb("incomplete data: reset read position, jump back %zu bytes",
+                buf->rpos - old_rpos);
+        buf->rpos = old_rpos; /* start from beginning next time */
+        req->token->nelem = 0;
+        return PARSE_EUNFIN;
+    }
+    if (status == PARSE_EEMPTY) {
+        log_verb("empty request skipped");
+        return PARSE_EEMPTY;
+    }
+    if (status != PARSE_OK) {
+        log_debug("parse req returned error state %d", status);
+        req->cerror = 1;
+        INCR(parse_req_metrics, request_parse_ex);
+    } else {
+        _lookup_type(req);
+        req->rstate = REQ_PARSED;
+        INCR(parse_req_metrics, request_parse);
+    }
+
+    return status;
+}
+
+
+/*
+ * response specific functions
+ */
+
+static parse_rstatus_t
+_parse_rsp_str(struct response *rsp, struct buf *buf)
+{
+    parse_rstatus_t status;
+    struct bstring line;
+
+    status = _read_line(&line, buf, MAX_INLINE_LEN, true);
+    if (status == PARSE_OK) {
+        rsp->vstr.data = line.data + 1;
+        rsp->vstr.len = line.len - 1;
+    }
+
+    return status;
+}
+
+static parse_rstatus_t
+_parse_rsp_bulk(struct response *rsp, struct buf *buf)
+{
+    parse_rstatus_t status;
+    bool nil;
+
+    status = _read_bulk(&rsp->vstr, &nil, buf);
+    if (status == PARSE_OK && nil) {
+        rsp->type = ELEM_NIL;
+    }
+
+    return status;
+}
+
+static parse_rstatus_t
+_parse_rsp_array(struct response *rsp, struct buf *buf)
+{
+    parse_rstatus_t status;
+
+    status = _read_int(&rsp->vint, buf, '*');
+    if (status != PARSE_OK) {
+        return status;
+    }
+
+    if (rsp->vint == -1) { /* null array, treated the same as nil */
+        rsp->type = ELEM_NIL;
+        rsp->vint = 0;
+    } else if (rsp->vint < 0) {
+        log_warn("ill formatted array: negative length %"PRId64, rsp->vint);
+        return PARSE_EINVALID;
+    }
+
+    return PARSE_OK;
+}
+
+/*
+ * Parse one element. For an array, only the header is parsed and the number
+ * of elements stored in vint, the caller is expected to parse the elements.
+ */
+parse_rstatus_t
+parse_rsp(struct response *rsp, struct buf *buf)
+{
+    parse_rstatus_t status = PARSE_EUNFIN;
+    char *old_rpos = buf->rpos;
+
+    ASSERT(rsp->rstate == RSP_PARSING);
+
+    log_verb("parsing buf %p into rsp %p", buf, rsp);
+
+    if (buf_rsize(buf) == 0) {
+        return PARSE_EUNFIN;
+    }
+
+    switch (*buf->rpos) {
+    case '+':
+        rsp->type = ELEM_STR;
+        status = _parse_rsp_str(rsp, buf);
+        break;
+
+    case '-':
+        rsp->type = ELEM_ERR;
+        status = _parse_rsp_str(rsp, buf);
+        break;
+
+    case ':':
+        rsp->type = ELEM_INT;
+        status = _read_int(&rsp->vint, buf, ':');
+        break;
+
+    case '$':
+        rsp->type = ELEM_BULK;
+        status = _parse_rsp_bulk(rsp, buf);
+        break;
+
+    case '*':
+        rsp->type = ELEM_ARRAY;
+        status = _parse_rsp_array(rsp, buf);
+        break;
+
+    default:
+        log_warn("ill formatted response: unknown type byte");
+        status = PARSE_EINVALID;
+        break;
+    }
+
+    if (status == PARSE_EUNFIN) {
+        log_verb("incomplete data: reset read position, jump back %zu bytes",
+                buf->rpos - old_rpos);
+        buf->rpos = old_rpos; /* start from beginning next time */
+        rsp->type = ELEM_UNKNOWN;
+        return PARSE_EUNFIN;
+    }
+    if (status != PARSE_OK) {
+        log_debug("parse rsp returned error state %d", status);
+        rsp->error = 1;
+        INCR(parse_rsp_metrics, response_parse_ex);
+    } else {
+        rsp->rstate = RSP_PARSED;
+        INCR(parse_rsp_metrics, response_parse);
+    }
+
+    return status;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <protocol/data/redis/constant.h>
+
+#include <cc_array.h>
+#include <cc_bstring.h>
+#include <cc_define.h>
+#include <cc_metric.h>
+#include <cc_mm.h>
+#include <cc_option.h>
+#include <cc_queue.h>
+
+#include <inttypes.h>
+
+#define REQ_POOLSIZE 0
+
+/*          name                type                default         description */
+#define REQUEST_OPTION(ACTION)                                                          \
+    ACTION( request_poolsize,   OPTION_TYPE_UINT,   REQ_POOLSIZE,   "request pool size")
+
+typedef struct {
+    REQUEST_OPTION(OPTION_DECLARE)
+} request_options_st;
+
+/*          name                type            description */
+#define REQUEST_METRIC(ACTION)                                          \
+    ACTION( request_free,       METRIC_GAUGE,   "# free req in pool"   )\
+    ACTION( request_borrow,     METRIC_COUNTER, "# reqs borrowed"      )\
+    ACTION( request_return,     METRIC_COUNTER, "# reqs returned"      )\
+    ACTION( request_create,     METRIC_COUNTER, "# reqs created"       )\
+    ACTION( request_destroy,    METRIC_COUNTER, "# reqs destroyed"     )
+
+typedef struct {
+    REQUEST_METRIC(METRIC_DECLARE)
+} request_metrics_st;
+
+/**
+ * Commands are matched case-insensitively by name. The arity follows the redis
+ * convention: it counts the command name itself, a positive value means that
+ * exact number of tokens, and a negative value means at least that many.
+ */
+#define REQ_TYPE_MSG(ACTION)                        \
+    ACTION( REQ_UNKNOWN,        "",         0      )\
+    ACTION( REQ_GET,            "get",      2      )\
+    ACTION( REQ_SET,            "set",      -3     )\
+    ACTION( REQ_DEL,            "del",      -2     )\
+    ACTION( REQ_INCR,           "incr",     2      )\
+    ACTION( REQ_EXPIRE,         "expire",   3      )\
+    ACTION( REQ_MGET,           "mget",     -2     )\
+    ACTION( REQ_PING,           "ping",     -1     )\
+    ACTION( REQ_QUIT,           "quit",     1      )
+
+#define GET_TYPE(_name, _str, _narg) _name,
+typedef enum request_type {
+    REQ_TYPE_MSG(GET_TYPE)
+    REQ_SENTINEL
+} request_type_t;
+#undef GET_TYPE
+
+extern struct bstring req_strings[REQ_SENTINEL];
+extern int32_t req_narg[REQ_SENTINEL];
+
+typedef enum request_state {
+    REQ_PARSING,
+    REQ_PARSED,
+    REQ_PROCESSING,
+    REQ_DONE
+} request_state_t;
+
+/*
+ * A request is an array of tokens, the first of which is the command name.
+ * Both inline commands and arrays of bulk strings are parsed into this form.
+ *
+ * NOTE(yao): as with memcache, tokens are stored as location in rbuf, which
+ * assumes the data will not be overwritten before the request is completed.
+ */
+struct request {
+    STAILQ_ENTRY(request)   next;       /* allow request pooling */
+    bool                    free;
+
+    request_state_t         rstate;     /* request state */
+
+    request_type_t          type;
+
+    struct array            *token;     /* elements are bstrings */
+
+    unsigned                cerror:1;   /* client error */
+};
+
+void request_setup(request_options_st *options, request_metrics_st *metrics);
+void request_teardown(void);
+
+struct request *request_create(void);
+void request_destroy(struct request **req);
+void request_reset(struct request *req);
+
+struct request *request_borrow(void);
+void request_return(struct request **req);
+
+/* whether the number of tokens agrees with the arity of the command */
+static inline bool
+request_narg_valid(struct request *req)
+{
+    int32_t narg = req_narg[req->type];
+    uint32_t ntoken = array_nelem(req->token);
+
+    return (narg >= 0) ? (ntoken == (uint32_t)narg) : (ntoken >= (uint32_t)-narg);
+}
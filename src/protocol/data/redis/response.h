@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cc_bstring.h>
+#include <cc_define.h>
+#include <cc_metric.h>
+#include <cc_option.h>
+#include <cc_queue.h>
+#include <cc_util.h>
+
+#include <inttypes.h>
+
+#define RSP_POOLSIZE 0
+#define RSP_VEC_INIT 16
+
+/*          name                type                default         description */
+#define RESPONSE_OPTION(ACTION)                                                             \
+    ACTION( response_poolsize,  OPTION_TYPE_UINT,   RSP_POOLSIZE,   "response pool size"   )
+
+typedef struct {
+    RESPONSE_OPTION(OPTION_DECLARE)
+} response_options_st;
+
+/*          name                type            description */
+#define RESPONSE_METRIC(ACTION)                                         \
+    ACTION( response_free,      METRIC_GAUGE,   "# free rsp in pool"   )\
+    ACTION( response_borrow,    METRIC_COUNTER, "# rsps borrowed"      )\
+    ACTION( response_return,    METRIC_COUNTER, "# rsps returned"      )\
+    ACTION( response_create,    METRIC_COUNTER, "# rsps created"       )\
+    ACTION( response_destroy,   METRIC_COUNTER, "# rsps destroyed"     )\
+    ACTION( response_vec_grow,  METRIC_COUNTER, "# rsp vector resizes" )
+
+typedef struct {
+    RESPONSE_METRIC(METRIC_DECLARE)
+} response_metrics_st;
+
+/**
+ * A response is a single RESP2 element, identified by its leading byte. A null
+ * bulk string is written as the bulk type with a length of -1, and an array is
+ * represented by its header only, its elements follow as separate responses.
+ */
+#define ELEM_TYPE_MSG(ACTION)                       \
+    ACTION( ELEM_UNKNOWN,       ""                 )\
+    ACTION( ELEM_STR,           "+"                )\
+    ACTION( ELEM_ERR,           "-"                )\
+    ACTION( ELEM_INT,           ":"                )\
+    ACTION( ELEM_BULK,          "$"                )\
+    ACTION( ELEM_NIL,           "$"                )\
+    ACTION( ELEM_ARRAY,         "*"                )
+
+#define GET_TYPE(_name, _str) _name,
+typedef enum element_type {
+    ELEM_TYPE_MSG(GET_TYPE)
+    ELEM_SENTINEL
+} element_type_t;
+#undef GET_TYPE
+
+extern struct bstring elem_strings[ELEM_SENTINEL];
+
+typedef enum response_state {
+    RSP_PARSING,
+    RSP_PARSED,
+    RSP_PROCESSING,
+    RSP_DONE
+} response_state_t;
+
+struct response {
+    STAILQ_ENTRY(response)  next;       /* allow response pooling/chaining */
+    bool                    free;
+
+    response_state_t        rstate;     /* response state */
+
+    element_type_t          type;
+
+    struct bstring          vstr;       /* simple/bulk string or error message */
+    int64_t                 vint;       /* integer, or # elements of an array */
+
+    unsigned                error:1;    /* error */
+};
+
+/*
+ * A response vector is a contiguous, grow-only array of response objects owned
+ * by a single thread, see the memcache protocol module for details. Only one
+ * batch can be outstanding at any time.
+ */
+struct response_vec {
+    struct response         *rsp;       /* contiguous response objects */
+    uint32_t                nalloc;     /* # responses allocated */
+    uint32_t                nused;      /* # responses handed out */
+};
+
+void response_setup(response_options_st *options, response_metrics_st *metrics);
+void response_teardown(void);
+
+struct response *response_create(void);
+void response_destroy(struct response **rsp);
+void response_reset(struct response *rsp);
+
+struct response *response_borrow(void);
+void response_return(struct response **rsp);
+void response_return_all(struct response **rsp); /* return all responses in chain */
+
+struct response_vec *response_vec_create(uint32_t nalloc);
+void response_vec_destroy(struct response_vec **vec);
+struct response *response_vec_borrow(struct response_vec *vec, uint32_t n);
+void response_vec_return(struct response_vec *vec);
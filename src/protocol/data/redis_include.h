@@ -0,0 +1,4 @@
+#include <protocol/data/redis/compose.h>
+#include <protocol/data/redis/parse.h>
+#include <protocol/data/redis/request.h>
+#include <protocol/data/redis/response.h>
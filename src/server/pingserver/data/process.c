@@ -1,5 +1,6 @@
 #include "process.h"
 
+#include <core/data/shared.h>
 #include <protocol/data/ping_include.h>
 
 #include <buffer/cc_dbuf.h>
@@ -12,8 +13,10 @@ pingserver_process_read(struct buf **rbuf, struct buf **wbuf, void **data)
 
     log_verb("post-read processing");
 
-    /* keep parse-process-compose until running out of data in rbuf */
-    while (buf_rsize(*rbuf) > 0) {
+    /* keep parse-process-compose until running out of data in rbuf, or until
+     * enough replies are held, the rest is left for when they have drained
+     */
+    while (buf_rsize(*rbuf) > 0 && !worker_wbuf_full(*wbuf)) {
         log_verb("%"PRIu32" bytes left", buf_rsize(*rbuf));
 
         status = parse_req(*rbuf);
@@ -63,6 +63,7 @@ teardown(void)
     timing_wheel_teardown();
     tcp_teardown();
     sockio_teardown();
+    efd_teardown();
     event_teardown();
     dbuf_teardown();
     buf_teardown();
@@ -84,7 +85,7 @@ setup(void)
 
     /* Setup logging first */
     log_setup(&stats.log);
-    if (debug_setup(&setting.debug) < 0) {
+    if (debug_setup(&setting.debug, &stats.debug) < 0) {
         log_stderr("debug log setup failed");
         goto error;
     }
@@ -103,6 +104,7 @@ setup(void)
     buf_setup(&setting.buf, &stats.buf);
     dbuf_setup(&setting.dbuf, &stats.dbuf);
     event_setup(&stats.event);
+    efd_setup(&stats.efd);
     sockio_setup(&setting.sockio);
     tcp_setup(&setting.tcp, &stats.tcp);
     timing_wheel_setup(&stats.timing_wheel);
@@ -116,10 +118,10 @@ setup(void)
     core_setup(&setting.admin, &setting.server, &setting.worker,
             &stats.server, &stats.worker);
 
-    /* adding recurring events to maintenance/admin thread */
+    /* flush debug log off the worker and admin threads */
     intvl = option_uint(&setting.pingserver.dlog_intvl);
-    if (core_admin_register(intvl, debug_log_flush, NULL) == NULL) {
-        log_stderr("Could not register timed event to flush debug log");
+    if (debug_log_flusher_start(intvl) != CC_OK) {
+        log_stderr("Could not start thread to flush debug log");
         goto error;
     }
 
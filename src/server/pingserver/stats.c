@@ -9,6 +9,8 @@ struct stats stats = {
     { CORE_WORKER_METRIC(METRIC_INIT)   },
     { BUF_METRIC(METRIC_INIT)           },
     { DBUF_METRIC(METRIC_INIT)          },
+    { DEBUG_METRIC(METRIC_INIT)         },
+    { EFD_METRIC(METRIC_INIT)           },
     { EVENT_METRIC(METRIC_INIT)         },
     { LOG_METRIC(METRIC_INIT)           },
     { TCP_METRIC(METRIC_INIT)           },
@@ -9,8 +9,10 @@
 #include <util/procinfo.h>
 
 #include <buffer/cc_dbuf.h>
+#include <cc_debug.h>
 #include <cc_event.h>
 #include <cc_log.h>
+#include <channel/cc_eventfd.h>
 #include <channel/cc_tcp.h>
 #include <time/cc_wheel.h>
 
@@ -26,6 +28,8 @@ struct stats {
     /* ccommon libraries */
     buf_metrics_st              buf;
     dbuf_metrics_st             dbuf;
+    debug_metrics_st            debug;
+    efd_metrics_st              efd;
     event_metrics_st            event;
     log_metrics_st              log;
     tcp_metrics_st              tcp;
@@ -0,0 +1,552 @@
+#include "process.h"
+
+#include <core/data/shared.h>
+#include <protocol/data/redis_include.h>
+#include <storage/slab/slab.h>
+#include <time/time.h>
+
+#include <cc_array.h>
+#include <cc_debug.h>
+#include <cc_print.h>
+
+#include <strings.h>
+
+#define REDIS_PROCESS_MODULE_NAME "redis::process"
+
+#define CMD_ERR_MSG         "ERR unknown command"
+#define NARG_ERR_MSG        "ERR wrong number of arguments"
+#define SYNTAX_ERR_MSG      "ERR syntax error"
+#define KEY_ERR_MSG         "ERR key is too long"
+#define NAN_ERR_MSG         "ERR value is not an integer or out of range"
+#define EXPIRE_ERR_MSG      "ERR invalid expire time"
+#define OVERSIZE_ERR_MSG    "ERR value is too large to be stored"
+#define OOM_ERR_MSG         "OOM server is out of memory"
+#define OTHER_ERR_MSG       "ERR unknown server error"
+
+#define OK_MSG              "OK"
+#define PONG_MSG            "PONG"
+
+static bool process_init = false;
+static process_metrics_st *process_metrics = NULL;
+static uint32_t shrink_idle = SHRINK_IDLE;
+static uint32_t shrink_size = SHRINK_SIZE;
+static struct response_vec *rspv = NULL; /* responses for the worker */
+
+void
+process_setup(process_options_st *options, process_metrics_st *metrics)
+{
+    log_info("set up the %s module", REDIS_PROCESS_MODULE_NAME);
+
+    if (process_init) {
+        log_warn("%s has already been setup, overwrite",
+                 REDIS_PROCESS_MODULE_NAME);
+    }
+
+    process_metrics = metrics;
+
+    if (options != NULL) {
+        shrink_idle = option_uint(&options->shrink_idle);
+        shrink_size = option_uint(&options->shrink_size);
+    }
+
+    rspv = response_vec_create(RSP_VEC_INIT);
+    if (rspv == NULL) {
+        log_crit("cannot create response vector, OOM. abort");
+        exit(EXIT_FAILURE);
+    }
+
+    process_init = true;
+}
+
+void
+process_teardown(void)
+{
+    log_info("tear down the %s module", REDIS_PROCESS_MODULE_NAME);
+    if (!process_init) {
+        log_warn("%s has never been setup", REDIS_PROCESS_MODULE_NAME);
+    }
+
+    response_vec_destroy(&rspv);
+    shrink_idle = SHRINK_IDLE;
+    shrink_size = SHRINK_SIZE;
+    process_metrics = NULL;
+    process_init = false;
+}
+
+
+static inline void
+_str_rsp(struct response *rsp, element_type_t type, const char *msg)
+{
+    rsp->type = type;
+    rsp->vstr.data = (char *)msg;
+    rsp->vstr.len = strlen(msg);
+}
+
+static void
+_error_rsp(struct response *rsp, item_rstatus_t status)
+{
+    INCR(process_metrics, process_ex);
+
+    if (status == ITEM_EOVERSIZED) {
+        _str_rsp(rsp, ELEM_ERR, OVERSIZE_ERR_MSG);
+    } else if (status == ITEM_ENAN) {
+        _str_rsp(rsp, ELEM_ERR, NAN_ERR_MSG);
+    } else if (status == ITEM_ENOMEM) {
+        _str_rsp(rsp, ELEM_ERR, OOM_ERR_MSG);
+        INCR(process_metrics, process_server_ex);
+    } else {
+        NOT_REACHED();
+        _str_rsp(rsp, ELEM_ERR, OTHER_ERR_MSG);
+        INCR(process_metrics, process_server_ex);
+    }
+}
+
+/* keys are stored with a one-byte length in the slab engine */
+static inline bool
+_key_valid(struct response *rsp, const struct bstring *key)
+{
+    if (key->len == 0 || key->len > MAX_KEY_LEN) {
+        _str_rsp(rsp, ELEM_ERR, KEY_ERR_MSG);
+        INCR(process_metrics, process_ex);
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * Redis expiration is always relative to the current time, unlike memcache
+ * where large values are treated as absolute unix time. A ttl too large to be
+ * represented is treated as never expiring.
+ */
+static rel_time_ms_t
+_expire_at(int64_t ttl, bool ms)
+{
+    int64_t sec = ms ? ttl / 1000 : ttl;
+
+    if (sec >= (int64_t)(UINT32_MAX - 1 - time_now())) {
+        return time_sec2ms(time_reltime(0));
+    }
+
+    return ms ? time_now_ms() + (rel_time_ms_t)ttl :
+        time_sec2ms(time_now() + (rel_time_t)sec);
+}
+
+static inline bool
+_token_is(const struct bstring *t, const char *str)
+{
+    return t->len == strlen(str) && strncasecmp(t->data, str, t->len) == 0;
+}
+
+static bool
+_get_key(struct response *rsp, struct bstring *key)
+{
+    struct item *it;
+
+    it = item_get(key);
+    if (it != NULL) {
+        rsp->type = ELEM_BULK;
+        rsp->vstr.len = it->vlen;
+        rsp->vstr.data = item_data(it);
+
+        log_verb("found key at %p, location %p", key, it);
+        return true;
+    } else {
+        rsp->type = ELEM_NIL;
+
+        log_verb("key at %p not found", key);
+        return false;
+    }
+}
+
+static void
+_process_get(struct response *rsp, struct request *req)
+{
+    INCR(process_metrics, get);
+    if (_get_key(rsp, array_get(req->token, 1))) {
+        INCR(process_metrics, get_key_hit);
+    } else {
+        INCR(process_metrics, get_key_miss);
+    }
+
+    log_verb("get req %p processed, rsp type %d", req, rsp->type);
+}
+
+static void
+_process_mget(struct response *rsp, struct request *req)
+{
+    struct response *r = rsp;
+    uint32_t i, nkey = array_nelem(req->token) - 1;
+
+    INCR(process_metrics, mget);
+    /* the array header is followed by one element per key, hit or miss */
+    r->type = ELEM_ARRAY;
+    r->vint = nkey;
+    for (i = 1; i <= nkey; ++i) {
+        r = STAILQ_NEXT(r, next);
+        INCR(process_metrics, mget_key);
+        if (_get_key(r, array_get(req->token, i))) {
+            INCR(process_metrics, mget_key_hit);
+        } else {
+            INCR(process_metrics, mget_key_miss);
+        }
+    }
+
+    log_verb("mget req %p processed, %"PRIu32" keys", req, nkey);
+}
+
+static void
+_process_set(struct response *rsp, struct request *req)
+{
+    item_rstatus_t status;
+    struct bstring *key, *val, *t;
+    uint32_t i, ntoken = array_nelem(req->token);
+    rel_time_ms_t expire_at = time_sec2ms(time_reltime(0));
+    bool nx = false, xx = false, exists;
+    int64_t ttl;
+
+    INCR(process_metrics, set);
+    key = array_get(req->token, 1);
+    val = array_get(req->token, 2);
+
+    /* SET key value [EX seconds|PX milliseconds] [NX|XX] */
+    for (i = 3; i < ntoken; ++i) {
+        t = array_get(req->token, i);
+        if (_token_is(t, "nx") && !xx) {
+            nx = true;
+        } else if (_token_is(t, "xx") && !nx) {
+            xx = true;
+        } else if ((_token_is(t, "ex") || _token_is(t, "px")) &&
+                i + 1 < ntoken) {
+            bool ms = _token_is(t, "px");
+
+            if (bstring_atoi64(&ttl, array_get(req->token, ++i)) != CC_OK) {
+                _str_rsp(rsp, ELEM_ERR, NAN_ERR_MSG);
+                goto error;
+            }
+            if (ttl <= 0) {
+                _str_rsp(rsp, ELEM_ERR, EXPIRE_ERR_MSG);
+                goto error;
+            }
+            expire_at = _expire_at(ttl, ms);
+        } else {
+            _str_rsp(rsp, ELEM_ERR, SYNTAX_ERR_MSG);
+            goto error;
+        }
+    }
+
+    if (!_key_valid(rsp, key)) {
+        INCR(process_metrics, set_ex);
+        return;
+    }
+
+    if (nx || xx) {
+        exists = (item_get(key) != NULL);
+        if ((nx && exists) || (xx && !exists)) {
+            rsp->type = ELEM_NIL;
+            INCR(process_metrics, set_notstored);
+            return;
+        }
+    }
+
+    item_delete(key);
+    status = item_insert(key, val, 0, expire_at);
+    if (status == ITEM_OK) {
+        _str_rsp(rsp, ELEM_STR, OK_MSG);
+        INCR(process_metrics, set_stored);
+    } else {
+        _error_rsp(rsp, status);
+        INCR(process_metrics, set_ex);
+    }
+
+    log_verb("set req %p processed, rsp type %d", req, rsp->type);
+    return;
+
+error:
+    INCR(process_metrics, process_ex);
+    INCR(process_metrics, set_ex);
+}
+
+static void
+_process_del(struct response *rsp, struct request *req)
+{
+    uint32_t i, ntoken = array_nelem(req->token);
+
+    INCR(process_metrics, del);
+    rsp->type = ELEM_INT;
+    rsp->vint = 0;
+    for (i = 1; i < ntoken; ++i) {
+        INCR(process_metrics, del_key);
+        if (item_delete(array_get(req->token, i))) {
+            rsp->vint++;
+            INCR(process_metrics, del_key_deleted);
+        }
+    }
+
+    log_verb("del req %p processed, %"PRId64" keys deleted", req, rsp->vint);
+}
+
+/* a missing key is treated as 0, and the result cannot overflow int64 */
+static void
+_process_incr(struct response *rsp, struct request *req)
+{
+    item_rstatus_t status;
+    struct bstring *key, vstr, nval;
+    struct item *it;
+    int64_t vint = 0;
+    char buf[CC_INT64_MAXLEN];
+
+    INCR(process_metrics, incr);
+    key = array_get(req->token, 1);
+    if (!_key_valid(rsp, key)) {
+        INCR(process_metrics, incr_ex);
+        return;
+    }
+
+    it = item_get(key);
+    if (it != NULL) {
+        vstr.len = it->vlen;
+        vstr.data = item_data(it);
+        if (bstring_atoi64(&vint, &vstr) != CC_OK || vint == INT64_MAX) {
+            _error_rsp(rsp, ITEM_ENAN);
+            INCR(process_metrics, incr_ex);
+            return;
+        }
+    }
+
+    vint++;
+    nval.len = cc_print_int64_unsafe(buf, vint);
+    nval.data = buf;
+    if (it == NULL) {
+        status = item_insert(key, &nval, 0, time_sec2ms(time_reltime(0)));
+    } else if (item_slabid(it->klen, nval.len) == it->id) {
+        status = item_update(it, &nval);
+    } else {
+        uint32_t dataflag = it->dataflag;
+        rel_time_ms_t expire_at = item_expire(it);
+
+        item_delete(key);
+        status = item_insert(key, &nval, dataflag, expire_at);
+    }
+
+    if (status == ITEM_OK) {
+        rsp->type = ELEM_INT;
+        rsp->vint = vint;
+    } else {
+        _error_rsp(rsp, status);
+        INCR(process_metrics, incr_ex);
+    }
+
+    log_verb("incr req %p processed, rsp type %d", req, rsp->type);
+}
+
+static void
+_process_expire(struct response *rsp, struct request *req)
+{
+    struct bstring *key;
+    struct item *it;
+    int64_t ttl;
+
+    INCR(process_metrics, expire);
+    key = array_get(req->token, 1);
+    if (bstring_atoi64(&ttl, array_get(req->token, 2)) != CC_OK) {
+        _str_rsp(rsp, ELEM_ERR, NAN_ERR_MSG);
+        INCR(process_metrics, process_ex);
+        return;
+    }
+
+    rsp->type = ELEM_INT;
+    it = item_get(key);
+    if (it == NULL) {
+        rsp->vint = 0;
+    } else {
+        INCR(process_metrics, expire_hit);
+        rsp->vint = 1;
+        if (ttl <= 0) { /* a ttl in the past removes the key right away */
+            item_delete(key);
+        } else {
+            item_set_expire(it, _expire_at(ttl, false));
+        }
+    }
+
+    log_verb("expire req %p processed, rsp %"PRId64, req, rsp->vint);
+}
+
+static void
+_process_ping(struct response *rsp, struct request *req)
+{
+    INCR(process_metrics, ping);
+    if (array_nelem(req->token) > 1) {
+        rsp->type = ELEM_BULK;
+        rsp->vstr = *(struct bstring *)array_get(req->token, 1);
+    } else {
+        _str_rsp(rsp, ELEM_STR, PONG_MSG);
+    }
+}
+
+static void
+_process_request(struct response *rsp, struct request *req)
+{
+    log_verb("processing req %p, write rsp to %p", req, rsp);
+    INCR(process_metrics, process_req);
+
+    if (req->type == REQ_UNKNOWN) {
+        INCR(process_metrics, unknown);
+        INCR(process_metrics, process_ex);
+        _str_rsp(rsp, ELEM_ERR, CMD_ERR_MSG);
+        return;
+    }
+
+    if (!request_narg_valid(req)) {
+        INCR(process_metrics, process_ex);
+        _str_rsp(rsp, ELEM_ERR, NARG_ERR_MSG);
+        return;
+    }
+
+    switch (req->type) {
+    case REQ_GET:
+        _process_get(rsp, req);
+        break;
+
+    case REQ_SET:
+        _process_set(rsp, req);
+        break;
+
+    case REQ_DEL:
+        _process_del(rsp, req);
+        break;
+
+    case REQ_INCR:
+        _process_incr(rsp, req);
+        break;
+
+    case REQ_EXPIRE:
+        _process_expire(rsp, req);
+        break;
+
+    case REQ_MGET:
+        _process_mget(rsp, req);
+        break;
+
+    case REQ_PING:
+        _process_ping(rsp, req);
+        break;
+
+    default:
+        _str_rsp(rsp, ELEM_ERR, CMD_ERR_MSG);
+        break;
+    }
+}
+
+static void
+_cleanup(struct request **req)
+{
+    request_return(req);
+    response_vec_return(rspv);
+}
+
+int
+redis_process_read(struct buf **rbuf, struct buf **wbuf, void **data)
+{
+    parse_rstatus_t status;
+    struct request *req;
+    struct response *rsp;
+
+    log_verb("post-read processing");
+
+    req = request_borrow();
+    if (req == NULL) {
+        log_error("cannot acquire request: OOM");
+        INCR(process_metrics, process_ex);
+
+        return -1;
+    }
+
+    /* keep parse-process-compose until running out of data in rbuf, or until
+     * enough replies are held, the rest is left for when they have drained
+     */
+    while (buf_rsize(*rbuf) > 0 && !worker_wbuf_full(*wbuf)) {
+        struct response *nr;
+        int i, card;
+
+        /* stage 1: parsing */
+        log_verb("%"PRIu32" bytes left", buf_rsize(*rbuf));
+
+        status = parse_req(req, *rbuf);
+        if (status == PARSE_EUNFIN) {
+            goto done;
+        }
+        if (status == PARSE_EEMPTY) { /* blank lines are skipped, no reply */
+            request_reset(req);
+            continue;
+        }
+        if (status != PARSE_OK) {
+            /* as with memcache, we cannot tell where an invalid request ends,
+             * so the connection is closed
+             */
+            log_warn("illegal request received, status: %d", status);
+            goto error;
+        }
+
+        /* stage 2: processing- check for quit, allocate response(s), process */
+
+        /* quit is special, the connection is closed without a reply */
+        if (req->type == REQ_QUIT) {
+            log_info("peer called quit");
+            goto error;
+        }
+
+        /* mget replies with an array header followed by one element per key */
+        card = 1;
+        if (req->type == REQ_MGET && request_narg_valid(req)) {
+            card = array_nelem(req->token);
+        }
+        rsp = response_vec_borrow(rspv, card);
+        if (rsp == NULL) {
+            log_error("cannot acquire response: OOM");
+            INCR(process_metrics, process_ex);
+            goto error;
+        }
+
+        _process_request(rsp, req);
+        if (rsp->type == ELEM_ERR) {
+            card = 1;
+        }
+
+        /* stage 3: write response(s) */
+        for (nr = rsp, i = 0; i < card; nr = STAILQ_NEXT(nr, next), ++i) {
+            if (compose_rsp(wbuf, nr) < 0) {
+                log_error("composing rsp erred");
+                INCR(process_metrics, process_ex);
+                goto error;
+            }
+        }
+
+        request_reset(req);
+        response_vec_return(rspv);
+    }
+
+done:
+    _cleanup(&req);
+    return 0;
+
+error:
+    _cleanup(&req);
+    return -1;
+}
+
+int
+redis_process_write(struct buf **rbuf, struct buf **wbuf, void **data)
+{
+    uintptr_t nidle = (uintptr_t)*data;
+
+    log_verb("post-write processing");
+
+    /* the count of idle cycles lives in the per-connection data field, which
+     * is cleared whenever the connection is recycled
+     */
+    dbuf_shrink_idle(rbuf, wbuf, &nidle, shrink_idle, shrink_size);
+    *data = (void *)nidle;
+
+    return 0;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <buffer/cc_buf.h>
+#include <cc_metric.h>
+#include <cc_option.h>
+#include <cc_util.h>
+
+#define SHRINK_IDLE 16
+#define SHRINK_SIZE (256 * KiB)
+
+/*          name         type              default      description */
+#define PROCESS_OPTION(ACTION)                                                              \
+    ACTION( shrink_idle, OPTION_TYPE_UINT, SHRINK_IDLE, "idle writes before buf shrinks"   )\
+    ACTION( shrink_size, OPTION_TYPE_UINT, SHRINK_SIZE, "always shrink bufs above (byte)"  )
+
+typedef struct {
+    PROCESS_OPTION(OPTION_DECLARE)
+} process_options_st;
+
+/*          name                        type            description */
+#define PROCESS_METRIC(ACTION)                                          \
+    ACTION( process_req,       METRIC_COUNTER, "# requests processed"  )\
+    ACTION( process_ex,        METRIC_COUNTER, "# processing error"    )\
+    ACTION( process_server_ex, METRIC_COUNTER, "# internal error"      )\
+    ACTION( get,               METRIC_COUNTER, "# get requests"        )\
+    ACTION( get_key_hit,       METRIC_COUNTER, "# key hits by get"     )\
+    ACTION( get_key_miss,      METRIC_COUNTER, "# key misses by get"   )\
+    ACTION( set,               METRIC_COUNTER, "# set requests"        )\
+    ACTION( set_stored,        METRIC_COUNTER, "# set successes"       )\
+    ACTION( set_notstored,     METRIC_COUNTER, "# set skipped by NX/XX")\
+    ACTION( set_ex,            METRIC_COUNTER, "# set errors"          )\
+    ACTION( del,               METRIC_COUNTER, "# del requests"        )\
+    ACTION( del_key,           METRIC_COUNTER, "# keys by del"         )\
+    ACTION( del_key_deleted,   METRIC_COUNTER, "# keys deleted by del" )\
+    ACTION( incr,              METRIC_COUNTER, "# incr requests"       )\
+    ACTION( incr_ex,           METRIC_COUNTER, "# incr errors"         )\
+    ACTION( expire,            METRIC_COUNTER, "# expire requests"     )\
+    ACTION( expire_hit,        METRIC_COUNTER, "# expire on a key"     )\
+    ACTION( mget,              METRIC_COUNTER, "# mget requests"       )\
+    ACTION( mget_key,          METRIC_COUNTER, "# keys by mget"        )\
+    ACTION( mget_key_hit,      METRIC_COUNTER, "# key hits by mget"    )\
+    ACTION( mget_key_miss,     METRIC_COUNTER, "# key misses by mget"  )\
+    ACTION( ping,              METRIC_COUNTER, "# ping requests"       )\
+    ACTION( unknown,           METRIC_COUNTER, "# unknown commands"    )
+
+typedef struct {
+    PROCESS_METRIC(METRIC_DECLARE)
+} process_metrics_st;
+
+void process_setup(process_options_st *options, process_metrics_st *metrics);
+void process_teardown(void);
+
+int redis_process_read(struct buf **rbuf, struct buf **wbuf, void **data);
+int redis_process_write(struct buf **rbuf, struct buf **wbuf, void **data);
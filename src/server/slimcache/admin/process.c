@@ -1,5 +1,6 @@
 #include "process.h"
 
+#include <core/admin/stats_json.h>
 #include <protocol/admin/admin_include.h>
 #include <util/procinfo.h>
 
@@ -39,9 +40,11 @@ admin_process_setup(admin_process_metrics_st *metrics)
 
     admin_metrics = metrics;
 
-    stats_len = METRIC_PRINT_LEN * nmetric;
+    stats_len = METRIC_PRINT_LEN * metric_nline((struct metric *)&stats,
+            nmetric);
     stats_buf = cc_alloc(stats_len + METRIC_END_LEN);
     /* TODO: check return status of cc_alloc */
+    admin_stats_json_setup((struct metric *)&stats, nmetric);
 
     admin_init = true;
 }
@@ -54,6 +57,7 @@ admin_process_teardown(void)
         log_warn("%s has never been setup", SLIMCACHE_ADMIN_MODULE_NAME);
     }
 
+    admin_stats_json_teardown();
     admin_metrics = NULL;
     admin_init = false;
 }
@@ -63,9 +67,18 @@ _admin_stats(struct response *rsp, struct request *req)
 {
     size_t offset = 0;
     struct metric *metrics = (struct metric *)&stats;
+    struct bstring sub;
 
     INCR(admin_metrics, stats);
 
+    if (admin_parse_arg(&req->arg, &sub)) {
+        if (!admin_stats_json(rsp, &sub, &req->arg, stats_buf,
+                    stats_len + METRIC_END_LEN)) {
+            rsp->type = RSP_INVALID;
+        }
+        return;
+    }
+
     procinfo_update();
     for (int i = 0; i < nmetric; ++i) {
         offset += metric_print(stats_buf + offset, stats_len - offset,
@@ -1,11 +1,13 @@
 #include "process.h"
 
+#include <core/data/shared.h>
 #include <protocol/data/memcache_include.h>
 #include <storage/cuckoo/cuckoo.h>
 
 #include <cc_array.h>
 #include <cc_debug.h>
 #include <cc_print.h>
+#include <time/cc_timer.h>
 
 #define SLIMCACHE_PROCESS_MODULE_NAME "slimcache::process"
 
@@ -16,6 +18,9 @@
 static bool process_init = false;
 static process_metrics_st *process_metrics = NULL;
 static bool allow_flush = ALLOW_FLUSH;
+static uint32_t shrink_idle = SHRINK_IDLE;
+static uint32_t shrink_size = SHRINK_SIZE;
+static struct response_vec *rspv = NULL; /* responses for the worker */
 
 void
 process_setup(process_options_st *options, process_metrics_st *metrics)
@@ -30,6 +35,14 @@ process_setup(process_options_st *options, process_metrics_st *metrics)
 
     if (options != NULL) {
         allow_flush = option_bool(&options->allow_flush);
+        shrink_idle = option_uint(&options->shrink_idle);
+        shrink_size = option_uint(&options->shrink_size);
+    }
+
+    rspv = response_vec_create(RSP_VEC_INIT);
+    if (rspv == NULL) {
+        log_crit("cannot create response vector, OOM. abort");
+        exit(EXIT_FAILURE);
     }
 
     process_init = true;
@@ -43,6 +56,11 @@ process_teardown(void)
         log_warn("%s has never been setup", SLIMCACHE_PROCESS_MODULE_NAME);
     }
 
+    response_vec_destroy(&rspv);
+    shrink_idle = SHRINK_IDLE;
+    shrink_size = SHRINK_SIZE;
+    metric_teardown((struct metric *)process_metrics,
+            METRIC_CARDINALITY(process_metrics_st));
     process_metrics = NULL;
     process_init = false;
     allow_flush = false;
@@ -181,14 +199,14 @@ static void
 _process_set(struct response *rsp, struct request *req)
 {
     rstatus_i status = CC_OK;
-    rel_time_t expire;
+    rel_time_ms_t expire;
     struct bstring *key;
     struct item *it;
     struct val val;
 
     INCR(process_metrics, set);
     key = array_first(req->keys);
-    expire = time_reltime(req->expiry);
+    expire = request_expire_at(req);
     _get_value(&val, &req->vstr);
 
     it = cuckoo_get(key);
@@ -224,7 +242,7 @@ _process_add(struct response *rsp, struct request *req)
         INCR(process_metrics, add_notstored);
     } else {
         _get_value(&val, &req->vstr);
-        if (cuckoo_insert(key, &val, time_reltime(req->expiry)) == CC_OK) {
+        if (cuckoo_insert(key, &val, request_expire_at(req)) == CC_OK) {
             rsp->type = RSP_STORED;
             INCR(process_metrics, add_stored);
         } else {
@@ -248,7 +266,7 @@ _process_replace(struct response *rsp, struct request *req)
     it = cuckoo_get(key);
     if (it != NULL) {
         _get_value(&val, &req->vstr);
-        if (cuckoo_update(it, &val, time_reltime(req->expiry)) == CC_OK) {
+        if (cuckoo_update(it, &val, request_expire_at(req)) == CC_OK) {
             rsp->type = RSP_STORED;
             INCR(process_metrics, replace_stored);
         } else {
@@ -277,7 +295,7 @@ _process_cas(struct response *rsp, struct request *req)
 
         if (item_cas_valid(it, req->vcas)) {
             _get_value(&val, &req->vstr);
-            if (cuckoo_update(it, &val, time_reltime(req->expiry)) == CC_OK) {
+            if (cuckoo_update(it, &val, request_expire_at(req)) == CC_OK) {
                 rsp->type = RSP_STORED;
                 INCR(process_metrics, cas_stored);
             } else {
@@ -384,51 +402,71 @@ _process_flush(struct response *rsp, struct request *req)
     }
 }
 
+/* service time of the request being processed, in ns */
+static inline uint64_t
+_process_ns(struct timeout *start)
+{
+    return (uint64_t)-timeout_ns(start);
+}
+
 void
 process_request(struct response *rsp, struct request *req)
 {
+    struct timeout start;
+
     log_verb("processing req %p, write rsp to %p", req, rsp);
     INCR(process_metrics, process_req);
 
+    timeout_add_ns(&start, 0); /* now */
     switch (req->type) {
     case REQ_GET:
         _process_get(rsp, req);
+        RECORD(process_metrics, get_lat, _process_ns(&start));
         break;
 
     case REQ_GETS:
         _process_gets(rsp, req);
+        RECORD(process_metrics, gets_lat, _process_ns(&start));
         break;
 
     case REQ_DELETE:
         _process_delete(rsp, req);
+        RECORD(process_metrics, delete_lat, _process_ns(&start));
         break;
 
     case REQ_SET:
         _process_set(rsp, req);
+        RECORD(process_metrics, set_lat, _process_ns(&start));
         break;
 
     case REQ_ADD:
         _process_add(rsp, req);
+        RECORD(process_metrics, add_lat, _process_ns(&start));
         break;
 
     case REQ_REPLACE:
         _process_replace(rsp, req);
+        RECORD(process_metrics, replace_lat, _process_ns(&start));
         break;
 
     case REQ_CAS:
         _process_cas(rsp, req);
+        RECORD(process_metrics, cas_lat, _process_ns(&start));
         break;
 
     case REQ_INCR:
         _process_incr(rsp, req);
+        RECORD(process_metrics, incr_lat, _process_ns(&start));
         break;
 
     case REQ_DECR:
         _process_decr(rsp, req);
+        RECORD(process_metrics, decr_lat, _process_ns(&start));
         break;
 
     case REQ_FLUSH:
         _process_flush(rsp, req);
+        RECORD(process_metrics, flush_lat, _process_ns(&start));
         break;
 
     default:
@@ -439,10 +477,10 @@ process_request(struct response *rsp, struct request *req)
 }
 
 static void
-_cleanup(struct request **req, struct response **rsp)
+_cleanup(struct request **req)
 {
     request_return(req);
-    response_return_all(rsp);
+    response_vec_return(rspv);
 }
 
 int
@@ -450,7 +488,7 @@ slimcache_process_read(struct buf **rbuf, struct buf **wbuf, void **data)
 {
     parse_rstatus_t status;
     struct request *req;
-    struct response *rsp = NULL;
+    struct response *rsp;
 
     log_verb("post-read processing");
 
@@ -463,8 +501,10 @@ slimcache_process_read(struct buf **rbuf, struct buf **wbuf, void **data)
         return -1;
     }
 
-    /* keep parse-process-compose until running out of data in rbuf */
-    while (buf_rsize(*rbuf) > 0) {
+    /* keep parse-process-compose until running out of data in rbuf, or until
+     * enough replies are held, the rest is left for when they have drained
+     */
+    while (buf_rsize(*rbuf) > 0 && !worker_wbuf_full(*wbuf)) {
         struct response *nr;
         int i, card;
 
@@ -499,15 +539,11 @@ slimcache_process_read(struct buf **rbuf, struct buf **wbuf, void **data)
             /* extra response object for the "END" line after values */
             card++;
         }
-        for (i = 0, rsp = response_borrow(), nr = rsp;
-             i < card;
-             i++, STAILQ_NEXT(nr, next) = response_borrow(), nr =
-                STAILQ_NEXT(nr, next)) {
-            if (nr == NULL) {
-                log_error("cannot acquire response: OOM");
-                INCR(process_metrics, process_ex);
-                goto error;
-            }
+        rsp = response_vec_borrow(rspv, card);
+        if (rsp == NULL) {
+            log_error("cannot acquire response: OOM");
+            INCR(process_metrics, process_ex);
+            goto error;
         }
 
         /* actual processing & command logging */
@@ -519,6 +555,7 @@ slimcache_process_read(struct buf **rbuf, struct buf **wbuf, void **data)
         /* noreply means no need to write to buffers */
         if (req->noreply) {
             request_reset(req);
+            response_vec_return(rspv);
             continue;
         }
 
@@ -534,24 +571,32 @@ slimcache_process_read(struct buf **rbuf, struct buf **wbuf, void **data)
                 goto error;
             }
         }
+
+        request_reset(req);
+        response_vec_return(rspv);
     }
 
 done:
-    _cleanup(&req, &rsp);
+    _cleanup(&req);
     return 0;
 
 error:
-    _cleanup(&req, &rsp);
+    _cleanup(&req);
     return -1;
 }
 
 int
 slimcache_process_write(struct buf **rbuf, struct buf **wbuf, void **data)
 {
+    uintptr_t nidle = (uintptr_t)*data;
+
     log_verb("post-write processing");
 
-    dbuf_shrink(rbuf);
-    dbuf_shrink(wbuf);
+    /* the count of idle cycles lives in the per-connection data field, which
+     * is cleared whenever the connection is recycled
+     */
+    dbuf_shrink_idle(rbuf, wbuf, &nidle, shrink_idle, shrink_size);
+    *data = (void *)nidle;
 
     return 0;
 }
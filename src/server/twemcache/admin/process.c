@@ -1,6 +1,10 @@
 #include "process.h"
 
+#include <core/admin/stats_json.h>
+#include <hotkey/hotkey.h>
+#include <mrc/mrc.h>
 #include <protocol/admin/admin_include.h>
+#include <storage/slab/slab.h>
 #include <util/procinfo.h>
 
 #include <cc_mm.h>
@@ -16,6 +20,27 @@
 #define METRIC_END "END\r\n"
 #define METRIC_END_LEN sizeof(METRIC_END)
 
+/* stats json, stats delta: see core/admin/stats_json.h
+ * stats slabs: slabs and chunks of each slabclass in use
+ * stats items: items stored in each slabclass in use
+ */
+#define STATS_SLABS "slabs"
+#define STATS_ITEMS "items"
+
+/* hotkeys [n]: the n (default: all) hottest keys tracked, hottest first
+ * hotkeys reset: forget keys tracked so far
+ */
+#define HOTKEY_PRINT_FMT "HOTKEY %.*s %"PRIu64" %"PRIu64"\r\n"
+#define HOTKEY_PRINT_LEN 320 /* > 7("HOTKEY ") + 255 (key) + 2 * 21 + CRLF */
+#define HOTKEY_RESET "reset"
+
+/* mrc: estimated miss ratio by cache size (# keys), see mrc.h
+ * mrc reset: forget accesses seen so far
+ */
+#define MRC_PRINT_FMT "MRC %"PRIu64" %.4f\r\n"
+#define MRC_PRINT_LEN 40 /* > 4("MRC ") + 20 (size) + 7 (ratio) + CRLF */
+#define MRC_RESET "reset"
+
 #define VERSION_PRINT_FMT "VERSION %s\r\n"
 #define VERSION_PRINT_LEN 30
 
@@ -25,6 +50,11 @@ extern unsigned int nmetric;
 static bool admin_init = false;
 static admin_process_metrics_st *admin_metrics = NULL;
 static char *stats_buf = NULL;
+static char *slab_buf = NULL;
+static size_t slab_len;
+static char *hotkey_buf = NULL;
+static size_t hotkey_len;
+static char mrc_buf[MRC_PRINT_LEN * MRC_NBUCKET + METRIC_END_LEN];
 static char version_buf[VERSION_PRINT_LEN];
 static size_t stats_len;
 
@@ -39,9 +69,17 @@ admin_process_setup(admin_process_metrics_st *metrics)
 
     admin_metrics = metrics;
 
-    stats_len = METRIC_PRINT_LEN * nmetric;
+    stats_len = METRIC_PRINT_LEN * metric_nline((struct metric *)&stats,
+            nmetric);
     stats_buf = cc_alloc(stats_len + METRIC_END_LEN);
     /* TODO: check return status of cc_alloc */
+    admin_stats_json_setup((struct metric *)&stats, nmetric);
+
+    slab_len = METRIC_PRINT_LEN * SLAB_STATS_NLINE * slab_nclass();
+    slab_buf = cc_alloc(slab_len + METRIC_END_LEN);
+
+    hotkey_len = HOTKEY_PRINT_LEN * hotkey_nslot();
+    hotkey_buf = cc_alloc(hotkey_len + METRIC_END_LEN);
 
     admin_init = true;
 }
@@ -54,18 +92,54 @@ admin_process_teardown(void)
         log_warn("%s has never been setup", TWEMCACHE_ADMIN_MODULE_NAME);
     }
 
+    admin_stats_json_teardown();
+    cc_free(slab_buf);
+    cc_free(hotkey_buf);
     admin_metrics = NULL;
     admin_init = false;
 }
 
+static void
+_admin_stats_slab(struct response *rsp, bool items)
+{
+    size_t offset;
+
+    if (items) {
+        offset = slab_print_items(slab_buf, slab_len, METRIC_PRINT_FMT);
+    } else {
+        offset = slab_print_stats(slab_buf, slab_len, METRIC_PRINT_FMT);
+    }
+    strcpy(slab_buf + offset, METRIC_END);
+
+    rsp->type = RSP_GENERIC;
+    rsp->data.data = slab_buf;
+    rsp->data.len = offset + METRIC_END_LEN - 1;
+}
+
 static void
 _admin_stats(struct response *rsp, struct request *req)
 {
     size_t offset = 0;
     struct metric *metrics = (struct metric *)&stats;
+    struct bstring sub;
 
     INCR(admin_metrics, stats);
 
+    if (admin_parse_arg(&req->arg, &sub)) {
+        if (admin_stats_json(rsp, &sub, &req->arg, stats_buf,
+                    stats_len + METRIC_END_LEN)) {
+            return;
+        }
+        if (bstring_compare(&sub, &str2bstr(STATS_SLABS)) == 0) {
+            _admin_stats_slab(rsp, false);
+        } else if (bstring_compare(&sub, &str2bstr(STATS_ITEMS)) == 0) {
+            _admin_stats_slab(rsp, true);
+        } else {
+            rsp->type = RSP_INVALID;
+        }
+        return;
+    }
+
     procinfo_update();
     for (int i = 0; i < nmetric; ++i) {
         offset += metric_print(stats_buf + offset, stats_len - offset,
@@ -78,6 +152,61 @@ _admin_stats(struct response *rsp, struct request *req)
     rsp->data.len = offset + METRIC_END_LEN;
 }
 
+static void
+_admin_hotkeys(struct response *rsp, struct request *req)
+{
+    size_t offset;
+    uint64_t n = UINT32_MAX;
+    struct bstring arg;
+
+    INCR(admin_metrics, hotkeys);
+
+    if (admin_parse_arg(&req->arg, &arg)) {
+        if (bstring_compare(&arg, &str2bstr(HOTKEY_RESET)) == 0) {
+            hotkey_reset();
+            rsp->type = RSP_OK;
+            return;
+        }
+        if (bstring_atou64(&n, &arg) != CC_OK || n > UINT32_MAX) {
+            rsp->type = RSP_INVALID;
+            return;
+        }
+    }
+
+    offset = hotkey_print(hotkey_buf, hotkey_len, HOTKEY_PRINT_FMT, n);
+    strcpy(hotkey_buf + offset, METRIC_END);
+
+    rsp->type = RSP_GENERIC;
+    rsp->data.data = hotkey_buf;
+    rsp->data.len = offset + METRIC_END_LEN - 1;
+}
+
+static void
+_admin_mrc(struct response *rsp, struct request *req)
+{
+    size_t offset;
+    struct bstring arg;
+
+    INCR(admin_metrics, mrc);
+
+    if (admin_parse_arg(&req->arg, &arg)) {
+        if (bstring_compare(&arg, &str2bstr(MRC_RESET)) == 0) {
+            mrc_reset();
+            rsp->type = RSP_OK;
+        } else {
+            rsp->type = RSP_INVALID;
+        }
+        return;
+    }
+
+    offset = mrc_print(mrc_buf, MRC_PRINT_LEN * MRC_NBUCKET, MRC_PRINT_FMT);
+    strcpy(mrc_buf + offset, METRIC_END);
+
+    rsp->type = RSP_GENERIC;
+    rsp->data.data = mrc_buf;
+    rsp->data.len = offset + METRIC_END_LEN - 1;
+}
+
 static void
 _admin_version(struct response *rsp, struct request *req)
 {
@@ -98,6 +227,12 @@ admin_process_request(struct response *rsp, struct request *req)
     case REQ_VERSION:
         _admin_version(rsp, req);
         break;
+    case REQ_HOTKEYS:
+        _admin_hotkeys(rsp, req);
+        break;
+    case REQ_MRC:
+        _admin_mrc(rsp, req);
+        break;
     default:
         rsp->type = RSP_INVALID;
         break;
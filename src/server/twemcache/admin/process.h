@@ -6,7 +6,9 @@
 #define ADMIN_PROCESS_METRIC(ACTION)                                    \
     ACTION( stats,             METRIC_COUNTER, "# stats requests"      )\
     ACTION( stats_ex,          METRIC_COUNTER, "# stats errors"        )\
-    ACTION( version,           METRIC_COUNTER, "# version requests"    )
+    ACTION( version,           METRIC_COUNTER, "# version requests"    )\
+    ACTION( hotkeys,           METRIC_COUNTER, "# hotkeys requests"    )\
+    ACTION( mrc,               METRIC_COUNTER, "# mrc requests"        )
 
 typedef struct {
     ADMIN_PROCESS_METRIC(METRIC_DECLARE)
@@ -1,11 +1,15 @@
 #include "process.h"
 
+#include <core/data/shared.h>
+#include <hotkey/hotkey.h>
+#include <mrc/mrc.h>
 #include <protocol/data/memcache_include.h>
 #include <storage/slab/slab.h>
 
 #include <cc_array.h>
 #include <cc_debug.h>
 #include <cc_print.h>
+#include <time/cc_timer.h>
 
 #define TWEMCACHE_PROCESS_MODULE_NAME "twemcache::process"
 
@@ -18,6 +22,9 @@
 static bool process_init = false;
 static process_metrics_st *process_metrics = NULL;
 static bool allow_flush = ALLOW_FLUSH;
+static uint32_t shrink_idle = SHRINK_IDLE;
+static uint32_t shrink_size = SHRINK_SIZE;
+static struct response_vec *rspv = NULL; /* responses for the worker */
 
 void
 process_setup(process_options_st *options, process_metrics_st *metrics)
@@ -33,6 +40,14 @@ process_setup(process_options_st *options, process_metrics_st *metrics)
 
     if (options != NULL) {
         allow_flush = option_bool(&options->allow_flush);
+        shrink_idle = option_uint(&options->shrink_idle);
+        shrink_size = option_uint(&options->shrink_size);
+    }
+
+    rspv = response_vec_create(RSP_VEC_INIT);
+    if (rspv == NULL) {
+        log_crit("cannot create response vector, OOM. abort");
+        exit(EXIT_FAILURE);
     }
 
     process_init = true;
@@ -47,6 +62,11 @@ process_teardown(void)
     }
 
     allow_flush = false;
+    response_vec_destroy(&rspv);
+    shrink_idle = SHRINK_IDLE;
+    shrink_size = SHRINK_SIZE;
+    metric_teardown((struct metric *)process_metrics,
+            METRIC_CARDINALITY(process_metrics_st));
     process_metrics = NULL;
     process_init = false;
 }
@@ -86,6 +106,8 @@ _process_get(struct response *rsp, struct request *req)
     for (i = 0; i < array_nelem(req->keys); ++i) {
         INCR(process_metrics, get_key);
         key = array_get(req->keys, i);
+        hotkey_count(key);
+        mrc_count(key);
         if (_get_key(r, key)) {
             req->nfound++;
             r->cas = false;
@@ -117,6 +139,8 @@ _process_gets(struct response *rsp, struct request *req)
     for (i = 0; i < array_nelem(req->keys); ++i) {
         INCR(process_metrics, gets_key);
         key = array_get(req->keys, i);
+        hotkey_count(key);
+        mrc_count(key);
         if (_get_key(r, key)) {
             r->cas = true;
             r = STAILQ_NEXT(r, next);
@@ -182,8 +206,10 @@ _process_set(struct response *rsp, struct request *req)
 
     INCR(process_metrics, set);
     key = array_first(req->keys);
+    hotkey_count(key);
+    mrc_count(key);
     item_delete(key);
-    status = item_insert(key, &(req->vstr), req->flag, time_reltime(req->expiry));
+    status = item_insert(key, &(req->vstr), req->flag, request_expire_at(req));
     if (status == ITEM_OK) {
         rsp->type = RSP_STORED;
         INCR(process_metrics, set_stored);
@@ -203,11 +229,12 @@ _process_add(struct response *rsp, struct request *req)
 
     INCR(process_metrics, add);
     key = array_first(req->keys);
+    mrc_count(key);
     if (item_get(key) != NULL) {
         rsp->type = RSP_NOT_STORED;
         INCR(process_metrics, add_notstored);
     } else {
-        status = item_insert(key, &(req->vstr), req->flag, time_reltime(req->expiry));
+        status = item_insert(key, &(req->vstr), req->flag, request_expire_at(req));
         if (status == ITEM_OK) {
             rsp->type = RSP_STORED;
             INCR(process_metrics, add_stored);
@@ -228,9 +255,10 @@ _process_replace(struct response *rsp, struct request *req)
 
     INCR(process_metrics, replace);
     key = array_first(req->keys);
+    mrc_count(key);
     if (item_get(key) != NULL) {
         item_delete(key);
-        status = item_insert(key, &(req->vstr), req->flag, time_reltime(req->expiry));
+        status = item_insert(key, &(req->vstr), req->flag, request_expire_at(req));
         if (status == ITEM_OK) {
             rsp->type = RSP_STORED;
             INCR(process_metrics, replace_stored);
@@ -254,6 +282,7 @@ _process_cas(struct response *rsp, struct request *req)
     struct item *it;
 
     key = array_first(req->keys);
+    mrc_count(key);
     it = item_get(key);
     if (it == NULL) {
         rsp->type = RSP_NOT_FOUND;
@@ -263,7 +292,7 @@ _process_cas(struct response *rsp, struct request *req)
         INCR(process_metrics, cas_exists);
     } else {
         item_delete(key);
-        status = item_insert(key, &(req->vstr), req->flag, time_reltime(req->expiry));
+        status = item_insert(key, &(req->vstr), req->flag, request_expire_at(req));
         if (status == ITEM_OK) {
             rsp->type = RSP_STORED;
             INCR(process_metrics, cas_stored);
@@ -307,7 +336,7 @@ _process_delta(struct response *rsp, struct item *it, struct request *req,
         } else {
             uint32_t dataflag = it->dataflag;
             item_delete(key);
-            status = item_insert(key, &nval, dataflag, it->expire_at);
+            status = item_insert(key, &nval, dataflag, item_expire(it));
         }
     }
 
@@ -323,6 +352,7 @@ _process_incr(struct response *rsp, struct request *req)
 
     INCR(process_metrics, incr);
     key = array_first(req->keys);
+    mrc_count(key);
     it = item_get(key);
     if (it != NULL) {
         status = _process_delta(rsp, it, req, key, true);
@@ -350,6 +380,7 @@ _process_decr(struct response *rsp, struct request *req)
 
     INCR(process_metrics, decr);
     key = array_first(req->keys);
+    mrc_count(key);
     it = item_get(key);
     if (it != NULL) {
         status = _process_delta(rsp, it, req, key, false);
@@ -376,6 +407,7 @@ _process_append(struct response *rsp, struct request *req)
     struct item *it;
 
     key = array_first(req->keys);
+    mrc_count(key);
     it = item_get(key);
     if (it == NULL) {
         rsp->type = RSP_NOT_STORED;
@@ -402,6 +434,7 @@ _process_prepend(struct response *rsp, struct request *req)
     struct item *it;
 
     key = array_first(req->keys);
+    mrc_count(key);
     it = item_get(key);
     if (it == NULL) {
         rsp->type = RSP_NOT_STORED;
@@ -435,59 +468,81 @@ _process_flush(struct response *rsp, struct request *req)
     }
 }
 
+/* service time of the request being processed, in ns */
+static inline uint64_t
+_process_ns(struct timeout *start)
+{
+    return (uint64_t)-timeout_ns(start);
+}
+
 void
 process_request(struct response *rsp, struct request *req)
 {
+    struct timeout start;
+
     log_verb("processing req %p, write rsp to %p", req, rsp);
     INCR(process_metrics, process_req);
 
+    timeout_add_ns(&start, 0); /* now */
     switch (req->type) {
     case REQ_GET:
         _process_get(rsp, req);
+        RECORD(process_metrics, get_lat, _process_ns(&start));
         break;
 
     case REQ_GETS:
         _process_gets(rsp, req);
+        RECORD(process_metrics, gets_lat, _process_ns(&start));
         break;
 
     case REQ_DELETE:
         _process_delete(rsp, req);
+        RECORD(process_metrics, delete_lat, _process_ns(&start));
         break;
 
     case REQ_SET:
         _process_set(rsp, req);
+        RECORD(process_metrics, set_lat, _process_ns(&start));
         break;
 
     case REQ_ADD:
         _process_add(rsp, req);
+        RECORD(process_metrics, add_lat, _process_ns(&start));
         break;
 
     case REQ_REPLACE:
         _process_replace(rsp, req);
+        RECORD(process_metrics, replace_lat, _process_ns(&start));
         break;
 
     case REQ_CAS:
         _process_cas(rsp, req);
+        RECORD(process_metrics, cas_lat, _process_ns(&start));
         break;
 
     case REQ_INCR:
         _process_incr(rsp, req);
+        RECORD(process_metrics, incr_lat, _process_ns(&start));
         break;
 
     case REQ_DECR:
         _process_decr(rsp, req);
+        RECORD(process_metrics, decr_lat, _process_ns(&start));
         break;
 
     case REQ_APPEND:
         _process_append(rsp, req);
+        RECORD(process_metrics, append_lat, _process_ns(&start));
         break;
 
     case REQ_PREPEND:
         _process_prepend(rsp, req);
+        RECORD(process_metrics, prepend_lat, _process_ns(&start));
         break;
 
     case REQ_FLUSH:
         _process_flush(rsp, req);
+        RECORD(process_metrics, flush_lat, _process_ns(&start));
         break;
 
     default:
@@ -498,10 +553,10 @@ process_request(struct response *rsp, struct request *req)
 }
 
 static void
-_cleanup(struct request **req, struct response **rsp)
+_cleanup(struct request **req)
 {
     request_return(req);
-    response_return_all(rsp);
+    response_vec_return(rspv);
 }
 
 int
@@ -509,7 +564,7 @@ twemcache_process_read(struct buf **rbuf, struct buf **wbuf, void **data)
 {
     parse_rstatus_t status;
     struct request *req;
-    struct response *rsp = NULL;
+    struct response *rsp;
 
     log_verb("post-read processing");
 
@@ -522,8 +577,10 @@ twemcache_process_read(struct buf **rbuf, struct buf **wbuf, void **data)
         return -1;
     }
 
-    /* keep parse-process-compose until running out of data in rbuf */
-    while (buf_rsize(*rbuf) > 0) {
+    /* keep parse-process-compose until running out of data in rbuf, or until
+     * enough replies are held, the rest is left for when they have drained
+     */
+    while (buf_rsize(*rbuf) > 0 && !worker_wbuf_full(*wbuf)) {
         struct response *nr;
         int i, card;
 
@@ -558,15 +615,11 @@ twemcache_process_read(struct buf **rbuf, struct buf **wbuf, void **data)
             /* extra response object for the "END" line after values */
             card++;
         }
-        for (i = 0, rsp = response_borrow(), nr = rsp;
-             i < card;
-             i++, STAILQ_NEXT(nr, next) = response_borrow(), nr =
-                STAILQ_NEXT(nr, next)) {
-            if (nr == NULL) {
-                log_error("cannot acquire response: OOM");
-                INCR(process_metrics, process_ex);
-                goto error;
-            }
+        rsp = response_vec_borrow(rspv, card);
+        if (rsp == NULL) {
+            log_error("cannot acquire response: OOM");
+            INCR(process_metrics, process_ex);
+            goto error;
         }
 
         /* actual processing & command logging */
@@ -578,6 +631,7 @@ twemcache_process_read(struct buf **rbuf, struct buf **wbuf, void **data)
         /* noreply means no need to write to buffers */
         if (req->noreply) {
             request_reset(req);
+            response_vec_return(rspv);
             continue;
         }
 
@@ -593,24 +647,32 @@ twemcache_process_read(struct buf **rbuf, struct buf **wbuf, void **data)
                 goto error;
             }
         }
+
+        request_reset(req);
+        response_vec_return(rspv);
     }
 
 done:
-    _cleanup(&req, &rsp);
+    _cleanup(&req);
     return 0;
 
 error:
-    _cleanup(&req, &rsp);
+    _cleanup(&req);
     return -1;
 }
 
 int
 twemcache_process_write(struct buf **rbuf, struct buf **wbuf, void **data)
 {
+    uintptr_t nidle = (uintptr_t)*data;
+
     log_verb("post-write processing");
 
-    dbuf_shrink(rbuf);
-    dbuf_shrink(wbuf);
+    /* the count of idle cycles lives in the per-connection data field, which
+     * is cleared whenever the connection is recycled
+     */
+    dbuf_shrink_idle(rbuf, wbuf, &nidle, shrink_idle, shrink_size);
+    *data = (void *)nidle;
 
     return 0;
 }
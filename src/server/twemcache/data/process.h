@@ -3,12 +3,17 @@
 #include <buffer/cc_buf.h>
 #include <cc_metric.h>
 #include <cc_option.h>
+#include <cc_util.h>
 
 #define ALLOW_FLUSH false
+#define SHRINK_IDLE 16
+#define SHRINK_SIZE (256 * KiB)
 
 /*          name         type              default      description */
 #define PROCESS_OPTION(ACTION)                                                              \
-    ACTION( allow_flush, OPTION_TYPE_BOOL, ALLOW_FLUSH, "allow flushing on the data port"  )
+    ACTION( allow_flush, OPTION_TYPE_BOOL, ALLOW_FLUSH, "allow flushing on the data port"  )\
+    ACTION( shrink_idle, OPTION_TYPE_UINT, SHRINK_IDLE, "idle writes before buf shrinks"   )\
+    ACTION( shrink_size, OPTION_TYPE_UINT, SHRINK_SIZE, "always shrink bufs above (byte)"  )
 
 typedef struct {
     PROCESS_OPTION(OPTION_DECLARE)
@@ -64,7 +69,19 @@ typedef struct {
     ACTION( prepend_stored,    METRIC_COUNTER, "# prepend successes"   )\
     ACTION( prepend_notstored, METRIC_COUNTER, "# prepend not_founds"  )\
     ACTION( prepend_ex,        METRIC_COUNTER, "# prepend errors"      )\
-    ACTION( flush,             METRIC_COUNTER, "# flush_all requests"  )
+    ACTION( flush,             METRIC_COUNTER, "# flush_all requests"  )\
+    ACTION( get_lat,           METRIC_HISTOGRAM, "get latency (ns)"    )\
+    ACTION( gets_lat,          METRIC_HISTOGRAM, "gets latency (ns)"   )\
+    ACTION( delete_lat,        METRIC_HISTOGRAM, "delete latency (ns)" )\
+    ACTION( set_lat,           METRIC_HISTOGRAM, "set latency (ns)"    )\
+    ACTION( add_lat,           METRIC_HISTOGRAM, "add latency (ns)"    )\
+    ACTION( replace_lat,       METRIC_HISTOGRAM, "replace latency (ns)")\
+    ACTION( cas_lat,           METRIC_HISTOGRAM, "cas latency (ns)"    )\
+    ACTION( incr_lat,          METRIC_HISTOGRAM, "incr latency (ns)"   )\
+    ACTION( decr_lat,          METRIC_HISTOGRAM, "decr latency (ns)"   )\
+    ACTION( append_lat,        METRIC_HISTOGRAM, "append latency (ns)" )\
+    ACTION( prepend_lat,       METRIC_HISTOGRAM, "prepend latency (ns)")\
+    ACTION( flush_lat,         METRIC_HISTOGRAM, "flush_all lat (ns)"  )
 
 typedef struct {
     PROCESS_METRIC(METRIC_DECLARE)
@@ -52,6 +52,8 @@ teardown(void)
     admin_process_teardown();
     process_teardown();
     slab_teardown();
+    mrc_teardown();
+    hotkey_teardown();
     klog_teardown();
     compose_teardown();
     parse_teardown();
@@ -63,6 +65,7 @@ teardown(void)
     timing_wheel_teardown();
     tcp_teardown();
     sockio_teardown();
+    efd_teardown();
     event_teardown();
     dbuf_teardown();
     buf_teardown();
@@ -84,7 +87,7 @@ setup(void)
 
     /* Setup logging first */
     log_setup(&stats.log);
-    if (debug_setup(&setting.debug) != CC_OK) {
+    if (debug_setup(&setting.debug, &stats.debug) != CC_OK) {
         log_stderr("debug log setup failed");
         exit(EX_CONFIG);
     }
@@ -103,6 +106,7 @@ setup(void)
     buf_setup(&setting.buf, &stats.buf);
     dbuf_setup(&setting.dbuf, &stats.dbuf);
     event_setup(&stats.event);
+    efd_setup(&stats.efd);
     sockio_setup(&setting.sockio);
     tcp_setup(&setting.tcp, &stats.tcp);
     timing_wheel_setup(&stats.timing_wheel);
@@ -115,19 +119,22 @@ setup(void)
     parse_setup(&stats.parse_req, NULL);
     compose_setup(NULL, &stats.compose_rsp);
     klog_setup(&setting.klog, &stats.klog);
+    hotkey_setup(&setting.hotkey, &stats.hotkey);
+    mrc_setup(&setting.mrc, &stats.mrc);
     slab_setup(&setting.slab, &stats.slab);
     process_setup(&setting.process, &stats.process);
     admin_process_setup(&stats.admin_process);
     core_setup(&setting.admin, &setting.server, &setting.worker,
             &stats.server, &stats.worker);
 
-    /* adding recurring events to maintenance/admin thread */
+    /* flush debug log off the worker and admin threads */
     intvl = option_uint(&setting.twemcache.dlog_intvl);
-    if (core_admin_register(intvl, debug_log_flush, NULL) == NULL) {
-        log_stderr("Could not register timed event to flush debug log");
+    if (debug_log_flusher_start(intvl) != CC_OK) {
+        log_stderr("Could not start thread to flush debug log");
         goto error;
     }
 
+    /* adding recurring events to maintenance/admin thread */
     intvl = option_uint(&setting.twemcache.klog_intvl);
     if (core_admin_register(intvl, klog_flush, NULL) == NULL) {
         log_error("Could not register timed event to flush command log");
@@ -3,6 +3,8 @@
 #include "data/process.h"
 
 #include <core/core.h>
+#include <hotkey/hotkey.h>
+#include <mrc/mrc.h>
 #include <storage/slab/slab.h>
 #include <storage/slab/item.h>
 #include <protocol/data/memcache_include.h>
@@ -36,6 +38,8 @@ struct setting {
     worker_options_st       worker;
     process_options_st      process;
     klog_options_st         klog;
+    hotkey_options_st       hotkey;
+    mrc_options_st          mrc;
     request_options_st      request;
     response_options_st     response;
     slab_options_st         slab;
@@ -7,6 +7,8 @@ struct stats stats = {
     { PARSE_REQ_METRIC(METRIC_INIT)     },
     { COMPOSE_RSP_METRIC(METRIC_INIT)   },
     { KLOG_METRIC(METRIC_INIT)          },
+    { HOTKEY_METRIC(METRIC_INIT)        },
+    { MRC_METRIC(METRIC_INIT)           },
     { REQUEST_METRIC(METRIC_INIT)       },
     { RESPONSE_METRIC(METRIC_INIT)      },
     { SLAB_METRIC(METRIC_INIT)          },
@@ -14,6 +16,8 @@ struct stats stats = {
     { CORE_WORKER_METRIC(METRIC_INIT)   },
     { BUF_METRIC(METRIC_INIT)           },
     { DBUF_METRIC(METRIC_INIT)          },
+    { DEBUG_METRIC(METRIC_INIT)         },
+    { EFD_METRIC(METRIC_INIT)           },
     { EVENT_METRIC(METRIC_INIT)         },
     { LOG_METRIC(METRIC_INIT)           },
     { TCP_METRIC(METRIC_INIT)           },
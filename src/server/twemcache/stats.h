@@ -7,10 +7,14 @@
 #include <storage/slab/item.h>
 #include <storage/slab/slab.h>
 #include <core/core.h>
+#include <hotkey/hotkey.h>
+#include <mrc/mrc.h>
 #include <util/procinfo.h>
 
+#include <cc_debug.h>
 #include <cc_event.h>
 #include <cc_log.h>
+#include <channel/cc_eventfd.h>
 #include <channel/cc_tcp.h>
 #include <time/cc_wheel.h>
 
@@ -23,6 +27,8 @@ struct stats {
     parse_req_metrics_st        parse_req;
     compose_rsp_metrics_st      compose_rsp;
     klog_metrics_st             klog;
+    hotkey_metrics_st           hotkey;
+    mrc_metrics_st              mrc;
     request_metrics_st          request;
     response_metrics_st         response;
     slab_metrics_st             slab;
@@ -31,6 +37,8 @@ struct stats {
     /* ccommon libraries */
     buf_metrics_st              buf;
     dbuf_metrics_st             dbuf;
+    debug_metrics_st            debug;
+    efd_metrics_st              efd;
     event_metrics_st            event;
     log_metrics_st              log;
     tcp_metrics_st              tcp;
@@ -98,7 +98,7 @@ _select_candidate(const uint32_t offset[])
     if (cuckoo_policy == CUCKOO_POLICY_RANDOM) {
         selected = offset[RANDOM(D)];
     } else if (cuckoo_policy == CUCKOO_POLICY_EXPIRE) {
-        rel_time_t expire, min = UINT32_MAX; /* legal ts should < UINT32_MAX */
+        rel_time_ms_t expire, min = UINT64_MAX; /* legal ts should < UINT64_MAX */
         uint32_t i;
 
         for (i = 0; i < D; ++i) {
@@ -132,11 +132,11 @@ _sort_candidate(uint32_t ordered[], const uint32_t offset[])
             ordered[i] = offset[j];
         }
     } else if (cuckoo_policy == CUCKOO_POLICY_EXPIRE) {
-        rel_time_t expire[D];
+        rel_time_ms_t expire[D];
 
         for (i = 0; i < D; ++i) {
             uint32_t j = i;
-            rel_time_t te;
+            rel_time_ms_t te;
             uint32_t to;
 
             /* basically an insert sort */
@@ -291,6 +291,8 @@ cuckoo_teardown(void)
         cc_free(ds);
     }
 
+    metric_teardown((struct metric *)cuckoo_metrics,
+            METRIC_CARDINALITY(cuckoo_metrics_st));
     cuckoo_metrics = NULL;
     cuckoo_init = false;
 }
@@ -333,9 +335,22 @@ cuckoo_get(struct bstring *key)
     return NULL;
 }
 
+static inline void
+_item_record(uint32_t klen, uint32_t vlen, rel_time_ms_t expire_ms)
+{
+    rel_time_t expire = (rel_time_t)(expire_ms / 1000);
+
+    RECORD(cuckoo_metrics, item_key_size, klen);
+    RECORD(cuckoo_metrics, item_val_size, vlen);
+    if (expire != TIME_NEVER) {
+        RECORD(cuckoo_metrics, item_ttl,
+                expire > time_now() ? expire - time_now() : 0);
+    }
+}
+
 /* insert applies to a key that doesn't exist validly in our array */
 rstatus_i
-cuckoo_insert(struct bstring *key, struct val *val, rel_time_t expire)
+cuckoo_insert(struct bstring *key, struct val *val, rel_time_ms_t expire)
 {
     struct item *it;
     uint32_t offset[D];
@@ -381,12 +396,13 @@ cuckoo_insert(struct bstring *key, struct val *val, rel_time_t expire)
     item_set(it, key, val, expire);
     INCR(cuckoo_metrics, item_insert);
     ITEM_METRICS_INCR(it);
+    _item_record(key->len, vlen(val), expire);
 
     return CC_OK;
 }
 
 rstatus_i
-cuckoo_update(struct item *it, struct val *val, rel_time_t expire)
+cuckoo_update(struct item *it, struct val *val, rel_time_ms_t expire)
 {
     ASSERT(it != NULL && val != NULL);
 
@@ -404,6 +420,7 @@ cuckoo_update(struct item *it, struct val *val, rel_time_t expire)
     item_update(it, val, expire);
     INCR_N(cuckoo_metrics, item_val_curr, item_vlen(it));
     INCR_N(cuckoo_metrics, item_data_curr, item_vlen(it));
+    _item_record(item_klen(it), vlen(val), expire);
 
     return CC_OK;
 }
@@ -46,7 +46,10 @@ typedef struct {
     ACTION( item_evict,         METRIC_COUNTER, "# evicted items"      )\
     ACTION( item_expire,        METRIC_COUNTER, "# expired items"      )\
     ACTION( item_insert,        METRIC_COUNTER, "# item inserts"       )\
-    ACTION( item_delete,        METRIC_COUNTER, "# item deletes"       )
+    ACTION( item_delete,        METRIC_COUNTER, "# item deletes"       )\
+    ACTION( item_key_size,      METRIC_HISTOGRAM, "key size on set"    )\
+    ACTION( item_val_size,      METRIC_HISTOGRAM, "val size on set"    )\
+    ACTION( item_ttl,           METRIC_HISTOGRAM, "ttl(s) if expiring" )
 
 
 typedef struct {
@@ -60,6 +63,7 @@ void cuckoo_teardown(void);
 void cuckoo_reset(void);
 
 struct item * cuckoo_get(struct bstring *key);
-rstatus_i cuckoo_insert(struct bstring *key, struct val *val, rel_time_t expire);
-rstatus_i cuckoo_update(struct item *it, struct val *val, rel_time_t expire);
+/* expire is in ms, see time_sec2ms */
+rstatus_i cuckoo_insert(struct bstring *key, struct val *val, rel_time_ms_t expire);
+rstatus_i cuckoo_update(struct item *it, struct val *val, rel_time_ms_t expire);
 bool cuckoo_delete(struct bstring *key);
@@ -64,9 +64,10 @@ struct val {
  */
 
 struct item {
-  rel_time_t expire;
+  rel_time_t expire;    /* expiry time in secs, 0 if empty */
   uint8_t    klen;
   uint8_t    vlen;
+  uint16_t   expire_ms; /* ms into expire, 2 more bytes of header per item */
   char       data[1];
 };
 
@@ -120,17 +121,17 @@ item_matched(struct item *it, struct bstring *key)
     return (cc_bcmp(ITEM_KEY_POS(it), key->data, key->len) == 0);
 }
 
-static inline rel_time_t
+static inline rel_time_ms_t
 item_expire(struct item *it)
 {
-    return it->expire;
+    return (rel_time_ms_t)it->expire * 1000 + it->expire_ms;
 }
 
 /* only use this on the read path */
 static inline bool
 item_valid(struct item *it)
 {
-    return (it->expire >= time_now());
+    return !time_expired(it->expire, it->expire_ms);
 }
 
 static inline bool
@@ -142,7 +143,7 @@ item_empty(struct item *it)
 static inline bool
 item_expired(struct item *it)
 {
-    if (it->expire < time_now() && it->expire > 0) {
+    if (it->expire > 0 && time_expired(it->expire, it->expire_ms)) {
         return true;
     } else {
         return false;
@@ -230,14 +231,15 @@ item_value_update(struct item *it, struct val *val)
 }
 
 static inline void
-item_update(struct item *it, struct val *val, rel_time_t expire)
+item_update(struct item *it, struct val *val, rel_time_ms_t expire)
 {
-    it->expire = expire;
+    it->expire = (rel_time_t)(expire / 1000);
+    it->expire_ms = (uint16_t)(expire % 1000);
     item_value_update(it, val);
 }
 
 static inline void
-item_set(struct item *it, struct bstring *key, struct val *val, rel_time_t expire)
+item_set(struct item *it, struct bstring *key, struct val *val, rel_time_ms_t expire)
 {
     it->klen = (uint8_t)key->len;
     cc_memcpy(ITEM_KEY_POS(it), key->data, key->len);
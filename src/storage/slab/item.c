@@ -11,7 +11,7 @@ static rel_time_t flush_at = 0;
 static inline bool
 _item_expired(struct item *it)
 {
-    return ((it->expire_at > 0 && it->expire_at < time_now())
+    return ((it->expire_at > 0 && time_expired(it->expire_at, it->expire_ms))
             || (it->create_at <= flush_at));
 }
 
@@ -59,6 +59,7 @@ _item_reset(struct item *it)
     it->dataflag = 0;
     it->klen = 0;
     it->expire_at = 0;
+    it->expire_ms = 0;
     it->create_at = 0;
 }
 
@@ -114,6 +115,8 @@ _item_link(struct item *it)
     it->is_linked = 1;
 
     hashtable_put(it, hash_table);
+    slabclass[it->id].nitem_curr++;
+    slabclass[it->id].keyval_byte += it->klen + it->vlen;
 
     INCR(slab_metrics, item_curr);
     INCR(slab_metrics, item_insert);
@@ -135,6 +138,8 @@ _item_unlink(struct item *it)
     if (it->is_linked) {
         it->is_linked = 0;
         hashtable_delete(item_key(it), it->klen, hash_table);
+        slabclass[it->id].nitem_curr--;
+        slabclass[it->id].keyval_byte -= it->klen + it->vlen;
     }
     slab_put_item(it, it->id);
 
@@ -173,7 +178,7 @@ item_get(const struct bstring *key)
 }
 
 item_rstatus_t
-item_insert(const struct bstring *key, const struct bstring *val, uint32_t dataflag, rel_time_t expire_at)
+item_insert(const struct bstring *key, const struct bstring *val, uint32_t dataflag, rel_time_ms_t expire_at)
 {
     item_rstatus_t status;
     struct item *it = NULL;
@@ -182,7 +187,7 @@ item_insert(const struct bstring *key, const struct bstring *val, uint32_t dataf
         return status;
     }
 
-    it->expire_at = expire_at;
+    item_set_expire(it, expire_at);
     it->create_at = time_now();
     it->dataflag = dataflag;
     _copy_key(it, key);
@@ -190,6 +195,13 @@ item_insert(const struct bstring *key, const struct bstring *val, uint32_t dataf
     item_set_cas(it);
     _item_link(it);
 
+    RECORD(slab_metrics, item_key_size, key->len);
+    RECORD(slab_metrics, item_val_size, val->len);
+    if (it->expire_at != TIME_NEVER) {
+        RECORD(slab_metrics, item_ttl,
+                it->expire_at > time_now() ? it->expire_at - time_now() : 0);
+    }
+
     log_verb("insert it %p of id %"PRIu8" it->klen: %d dataflag %u", it, it->id, it->klen, it->dataflag);
 
     return ITEM_OK;
@@ -221,6 +233,7 @@ item_annex(struct item *oit, const struct bstring *val, bool append)
         if (id == oit->id && !(oit->is_raligned)) {
             cc_memcpy(item_data(oit) + oit->vlen, val->data, val->len);
             oit->vlen = ntotal;
+            slabclass[oit->id].keyval_byte += val->len;
             INCR_N(slab_metrics, item_keyval_byte, val->len);
             INCR_N(slab_metrics, item_val_byte, val->len);
             item_set_cas(oit);
@@ -232,6 +245,7 @@ item_annex(struct item *oit, const struct bstring *val, bool append)
             }
             _copy_key_item(nit, oit);
             nit->expire_at = oit->expire_at;
+            nit->expire_ms = oit->expire_ms;
             nit->create_at = time_now();
             nit->dataflag = oit->dataflag;
             item_set_cas(nit);
@@ -251,6 +265,7 @@ item_annex(struct item *oit, const struct bstring *val, bool append)
         if (id == oit->id && oit->is_raligned) {
             cc_memcpy(item_data(oit) - val->len, val->data, val->len);
             oit->vlen = ntotal;
+            slabclass[oit->id].keyval_byte += val->len;
             INCR_N(slab_metrics, item_keyval_byte, val->len);
             INCR_N(slab_metrics, item_val_byte, val->len);
             item_set_cas(oit);
@@ -262,6 +277,7 @@ item_annex(struct item *oit, const struct bstring *val, bool append)
             }
             _copy_key_item(nit, oit);
             nit->expire_at = oit->expire_at;
+            nit->expire_ms = oit->expire_ms;
             nit->create_at = time_now();
             nit->dataflag = oit->dataflag;
             item_set_cas(nit);
@@ -286,6 +302,15 @@ item_update(struct item *it, const struct bstring *val)
 {
     ASSERT(item_slabid(it->klen, val->len) == it->id);
 
+    if (it->is_linked) { /* keep byte counts in step with the new value */
+        slabclass[it->id].keyval_byte += val->len;
+        slabclass[it->id].keyval_byte -= it->vlen;
+        INCR_N(slab_metrics, item_keyval_byte, val->len);
+        DECR_N(slab_metrics, item_keyval_byte, it->vlen);
+        INCR_N(slab_metrics, item_val_byte, val->len);
+        DECR_N(slab_metrics, item_val_byte, it->vlen);
+    }
+
     it->vlen = val->len;
     cc_memcpy(item_data(it), val->data, val->len);
     item_set_cas(it);
@@ -51,7 +51,7 @@ struct item {
     uint32_t          magic;         /* item magic (const) */
 #endif
     SLIST_ENTRY(item) i_sle;         /* link in hash/freeq */
-    rel_time_t        expire_at;     /* expiry time in secs */
+    rel_time_t        expire_at;     /* expiry time in secs, TIME_NEVER if never */
     rel_time_t        create_at;     /* time when this item was last linked */
 
     uint32_t          is_linked:1;   /* item in hash */
@@ -65,7 +65,8 @@ struct item {
     uint32_t          dataflag;      /* data flags opaque to the server */
     uint8_t           id;            /* slab class id */
     uint8_t           klen;          /* key length */
-    uint16_t          padding;       /* keep end 64-bit aligned, it may be a cas */
+    uint16_t          expire_ms;     /* ms into expire_at, also keeps end 64-bit
+                                        aligned, it may be a cas */
     char              end[1];        /* item data */
 };
 
@@ -94,6 +95,19 @@ item_flag(struct item *it)
     return it->dataflag;
 }
 
+static inline rel_time_ms_t
+item_expire(struct item *it)
+{
+    return (rel_time_ms_t)it->expire_at * 1000 + it->expire_ms;
+}
+
+static inline void
+item_set_expire(struct item *it, rel_time_ms_t expire)
+{
+    it->expire_at = (rel_time_t)(expire / 1000);
+    it->expire_ms = (uint16_t)(expire % 1000);
+}
+
 static inline uint64_t
 item_get_cas(struct item *it)
 {
@@ -179,8 +193,8 @@ void item_hdr_init(struct item *it, uint32_t offset, uint8_t id);
 /* Item lookup */
 struct item *item_get(const struct bstring *key);
 
-/* Insert item, this assumes the key does not exist */
-item_rstatus_t item_insert(const struct bstring *key, const struct bstring *val, uint32_t dataflag, rel_time_t expire_at);
+/* Insert item, this assumes the key does not exist, expire_at is in ms */
+item_rstatus_t item_insert(const struct bstring *key, const struct bstring *val, uint32_t dataflag, rel_time_ms_t expire_at);
 
 /* Append/prepend */
 item_rstatus_t item_annex(struct item *it, const struct bstring *val, bool append);
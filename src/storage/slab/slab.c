@@ -3,6 +3,7 @@
 #include <storage/slab/hashtable.h>
 
 #include <cc_mm.h>
+#include <cc_print.h>
 #include <cc_util.h>
 
 #include <errno.h>
@@ -12,6 +13,7 @@
 #include <sysexits.h>
 
 #define SLAB_MODULE_NAME       "storage::slab"
+#define SLAB_STATS_NAME_LEN    32
 #define SLAB_ALIGN_DOWN(d, n)  ((d) - ((d) % (n)))
 
 struct slab_heapinfo {
@@ -64,6 +66,104 @@ slab_print(void)
     }
 }
 
+uint8_t
+slab_nclass(void)
+{
+    return profile_last_id;
+}
+
+static size_t
+_slab_print_val(char *buf, size_t nbuf, char *fmt, uint8_t id, char *name,
+        uint64_t val)
+{
+    char name_buf[SLAB_STATS_NAME_LEN];
+    char val_buf[CC_UINT64_MAXLEN];
+
+    cc_scnprintf(name_buf, SLAB_STATS_NAME_LEN, "%"PRIu8":%s", id, name);
+    val_buf[cc_print_uint64_unsafe(val_buf, val)] = '\0';
+
+    return cc_scnprintf(buf, nbuf, fmt, name_buf, val_buf);
+}
+
+/* the worker updates per-class stats without atomics, read them as such */
+#define SLAB_STAT(_p, _field) __atomic_load_n(&(_p)->_field, __ATOMIC_RELAXED)
+
+static inline bool
+_slab_class_used(struct slabclass *p)
+{
+    return SLAB_STAT(p, nslab) > 0 || SLAB_STAT(p, nalloc_ex) > 0 ||
+        SLAB_STAT(p, nevict_slab) > 0;
+}
+
+size_t
+slab_print_stats(char *buf, size_t nbuf, char *fmt)
+{
+    uint8_t id;
+    struct slabclass *p;
+    uint64_t nchunk, nfree;
+    size_t len = 0;
+
+    for (id = SLABCLASS_MIN_ID; id <= profile_last_id; id++) {
+        p = &slabclass[id];
+        if (!_slab_class_used(p)) {
+            continue;
+        }
+
+        nchunk = (uint64_t)SLAB_STAT(p, nslab) * p->nitem;
+        nfree = SLAB_STAT(p, nfree_itemq) + SLAB_STAT(p, nfree_item);
+        nfree = nfree < nchunk ? nfree : nchunk;
+
+        len += _slab_print_val(buf + len, nbuf - len, fmt, id, "chunk_size",
+                p->size);
+        len += _slab_print_val(buf + len, nbuf - len, fmt, id,
+                "chunks_per_slab", p->nitem);
+        len += _slab_print_val(buf + len, nbuf - len, fmt, id, "total_slabs",
+                SLAB_STAT(p, nslab));
+        len += _slab_print_val(buf + len, nbuf - len, fmt, id, "total_chunks",
+                nchunk);
+        len += _slab_print_val(buf + len, nbuf - len, fmt, id, "used_chunks",
+                nchunk - nfree);
+        len += _slab_print_val(buf + len, nbuf - len, fmt, id, "free_chunks",
+                nfree);
+        len += _slab_print_val(buf + len, nbuf - len, fmt, id, "free_itemq",
+                SLAB_STAT(p, nfree_itemq));
+        len += _slab_print_val(buf + len, nbuf - len, fmt, id, "mem_byte",
+                (uint64_t)SLAB_STAT(p, nslab) * slab_size);
+        len += _slab_print_val(buf + len, nbuf - len, fmt, id, "evicted_slabs",
+                SLAB_STAT(p, nevict_slab));
+        len += _slab_print_val(buf + len, nbuf - len, fmt, id, "alloc_ex",
+                SLAB_STAT(p, nalloc_ex));
+    }
+
+    return len;
+}
+
+size_t
+slab_print_items(char *buf, size_t nbuf, char *fmt)
+{
+    uint8_t id;
+    struct slabclass *p;
+    size_t len = 0;
+
+    for (id = SLABCLASS_MIN_ID; id <= profile_last_id; id++) {
+        p = &slabclass[id];
+        if (!_slab_class_used(p)) {
+            continue;
+        }
+
+        len += _slab_print_val(buf + len, nbuf - len, fmt, id, "number",
+                SLAB_STAT(p, nitem_curr));
+        len += _slab_print_val(buf + len, nbuf - len, fmt, id, "keyval_byte",
+                SLAB_STAT(p, keyval_byte));
+        len += _slab_print_val(buf + len, nbuf - len, fmt, id, "alloc",
+                SLAB_STAT(p, nalloc));
+        len += _slab_print_val(buf + len, nbuf - len, fmt, id, "evicted",
+                SLAB_STAT(p, nevict_item));
+    }
+
+    return len;
+}
+
 /*
  * Get the idx^th item with a given size from the slab.
  */
@@ -157,6 +257,14 @@ _slab_slabclass_setup(void)
 
         p->nfree_item = 0;
         p->next_item_in_slab = NULL;
+
+        p->nslab = 0;
+        p->nitem_curr = 0;
+        p->keyval_byte = 0;
+        p->nalloc = 0;
+        p->nalloc_ex = 0;
+        p->nevict_slab = 0;
+        p->nevict_item = 0;
     }
 
     return CC_OK;
@@ -380,6 +488,8 @@ slab_teardown(void)
     hashtable_destroy(hash_table);
     _slab_heapinfo_teardown();
     _slab_slabclass_teardown();
+    metric_teardown((struct metric *)slab_metrics,
+            METRIC_CARDINALITY(slab_metrics_st));
     slab_metrics = NULL;
 
     slab_init = false;
@@ -574,6 +684,13 @@ _slab_evict_one(struct slab *slab)
         if (it->is_linked) {
             it->is_linked = 0;
             hashtable_delete(item_key(it), it->klen, hash_table);
+
+            p->nevict_item++;
+            p->nitem_curr--;
+            p->keyval_byte -= it->klen + it->vlen;
+            DECR(slab_metrics, item_curr);
+            DECR_N(slab_metrics, item_keyval_byte, it->klen + it->vlen);
+            DECR_N(slab_metrics, item_val_byte, it->vlen);
         } else if (it->in_freeq) {
             ASSERT(slab == item_to_slab(it));
             ASSERT(!SLIST_EMPTY(&p->free_itemq));
@@ -587,6 +704,8 @@ _slab_evict_one(struct slab *slab)
 
     /* unlink the slab from its class */
     _slab_lruq_remove(slab);
+    p->nslab--;
+    p->nevict_slab++;
 
     INCR(slab_metrics, slab_evict);
 }
@@ -650,6 +769,8 @@ _slab_init(struct slab *slab, uint8_t id)
         item_hdr_init(it, offset, id);
     }
 
+    p->nslab++;
+
     /* make this slab as the current slab */
     p->nfree_item = p->nitem;
     p->next_item_in_slab = (struct item *)&slab->data[0];
@@ -778,6 +899,11 @@ slab_get_item(uint8_t id)
     ASSERT(id >= SLABCLASS_MIN_ID && id <= profile_last_id);
 
     it = _slab_get_item(id);
+    if (it != NULL) {
+        slabclass[id].nalloc++;
+    } else {
+        slabclass[id].nalloc_ex++;
+    }
 
     return it;
 }
@@ -68,7 +68,10 @@ typedef struct {
     ACTION( item_req,           METRIC_COUNTER, "# items allocated"        )\
     ACTION( item_req_ex,        METRIC_COUNTER, "# item alloc errors"      )\
     ACTION( item_insert,        METRIC_COUNTER, "# items inserted"         )\
-    ACTION( item_remove,        METRIC_COUNTER, "# items removed"          )
+    ACTION( item_remove,        METRIC_COUNTER, "# items removed"          )\
+    ACTION( item_key_size,      METRIC_HISTOGRAM, "key size on set"        )\
+    ACTION( item_val_size,      METRIC_HISTOGRAM, "val size on set"        )\
+    ACTION( item_ttl,           METRIC_HISTOGRAM, "ttl(s) if expiring"     )
 
 
 typedef struct {
@@ -146,6 +149,17 @@ item_to_slab(struct item *it)
 void slab_print(void);
 uint8_t slab_id(size_t size);
 
+/*
+ * Per-slabclass stats, written with fmt taking a name and a value (e.g.
+ * "STAT %s %s\r\n") as "<id>:<name> <value>" for every class in use.
+ * slab_print_stats covers slabs and chunks (memory), slab_print_items the
+ * items stored. Each writes at most SLAB_STATS_NLINE lines per class.
+ */
+#define SLAB_STATS_NLINE 10
+uint8_t slab_nclass(void);
+size_t slab_print_stats(char *buf, size_t nbuf, char *fmt);
+size_t slab_print_items(char *buf, size_t nbuf, char *fmt);
+
 /* Calculate slab id that will accommodate item with given key/val lengths */
 static inline uint8_t
 item_slabid(uint8_t klen, uint32_t vlen)
@@ -73,6 +73,15 @@ struct slabclass {
 
     uint32_t        nfree_item;            /* # free item (in current slab) */
     struct item     *next_item_in_slab;    /* next free item (in current slab, not freeq) */
+
+    /* per-class stats, see slab_print_stats/slab_print_items */
+    uint32_t        nslab;                 /* # slabs in the class */
+    uint64_t        nitem_curr;            /* # items linked */
+    uint64_t        keyval_byte;           /* key + val of linked items */
+    uint64_t        nalloc;                /* # items allocated */
+    uint64_t        nalloc_ex;             /* # item allocation failures */
+    uint64_t        nevict_slab;           /* # slabs evicted from the class */
+    uint64_t        nevict_item;           /* # linked items lost to eviction */
 };
 
 /*
@@ -3,23 +3,19 @@
 #include <cc_debug.h>
 #include <cc_event.h>
 
-#include <errno.h>
 #include <stdbool.h>
-#include <string.h>
 
 void
 time_update(void)
 {
-    time_t t;
+    rel_time_ms_t ms;
 
-    t = time(NULL);
-    if (t < 0) {
-	log_warn("get current time failed: %s", strerror(errno));
-        return;
-    }
+    clock_update();
 
     /* we assume service is online for less than 2^32 seconds */
-    now = (rel_time_t) (t - time_start);
+    ms = clock_ms() - (rel_time_ms_t)time_start * 1000;
+    __atomic_store_n(&now_ms, ms, __ATOMIC_RELAXED);
+    now = (rel_time_t)(ms / 1000);
 
     log_vverb("internal timer updated to %u", now);
 }
@@ -33,7 +29,8 @@ time_setup(void)
      * like 'settings.oldest_live' which act as booleans as well as
      * values are now false in boolean context.
      */
-    time_start = time(NULL) - 2;
+    clock_update();
+    time_start = clock_sec() - 2;
 
     log_info("timer started at %"PRIu64"(2 sec setback)",
             (uint64_t)time_start);
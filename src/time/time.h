@@ -15,8 +15,10 @@
  *   added in the future to strike different balance between precision and cost.
  */
 #include <cc_define.h>
+#include <time/cc_clock.h>
 
 #include <inttypes.h>
+#include <stdbool.h>
 #include <time.h>
 
 /* NOTE(yao): this whole time module needs a major overhaul */
@@ -32,6 +34,18 @@
  */
 typedef uint32_t rel_time_t;
 
+#define TIME_NEVER (UINT32_MAX - 1) /* expiry of items that never expire */
+
+/*
+ * Expiry with millisecond precision, rel_time_t * 1000 + the millisecond into
+ * that second. Items store the two parts apart, so the second keeps its width
+ * and existing comparisons. Expiry given in seconds is at TIME_MSEC_END of its
+ * second, so such items last through the second as they always have.
+ */
+typedef uint64_t rel_time_ms_t;
+
+#define TIME_MSEC_END 999
+
 /*
  * From memcache protocol specification:
  *
@@ -68,6 +82,12 @@ time_t time_start;
  */
 rel_time_t now;
 
+/*
+ * now in milliseconds, set from the same clock read as now, so the two never
+ * disagree on the second
+ */
+rel_time_ms_t now_ms;
+
 /* Get the time the process started */
 static inline time_t
 time_started(void)
@@ -89,12 +109,38 @@ time_now(void)
     return now;
 }
 
+/* Get the current time in milliseconds (since process started) */
+static inline rel_time_ms_t
+time_now_ms(void)
+{
+    return __atomic_load_n(&now_ms, __ATOMIC_RELAXED);
+}
+
+/* Get expiry in ms given expiry in seconds, lasting through that second */
+static inline rel_time_ms_t
+time_sec2ms(rel_time_t t)
+{
+    return (rel_time_ms_t)t * 1000 + TIME_MSEC_END;
+}
+
+/*
+ * Whether an expiry of second sec, millisecond msec into it, has passed. now
+ * decides unless sec is the current second, then it takes now_ms, which is
+ * never behind now when both come from the same update.
+ */
+static inline bool
+time_expired(rel_time_t sec, uint16_t msec)
+{
+    return sec < now ||
+        (sec == now && (rel_time_ms_t)sec * 1000 + msec < time_now_ms());
+}
+
 /* Get time relative to process start given absolute time */
 static inline rel_time_t
 time_reltime(uint32_t t)
 {
     if (t == 0) { /* 0 means never expire so we set it a very large number */
-        return UINT32_MAX - 1;
+        return TIME_NEVER;
     }
 
     if (t > TIME_MAXDELTA) {
@@ -116,6 +162,21 @@ time_reltime(uint32_t t)
     }
 }
 
+/*
+ * Get expiry in ms given a ttl in ms (protocol extension), which is always
+ * relative to the current time; 0 still means never expire
+ */
+static inline rel_time_ms_t
+time_reltime_ms(uint32_t ms)
+{
+    if (ms == 0) {
+        return time_sec2ms(TIME_NEVER);
+    }
+
+    return time_now_ms() + ms;
+}
+
+/* refresh the cached clock (see cc_clock.h) and now from it */
 void time_update(void);
 
 /* Set up: record process start time, start periodic timer update */
@@ -0,0 +1,639 @@
+#include "setting.h"
+#include "stats.h"
+
+#include <util/util.h>
+
+#include <cc_debug.h>
+#include <cc_define.h>
+#include <cc_event.h>
+#include <cc_mm.h>
+#include <cc_print.h>
+#include <stream/cc_sockio.h>
+#include <time/cc_timer.h>
+
+#include <netdb.h>
+#include <stdio.h>
+#include <string.h>
+#include <sysexits.h>
+
+#define NSEC_PER_USEC   1000ULL
+#define NSEC_PER_MSEC   1000000ULL
+#define NSEC_PER_SEC    1000000000ULL
+
+#define BENCH_NEVENT    1024
+#define BENCH_WAIT_MS   100     /* event wait with nothing else to do */
+#define CONNECT_WAIT_MS 5000
+
+/*
+ * A request in flight: its type, to tell when its response is complete and
+ * where to record its latency, and when it was sent. In an open loop, that is
+ * when it was due, so a request that had to wait for a connection counts the
+ * wait as well, as a client issuing it at that time would have seen.
+ */
+struct bench_req {
+    uint64_t            start;      /* ns since the epoch */
+    request_type_t      type;
+};
+
+struct bench_conn {
+    struct buf_sock     *s;
+    struct bench_req    *req;       /* ring of bench_pipeline slots */
+    uint32_t            head;       /* oldest request in flight */
+    uint32_t            nreq;       /* # requests in flight */
+    bool                hit;        /* the oldest, a get, has had a value */
+};
+
+static channel_handler_st handlers;
+static channel_handler_st *hdl = &handlers;
+static struct addrinfo *bench_ai = NULL;
+static struct event_base *evb = NULL;
+static struct bench_conn *conn = NULL;
+static uint32_t nconn;
+static uint32_t pipeline;
+static uint64_t rate;
+static struct request *req = NULL;
+static struct response *rsp = NULL;
+static bench_metrics_st *bench_metrics = &stats.bench;
+
+static struct timeout epoch;        /* times are in ns since */
+static bool prefill = false;        /* setting every key, nothing recorded */
+static uint64_t nsent;              /* # requests sent in this phase */
+static uint64_t nrecv;              /* # responses received in this phase */
+static uint32_t nconnected;
+
+static void
+show_usage(void)
+{
+    log_stdout(
+            "Usage:" CRLF
+            "  pelikan_bench [option|config]" CRLF
+            );
+    log_stdout(
+            "Description:" CRLF
+            "  pelikan_bench drives a memcache server, e.g. twemcache or " CRLF
+            "  slimcache, with a configurable workload and reports the " CRLF
+            "  throughput and latency percentiles seen." CRLF
+            CRLF
+            "  Requests go over bench_nconn connections, each with up to " CRLF
+            "  bench_pipeline of them in flight. With bench_rate unset, " CRLF
+            "  every response is followed by a new request (closed loop), " CRLF
+            "  otherwise requests are sent at that rate no matter how fast " CRLF
+            "  responses come back (open loop)." CRLF
+            );
+    log_stdout(
+            "Command-line options:" CRLF
+            "  -h, --help        show this message" CRLF
+            "  -v, --version     show version number" CRLF
+            "  -c, --config      list & describe all options in config" CRLF
+            "  -s, --stats       list & describe all metrics in stats" CRLF
+            );
+    log_stdout(
+            "Example:" CRLF
+            "  pelikan_bench bench.conf" CRLF CRLF
+            "Sample config files can be found under the config dir." CRLF
+            );
+}
+
+static inline uint64_t
+_now_ns(void)
+{
+    return (uint64_t)-timeout_ns(&epoch);
+}
+
+static void
+_bench_fail(struct bench_conn *c, const char *reason)
+{
+    log_stderr("connection %td: %s", c - conn, reason);
+    exit(EX_PROTOCOL);
+}
+
+static void
+_record(struct bench_req *r, response_type_t type, bool hit, uint64_t now)
+{
+    uint64_t lat = now - r->start;
+
+    INCR(bench_metrics, bench_response);
+
+    switch (type) {
+    case RSP_END:
+        if (hit) {
+            INCR(bench_metrics, bench_hit);
+        } else {
+            INCR(bench_metrics, bench_miss);
+        }
+        break;
+
+    case RSP_NOT_FOUND:
+        INCR(bench_metrics, bench_miss);
+        break;
+
+    case RSP_NUMERIC:
+        INCR(bench_metrics, bench_hit);
+        break;
+
+    case RSP_CLIENT_ERROR:
+    case RSP_SERVER_ERROR:
+        INCR(bench_metrics, bench_error);
+        break;
+
+    default:
+        break;
+    }
+
+    RECORD(bench_metrics, bench_lat, lat);
+    switch (r->type) {
+    case REQ_GET:
+        RECORD(bench_metrics, get_lat, lat);
+        break;
+
+    case REQ_SET:
+        RECORD(bench_metrics, set_lat, lat);
+        break;
+
+    case REQ_INCR:
+        RECORD(bench_metrics, incr_lat, lat);
+        break;
+
+    default:
+        break;
+    }
+}
+
+/* parse all complete responses received, matching them to requests in order */
+static void
+_conn_recv(struct bench_conn *c)
+{
+    struct buf *buf = c->s->rbuf;
+    struct bench_req *r;
+    parse_rstatus_t status;
+    uint64_t now = _now_ns();
+
+    while (buf_rsize(buf) > 0) {
+        response_reset(rsp);
+        status = parse_rsp(rsp, buf);
+        if (status == PARSE_EUNFIN) {
+            break;
+        }
+        if (status != PARSE_OK) {
+            _bench_fail(c, "cannot parse response");
+        }
+        if (c->nreq == 0) {
+            _bench_fail(c, "response to no request");
+        }
+
+        r = &c->req[c->head];
+        /* a get is over at END, with or without a value before it */
+        if (rsp->type == RSP_VALUE && r->type == REQ_GET) {
+            c->hit = true;
+            continue;
+        }
+        if (!prefill) {
+            _record(r, rsp->type, c->hit, now);
+        }
+        c->head = (c->head + 1) % pipeline;
+        c->nreq--;
+        c->hit = false;
+        nrecv++;
+    }
+
+    buf_lshift(buf);
+}
+
+static void
+_conn_send(struct bench_conn *c, uint64_t start)
+{
+    struct bench_req *r;
+    int n;
+
+    request_reset(req);
+    if (prefill) {
+        workload_set(req, nsent);
+    } else {
+        workload_next(req);
+    }
+
+    n = compose_req(&c->s->wbuf, req);
+    if (n < 0) {
+        _bench_fail(c, "cannot compose request, too large for dbuf_max_power?");
+    }
+
+    r = &c->req[(c->head + c->nreq) % pipeline];
+    r->start = start;
+    r->type = req->type;
+    c->nreq++;
+    nsent++;
+    if (!prefill) {
+        INCR(bench_metrics, bench_request);
+    }
+}
+
+/* returns true if the connection is left with data to write */
+static bool
+_conn_flush(struct bench_conn *c)
+{
+    struct buf_sock *s = c->s;
+    rstatus_i status;
+
+    if (buf_rsize(s->wbuf) == 0) {
+        return false;
+    }
+
+    status = buf_tcp_write(s);
+    if (status == CC_ERROR) {
+        _bench_fail(c, "cannot send requests");
+    }
+    if (buf_rsize(s->wbuf) > 0) {
+        return true;
+    }
+    buf_reset(s->wbuf);
+
+    return false;
+}
+
+static void
+_bench_event(void *arg, uint32_t events)
+{
+    struct bench_conn *c = arg;
+    struct tcp_conn *ch = c->s->ch;
+
+    if (events & EVENT_ERR) {
+        _bench_fail(c, "connection error");
+    }
+
+    if (ch->state == CHANNEL_OPEN && (events & EVENT_WRITE)) {
+        if (tcp_get_soerror(ch->sd) != 0) {
+            _bench_fail(c, "cannot connect");
+        }
+        ch->state = CHANNEL_ESTABLISHED;
+        event_del(evb, hdl->wid(ch));
+        nconnected++;
+        return;
+    }
+
+    if (events & EVENT_READ) {
+        if (dbuf_tcp_read(c->s) == CC_ERROR || ch->state == CHANNEL_TERM ||
+                ch->state == CHANNEL_ERROR) {
+            _bench_fail(c, "connection closed by server");
+        }
+        _conn_recv(c);
+    }
+}
+
+/* closed loop: keep every connection busy up to its pipeline depth */
+static void
+_bench_fill(uint64_t now, uint64_t limit)
+{
+    struct bench_conn *c;
+    uint32_t i;
+
+    for (i = 0; i < nconn; i++) {
+        c = &conn[i];
+        while (c->nreq < pipeline && nsent < limit) {
+            _conn_send(c, now);
+        }
+    }
+}
+
+/* # requests due by now in an open loop, the first of them at t0 */
+static inline uint64_t
+_ndue(uint64_t t0, uint64_t now)
+{
+    return (uint64_t)((double)(now - t0) * rate / NSEC_PER_SEC) + 1;
+}
+
+/*
+ * open loop: send requests due by now, each on the next connection free.
+ * Returns # requests left waiting for a connection.
+ */
+static uint64_t
+_bench_issue(uint64_t t0, uint64_t now)
+{
+    static uint32_t next = 0;
+    uint64_t due = _ndue(t0, now);
+    uint32_t i;
+
+    while (nsent < due) {
+        for (i = 0; i < nconn && conn[next].nreq == pipeline; i++) {
+            next = (next + 1) % nconn;
+        }
+        if (i == nconn) { /* all busy, the rest wait and count it as latency */
+            return due - nsent;
+        }
+        _conn_send(&conn[next], t0 + nsent * NSEC_PER_SEC / rate);
+        next = (next + 1) % nconn;
+    }
+
+    return 0;
+}
+
+/*
+ * Send up to limit requests, stopping early at end (ns). Writes left over are
+ * retried on every iteration rather than waited for with an event, so reads
+ * are never held up behind them.
+ */
+static void
+_bench_run(uint64_t limit, uint64_t end)
+{
+    uint64_t t0 = _now_ns(), now, due, late, late_max = 0;
+    bool pending;
+    uint32_t i;
+    int timeout;
+
+    nsent = nrecv = 0;
+    for (now = t0; now < end && nrecv < limit; now = _now_ns()) {
+        if (rate == 0 || prefill) {
+            _bench_fill(now, limit);
+        } else {
+            late = _bench_issue(t0, now);
+            if (late > late_max) { /* backlog is a level, keep its peak */
+                late_max = late;
+                UPDATE_VAL(bench_metrics, bench_late, late_max);
+            }
+        }
+
+        for (i = 0, pending = false; i < nconn; i++) {
+            pending = _conn_flush(&conn[i]) || pending;
+        }
+
+        if (pending) {
+            timeout = 0;
+        } else if (rate > 0 && !prefill) {
+            /* event waits are in ms, spin for anything due sooner */
+            due = t0 + nsent * NSEC_PER_SEC / rate;
+            timeout = due > now ? (due - now) / NSEC_PER_MSEC : 0;
+        } else {
+            timeout = BENCH_WAIT_MS;
+        }
+        if (event_wait(evb, timeout) < 0) {
+            log_stderr("event wait failed");
+            exit(EX_OSERR);
+        }
+    }
+}
+
+static void
+_bench_connect(void)
+{
+    struct bench_conn *c;
+    uint64_t end;
+    uint32_t i;
+
+    for (i = 0; i < nconn; i++) {
+        c = &conn[i];
+        c->s = buf_sock_create();
+        c->req = cc_alloc(pipeline * sizeof(struct bench_req));
+        if (c->s == NULL || c->req == NULL) {
+            log_stderr("cannot allocate connection %"PRIu32, i);
+            exit(EX_OSERR);
+        }
+        c->s->hdl = hdl;
+        if (!hdl->open(bench_ai, c->s->ch)) {
+            log_stderr("cannot connect to %s:%s",
+                    option_str(&setting.bench.bench_host),
+                    option_str(&setting.bench.bench_port));
+            exit(EX_UNAVAILABLE);
+        }
+        if (c->s->ch->state == CHANNEL_ESTABLISHED) {
+            nconnected++;
+        } else {
+            event_add_write(evb, hdl->wid(c->s->ch), c);
+        }
+    }
+
+    end = _now_ns() + CONNECT_WAIT_MS * NSEC_PER_SEC / 1000;
+    while (nconnected < nconn && _now_ns() < end) {
+        event_wait(evb, BENCH_WAIT_MS);
+    }
+    if (nconnected < nconn) {
+        log_stderr("timed out connecting to %s:%s",
+                option_str(&setting.bench.bench_host),
+                option_str(&setting.bench.bench_port));
+        exit(EX_UNAVAILABLE);
+    }
+
+    for (i = 0; i < nconn; i++) {
+        event_add_read(evb, hdl->rid(conn[i].s->ch), &conn[i]);
+    }
+}
+
+static void
+_report_lat(const char *name, struct metric *m)
+{
+    static const double p[] = { 50.0, 90.0, 99.0, 99.9, 99.99, 100.0 };
+    char line[128];
+    size_t len;
+    unsigned int i;
+
+    if (metric_histo_count(m) == 0) {
+        return;
+    }
+
+    len = cc_scnprintf(line, sizeof(line), "%-8s%12"PRIu64, name,
+            metric_histo_count(m));
+    for (i = 0; i < sizeof(p) / sizeof(p[0]); i++) {
+        len += cc_scnprintf(line + len, sizeof(line) - len, "%10.1f",
+                (double)metric_histo_percentile(m, p[i]) / NSEC_PER_USEC);
+    }
+    log_stdout("%s", line);
+}
+
+static void
+_report(double sec)
+{
+    bench_metrics_st *m = bench_metrics;
+    uint64_t nreq = metric_counter(&m->bench_request);
+    uint64_t nrsp = metric_counter(&m->bench_response);
+
+    log_stdout("duration: %.2f s, connections: %"PRIu32", pipeline: %"PRIu32,
+            sec, nconn, pipeline);
+    if (rate > 0) {
+        log_stdout("rate: %"PRIu64" req/s offered, at most %"PRId64" due but "
+                "unsent", rate, metric_gauge(&m->bench_late));
+    }
+    log_stdout("requests: %"PRIu64", responses: %"PRIu64", throughput: "
+            "%.1f req/s", nreq, nrsp, nrsp / sec);
+    log_stdout("hit: %"PRIu64", miss: %"PRIu64", error: %"PRIu64,
+            metric_counter(&m->bench_hit), metric_counter(&m->bench_miss),
+            metric_counter(&m->bench_error));
+    log_stdout("%-8s%12s%10s%10s%10s%10s%10s%10s", "latency", "count",
+            "p50(us)", "p90", "p99", "p99.9", "p99.99", "max");
+    _report_lat("all", &m->bench_lat);
+    _report_lat("get", &m->get_lat);
+    _report_lat("set", &m->set_lat);
+    _report_lat("incr", &m->incr_lat);
+}
+
+static void
+teardown(void)
+{
+    uint32_t i;
+
+    if (conn != NULL) {
+        for (i = 0; i < nconn; i++) {
+            if (conn[i].s != NULL) {
+                hdl->term(conn[i].s->ch);
+                buf_sock_destroy(&conn[i].s);
+            }
+            cc_free(conn[i].req);
+        }
+        cc_free(conn);
+        conn = NULL;
+    }
+    if (bench_ai != NULL) {
+        freeaddrinfo(bench_ai);
+        bench_ai = NULL;
+    }
+    event_base_destroy(&evb);
+    request_destroy(&req);
+    response_destroy(&rsp);
+
+    workload_teardown();
+    compose_teardown();
+    parse_teardown();
+    response_teardown();
+    request_teardown();
+
+    tcp_teardown();
+    event_teardown();
+    dbuf_teardown();
+    buf_teardown();
+    array_teardown();
+
+    debug_teardown();
+    log_teardown();
+}
+
+static void
+setup(void)
+{
+    if (atexit(teardown) != 0) {
+        log_stderr("cannot register teardown procedure with atexit()");
+        exit(EX_OSERR); /* only failure comes from NOMEM */
+    }
+
+    /* Setup logging first */
+    log_setup(&stats.log);
+    if (debug_setup(&setting.debug, &stats.debug) != CC_OK) {
+        log_stderr("debug log setup failed");
+        exit(EX_CONFIG);
+    }
+
+    /* setup top-level application options */
+    nconn = option_uint(&setting.bench.bench_nconn);
+    pipeline = option_uint(&setting.bench.bench_pipeline);
+    rate = option_uint(&setting.bench.bench_rate);
+    prefill = option_bool(&setting.bench.bench_prefill);
+    if (nconn == 0 || pipeline == 0) {
+        log_stderr("bench_nconn and bench_pipeline must be above 0");
+        exit(EX_CONFIG);
+    }
+
+    /* setup library modules */
+    array_setup(&setting.array);
+    buf_setup(&setting.buf, &stats.buf);
+    dbuf_setup(&setting.dbuf, &stats.dbuf);
+    event_setup(&stats.event);
+    tcp_setup(&setting.tcp, &stats.tcp);
+
+    /* setup pelikan modules */
+    request_setup(&setting.request, &stats.request);
+    response_setup(&setting.response, &stats.response);
+    parse_setup(NULL, &stats.parse_rsp);
+    compose_setup(&stats.compose_req, NULL);
+    workload_setup(&setting.workload);
+
+    hdl->open = (channel_open_fn)tcp_connect;
+    hdl->term = (channel_term_fn)tcp_close;
+    hdl->recv = (channel_recv_fn)tcp_recv;
+    hdl->send = (channel_send_fn)tcp_send;
+    hdl->rid = (channel_id_fn)tcp_read_id;
+    hdl->wid = (channel_id_fn)tcp_write_id;
+
+    if (getaddr(&bench_ai, option_str(&setting.bench.bench_host),
+                option_str(&setting.bench.bench_port)) != CC_OK) {
+        log_stderr("cannot resolve address for bench host & port");
+        exit(EX_CONFIG);
+    }
+
+    evb = event_base_create(BENCH_NEVENT, _bench_event);
+    req = request_create();
+    rsp = response_create();
+    conn = cc_zalloc(nconn * sizeof(struct bench_conn));
+    if (evb == NULL || req == NULL || rsp == NULL || conn == NULL) {
+        log_stderr("cannot set up bench, OOM");
+        exit(EX_OSERR);
+    }
+}
+
+int
+main(int argc, char **argv)
+{
+    rstatus_i status = CC_OK;
+    FILE *fp = NULL;
+    uint64_t t0;
+
+    if (argc > 2) {
+        show_usage();
+        exit(EX_USAGE);
+    }
+
+    if (argc == 2) {
+        if (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0) {
+            show_usage();
+            exit(EX_OK);
+        }
+        if (strcmp(argv[1], "-v") == 0 || strcmp(argv[1], "--version") == 0) {
+            show_version();
+            exit(EX_OK);
+        }
+        if (strcmp(argv[1], "-c") == 0 || strcmp(argv[1], "--config") == 0) {
+            option_describe_all((struct option *)&setting, nopt);
+            exit(EX_OK);
+        }
+        if (strcmp(argv[1], "-s") == 0 || strcmp(argv[1], "--stats") == 0) {
+            metric_describe_all((struct metric *)&stats, nmetric);
+            exit(EX_OK);
+        }
+        fp = fopen(argv[1], "r");
+        if (fp == NULL) {
+            log_stderr("cannot open config: incorrect path or doesn't exist");
+            exit(EX_DATAERR);
+        }
+    }
+
+    if (option_load_default((struct option *)&setting, nopt) != CC_OK) {
+        log_stderr("failed to load default option values");
+        exit(EX_CONFIG);
+    }
+
+    if (fp != NULL) {
+        log_stderr("load config from %s", argv[1]);
+        status = option_load_file(fp, (struct option *)&setting, nopt);
+        fclose(fp);
+    }
+    if (status != CC_OK) {
+        log_stderr("failed to load config");
+        exit(EX_DATAERR);
+    }
+
+    setup();
+
+    timeout_reset(&epoch);
+    timeout_add_ns(&epoch, 0);
+    _bench_connect();
+
+    if (prefill) {
+        log_stderr("setting %"PRIu64" keys", workload_nkey());
+        _bench_run(workload_nkey(), UINT64_MAX);
+        prefill = false;
+    }
+
+    log_stderr("running for %"PRIuMAX" seconds",
+            option_uint(&setting.bench.bench_duration));
+    t0 = _now_ns();
+    _bench_run(UINT64_MAX, t0 + option_uint(&setting.bench.bench_duration) *
+            NSEC_PER_SEC);
+    _report((double)(_now_ns() - t0) / NSEC_PER_SEC);
+
+    exit(EX_OK);
+}
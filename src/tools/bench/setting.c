@@ -0,0 +1,15 @@
+#include "setting.h"
+
+struct setting setting = {
+    { BENCH_OPTION(OPTION_INIT)     },
+    { WORKLOAD_OPTION(OPTION_INIT)  },
+    { REQUEST_OPTION(OPTION_INIT)   },
+    { RESPONSE_OPTION(OPTION_INIT)  },
+    { ARRAY_OPTION(OPTION_INIT)     },
+    { BUF_OPTION(OPTION_INIT)       },
+    { DBUF_OPTION(OPTION_INIT)      },
+    { DEBUG_OPTION(OPTION_INIT)     },
+    { TCP_OPTION(OPTION_INIT)       },
+};
+
+unsigned int nopt = OPTION_CARDINALITY(setting);
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "workload.h"
+
+#include <protocol/data/memcache_include.h>
+
+#include <buffer/cc_buf.h>
+#include <buffer/cc_dbuf.h>
+#include <cc_array.h>
+#include <cc_debug.h>
+#include <cc_option.h>
+#include <channel/cc_tcp.h>
+
+#define BENCH_HOST      "127.0.0.1"
+#define BENCH_PORT      "12321"
+#define BENCH_NCONN     1
+#define BENCH_PIPELINE  1
+#define BENCH_DURATION  10
+
+/* option related */
+/*          name            type                default         description */
+#define BENCH_OPTION(ACTION)                                                                    \
+    ACTION( bench_host,     OPTION_TYPE_STR,    BENCH_HOST,     "server host"                  )\
+    ACTION( bench_port,     OPTION_TYPE_STR,    BENCH_PORT,     "server port"                  )\
+    ACTION( bench_nconn,    OPTION_TYPE_UINT,   BENCH_NCONN,    "# connections"                )\
+    ACTION( bench_pipeline, OPTION_TYPE_UINT,   BENCH_PIPELINE, "max # requests per conn"      )\
+    ACTION( bench_rate,     OPTION_TYPE_UINT,   0,              "requests/sec, 0: closed loop" )\
+    ACTION( bench_duration, OPTION_TYPE_UINT,   BENCH_DURATION, "duration of the run (sec)"    )\
+    ACTION( bench_prefill,  OPTION_TYPE_BOOL,   false,          "set every key before the run" )
+
+typedef struct {
+    BENCH_OPTION(OPTION_DECLARE)
+} bench_options_st;
+
+struct setting {
+    /* top-level */
+    bench_options_st        bench;
+    /* application modules */
+    workload_options_st     workload;
+    request_options_st      request;
+    response_options_st     response;
+    /* ccommon libraries */
+    array_options_st        array;
+    buf_options_st          buf;
+    dbuf_options_st         dbuf;
+    debug_options_st        debug;
+    tcp_options_st          tcp;
+};
+
+extern struct setting setting;
+extern unsigned int nopt;
@@ -0,0 +1,17 @@
+#include "stats.h"
+
+struct stats stats = {
+    { BENCH_METRIC(METRIC_INIT)         },
+    { PARSE_RSP_METRIC(METRIC_INIT)     },
+    { COMPOSE_REQ_METRIC(METRIC_INIT)   },
+    { REQUEST_METRIC(METRIC_INIT)       },
+    { RESPONSE_METRIC(METRIC_INIT)      },
+    { BUF_METRIC(METRIC_INIT)           },
+    { DBUF_METRIC(METRIC_INIT)          },
+    { DEBUG_METRIC(METRIC_INIT)         },
+    { EVENT_METRIC(METRIC_INIT)         },
+    { LOG_METRIC(METRIC_INIT)           },
+    { TCP_METRIC(METRIC_INIT)           },
+};
+
+unsigned int nmetric = METRIC_CARDINALITY(stats);
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <protocol/data/memcache_include.h>
+
+#include <buffer/cc_buf.h>
+#include <buffer/cc_dbuf.h>
+#include <cc_debug.h>
+#include <cc_event.h>
+#include <cc_log.h>
+#include <cc_metric.h>
+#include <channel/cc_tcp.h>
+
+/* latencies are in ns, taken from when a request is due in an open loop */
+/*          name            type                description */
+#define BENCH_METRIC(ACTION)                                                    \
+    ACTION( bench_request,  METRIC_COUNTER,     "# requests sent"              )\
+    ACTION( bench_response, METRIC_COUNTER,     "# responses received"         )\
+    ACTION( bench_hit,      METRIC_COUNTER,     "# get/incr finding the key"   )\
+    ACTION( bench_miss,     METRIC_COUNTER,     "# get/incr missing the key"   )\
+    ACTION( bench_error,    METRIC_COUNTER,     "# error responses"            )\
+    ACTION( bench_late,     METRIC_GAUGE,       "max # requests due but unsent")\
+    ACTION( bench_lat,      METRIC_HISTOGRAM,   "latency of all requests"      )\
+    ACTION( get_lat,        METRIC_HISTOGRAM,   "latency of get"               )\
+    ACTION( set_lat,        METRIC_HISTOGRAM,   "latency of set"               )\
+    ACTION( incr_lat,       METRIC_HISTOGRAM,   "latency of incr"              )
+
+typedef struct {
+    BENCH_METRIC(METRIC_DECLARE)
+} bench_metrics_st;
+
+struct stats {
+    /* top-level */
+    bench_metrics_st            bench;
+    /* application modules */
+    parse_rsp_metrics_st        parse_rsp;
+    compose_req_metrics_st      compose_req;
+    request_metrics_st          request;
+    response_metrics_st         response;
+    /* ccommon libraries */
+    buf_metrics_st              buf;
+    dbuf_metrics_st             dbuf;
+    debug_metrics_st            debug;
+    event_metrics_st            event;
+    log_metrics_st              log;
+    tcp_metrics_st              tcp;
+};
+
+extern struct stats stats;
+extern unsigned int nmetric;
@@ -0,0 +1,320 @@
+#include "workload.h"
+
+#include <protocol/data/memcache_include.h>
+
+#include <cc_array.h>
+#include <cc_debug.h>
+#include <cc_mm.h>
+#include <cc_print.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sysexits.h>
+#include <time.h>
+#include <unistd.h>
+
+#define WORKLOAD_MODULE_NAME "bench::workload"
+
+#define NUMERIC_MAX 1000000000 /* numeric values are drawn from [0, 1e9) */
+
+static bool workload_init = false;
+
+static uint64_t nkey = WORKLOAD_NKEY;
+static uint32_t klen_min = WORKLOAD_KLEN;
+static uint32_t klen_max = WORKLOAD_KLEN;
+static uint32_t vlen_min = WORKLOAD_VLEN;
+static uint32_t vlen_max = WORKLOAD_VLEN;
+static bool vlen_log = false;
+static bool numeric = false;
+static uint32_t get_weight = 9;
+static uint32_t set_weight = 1;
+static uint32_t total_weight = 10;
+static uint32_t ttl = 0;
+
+static uint64_t rng;                /* xorshift64* state, never 0 */
+
+static char key_buf[MAX_KEY_LEN];
+static char *val_buf = NULL;        /* vlen_max bytes of filler */
+
+/*
+ * Zipf ranks are sampled by rejection-inversion (Hormann & Derflinger, 1996),
+ * which takes O(1) time and memory however many keys there are: a rank is
+ * drawn from the continuous integral H of h(x) = x^-alpha and kept unless it
+ * falls outside the area of the discrete distribution, which is rare.
+ */
+static double zipf_alpha = 0.0;     /* 0 draws keys uniformly */
+static double zipf_hx1;             /* H(1.5) - h(1) */
+static double zipf_hn;              /* H(nkey + 0.5) */
+static double zipf_s;               /* ranks close enough to x are kept */
+
+static inline uint64_t
+_rand(void)
+{
+    rng ^= rng >> 12;
+    rng ^= rng << 25;
+    rng ^= rng >> 27;
+
+    return rng * 0x2545f4914f6cdd1dULL;
+}
+
+/* uniform in [0, 1) */
+static inline double
+_rand_double(void)
+{
+    return (_rand() >> 11) * (1.0 / (1ULL << 53));
+}
+
+/* log1p(x) / x, accurate near 0 */
+static inline double
+_helper1(double x)
+{
+    if (fabs(x) > 1e-8) {
+        return log1p(x) / x;
+    }
+
+    return 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+}
+
+/* expm1(x) / x, accurate near 0 */
+static inline double
+_helper2(double x)
+{
+    if (fabs(x) > 1e-8) {
+        return expm1(x) / x;
+    }
+
+    return 1.0 + x * 0.5 * (1.0 + x / 3.0 * (1.0 + 0.25 * x));
+}
+
+static inline double
+_zipf_h(double x)
+{
+    return exp(-zipf_alpha * log(x));
+}
+
+static inline double
+_zipf_hint(double x)
+{
+    double lx = log(x);
+
+    return _helper2((1.0 - zipf_alpha) * lx) * lx;
+}
+
+static inline double
+_zipf_hint_inv(double x)
+{
+    double t = x * (1.0 - zipf_alpha);
+
+    if (t < -1.0) {
+        t = -1.0;
+    }
+
+    return exp(_helper1(t) * x);
+}
+
+/* key id of the given popularity, 0 being the hottest */
+static uint64_t
+_key_id(void)
+{
+    double u, x;
+    uint64_t k;
+
+    if (zipf_alpha == 0.0) {
+        return _rand() % nkey;
+    }
+
+    for (;;) {
+        u = zipf_hn + _rand_double() * (zipf_hx1 - zipf_hn);
+        x = _zipf_hint_inv(u);
+        k = (uint64_t)(x + 0.5);
+        if (k < 1) {
+            k = 1;
+        } else if (k > nkey) {
+            k = nkey;
+        }
+        if (k - x <= zipf_s || u >= _zipf_hint(k + 0.5) - _zipf_h(k)) {
+            return k - 1;
+        }
+    }
+}
+
+/* key of id, zero-padded to a size fixed by a hash of id */
+static void
+_key(struct request *req, uint64_t id)
+{
+    struct bstring *key;
+    uint64_t h = id;
+    uint32_t len, i;
+
+    /* splitmix64 finalizer, so sizes are not correlated with popularity */
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    len = klen_min + h % (klen_max - klen_min + 1);
+
+    cc_memset(key_buf, '0', len);
+    for (i = len; id > 0; id /= 10) {
+        key_buf[--i] = '0' + id % 10;
+    }
+
+    key = array_push(req->keys);
+    key->data = key_buf;
+    key->len = len;
+}
+
+static void
+_val(struct request *req)
+{
+    uint32_t len;
+
+    if (numeric) {
+        req->vstr.data = val_buf;
+        req->vstr.len = cc_scnprintf(val_buf, CC_UINT64_MAXLEN, "%"PRIu64,
+                _rand() % NUMERIC_MAX);
+        return;
+    }
+
+    if (vlen_log) { /* the same # values for each order of magnitude */
+        len = (uint32_t)exp(log(vlen_min) + _rand_double() *
+                (log(vlen_max + 1.0) - log(vlen_min)));
+        len = len > vlen_max ? vlen_max : len;
+    } else {
+        len = vlen_min + _rand() % (vlen_max - vlen_min + 1);
+    }
+
+    req->vstr.data = val_buf;
+    req->vstr.len = len;
+}
+
+void
+workload_setup(workload_options_st *options)
+{
+    uint64_t seed = 0, n, weight;
+    uint32_t ndigit, incr_weight = 0;
+    char *dist = WORKLOAD_VSIZE_UNIFORM;
+
+    log_info("set up the %s module", WORKLOAD_MODULE_NAME);
+
+    if (workload_init) {
+        log_warn("%s has already been setup, overwrite", WORKLOAD_MODULE_NAME);
+        workload_teardown();
+    }
+
+    if (options != NULL) {
+        nkey = option_uint(&options->key_count);
+        zipf_alpha = option_fpn(&options->key_alpha);
+        klen_min = option_uint(&options->key_size_min);
+        klen_max = option_uint(&options->key_size_max);
+        vlen_min = option_uint(&options->val_size_min);
+        vlen_max = option_uint(&options->val_size_max);
+        dist = option_str(&options->val_size_dist);
+        numeric = option_bool(&options->val_numeric);
+        get_weight = option_uint(&options->get_weight);
+        set_weight = option_uint(&options->set_weight);
+        incr_weight = option_uint(&options->incr_weight);
+        ttl = option_uint(&options->key_ttl);
+        seed = option_uint(&options->seed);
+    }
+
+    for (ndigit = 1, n = nkey - 1; n >= 10; n /= 10, ndigit++);
+    weight = (uint64_t)get_weight + set_weight + incr_weight;
+
+    if (nkey == 0 || zipf_alpha < 0.0) {
+        log_crit("key_count must be above 0, key_alpha not negative");
+        exit(EX_CONFIG);
+    }
+    if (klen_min < ndigit || klen_min > klen_max || klen_max > MAX_KEY_LEN) {
+        log_crit("key sizes must be within [%"PRIu32", %d] for %"PRIu64" keys",
+                ndigit, MAX_KEY_LEN, nkey);
+        exit(EX_CONFIG);
+    }
+    if (strcmp(dist, WORKLOAD_VSIZE_LOG) == 0) {
+        vlen_log = true;
+    } else if (strcmp(dist, WORKLOAD_VSIZE_UNIFORM) != 0) {
+        log_crit("val_size_dist must be %s or %s", WORKLOAD_VSIZE_UNIFORM,
+                WORKLOAD_VSIZE_LOG);
+        exit(EX_CONFIG);
+    }
+    if (vlen_min > vlen_max || (vlen_log && vlen_min == 0)) {
+        log_crit("value sizes must be ordered, and above 0 if %s",
+                WORKLOAD_VSIZE_LOG);
+        exit(EX_CONFIG);
+    }
+    if (weight == 0 || weight > UINT32_MAX) {
+        log_crit("operation weights must add up to within (0, %"PRIu32"]",
+                UINT32_MAX);
+        exit(EX_CONFIG);
+    }
+    total_weight = (uint32_t)weight;
+
+    val_buf = cc_alloc(vlen_max > CC_UINT64_MAXLEN ? vlen_max :
+            CC_UINT64_MAXLEN);
+    if (val_buf == NULL) {
+        log_crit("cannot allocate values of %"PRIu32" bytes", vlen_max);
+        exit(EX_CONFIG);
+    }
+    cc_memset(val_buf, 'x', vlen_max);
+
+    if (seed == 0) {
+        seed = (uint64_t)time(NULL) ^ ((uint64_t)getpid() << 32);
+    }
+    rng = seed | 1;
+
+    if (zipf_alpha > 0.0) {
+        zipf_hx1 = _zipf_hint(1.5) - 1.0;
+        zipf_hn = _zipf_hint(nkey + 0.5);
+        zipf_s = 2.0 - _zipf_hint_inv(_zipf_hint(2.5) - _zipf_h(2.0));
+    }
+
+    workload_init = true;
+}
+
+void
+workload_teardown(void)
+{
+    log_info("tear down the %s module", WORKLOAD_MODULE_NAME);
+
+    if (!workload_init) {
+        log_warn("%s has never been setup", WORKLOAD_MODULE_NAME);
+    }
+
+    cc_free(val_buf);
+    val_buf = NULL;
+
+    workload_init = false;
+}
+
+uint64_t
+workload_nkey(void)
+{
+    return nkey;
+}
+
+void
+workload_next(struct request *req)
+{
+    uint32_t w = _rand() % total_weight;
+
+    _key(req, _key_id());
+
+    if (w < get_weight) {
+        req->type = REQ_GET;
+    } else if (w < get_weight + set_weight) {
+        req->type = REQ_SET;
+        req->expiry = ttl;
+        _val(req);
+    } else {
+        req->type = REQ_INCR;
+        req->delta = 1;
+    }
+}
+
+void
+workload_set(struct request *req, uint64_t id)
+{
+    _key(req, id);
+    req->type = REQ_SET;
+    req->expiry = ttl;
+    _val(req);
+}
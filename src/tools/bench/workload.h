@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cc_option.h>
+
+#include <stdint.h>
+
+/*
+ * A workload draws requests at random: the operation by weight, the key by
+ * popularity rank, zipfian with exponent key_alpha (uniform if 0), and the
+ * value size from val_size_dist. Each key has a size of its own, fixed by its
+ * id, so a key looks the same every time it is drawn. Values are decimal
+ * integers if val_numeric is set, which takes the integer path of servers
+ * that have one (e.g. slimcache) and is needed for incr to succeed.
+ */
+
+#define WORKLOAD_NKEY           1000000
+#define WORKLOAD_KLEN           16
+#define WORKLOAD_VLEN           64
+#define WORKLOAD_VSIZE_UNIFORM  "uniform"
+#define WORKLOAD_VSIZE_LOG      "loguniform"
+
+/*          name            type                default                 description */
+#define WORKLOAD_OPTION(ACTION)                                                                         \
+    ACTION( key_count,      OPTION_TYPE_UINT,   WORKLOAD_NKEY,          "# distinct keys"              )\
+    ACTION( key_alpha,      OPTION_TYPE_FPN,    0.0,                    "zipf exponent, 0 for uniform" )\
+    ACTION( key_size_min,   OPTION_TYPE_UINT,   WORKLOAD_KLEN,          "min key size"                 )\
+    ACTION( key_size_max,   OPTION_TYPE_UINT,   WORKLOAD_KLEN,          "max key size"                 )\
+    ACTION( val_size_min,   OPTION_TYPE_UINT,   WORKLOAD_VLEN,          "min value size"               )\
+    ACTION( val_size_max,   OPTION_TYPE_UINT,   WORKLOAD_VLEN,          "max value size"               )\
+    ACTION( val_size_dist,  OPTION_TYPE_STR,    WORKLOAD_VSIZE_UNIFORM, "uniform or loguniform"        )\
+    ACTION( val_numeric,    OPTION_TYPE_BOOL,   false,                  "values are decimal integers"  )\
+    ACTION( get_weight,     OPTION_TYPE_UINT,   9,                      "relative frequency of get"    )\
+    ACTION( set_weight,     OPTION_TYPE_UINT,   1,                      "relative frequency of set"    )\
+    ACTION( incr_weight,    OPTION_TYPE_UINT,   0,                      "relative frequency of incr"   )\
+    ACTION( key_ttl,        OPTION_TYPE_UINT,   0,                      "ttl of keys set (sec)"        )\
+    ACTION( seed,           OPTION_TYPE_UINT,   0,                      "random seed, 0 picks one"     )
+
+typedef struct {
+    WORKLOAD_OPTION(OPTION_DECLARE)
+} workload_options_st;
+
+struct request;
+
+void workload_setup(workload_options_st *options);
+void workload_teardown(void);
+
+uint64_t workload_nkey(void);
+
+/* fill a freshly reset req with the next request drawn */
+void workload_next(struct request *req);
+/* fill a freshly reset req with a set of key id, e.g. to populate the cache */
+void workload_set(struct request *req, uint64_t id);
@@ -0,0 +1,105 @@
+#include <protocol/data/memcache_include.h>
+
+#include <cc_debug.h>
+#include <cc_define.h>
+#include <cc_log.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <sysexits.h>
+
+#define LINE_MAX_LEN KiB
+
+static void
+show_usage(void)
+{
+    log_stdout(
+            "Usage:" CRLF
+            "  pelikan_klog_decode [file]" CRLF
+            );
+    log_stdout(
+            "Description:" CRLF
+            "  pelikan_klog_decode reads a command log written with " CRLF
+            "  klog_binary enabled, from file or stdin, and prints it in " CRLF
+            "  the same text format as when klog_binary is disabled." CRLF
+            );
+    log_stdout(
+            "Command-line options:" CRLF
+            "  -h, --help        show this message" CRLF
+            );
+}
+
+/* returns EX_OK at the end of input, EX_DATAERR on a malformed record */
+static int
+decode(FILE *fp)
+{
+    struct klog_rec rec;
+    char key[UINT8_MAX + 1];
+    char line[LINE_MAX_LEN];
+    size_t nrec = 0, n;
+    int len;
+
+    /* a partial record at the end of input is reported, not skipped */
+    while ((n = fread(&rec, 1, sizeof(rec), fp)) > 0) {
+        if (n < sizeof(rec)) {
+            log_stderr("record %zu is truncated", nrec);
+            return EX_DATAERR;
+        }
+        if (rec.magic != KLOG_REC_MAGIC || rec.op >= REQ_SENTINEL ||
+                rec.status >= RSP_SENTINEL) {
+            log_stderr("record %zu is malformed, not a binary klog?", nrec);
+            return EX_DATAERR;
+        }
+        if (fread(key, 1, rec.klen, fp) != rec.klen) {
+            log_stderr("record %zu is truncated", nrec);
+            return EX_DATAERR;
+        }
+
+        len = klog_fmt_rec(line, LINE_MAX_LEN, &rec, key);
+        if (len == 0) {
+            log_stderr("record %zu cannot be rendered", nrec);
+            return EX_DATAERR;
+        }
+        fwrite(line, 1, len, stdout);
+        nrec++;
+    }
+
+    if (ferror(fp)) {
+        log_stderr("record %zu cannot be read", nrec);
+        return EX_DATAERR;
+    }
+
+    return EX_OK;
+}
+
+int
+main(int argc, char **argv)
+{
+    FILE *fp = stdin;
+    int status;
+
+    if (argc > 2) {
+        show_usage();
+        exit(EX_USAGE);
+    }
+
+    if (argc == 2) {
+        if (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0) {
+            show_usage();
+            exit(EX_OK);
+        }
+        fp = fopen(argv[1], "r");
+        if (fp == NULL) {
+            log_stderr("cannot open klog: incorrect path or doesn't exist");
+            exit(EX_NOINPUT);
+        }
+    }
+
+    status = decode(fp);
+
+    if (fp != stdin) {
+        fclose(fp);
+    }
+
+    exit(status);
+}
@@ -0,0 +1,360 @@
+#include <core/core.h>
+#include <core/data/shared.h>
+#include <protocol/data/memcache_include.h>
+#include <server/twemcache/data/process.h>
+#include <storage/slab/slab.h>
+#include <time/time.h>
+
+#include <buffer/cc_buf.h>
+#include <buffer/cc_dbuf.h>
+#include <cc_event.h>
+#include <channel/cc_tcp.h>
+#include <stream/cc_sockio.h>
+
+#include <check.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+/* define for each suite, local scope due to macro visibility rule */
+#define SUITE_NAME "core"
+#define DEBUG_LOG  SUITE_NAME ".log"
+
+#define VLEN        1024
+#define SET         "set k 0 0 1024\r\n"
+#define GET         "get k\r\n"
+#define VALUE       "VALUE k 0 1024\r\n"
+#define END         "\r\nEND\r\n"
+#define GET_LEN     (sizeof(GET) - 1)
+#define RSP_LEN     (sizeof(VALUE) - 1 + VLEN + sizeof(END) - 1)
+#define WBUF_HWM    (64 * KiB)
+#define NGET        100000  /* requests take more than socket buffers hold */
+#define CHUNK       (64 * KiB)
+#define NSET        4000    /* small requests, far more than fit in rbuf */
+#define SET_VLEN    100
+#define BIG_VLEN    (200 * KiB) /* a request that spans many pool bufs */
+
+server_options_st soptions = { SERVER_OPTION(OPTION_INIT) };
+worker_options_st woptions = { WORKER_OPTION(OPTION_INIT) };
+server_metrics_st smetrics = { CORE_SERVER_METRIC(METRIC_INIT) };
+worker_metrics_st wmetrics = { CORE_WORKER_METRIC(METRIC_INIT) };
+process_metrics_st pmetrics = { PROCESS_METRIC(METRIC_INIT) };
+dbuf_metrics_st dmetrics = { DBUF_METRIC(METRIC_INIT) };
+
+struct post_processor worker_processor = {
+    twemcache_process_read,
+    twemcache_process_write
+};
+
+static char rsp[RSP_LEN];
+
+/*
+ * utilities
+ */
+
+/* start a worker accepting on its own listener, returns the port it is on */
+static in_port_t
+worker_start(void)
+{
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    pthread_t worker;
+
+    buf_setup(NULL, NULL);
+    dbuf_setup(NULL, &dmetrics);
+    event_setup(NULL);
+    sockio_setup(NULL);
+    tcp_setup(NULL, NULL);
+    time_setup();
+    slab_setup(NULL, NULL);
+    request_setup(NULL, NULL);
+    response_setup(NULL, NULL);
+    process_setup(NULL, &pmetrics);
+
+    option_load_default((struct option *)&soptions,
+            OPTION_CARDINALITY(soptions));
+    soptions.server_host.val.vstr = "127.0.0.1";
+    soptions.server_port.val.vstr = "0";
+    soptions.server_reuseport.val.vbool = true;
+    option_load_default((struct option *)&woptions,
+            OPTION_CARDINALITY(woptions));
+    woptions.worker_wbuf_hwm.val.vuint = WBUF_HWM;
+
+    core_server_setup(&soptions, &smetrics);
+    core_worker_setup(&woptions, &wmetrics);
+    ck_assert_int_eq(getsockname(worker_listener->ch->sd,
+                (struct sockaddr *)&addr, &len), 0);
+
+    ck_assert_int_eq(pthread_create(&worker, NULL, core_worker_evloop,
+                &worker_processor), 0);
+    pthread_detach(worker);
+
+    return addr.sin_port;
+}
+
+/* a client with socket buffers of bufsize bytes each way */
+static int
+client_connect(in_port_t port, int bufsize)
+{
+    struct sockaddr_in addr;
+    struct timeval tv = {5, 0};
+    int sd;
+
+    sd = socket(AF_INET, SOCK_STREAM, 0);
+    ck_assert_int_ge(sd, 0);
+    ck_assert_int_eq(setsockopt(sd, SOL_SOCKET, SO_RCVBUF, &bufsize,
+                sizeof(bufsize)), 0);
+    ck_assert_int_eq(setsockopt(sd, SOL_SOCKET, SO_SNDBUF, &bufsize,
+                sizeof(bufsize)), 0);
+    ck_assert_int_eq(setsockopt(sd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)),
+            0);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = port;
+    ck_assert_int_eq(connect(sd, (struct sockaddr *)&addr, sizeof(addr)), 0);
+
+    return sd;
+}
+
+/* send as much of buf as the socket takes right now, returns how much */
+static size_t
+client_send(int sd, const char *buf, size_t len)
+{
+    ssize_t n;
+
+    n = send(sd, buf, len < CHUNK ? len : CHUNK, MSG_DONTWAIT);
+
+    return n > 0 ? (size_t)n : 0;
+}
+
+/* the reply expected for each get */
+static void
+rsp_init(void)
+{
+    memcpy(rsp, VALUE, sizeof(VALUE) - 1);
+    memset(rsp + sizeof(VALUE) - 1, 'v', VLEN);
+    memcpy(rsp + sizeof(VALUE) - 1 + VLEN, END, sizeof(END) - 1);
+}
+
+/* store the value of k that every get asks for */
+static void
+client_set(int sd)
+{
+    char val[VLEN + 2], buf[sizeof("STORED\r\n")];
+
+    memset(val, 'v', VLEN);
+    memcpy(val + VLEN, CRLF, 2);
+    ck_assert_int_eq(send(sd, SET, sizeof(SET) - 1, 0), sizeof(SET) - 1);
+    ck_assert_int_eq(send(sd, val, sizeof(val), 0), sizeof(val));
+    ck_assert_int_eq(recv(sd, buf, sizeof(buf), 0), sizeof(buf) - 1);
+    ck_assert_int_eq(memcmp(buf, "STORED\r\n", sizeof(buf) - 1), 0);
+}
+
+/* wait up to a second for the # connections throttled to become n */
+static void
+wait_throttle_curr(int64_t n)
+{
+    int i;
+
+    for (i = 0; i < 1000 && metric_gauge(&wmetrics.worker_throttle_curr) != n;
+            i++) {
+        usleep(1000);
+    }
+    ck_assert_int_eq(metric_gauge(&wmetrics.worker_throttle_curr), n);
+}
+
+/**************
+ * test cases *
+ **************/
+
+/*
+ * a client pipelines gets of a value far larger than the request, more than
+ * fit in any buffer, and reads the replies only once it cannot send any more,
+ * slowly: the connection is throttled, yet every request is answered, in
+ * order, and it stays open
+ */
+START_TEST(test_throttle)
+{
+    size_t total = NGET * GET_LEN, sent = 0, recvd = 0, i, stall;
+    char *req, buf[CHUNK];
+    ssize_t n;
+    int sd;
+
+    rsp_init();
+    sd = client_connect(worker_start(), 4 * KiB);
+    client_set(sd);
+
+    req = malloc(total);
+    ck_assert_ptr_ne(req, NULL);
+    for (i = 0; i < NGET; i++) {
+        memcpy(req + i * GET_LEN, GET, GET_LEN);
+    }
+
+    /* send without reading until the server stops taking requests */
+    for (stall = 0; stall < 100 && sent < total; ) {
+        n = client_send(sd, req + sent, total - sent);
+        sent += n;
+        if (n == 0) {
+            stall++;
+            usleep(1000);
+        } else {
+            stall = 0;
+        }
+    }
+    ck_assert_uint_lt(sent, total);
+    wait_throttle_curr(1);
+
+    /* then read as the small receive buffer lets it, topping up requests */
+    while (recvd < NGET * RSP_LEN) {
+        sent += client_send(sd, req + sent, total - sent);
+        n = recv(sd, buf, sizeof(buf), 0);
+        ck_assert_int_gt(n, 0);
+        for (i = 0; i < (size_t)n; i++) {
+            ck_assert_int_eq(buf[i], rsp[(recvd + i) % RSP_LEN]);
+        }
+        recvd += n;
+    }
+    ck_assert_uint_eq(sent, total);
+    ck_assert_uint_eq(metric_counter(&pmetrics.get_key_hit), NGET);
+    ck_assert_uint_ge(metric_counter(&wmetrics.worker_throttle), 1);
+    wait_throttle_curr(0);
+
+    /* still served as usual */
+    ck_assert_int_eq(send(sd, GET, GET_LEN, 0), GET_LEN);
+    for (recvd = 0; recvd < RSP_LEN; recvd += n) {
+        n = recv(sd, buf + recvd, RSP_LEN - recvd, 0);
+        ck_assert_int_gt(n, 0);
+    }
+    ck_assert_int_eq(memcmp(buf, rsp, RSP_LEN), 0);
+
+    close(sd);
+    free(req);
+}
+END_TEST
+
+/* send all of len bytes, blocking */
+static void
+client_send_all(int sd, const char *buf, size_t len)
+{
+    ssize_t n;
+
+    for (; len > 0; buf += n, len -= n) {
+        n = send(sd, buf, len, 0);
+        ck_assert_int_gt(n, 0);
+    }
+}
+
+/* receive exactly len bytes, blocking */
+static void
+client_recv_all(int sd, char *buf, size_t len)
+{
+    ssize_t n;
+
+    for (; len > 0; buf += n, len -= n) {
+        n = recv(sd, buf, len, 0);
+        ck_assert_int_gt(n, 0);
+    }
+}
+
+/*
+ * a burst of pipelined requests larger than rbuf is read past it into pool
+ * bufs, and parsed from there without rbuf ever growing, while a request
+ * larger than a pool buf is still put together in rbuf
+ */
+START_TEST(test_rchain)
+{
+    size_t len = 0, i;
+    char *req, *reply, hdr[64];
+    int sd, n;
+
+    sd = client_connect(worker_start(), MiB);
+
+    req = malloc(NSET * (SET_VLEN + 64) + BIG_VLEN);
+    ck_assert_ptr_ne(req, NULL);
+    reply = malloc(CHUNK);
+    ck_assert_ptr_ne(reply, NULL);
+    for (i = 0; i < NSET; i++) {
+        len += sprintf(req + len, "set k%05zu 0 0 %d noreply\r\n", i,
+                SET_VLEN);
+        memset(req + len, 'a' + i % 26, SET_VLEN);
+        len += SET_VLEN;
+        len += sprintf(req + len, "\r\n");
+    }
+    /* the last value, once all before it are in */
+    len += sprintf(req + len, "get k%05d\r\n", NSET - 1);
+    client_send_all(sd, req, len);
+
+    n = sprintf(hdr, "VALUE k%05d 0 %d\r\n", NSET - 1, SET_VLEN);
+    client_recv_all(sd, reply, n + SET_VLEN + sizeof(END) - 1);
+    ck_assert_int_eq(memcmp(reply, hdr, n), 0);
+    for (i = 0; i < SET_VLEN; i++) {
+        ck_assert_int_eq(reply[n + i], 'a' + (NSET - 1) % 26);
+    }
+    ck_assert_uint_eq(metric_counter(&pmetrics.set_stored), NSET);
+    ck_assert_uint_eq(metric_counter(&dmetrics.dbuf_double), 0);
+    ck_assert_uint_eq(metric_counter(&dmetrics.dbuf_fit), 0);
+
+    /* a value that cannot be parsed from any one pool buf */
+    len = sprintf(req, "set big 0 0 %d\r\n", BIG_VLEN);
+    for (i = 0; i < BIG_VLEN; i++) {
+        req[len + i] = 'a' + i % 26;
+    }
+    len += BIG_VLEN;
+    len += sprintf(req + len, "\r\n");
+    client_send_all(sd, req, len);
+    client_recv_all(sd, reply, sizeof("STORED\r\n") - 1);
+    ck_assert_int_eq(memcmp(reply, "STORED\r\n", sizeof("STORED\r\n") - 1), 0);
+    ck_assert_uint_eq(metric_counter(&pmetrics.set_stored), NSET + 1);
+
+    client_send_all(sd, "get big\r\n", sizeof("get big\r\n") - 1);
+    n = sprintf(hdr, "VALUE big 0 %d\r\n", BIG_VLEN);
+    client_recv_all(sd, req, n + BIG_VLEN + sizeof(END) - 1);
+    ck_assert_int_eq(memcmp(req, hdr, n), 0);
+    for (i = 0; i < BIG_VLEN; i++) {
+        ck_assert_int_eq(req[n + i], 'a' + i % 26);
+    }
+
+    close(sd);
+    free(reply);
+    free(req);
+}
+END_TEST
+
+/*
+ * test suite
+ */
+static Suite *
+core_suite(void)
+{
+    Suite *s = suite_create(SUITE_NAME);
+
+    TCase *tc_worker = tcase_create("worker");
+    suite_add_tcase(s, tc_worker);
+
+    tcase_add_test(tc_worker, test_throttle);
+    tcase_add_test(tc_worker, test_rchain);
+
+    return s;
+}
+
+int
+main(void)
+{
+    int nfail;
+
+    Suite *suite = core_suite();
+    SRunner *srunner = srunner_create(suite);
+    srunner_set_log(srunner, DEBUG_LOG);
+    srunner_run_all(srunner, CK_ENV); /* set CK_VEBOSITY in ENV to customize */
+    nfail = srunner_ntests_failed(srunner);
+    srunner_free(srunner);
+
+    return (nfail == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,281 @@
+#include <hotkey/hotkey.h>
+
+#include <cc_bstring.h>
+
+#include <check.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+/* define for each suite, local scope due to macro visibility rule */
+#define SUITE_NAME "hotkey"
+#define DEBUG_LOG  SUITE_NAME ".log"
+
+#define PRINT_FMT "%.*s %"PRIu64" %"PRIu64"\n"
+#define BUF_LEN 4096
+
+hotkey_options_st options = { HOTKEY_OPTION(OPTION_INIT) };
+hotkey_metrics_st metrics = { HOTKEY_METRIC(METRIC_INIT) };
+
+/*
+ * utilities
+ */
+static void
+test_setup(uint32_t nkey, uint32_t sample)
+{
+    option_load_default((struct option *)&options, OPTION_CARDINALITY(options));
+    options.hotkey_enable.val.vbool = true;
+    options.hotkey_nkey.val.vuint = nkey;
+    options.hotkey_sample.val.vuint = sample;
+    metric_reset((struct metric *)&metrics, METRIC_CARDINALITY(metrics));
+
+    hotkey_setup(&options, &metrics);
+}
+
+static void
+test_teardown(void)
+{
+    hotkey_teardown();
+}
+
+static void
+test_reset(uint32_t nkey, uint32_t sample)
+{
+    test_teardown();
+    test_setup(nkey, sample);
+}
+
+static void
+count_key(const char *key, uint32_t n)
+{
+    struct bstring k = {strlen(key), (char *)key};
+
+    for (; n > 0; n--) {
+        hotkey_count(&k);
+    }
+}
+
+/**************
+ * test cases *
+ **************/
+
+START_TEST(test_disabled)
+{
+    char buf[BUF_LEN];
+
+    test_teardown();
+    option_load_default((struct option *)&options, OPTION_CARDINALITY(options));
+    hotkey_setup(&options, &metrics);
+
+    ck_assert(!hotkey_enabled);
+    ck_assert_int_eq(hotkey_nslot(), 0);
+    count_key("foo", 1);
+    ck_assert_int_eq(hotkey_print(buf, BUF_LEN, PRINT_FMT, UINT32_MAX), 0);
+}
+END_TEST
+
+START_TEST(test_order)
+{
+    char buf[BUF_LEN];
+    size_t len;
+
+    test_reset(4, 1);
+
+    count_key("b", 2);
+    count_key("c", 1);
+    count_key("a", 3);
+
+    len = hotkey_print(buf, BUF_LEN, PRINT_FMT, UINT32_MAX);
+    ck_assert_int_eq(len, strlen(buf));
+    ck_assert_str_eq(buf, "a 3 0\nb 2 0\nc 1 0\n");
+
+    len = hotkey_print(buf, BUF_LEN, PRINT_FMT, 1);
+    ck_assert_str_eq(buf, "a 3 0\n");
+
+    hotkey_reset();
+    ck_assert_int_eq(hotkey_print(buf, BUF_LEN, PRINT_FMT, UINT32_MAX), 0);
+}
+END_TEST
+
+START_TEST(test_replace)
+{
+    char buf[BUF_LEN];
+
+    test_reset(2, 1);
+
+    count_key("a", 5);
+    count_key("b", 2);
+    /* c takes over the counter of b, inheriting its count as error */
+    count_key("c", 1);
+    ck_assert_int_eq(metrics.hotkey_replace.counter, 1);
+
+    hotkey_print(buf, BUF_LEN, PRINT_FMT, UINT32_MAX);
+    ck_assert_str_eq(buf, "a 5 0\nc 3 2\n");
+}
+END_TEST
+
+START_TEST(test_heavy_hitter)
+{
+#define NKEY 8
+#define NCOLD 1000
+    char buf[BUF_LEN], key[32];
+    uint32_t i;
+
+    test_reset(NKEY, 1);
+
+    /* a key with more than 1/NKEY of all accesses is always found on top */
+    for (i = 0; i < NCOLD; i++) {
+        snprintf(key, sizeof(key), "cold%u", i);
+        count_key(key, 1);
+        count_key("hot", 1);
+    }
+
+    hotkey_print(buf, BUF_LEN, PRINT_FMT, 1);
+    ck_assert_int_eq(strncmp(buf, "hot ", 4), 0);
+    ck_assert_int_eq(metrics.hotkey_count.counter, 2 * NCOLD);
+#undef NKEY
+#undef NCOLD
+}
+END_TEST
+
+START_TEST(test_sample)
+{
+#define NACCESS 100000
+    char buf[BUF_LEN];
+    uint64_t count, error;
+
+    test_reset(4, 10);
+
+    /* one out of 10 on average, the intervals are random */
+    count_key("a", NACCESS);
+    ck_assert_uint_ge(metrics.hotkey_count.counter, NACCESS / 10 * 95 / 100);
+    ck_assert_uint_le(metrics.hotkey_count.counter, NACCESS / 10 * 105 / 100);
+
+    /* counts are scaled back up by the sample ratio */
+    hotkey_print(buf, BUF_LEN, PRINT_FMT, UINT32_MAX);
+    ck_assert_int_eq(sscanf(buf, "a %"SCNu64" %"SCNu64, &count, &error), 2);
+    ck_assert_uint_eq(count, metrics.hotkey_count.counter * 10);
+    ck_assert_uint_eq(error, 0);
+#undef NACCESS
+}
+END_TEST
+
+START_TEST(test_sample_alias)
+{
+#define NROUND 10000
+    char buf[BUF_LEN], *p;
+    uint64_t count;
+    uint32_t i;
+
+    test_reset(4, 2);
+
+    /* keys cycled with the sample ratio as period are all counted */
+    for (i = 0; i < NROUND; i++) {
+        count_key("a", 1);
+        count_key("b", 1);
+    }
+
+    hotkey_print(buf, BUF_LEN, PRINT_FMT, UINT32_MAX);
+    for (p = buf; *p != '\0'; p = strchr(p, '\n') + 1) {
+        ck_assert_int_eq(sscanf(p, "%*s %"SCNu64, &count), 1);
+        ck_assert_uint_ge(count, NROUND * 9 / 10);
+        ck_assert_uint_le(count, NROUND * 11 / 10);
+    }
+    ck_assert_int_eq(p - buf, strlen(buf));
+    ck_assert_ptr_ne(strstr(buf, "a "), NULL);
+    ck_assert_ptr_ne(strstr(buf, "b "), NULL);
+#undef NROUND
+}
+END_TEST
+
+START_TEST(test_index)
+{
+#define NKEY 32
+#define NCOLD 5000
+    char buf[BUF_LEN], key[32], *p;
+    uint64_t nreplace;
+    uint32_t i;
+    int len;
+
+    test_reset(NKEY, 1);
+
+    /* keys taking over counters leave every tracked key reachable */
+    for (i = 0; i < NCOLD; i++) {
+        snprintf(key, sizeof(key), "cold%u", i * 7919 % NCOLD);
+        count_key(key, 1 + i % 3);
+    }
+    nreplace = metrics.hotkey_replace.counter;
+    ck_assert_uint_eq(nreplace, NCOLD - NKEY);
+
+    hotkey_print(buf, BUF_LEN, PRINT_FMT, UINT32_MAX);
+    for (i = 0, p = buf; *p != '\0'; i++, p = strchr(p, '\n') + 1) {
+        len = strchr(p, ' ') - p;
+        snprintf(key, sizeof(key), "%.*s", len, p);
+        count_key(key, 1);
+    }
+    ck_assert_int_eq(i, NKEY);
+    ck_assert_uint_eq(metrics.hotkey_replace.counter, nreplace);
+#undef NKEY
+#undef NCOLD
+}
+END_TEST
+
+START_TEST(test_print_truncate)
+{
+    char buf[16];
+
+    test_reset(4, 1);
+
+    count_key("aaaa", 2);
+    count_key("bbbb", 1);
+
+    /* only whole lines are printed */
+    ck_assert_int_eq(hotkey_print(buf, sizeof(buf), PRINT_FMT, UINT32_MAX),
+            strlen("aaaa 2 0\n"));
+    ck_assert_str_eq(buf, "aaaa 2 0\n");
+}
+END_TEST
+
+/*
+ * test suite
+ */
+static Suite *
+hotkey_suite(void)
+{
+    Suite *s = suite_create(SUITE_NAME);
+
+    TCase *tc_hotkey = tcase_create("hotkey");
+    suite_add_tcase(s, tc_hotkey);
+
+    tcase_add_test(tc_hotkey, test_disabled);
+    tcase_add_test(tc_hotkey, test_order);
+    tcase_add_test(tc_hotkey, test_replace);
+    tcase_add_test(tc_hotkey, test_heavy_hitter);
+    tcase_add_test(tc_hotkey, test_sample);
+    tcase_add_test(tc_hotkey, test_sample_alias);
+    tcase_add_test(tc_hotkey, test_index);
+    tcase_add_test(tc_hotkey, test_print_truncate);
+
+    return s;
+}
+
+int
+main(void)
+{
+    int nfail;
+
+    /* setup */
+    test_setup(HOTKEY_NKEY, HOTKEY_SAMPLE);
+
+    Suite *suite = hotkey_suite();
+    SRunner *srunner = srunner_create(suite);
+    srunner_set_log(srunner, DEBUG_LOG);
+    srunner_run_all(srunner, CK_ENV); /* set CK_VEBOSITY in ENV to customize */
+    nfail = srunner_ntests_failed(srunner);
+    srunner_free(srunner);
+
+    /* teardown */
+    test_teardown();
+
+    return (nfail == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
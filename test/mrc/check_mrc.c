@@ -0,0 +1,398 @@
+#include <mrc/mrc.h>
+#include <protocol/data/memcache_include.h>
+#include <server/twemcache/data/process.h>
+#include <storage/slab/slab.h>
+#include <time/time.h>
+
+#include <buffer/cc_buf.h>
+#include <buffer/cc_dbuf.h>
+#include <cc_bstring.h>
+#include <cc_hash.h>
+
+#include <check.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* define for each suite, local scope due to macro visibility rule */
+#define SUITE_NAME "mrc"
+#define DEBUG_LOG  SUITE_NAME ".log"
+
+#define PRINT_FMT "%"PRIu64" %.4f\n"
+#define BUF_LEN 4096
+
+mrc_options_st options = { MRC_OPTION(OPTION_INIT) };
+mrc_metrics_st metrics = { MRC_METRIC(METRIC_INIT) };
+
+/*
+ * utilities
+ */
+
+/* track up to nkey of the keys sampled one out of sample, from scratch */
+static void
+track(uint32_t nkey, uint32_t sample)
+{
+    option_load_default((struct option *)&options, OPTION_CARDINALITY(options));
+    options.mrc_enable.val.vbool = true;
+    options.mrc_nkey.val.vuint = nkey;
+    options.mrc_sample.val.vuint = sample;
+    metric_reset((struct metric *)&metrics, METRIC_CARDINALITY(metrics));
+
+    mrc_setup(&options, &metrics);
+}
+
+/* access one key per character of trace, in order */
+static void
+count_trace(const char *trace)
+{
+    struct bstring key;
+
+    for (key.len = 1; *trace != '\0'; trace++) {
+        key.data = (char *)trace;
+        mrc_count(&key);
+    }
+}
+
+/* access nkey keys in a loop, n times over */
+static void
+count_cyclic(uint32_t nkey, uint32_t n)
+{
+    char keystr[32];
+    struct bstring key;
+    uint32_t i, j;
+
+    for (i = 0; i < n; i++) {
+        for (j = 0; j < nkey; j++) {
+            key.len = snprintf(keystr, sizeof(keystr), "key%u", j);
+            key.data = keystr;
+            mrc_count(&key);
+        }
+    }
+}
+
+/**************
+ * test cases *
+ **************/
+
+START_TEST(test_distance)
+{
+    char buf[BUF_LEN];
+
+    track(4, 1);
+
+    /*
+     * a, b, c are first accesses; b then reuses with distance 1 (c) and a
+     * with distance 2 (b, c), hitting at 2 and 3 keys respectively
+     */
+    count_trace("abcba");
+    ck_assert_int_eq(metrics.mrc_access.counter, 5);
+    ck_assert_int_eq(metrics.mrc_cold.counter, 3);
+
+    mrc_print(buf, BUF_LEN, PRINT_FMT);
+    ck_assert_str_eq(buf, "1 1.0000\n2 0.8000\n3 0.6000\n4 0.6000\n");
+
+    /* repeated accesses to the same key have distance 0 */
+    count_trace("aaaaa");
+    mrc_print(buf, BUF_LEN, PRINT_FMT);
+    ck_assert_str_eq(buf, "1 0.5000\n2 0.4000\n3 0.3000\n4 0.3000\n");
+
+    mrc_reset();
+    ck_assert_int_eq(mrc_print(buf, BUF_LEN, PRINT_FMT), 0);
+}
+END_TEST
+
+START_TEST(test_cyclic)
+{
+    char buf[BUF_LEN];
+
+    track(8, 1);
+
+    /* a loop over 3 keys only hits in an LRU cache of 3 or more keys */
+    count_cyclic(3, 10);
+    ck_assert_int_eq(metrics.mrc_access.counter, 30);
+    ck_assert_int_eq(metrics.mrc_cold.counter, 3);
+
+    mrc_print(buf, BUF_LEN, PRINT_FMT);
+    ck_assert_str_eq(buf, "1 1.0000\n2 1.0000\n3 0.1000\n4 0.1000\n"
+            "5 0.1000\n6 0.1000\n7 0.1000\n8 0.1000\n");
+}
+END_TEST
+
+START_TEST(test_bucket)
+{
+    char buf[BUF_LEN];
+
+    track(64, 1);
+
+    /* buckets 2 keys wide, a loop over 3 keys hits from the 2nd bucket on */
+    count_cyclic(3, 10);
+    mrc_print(buf, BUF_LEN, PRINT_FMT);
+    ck_assert_int_eq(strncmp(buf, "2 1.0000\n4 0.1000\n6 0.1000\n",
+            strlen("2 1.0000\n4 0.1000\n6 0.1000\n")), 0);
+    ck_assert_ptr_ne(strstr(buf, "\n64 0.1000\n"), NULL);
+}
+END_TEST
+
+START_TEST(test_renumber)
+{
+    char buf[BUF_LEN];
+
+    track(4, 1);
+
+    /* logical time wraps around many times, distances are unaffected */
+    count_cyclic(3, 1000);
+    ck_assert_int_eq(metrics.mrc_cold.counter, 3);
+    ck_assert_int_eq(metrics.mrc_drop.counter, 0);
+
+    mrc_print(buf, BUF_LEN, PRINT_FMT);
+    ck_assert_str_eq(buf, "1 1.0000\n2 1.0000\n3 0.0010\n4 0.0010\n");
+}
+END_TEST
+
+START_TEST(test_drop)
+{
+    char buf[BUF_LEN];
+
+    track(4, 1);
+
+    /* keys reused beyond the tracked range are all misses */
+    count_cyclic(8, 2);
+    ck_assert_int_eq(metrics.mrc_cold.counter, 16);
+    ck_assert_int_eq(metrics.mrc_drop.counter, 12);
+
+    mrc_print(buf, BUF_LEN, PRINT_FMT);
+    ck_assert_str_eq(buf, "1 1.0000\n2 1.0000\n3 1.0000\n4 1.0000\n");
+
+    /* the 4 keys accessed last are still tracked */
+    count_cyclic(4, 1);
+    ck_assert_int_eq(metrics.mrc_cold.counter, 20);
+    count_cyclic(4, 1);
+    ck_assert_int_eq(metrics.mrc_cold.counter, 20);
+}
+END_TEST
+
+START_TEST(test_lru)
+{
+#define NKEY 64
+#define NBUCKET 32
+#define NSPACE 100
+#define NACCESS 100000
+    char buf[BUF_LEN], expect[BUF_LEN], keystr[32];
+    struct bstring key;
+    uint32_t stack[NKEY], nstack = 0, i, j, k;
+    uint64_t count[NBUCKET] = {0}, miss = NACCESS;
+    size_t len = 0;
+
+    track(NKEY, 1);
+
+    /* compare against a plain LRU stack of the NKEY keys accessed last */
+    srand(1);
+    for (i = 0; i < NACCESS; i++) {
+        k = rand() % NSPACE;
+        key.len = snprintf(keystr, sizeof(keystr), "key%u", k);
+        key.data = keystr;
+        mrc_count(&key);
+
+        for (j = 0; j < nstack && stack[j] != k; j++);
+        if (j < nstack) {
+            count[j * NBUCKET / NKEY]++;
+        } else if (nstack < NKEY) {
+            nstack++;
+        } else {
+            j = NKEY - 1;
+        }
+        for (; j > 0; j--) {
+            stack[j] = stack[j - 1];
+        }
+        stack[0] = k;
+    }
+
+    for (i = 0; i < NBUCKET; i++) {
+        miss -= count[i];
+        len += snprintf(expect + len, BUF_LEN - len, PRINT_FMT,
+                (uint64_t)(i + 1) * NKEY / NBUCKET, (double)miss / NACCESS);
+    }
+    mrc_print(buf, BUF_LEN, PRINT_FMT);
+    ck_assert_str_eq(buf, expect);
+#undef NKEY
+#undef NBUCKET
+#undef NSPACE
+#undef NACCESS
+}
+END_TEST
+
+START_TEST(test_sample_rate)
+{
+#define NSPACE 4000
+#define SAMPLE 8
+    char buf[BUF_LEN], keystr[32];
+    uint32_t i, len, nsampled = 0;
+
+    track(1024, SAMPLE);
+
+    /* exactly the keys whose hash falls on the sample ratio are sampled */
+    for (i = 0; i < NSPACE; i++) {
+        len = snprintf(keystr, sizeof(keystr), "key%u", i);
+        nsampled += hash(keystr, len, 0) % SAMPLE == 0;
+    }
+    ck_assert_int_gt(nsampled, NSPACE / SAMPLE * 9 / 10);
+    ck_assert_int_lt(nsampled, NSPACE / SAMPLE * 11 / 10);
+
+    /* and all accesses of a sampled key are counted */
+    count_cyclic(NSPACE, 2);
+    ck_assert_int_eq(metrics.mrc_cold.counter, nsampled);
+    ck_assert_int_eq(metrics.mrc_access.counter, 2 * nsampled);
+
+    /* sizes are scaled up by the sample ratio */
+    mrc_print(buf, BUF_LEN, PRINT_FMT);
+    ck_assert_int_eq(strncmp(buf, "256 1.0000\n512 1.0000\n",
+            strlen("256 1.0000\n512 1.0000\n")), 0);
+#undef NSPACE
+#undef SAMPLE
+}
+END_TEST
+
+START_TEST(test_print_truncate)
+{
+    char buf[20];
+
+    track(4, 1);
+
+    count_cyclic(3, 10);
+
+    /* only whole lines are printed */
+    ck_assert_int_eq(mrc_print(buf, sizeof(buf), PRINT_FMT),
+            strlen("1 1.0000\n2 1.0000\n"));
+    ck_assert_str_eq(buf, "1 1.0000\n2 1.0000\n");
+}
+END_TEST
+
+/*
+ * the same trace as test_distance, through the twemcache data path: each key
+ * of a get or gets is counted once, whether found or not
+ */
+START_TEST(test_twemcache)
+{
+#define TRACE "get a\r\nget b\r\nget c\r\ngets b\r\nget a\r\n"
+    process_metrics_st pmetrics = { PROCESS_METRIC(METRIC_INIT) };
+    struct buf *rbuf, *wbuf;
+    char buf[BUF_LEN];
+    void *data = NULL;
+
+    track(4, 1);
+    slab_setup(NULL, NULL);
+    request_setup(NULL, NULL);
+    response_setup(NULL, NULL);
+    process_setup(NULL, &pmetrics);
+    rbuf = buf_create();
+    wbuf = buf_create();
+
+    buf_write(rbuf, TRACE, sizeof(TRACE) - 1);
+    ck_assert_int_eq(twemcache_process_read(&rbuf, &wbuf, &data), 0);
+    ck_assert_int_eq(buf_rsize(rbuf), 0);
+    ck_assert_int_eq(pmetrics.get_key_miss.counter, 4);
+    ck_assert_int_eq(pmetrics.gets_key_miss.counter, 1);
+
+    ck_assert_int_eq(metrics.mrc_access.counter, 5);
+    mrc_print(buf, BUF_LEN, PRINT_FMT);
+    ck_assert_str_eq(buf, "1 1.0000\n2 0.8000\n3 0.6000\n4 0.6000\n");
+
+    buf_destroy(&rbuf);
+    buf_destroy(&wbuf);
+    process_teardown();
+    response_teardown();
+    request_teardown();
+    slab_teardown();
+#undef TRACE
+}
+END_TEST
+
+/*
+ * the same trace again, made of writes only: set, add, replace and cas
+ * count their key as an access the same way get does
+ */
+START_TEST(test_twemcache_write)
+{
+#define TRACE   "set a 0 0 1\r\n1\r\nadd b 0 0 1\r\n1\r\nset c 0 0 1\r\n1\r\n" \
+                "replace b 0 0 1\r\n2\r\ncas a 0 0 1 0\r\n2\r\n"
+    process_metrics_st pmetrics = { PROCESS_METRIC(METRIC_INIT) };
+    struct buf *rbuf, *wbuf;
+    char buf[BUF_LEN];
+    void *data = NULL;
+
+    track(4, 1);
+    time_setup();
+    time_update();
+    slab_setup(NULL, NULL);
+    request_setup(NULL, NULL);
+    response_setup(NULL, NULL);
+    process_setup(NULL, &pmetrics);
+    rbuf = buf_create();
+    wbuf = buf_create();
+
+    buf_write(rbuf, TRACE, sizeof(TRACE) - 1);
+    ck_assert_int_eq(twemcache_process_read(&rbuf, &wbuf, &data), 0);
+    ck_assert_int_eq(buf_rsize(rbuf), 0);
+    ck_assert_int_eq(pmetrics.set_stored.counter, 2);
+    ck_assert_int_eq(pmetrics.add_stored.counter, 1);
+    ck_assert_int_eq(pmetrics.replace_stored.counter, 1);
+    ck_assert_int_eq(pmetrics.cas_exists.counter, 1);
+
+    ck_assert_int_eq(metrics.mrc_access.counter, 5);
+    mrc_print(buf, BUF_LEN, PRINT_FMT);
+    ck_assert_str_eq(buf, "1 1.0000\n2 0.8000\n3 0.6000\n4 0.6000\n");
+
+    buf_destroy(&rbuf);
+    buf_destroy(&wbuf);
+    process_teardown();
+    response_teardown();
+    request_teardown();
+    slab_teardown();
+    time_teardown();
+#undef TRACE
+}
+END_TEST
+
+/*
+ * test suite
+ */
+static Suite *
+mrc_suite(void)
+{
+    Suite *s = suite_create(SUITE_NAME);
+
+    TCase *tc_curve = tcase_create("curve");
+    suite_add_tcase(s, tc_curve);
+
+    tcase_add_test(tc_curve, test_distance);
+    tcase_add_test(tc_curve, test_cyclic);
+    tcase_add_test(tc_curve, test_bucket);
+    tcase_add_test(tc_curve, test_renumber);
+    tcase_add_test(tc_curve, test_drop);
+    tcase_add_test(tc_curve, test_lru);
+    tcase_add_test(tc_curve, test_sample_rate);
+    tcase_add_test(tc_curve, test_print_truncate);
+
+    TCase *tc_process = tcase_create("process");
+    suite_add_tcase(s, tc_process);
+
+    tcase_add_test(tc_process, test_twemcache);
+    tcase_add_test(tc_process, test_twemcache_write);
+
+    return s;
+}
+
+int
+main(void)
+{
+    int nfail;
+
+    Suite *suite = mrc_suite();
+    SRunner *srunner = srunner_create(suite);
+    srunner_set_log(srunner, DEBUG_LOG);
+    srunner_run_all(srunner, CK_ENV); /* set CK_VEBOSITY in ENV to customize */
+    nfail = srunner_ntests_failed(srunner);
+    srunner_free(srunner);
+
+    return (nfail == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -93,6 +93,32 @@ START_TEST(test_stats)
 }
 END_TEST
 
+START_TEST(test_stats_arg)
+{
+#define SERIALIZED "stats  delta worker_\r\n"
+    int ret;
+    struct bstring token;
+
+    test_reset();
+
+    buf_write(buf, SERIALIZED, sizeof(SERIALIZED) - 1);
+    ret = admin_parse_req(req, buf);
+    ck_assert_int_eq(ret, PARSE_OK);
+    ck_assert(req->type == REQ_STATS);
+    ck_assert_int_eq(req->arg.len, sizeof("  delta worker_") - 1);
+
+    ck_assert(admin_parse_arg(&req->arg, &token));
+    ck_assert_int_eq(token.len, sizeof("delta") - 1);
+    ck_assert_int_eq(cc_bcmp(token.data, "delta", token.len), 0);
+    ck_assert(admin_parse_arg(&req->arg, &token));
+    ck_assert_int_eq(token.len, sizeof("worker_") - 1);
+    ck_assert_int_eq(cc_bcmp(token.data, "worker_", token.len), 0);
+    ck_assert(!admin_parse_arg(&req->arg, &token));
+    ck_assert_int_eq(token.len, 0);
+#undef SERIALIZED
+}
+END_TEST
+
 START_TEST(test_version)
 {
 #define SERIALIZED "version\r\n"
@@ -117,6 +143,59 @@ START_TEST(test_version)
 }
 END_TEST
 
+START_TEST(test_hotkeys)
+{
+#define SERIALIZED "hotkeys 10\r\n"
+    int ret;
+    int len = sizeof(SERIALIZED) - 1;
+    struct bstring token;
+
+    test_reset();
+
+    /* compose */
+    req->type = REQ_HOTKEYS;
+    req->arg = str2bstr(" 10");
+    ret = admin_compose_req(&buf, req);
+    ck_assert_msg(ret == len, "expected: %d, returned: %d", len, ret);
+    ck_assert_int_eq(cc_bcmp(buf->rpos, SERIALIZED, ret), 0);
+
+    /* parse */
+    admin_request_reset(req);
+    ret = admin_parse_req(req, buf);
+    ck_assert_int_eq(ret, PARSE_OK);
+    ck_assert(req->state == REQ_PARSED);
+    ck_assert(req->type == REQ_HOTKEYS);
+    ck_assert(admin_parse_arg(&req->arg, &token));
+    ck_assert_int_eq(token.len, sizeof("10") - 1);
+    ck_assert_int_eq(cc_bcmp(token.data, "10", token.len), 0);
+#undef SERIALIZED
+}
+END_TEST
+
+START_TEST(test_mrc)
+{
+#define SERIALIZED "mrc\r\n"
+    int ret;
+    int len = sizeof(SERIALIZED) - 1;
+
+    test_reset();
+
+    /* compose */
+    req->type = REQ_MRC;
+    ret = admin_compose_req(&buf, req);
+    ck_assert_msg(ret == len, "expected: %d, returned: %d", len, ret);
+    ck_assert_int_eq(cc_bcmp(buf->rpos, SERIALIZED, ret), 0);
+
+    /* parse */
+    admin_request_reset(req);
+    ret = admin_parse_req(req, buf);
+    ck_assert_int_eq(ret, PARSE_OK);
+    ck_assert(req->state == REQ_PARSED);
+    ck_assert(req->type == REQ_MRC);
+#undef SERIALIZED
+}
+END_TEST
+
 /*
  * test suite
  */
@@ -131,7 +210,10 @@ admin_suite(void)
 
     tcase_add_test(tc_basic_req, test_quit);
     tcase_add_test(tc_basic_req, test_stats);
+    tcase_add_test(tc_basic_req, test_stats_arg);
     tcase_add_test(tc_basic_req, test_version);
+    tcase_add_test(tc_basic_req, test_hotkeys);
+    tcase_add_test(tc_basic_req, test_mrc);
 
     return s;
 }
@@ -9,6 +9,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 /* define for each suite, local scope due to macro visibility rule */
 #define SUITE_NAME "memcache"
@@ -310,6 +311,60 @@ START_TEST(test_set)
 }
 END_TEST
 
+START_TEST(test_set_ms)
+{
+#define SERIALIZED "set foo 123 1500ms 3\r\nXYZ\r\n"
+#define KEY "foo"
+#define VAL "XYZ"
+#define FLAG 123
+#define EXPIRY 1500
+
+    int ret;
+    int len = sizeof(SERIALIZED) - 1;
+    struct bstring key = str2bstr(KEY);
+    struct bstring val = str2bstr(VAL);
+    struct bstring *pos;
+
+    test_reset();
+
+    /* compose */
+    req->type = REQ_SET;
+    pos = array_push(req->keys);
+    *pos = key;
+    req->flag = FLAG;
+    req->expiry = EXPIRY;
+    req->expiry_ms = 1;
+    req->vstr = val;
+    ret = compose_req(&buf, req);
+    ck_assert_msg(ret == len, "expected: %d, returned: %d", len, ret);
+    ck_assert_int_eq(cc_bcmp(buf->rpos, SERIALIZED, ret), 0);
+
+    /* parse */
+    request_reset(req);
+    ret = parse_req(req, buf);
+    ck_assert_int_eq(ret, PARSE_OK);
+    ck_assert(req->rstate == REQ_PARSED);
+    ck_assert(req->type == REQ_SET);
+    ck_assert_int_eq(bstring_compare(&key, array_first(req->keys)), 0);
+    ck_assert_int_eq(req->flag, FLAG);
+    ck_assert_int_eq(req->expiry, EXPIRY);
+    ck_assert(req->expiry_ms);
+    ck_assert_int_eq(bstring_compare(&val, &req->vstr), 0);
+    ck_assert(buf->rpos == buf->wpos);
+
+    /* a unit other than ms is not allowed */
+    test_reset();
+    buf_write(buf, "set foo 123 1500s 3\r\nXYZ\r\n", len - 1);
+    ret = parse_req(req, buf);
+    ck_assert_int_eq(ret, PARSE_EINVALID);
+#undef EXPIRY
+#undef FLAG
+#undef VAL
+#undef KEY
+#undef SERIALIZED
+}
+END_TEST
+
 START_TEST(test_add_noreply)
 {
 #define SERIALIZED "add foo 123 86400 3 noreply\r\nXYZ\r\n"
@@ -1170,6 +1225,52 @@ START_TEST(test_rsp_pool_metrics)
 }
 END_TEST
 
+START_TEST(test_rsp_vec_basic)
+{
+    int i;
+    struct response *r, *nr;
+    struct response_vec *vec;
+    response_metrics_st metrics =
+        (response_metrics_st) { RESPONSE_METRIC(METRIC_INIT) };
+
+    response_setup(NULL, &metrics);
+
+    vec = response_vec_create(2);
+    ck_assert_msg(vec != NULL, "expected to create a response vector");
+
+    r = response_vec_borrow(vec, 2);
+    ck_assert_msg(r != NULL, "expected to borrow from response vector");
+    ck_assert_int_eq(metrics.response_vec_grow.counter, 0);
+    response_vec_return(vec);
+
+    r = response_vec_borrow(vec, 5);
+    ck_assert_msg(r != NULL, "expected to borrow from response vector");
+    ck_assert_int_eq(metrics.response_vec_grow.counter, 1);
+    ck_assert_int_ge(vec->nalloc, 5);
+    for (i = 0, nr = r; nr != NULL; nr = STAILQ_NEXT(nr, next), ++i) {
+        ck_assert_int_eq(nr->type, RSP_UNKNOWN);
+        nr->type = RSP_END;
+    }
+    ck_assert_int_eq(i, 5);
+    response_vec_return(vec);
+    ck_assert_int_eq(vec->nused, 0);
+
+    r = response_vec_borrow(vec, 3);
+    ck_assert_int_eq(metrics.response_vec_grow.counter, 1);
+    for (i = 0, nr = r; nr != NULL; nr = STAILQ_NEXT(nr, next), ++i) {
+        ck_assert_int_eq(nr->type, RSP_UNKNOWN);
+    }
+    ck_assert_int_eq(i, 3);
+    ck_assert_int_eq(metrics.response_borrow.counter, 0);
+    response_vec_return(vec);
+
+    response_vec_destroy(&vec);
+    ck_assert_msg(vec == NULL, "expected response vector to be nulled");
+
+    response_teardown();
+}
+END_TEST
+
 START_TEST(test_req_pool_basic)
 {
 #define POOL_SIZE 10
@@ -1195,6 +1296,78 @@ START_TEST(test_req_pool_basic)
 }
 END_TEST
 
+/*
+ * command log
+ */
+START_TEST(test_klog_fmt_rec)
+{
+#define STORE_LINE "\"set foo 1 2 3\" 5 8\n"
+#define STORE_MS_LINE "\"set foo 1 2ms 3\" 5 8\n"
+#define CAS_LINE "\"cas foo 1 2 3 42\" 6 8\n"
+#define GET_LINE "\"get foo\" 0 0\n"
+#define DELTA_LINE "\"incr foo 7\" 12 3\n"
+
+    struct klog_rec rec;
+    char line[KiB];
+    int len;
+
+    memset(&rec, 0, sizeof(rec));
+    rec.time = 1;
+    rec.magic = KLOG_REC_MAGIC;
+    rec.klen = 3;
+
+    /* the timestamp depends on the local time zone, only check the rest */
+    rec.op = REQ_SET;
+    rec.status = RSP_STORED;
+    rec.flag = 1;
+    rec.expiry = 2;
+    rec.vlen = 3;
+    rec.rlen = 8;
+    len = klog_fmt_rec(line, KiB, &rec, "foo");
+    ck_assert_int_gt(len, sizeof(STORE_LINE) - 1);
+    ck_assert_int_eq(cc_bcmp(line + len - (sizeof(STORE_LINE) - 1), STORE_LINE,
+            sizeof(STORE_LINE) - 1), 0);
+
+    /* an expiry in ms is logged as it was given */
+    rec.expiry_ms = 1;
+    len = klog_fmt_rec(line, KiB, &rec, "foo");
+    ck_assert_int_eq(cc_bcmp(line + len - (sizeof(STORE_MS_LINE) - 1),
+            STORE_MS_LINE, sizeof(STORE_MS_LINE) - 1), 0);
+    rec.expiry_ms = 0;
+
+    rec.op = REQ_CAS;
+    rec.status = RSP_EXISTS;
+    rec.aux = 42;
+    len = klog_fmt_rec(line, KiB, &rec, "foo");
+    ck_assert_int_eq(cc_bcmp(line + len - (sizeof(CAS_LINE) - 1), CAS_LINE,
+            sizeof(CAS_LINE) - 1), 0);
+
+    rec.op = REQ_GET;
+    rec.status = RSP_UNKNOWN;
+    rec.rlen = 0;
+    len = klog_fmt_rec(line, KiB, &rec, "foo");
+    ck_assert_int_eq(cc_bcmp(line + len - (sizeof(GET_LINE) - 1), GET_LINE,
+            sizeof(GET_LINE) - 1), 0);
+
+    rec.op = REQ_INCR;
+    rec.status = RSP_NUMERIC;
+    rec.aux = 7;
+    rec.rlen = 3;
+    len = klog_fmt_rec(line, KiB, &rec, "foo");
+    ck_assert_int_eq(cc_bcmp(line + len - (sizeof(DELTA_LINE) - 1), DELTA_LINE,
+            sizeof(DELTA_LINE) - 1), 0);
+
+    /* an out-of-range op cannot be rendered */
+    rec.op = REQ_SENTINEL;
+    ck_assert_int_eq(klog_fmt_rec(line, KiB, &rec, "foo"), 0);
+#undef STORE_LINE
+#undef STORE_MS_LINE
+#undef CAS_LINE
+#undef GET_LINE
+#undef DELTA_LINE
+}
+END_TEST
+
 /*
  * test suite
  */
@@ -1214,6 +1387,7 @@ memcache_suite(void)
     tcase_add_test(tc_basic_req, test_multikey);
     tcase_add_test(tc_basic_req, test_gets);
     tcase_add_test(tc_basic_req, test_set);
+    tcase_add_test(tc_basic_req, test_set_ms);
     tcase_add_test(tc_basic_req, test_add_noreply);
     tcase_add_test(tc_basic_req, test_replace_noreply);
     tcase_add_test(tc_basic_req, test_cas);
@@ -1253,12 +1427,18 @@ memcache_suite(void)
     tcase_add_test(tc_rsp_pool, test_rsp_pool_basic);
     tcase_add_test(tc_rsp_pool, test_rsp_pool_chained);
     tcase_add_test(tc_rsp_pool, test_rsp_pool_metrics);
+    tcase_add_test(tc_rsp_pool, test_rsp_vec_basic);
 
     TCase *tc_req_pool = tcase_create("request pool");
     suite_add_tcase(s, tc_req_pool);
 
     tcase_add_test(tc_req_pool, test_req_pool_basic);
 
+    TCase *tc_klog = tcase_create("command log");
+    suite_add_tcase(s, tc_klog);
+
+    tcase_add_test(tc_klog, test_klog_fmt_rec);
+
     return s;
 }
 
@@ -0,0 +1,423 @@
+#include <protocol/data/redis_include.h>
+
+#include <buffer/cc_buf.h>
+#include <cc_array.h>
+#include <cc_bstring.h>
+#include <cc_define.h>
+
+#include <check.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* define for each suite, local scope due to macro visibility rule */
+#define SUITE_NAME "redis"
+#define DEBUG_LOG  SUITE_NAME ".log"
+
+struct request *req;
+struct response *rsp;
+struct buf *buf;
+
+/*
+ * utilities
+ */
+static void
+test_setup(void)
+{
+    req = request_create();
+    rsp = response_create();
+    buf = buf_create();
+}
+
+static void
+test_reset(void)
+{
+    request_reset(req);
+    response_reset(rsp);
+    buf_reset(buf);
+}
+
+static void
+test_teardown(void)
+{
+    buf_destroy(&buf);
+    response_destroy(&rsp);
+    request_destroy(&req);
+}
+
+static void
+test_token(uint32_t idx, char *str)
+{
+    struct bstring expect = {strlen(str), str};
+
+    ck_assert_int_eq(bstring_compare(&expect, array_get(req->token, idx)), 0);
+}
+
+/**************
+ * test cases *
+ **************/
+
+/*
+ * basic requests
+ */
+START_TEST(test_get)
+{
+#define SERIALIZED "*2\r\n$3\r\nget\r\n$3\r\nfoo\r\n"
+
+    int ret;
+    int len = sizeof(SERIALIZED) - 1;
+    struct bstring *t;
+
+    test_reset();
+
+    /* compose */
+    t = array_push(req->token);
+    *t = str2bstr("get");
+    t = array_push(req->token);
+    *t = str2bstr("foo");
+    ret = compose_req(&buf, req);
+    ck_assert_msg(ret == len, "expected: %d, returned: %d", len, ret);
+    ck_assert_int_eq(cc_bcmp(buf->rpos, SERIALIZED, ret), 0);
+
+    /* parse */
+    request_reset(req);
+    ret = parse_req(req, buf);
+    ck_assert_int_eq(ret, PARSE_OK);
+    ck_assert(req->rstate == REQ_PARSED);
+    ck_assert(req->type == REQ_GET);
+    ck_assert_int_eq(array_nelem(req->token), 2);
+    test_token(1, "foo");
+    ck_assert(request_narg_valid(req));
+    ck_assert(buf->rpos == buf->wpos);
+#undef SERIALIZED
+}
+END_TEST
+
+START_TEST(test_set_binary)
+{
+#define SERIALIZED "*3\r\n$3\r\nSET\r\n$3\r\nfoo\r\n$4\r\na\r\nb\r\n"
+
+    int ret;
+
+    test_reset();
+
+    buf_write(buf, SERIALIZED, sizeof(SERIALIZED) - 1);
+    ret = parse_req(req, buf);
+    ck_assert_int_eq(ret, PARSE_OK);
+    ck_assert(req->type == REQ_SET);
+    ck_assert_int_eq(array_nelem(req->token), 3);
+    test_token(1, "foo");
+    test_token(2, "a\r\nb");
+    ck_assert(buf->rpos == buf->wpos);
+#undef SERIALIZED
+}
+END_TEST
+
+START_TEST(test_inline)
+{
+#define SERIALIZED "mget  foo bar\r\nPING\n"
+
+    int ret;
+
+    test_reset();
+
+    buf_write(buf, SERIALIZED, sizeof(SERIALIZED) - 1);
+    ret = parse_req(req, buf);
+    ck_assert_int_eq(ret, PARSE_OK);
+    ck_assert(req->type == REQ_MGET);
+    ck_assert_int_eq(array_nelem(req->token), 3);
+    test_token(1, "foo");
+    test_token(2, "bar");
+
+    request_reset(req);
+    ret = parse_req(req, buf);
+    ck_assert_int_eq(ret, PARSE_OK);
+    ck_assert(req->type == REQ_PING);
+    ck_assert_int_eq(array_nelem(req->token), 1);
+    ck_assert(buf->rpos == buf->wpos);
+#undef SERIALIZED
+}
+END_TEST
+
+START_TEST(test_empty)
+{
+#define SERIALIZED "\r\n*0\r\n"
+
+    int ret;
+
+    test_reset();
+
+    buf_write(buf, SERIALIZED, sizeof(SERIALIZED) - 1);
+    ret = parse_req(req, buf);
+    ck_assert_int_eq(ret, PARSE_EEMPTY);
+    ret = parse_req(req, buf);
+    ck_assert_int_eq(ret, PARSE_EEMPTY);
+    ck_assert(buf->rpos == buf->wpos);
+#undef SERIALIZED
+}
+END_TEST
+
+START_TEST(test_unknown)
+{
+#define SERIALIZED "*1\r\n$5\r\nhello\r\n"
+
+    int ret;
+
+    test_reset();
+
+    buf_write(buf, SERIALIZED, sizeof(SERIALIZED) - 1);
+    ret = parse_req(req, buf);
+    ck_assert_int_eq(ret, PARSE_OK);
+    ck_assert(req->type == REQ_UNKNOWN);
+    ck_assert(buf->rpos == buf->wpos);
+#undef SERIALIZED
+}
+END_TEST
+
+START_TEST(test_narg)
+{
+    test_reset();
+
+    buf_write(buf, "get foo bar\r\n", sizeof("get foo bar\r\n") - 1);
+    ck_assert_int_eq(parse_req(req, buf), PARSE_OK);
+    ck_assert(req->type == REQ_GET);
+    ck_assert(!request_narg_valid(req));
+
+    request_reset(req);
+    buf_write(buf, "del a b c\r\n", sizeof("del a b c\r\n") - 1);
+    ck_assert_int_eq(parse_req(req, buf), PARSE_OK);
+    ck_assert(req->type == REQ_DEL);
+    ck_assert(request_narg_valid(req));
+
+    request_reset(req);
+    buf_write(buf, "set foo\r\n", sizeof("set foo\r\n") - 1);
+    ck_assert_int_eq(parse_req(req, buf), PARSE_OK);
+    ck_assert(req->type == REQ_SET);
+    ck_assert(!request_narg_valid(req));
+}
+END_TEST
+
+START_TEST(test_incomplete)
+{
+#define SERIALIZED "*2\r\n$3\r\nget\r\n$3\r\nfoo\r\n"
+
+    int ret;
+    char *pos;
+    size_t i, len = sizeof(SERIALIZED) - 1;
+
+    /* every strict prefix of a request is incomplete */
+    for (i = 1; i < len; i++) {
+        test_reset();
+
+        buf_write(buf, SERIALIZED, i);
+        pos = buf->rpos;
+        ret = parse_req(req, buf);
+        ck_assert_msg(ret == PARSE_EUNFIN, "prefix of %zu bytes returned %d",
+                i, ret);
+        ck_assert(buf->rpos == pos);
+        ck_assert_int_eq(array_nelem(req->token), 0);
+    }
+#undef SERIALIZED
+}
+END_TEST
+
+START_TEST(test_invalid)
+{
+    test_reset();
+    buf_write(buf, "*2\r\n:3\r\n", sizeof("*2\r\n:3\r\n") - 1);
+    ck_assert_int_eq(parse_req(req, buf), PARSE_EINVALID);
+
+    test_reset();
+    buf_write(buf, "*1\r\n$3\r\nfoobar\r\n", sizeof("*1\r\n$3\r\nfoobar\r\n") - 1);
+    ck_assert_int_eq(parse_req(req, buf), PARSE_EINVALID);
+
+    test_reset();
+    buf_write(buf, "*x\r\n", sizeof("*x\r\n") - 1);
+    ck_assert_int_eq(parse_req(req, buf), PARSE_EINVALID);
+}
+END_TEST
+
+/*
+ * basic responses
+ */
+static void
+test_rsp(const char *serialized)
+{
+    int ret;
+    int len = strlen(serialized);
+    element_type_t type = rsp->type;
+    int64_t vint = rsp->vint;
+    struct bstring vstr = rsp->vstr;
+
+    ret = compose_rsp(&buf, rsp);
+    ck_assert_msg(ret == len, "expected: %d, returned: %d", len, ret);
+    ck_assert_int_eq(cc_bcmp(buf->rpos, serialized, ret), 0);
+
+    response_reset(rsp);
+    ret = parse_rsp(rsp, buf);
+    ck_assert_int_eq(ret, PARSE_OK);
+    ck_assert(rsp->rstate == RSP_PARSED);
+    ck_assert_int_eq(rsp->type, type);
+    ck_assert(buf->rpos == buf->wpos);
+    if (type == ELEM_INT || type == ELEM_ARRAY) {
+        ck_assert_int_eq(rsp->vint, vint);
+    }
+    if (type == ELEM_STR || type == ELEM_ERR || type == ELEM_BULK) {
+        ck_assert_int_eq(bstring_compare(&rsp->vstr, &vstr), 0);
+    }
+}
+
+START_TEST(test_str)
+{
+    test_reset();
+    rsp->type = ELEM_STR;
+    rsp->vstr = str2bstr("OK");
+    test_rsp("+OK\r\n");
+}
+END_TEST
+
+START_TEST(test_err)
+{
+    test_reset();
+    rsp->type = ELEM_ERR;
+    rsp->vstr = str2bstr("ERR unknown command");
+    test_rsp("-ERR unknown command\r\n");
+}
+END_TEST
+
+START_TEST(test_int)
+{
+    test_reset();
+    rsp->type = ELEM_INT;
+    rsp->vint = -42;
+    test_rsp(":-42\r\n");
+}
+END_TEST
+
+START_TEST(test_bulk)
+{
+    test_reset();
+    rsp->type = ELEM_BULK;
+    rsp->vstr = str2bstr("bar");
+    test_rsp("$3\r\nbar\r\n");
+
+    test_reset();
+    rsp->type = ELEM_BULK;
+    rsp->vstr = str2bstr("");
+    test_rsp("$0\r\n\r\n");
+}
+END_TEST
+
+START_TEST(test_nil)
+{
+    test_reset();
+    rsp->type = ELEM_NIL;
+    test_rsp("$-1\r\n");
+}
+END_TEST
+
+START_TEST(test_array)
+{
+    test_reset();
+    rsp->type = ELEM_ARRAY;
+    rsp->vint = 2;
+    test_rsp("*2\r\n");
+}
+END_TEST
+
+START_TEST(test_rsp_incomplete)
+{
+    test_reset();
+    buf_write(buf, "$3\r\nba", sizeof("$3\r\nba") - 1);
+    ck_assert_int_eq(parse_rsp(rsp, buf), PARSE_EUNFIN);
+    ck_assert(buf->rpos == buf->begin);
+}
+END_TEST
+
+/*
+ * response vector
+ */
+START_TEST(test_rsp_vec)
+{
+    int i;
+    struct response *r, *nr;
+    struct response_vec *vec;
+
+    vec = response_vec_create(1);
+    ck_assert_msg(vec != NULL, "expected to create a response vector");
+
+    r = response_vec_borrow(vec, 3);
+    ck_assert_msg(r != NULL, "expected to borrow from response vector");
+    for (i = 0, nr = r; nr != NULL; nr = STAILQ_NEXT(nr, next), ++i) {
+        ck_assert_int_eq(nr->type, ELEM_UNKNOWN);
+    }
+    ck_assert_int_eq(i, 3);
+    response_vec_return(vec);
+
+    response_vec_destroy(&vec);
+    ck_assert_msg(vec == NULL, "expected response vector to be nulled");
+}
+END_TEST
+
+/*
+ * test suite
+ */
+static Suite *
+redis_suite(void)
+{
+    Suite *s = suite_create(SUITE_NAME);
+
+    /* basic requests */
+    TCase *tc_basic_req = tcase_create("basic request");
+    suite_add_tcase(s, tc_basic_req);
+
+    tcase_add_test(tc_basic_req, test_get);
+    tcase_add_test(tc_basic_req, test_set_binary);
+    tcase_add_test(tc_basic_req, test_inline);
+    tcase_add_test(tc_basic_req, test_empty);
+    tcase_add_test(tc_basic_req, test_unknown);
+    tcase_add_test(tc_basic_req, test_narg);
+    tcase_add_test(tc_basic_req, test_incomplete);
+    tcase_add_test(tc_basic_req, test_invalid);
+
+    /* basic responses */
+    TCase *tc_basic_rsp = tcase_create("basic response");
+    suite_add_tcase(s, tc_basic_rsp);
+
+    tcase_add_test(tc_basic_rsp, test_str);
+    tcase_add_test(tc_basic_rsp, test_err);
+    tcase_add_test(tc_basic_rsp, test_int);
+    tcase_add_test(tc_basic_rsp, test_bulk);
+    tcase_add_test(tc_basic_rsp, test_nil);
+    tcase_add_test(tc_basic_rsp, test_array);
+    tcase_add_test(tc_basic_rsp, test_rsp_incomplete);
+
+    TCase *tc_rsp_pool = tcase_create("response pool");
+    suite_add_tcase(s, tc_rsp_pool);
+
+    tcase_add_test(tc_rsp_pool, test_rsp_vec);
+
+    return s;
+}
+
+int
+main(void)
+{
+    int nfail;
+
+    /* setup */
+    test_setup();
+
+    Suite *suite = redis_suite();
+    SRunner *srunner = srunner_create(suite);
+    srunner_set_log(srunner, DEBUG_LOG);
+    srunner_run_all(srunner, CK_ENV); /* set CK_VEBOSITY in ENV to customize */
+    nfail = srunner_ntests_failed(srunner);
+    srunner_free(srunner);
+
+    /* teardown */
+    test_teardown();
+
+    return (nfail == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -17,6 +17,7 @@ void test_insert_collision(uint32_t policy, bool cas);
 void test_cas(uint32_t policy);
 void test_delete_basic(uint32_t policy, bool cas);
 void test_expire_basic(uint32_t policy, bool cas);
+void test_expire_ms(uint32_t policy, bool cas);
 
 cuckoo_options_st options = { CUCKOO_OPTION(OPTION_INIT) };
 cuckoo_metrics_st metrics = { CUCKOO_METRIC(METRIC_INIT) };
@@ -71,7 +72,7 @@ test_insert_basic(uint32_t policy, bool cas)
     val.vstr.len = sizeof(VAL) - 1;
 
     time_update();
-    status = cuckoo_insert(&key, &val, UINT32_MAX - 1);
+    status = cuckoo_insert(&key, &val, time_sec2ms(UINT32_MAX - 1));
     ck_assert_msg(status == CC_OK, "cuckoo_insert not OK - return status %d",
             status);
 
@@ -107,7 +108,7 @@ test_insert_collision(uint32_t policy, bool cas)
         val.type = VAL_TYPE_INT;
         val.vint = i;
 
-        status = cuckoo_insert(&key, &val, UINT32_MAX - 1);
+        status = cuckoo_insert(&key, &val, time_sec2ms(UINT32_MAX - 1));
         ck_assert_msg(status == CC_OK, "cuckoo_insert not OK - return status %d",
                 status);
     }
@@ -152,7 +153,7 @@ test_cas(uint32_t policy)
     val.vstr.len = sizeof(VAL) - 1;
 
     time_update();
-    status = cuckoo_insert(&key, &val, UINT32_MAX - 1);
+    status = cuckoo_insert(&key, &val, time_sec2ms(UINT32_MAX - 1));
     ck_assert_msg(status == CC_OK, "cuckoo_insert not OK - return status %d",
             status);
 
@@ -163,7 +164,7 @@ test_cas(uint32_t policy)
     val.vstr.data = VAL2;
     val.vstr.len = sizeof(VAL2) - 1;
 
-    status = cuckoo_update(it, &val, UINT32_MAX - 1);
+    status = cuckoo_update(it, &val, time_sec2ms(UINT32_MAX - 1));
     ck_assert_msg(status == CC_OK, "cuckoo_update not OK - return status %d",
             status);
 
@@ -197,7 +198,7 @@ test_delete_basic(uint32_t policy, bool cas)
     val.vstr.len = sizeof(VAL) - 1;
 
     time_update();
-    status = cuckoo_insert(&key, &val, UINT32_MAX - 1);
+    status = cuckoo_insert(&key, &val, time_sec2ms(UINT32_MAX - 1));
     ck_assert_msg(status == CC_OK, "cuckoo_insert not OK - return status %d",
             status);
 
@@ -237,7 +238,7 @@ test_expire_basic(uint32_t policy, bool cas)
     val.vstr.len = sizeof(VAL) - 1;
 
     now = NOW;
-    status = cuckoo_insert(&key, &val, NOW + 1);
+    status = cuckoo_insert(&key, &val, time_sec2ms(NOW + 1));
     ck_assert_msg(status == CC_OK, "cuckoo_insert not OK - return status %d",
             status);
 
@@ -253,6 +254,47 @@ test_expire_basic(uint32_t policy, bool cas)
 #undef VAL
 }
 
+void
+test_expire_ms(uint32_t policy, bool cas)
+{
+#define KEY "key"
+#define VAL "value"
+#define NOW 12345678
+    struct bstring key;
+    struct val val;
+    rstatus_i status;
+    struct item *it;
+
+    test_reset(policy, cas);
+
+    key.data = KEY;
+    key.len = sizeof(KEY) - 1;
+
+    val.type = VAL_TYPE_STR;
+    val.vstr.data = VAL;
+    val.vstr.len = sizeof(VAL) - 1;
+
+    /* expire 500ms into the current second */
+    now = NOW;
+    now_ms = (rel_time_ms_t)NOW * 1000 + 100;
+    status = cuckoo_insert(&key, &val, (rel_time_ms_t)NOW * 1000 + 500);
+    ck_assert_msg(status == CC_OK, "cuckoo_insert not OK - return status %d",
+            status);
+
+    it = cuckoo_get(&key);
+    ck_assert_msg(it != NULL, "cuckoo_get returned NULL");
+    ck_assert_int_eq(item_expire(it), (rel_time_ms_t)NOW * 1000 + 500);
+
+    now_ms = (rel_time_ms_t)NOW * 1000 + 600;
+
+    it = cuckoo_get(&key);
+    ck_assert_msg(it == NULL, "cuckoo_get returned not NULL after expiration");
+    now_ms = 0;
+#undef NOW
+#undef KEY
+#undef VAL
+}
+
 START_TEST(test_insert_basic_random_true)
 {
     test_insert_basic(CUCKOO_POLICY_RANDOM, true);
@@ -325,6 +367,18 @@ START_TEST(test_expire_basic_random_false)
 }
 END_TEST
 
+START_TEST(test_expire_ms_random_true)
+{
+    test_expire_ms(CUCKOO_POLICY_RANDOM, true);
+}
+END_TEST
+
+START_TEST(test_expire_ms_random_false)
+{
+    test_expire_ms(CUCKOO_POLICY_RANDOM, false);
+}
+END_TEST
+
 START_TEST(test_insert_replace_expired)
 {
 #define NOW 12345678
@@ -346,7 +400,7 @@ START_TEST(test_insert_replace_expired)
         val.type = VAL_TYPE_INT;
         val.vint = i;
 
-        status = cuckoo_insert(&key, &val, now + 1);
+        status = cuckoo_insert(&key, &val, time_sec2ms(now + 1));
         ck_assert_msg(status == CC_OK, "cuckoo_insert not OK - return status %d",
                 status);
     }
@@ -359,7 +413,7 @@ START_TEST(test_insert_replace_expired)
     val.type = VAL_TYPE_INT;
     val.vint = i;
 
-    status = cuckoo_insert(&key, &val, now + 1);
+    status = cuckoo_insert(&key, &val, time_sec2ms(now + 1));
     ck_assert_msg(status == CC_OK, "cuckoo_insert not OK - return status %d",
             status);
     ck_assert_int_eq(metrics.item_expire.counter, 1);
@@ -388,7 +442,7 @@ START_TEST(test_insert_insert_expire_swap)
         val.type = VAL_TYPE_INT;
         val.vint = i;
 
-        status = cuckoo_insert(&key, &val, now + i);
+        status = cuckoo_insert(&key, &val, time_sec2ms(now + i));
         ck_assert_msg(status == CC_OK, "cuckoo_insert not OK - return status %d",
                 status);
     }
@@ -399,7 +453,7 @@ START_TEST(test_insert_insert_expire_swap)
     val.type = VAL_TYPE_INT;
     val.vint = i;
 
-    status = cuckoo_insert(&key, &val, now + i);
+    status = cuckoo_insert(&key, &val, time_sec2ms(now + i));
     ck_assert_msg(status == CC_OK, "cuckoo_insert not OK - return status %d",
             status);
 
@@ -413,6 +467,45 @@ START_TEST(test_insert_insert_expire_swap)
 #undef NOW
 }
 END_TEST
+
+START_TEST(test_size_histogram)
+{
+#define KEY "key"
+#define VAL "value"
+#define NOW 12345678
+#define TTL 30
+    struct bstring key = str2bstr(KEY);
+    struct val val;
+    struct item *it;
+
+    metric_reset((struct metric *)&metrics, METRIC_CARDINALITY(metrics));
+    test_reset(CUCKOO_POLICY_RANDOM, true);
+
+    val.type = VAL_TYPE_STR;
+    val.vstr = str2bstr(VAL);
+
+    now = NOW;
+    ck_assert_int_eq(cuckoo_insert(&key, &val, time_sec2ms(TIME_NEVER)), CC_OK);
+    it = cuckoo_get(&key);
+    ck_assert_msg(it != NULL, "cuckoo_get returned NULL");
+    ck_assert_int_eq(cuckoo_update(it, &val, time_sec2ms(NOW + TTL)), CC_OK);
+
+    /* both insert and update are recorded, ttl only if the item expires */
+    ck_assert_int_eq(metric_histo_count(&metrics.item_key_size), 2);
+    ck_assert_int_eq(metric_histo_percentile(&metrics.item_key_size, 50),
+            sizeof(KEY) - 1);
+    ck_assert_int_eq(metric_histo_count(&metrics.item_val_size), 2);
+    ck_assert_int_eq(metric_histo_percentile(&metrics.item_val_size, 50),
+            sizeof(VAL) - 1);
+    ck_assert_int_eq(metric_histo_count(&metrics.item_ttl), 1);
+    ck_assert_int_eq(metric_histo_percentile(&metrics.item_ttl, 50), TTL);
+#undef KEY
+#undef VAL
+#undef NOW
+#undef TTL
+}
+END_TEST
+
 /*
  * test suite
  */
@@ -439,8 +532,11 @@ cuckoo_suite(void)
     tcase_add_test(tc_basic_req, test_delete_basic_random_false);
     tcase_add_test(tc_basic_req, test_expire_basic_random_true);
     tcase_add_test(tc_basic_req, test_expire_basic_random_false);
+    tcase_add_test(tc_basic_req, test_expire_ms_random_true);
+    tcase_add_test(tc_basic_req, test_expire_ms_random_false);
     tcase_add_test(tc_basic_req, test_insert_replace_expired);
     tcase_add_test(tc_basic_req, test_insert_insert_expire_swap);
+    tcase_add_test(tc_basic_req, test_size_histogram);
 
     return s;
 }
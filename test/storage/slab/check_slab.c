@@ -382,6 +382,41 @@ START_TEST(test_delete_basic)
 }
 END_TEST
 
+/**
+ * Tests expiry within the current second
+ */
+START_TEST(test_expire_ms)
+{
+#define KEY "key"
+#define VAL "val"
+    struct bstring key, val;
+    item_rstatus_t status;
+    struct item *it;
+
+    test_reset();
+
+    key = str2bstr(KEY);
+    val = str2bstr(VAL);
+
+    time_update();
+    ck_assert_int_eq(time_now_ms() / 1000, time_now());
+    now_ms = (rel_time_ms_t)time_now() * 1000 + 100;
+    status = item_insert(&key, &val, 0, (rel_time_ms_t)time_now() * 1000 + 500);
+    ck_assert_msg(status == ITEM_OK, "item_insert not OK - return status %d", status);
+
+    it = item_get(&key);
+    ck_assert_msg(it != NULL, "item_get could not find key %.*s", key.len, key.data);
+    ck_assert_int_eq(item_expire(it), (rel_time_ms_t)time_now() * 1000 + 500);
+
+    now_ms = (rel_time_ms_t)time_now() * 1000 + 600;
+    it = item_get(&key);
+    ck_assert_msg(it == NULL, "item with key %.*s still exists after expiry", key.len, key.data);
+    time_update();
+#undef KEY
+#undef VAL
+}
+END_TEST
+
 /**
  * Tests basic functionality for item_flush
  */
@@ -460,6 +495,7 @@ START_TEST(test_evict_lru_basic)
         {VALUE_LENGTH, "cccccccc"},
     };
     item_rstatus_t status;
+    uint8_t id;
 
     option_load_default((struct option *)&options, OPTION_CARDINALITY(options));
     options.slab_size.val.vuint = MY_SLAB_SIZE;
@@ -484,6 +520,17 @@ START_TEST(test_evict_lru_basic)
     ck_assert_msg(item_get(&key[2]) != NULL,
         "item 2 not found");
 
+    /* evicted items are no longer counted, in total and per class */
+    id = item_slabid(KEY_LENGTH, VALUE_LENGTH);
+    ck_assert_int_eq(metrics.item_curr.gauge, 1);
+    ck_assert_int_eq(metrics.item_keyval_byte.gauge, KEY_LENGTH + VALUE_LENGTH);
+    ck_assert_int_eq(slabclass[id].nslab, 1);
+    ck_assert_int_eq(slabclass[id].nitem_curr, 1);
+    ck_assert_int_eq(slabclass[id].keyval_byte, KEY_LENGTH + VALUE_LENGTH);
+    ck_assert_int_eq(slabclass[id].nalloc, NUM_ITEMS + 1);
+    ck_assert_int_eq(slabclass[id].nevict_slab, 1);
+    ck_assert_int_eq(slabclass[id].nevict_item, NUM_ITEMS);
+
 #undef KEY_LENGTH
 #undef VALUE_LENGTH
 #undef NUM_ITEMS
@@ -492,6 +539,72 @@ START_TEST(test_evict_lru_basic)
 }
 END_TEST
 
+START_TEST(test_size_histogram)
+{
+#define KEY "key"
+#define VAL "val"
+#define TTL 30
+    struct bstring key = str2bstr(KEY), val = str2bstr(VAL);
+
+    test_reset();
+    metric_reset((struct metric *)&metrics, METRIC_CARDINALITY(metrics));
+
+    time_update();
+    ck_assert_int_eq(item_insert(&key, &val, 0, time_sec2ms(TIME_NEVER)), ITEM_OK);
+    ck_assert(item_delete(&key));
+    ck_assert_int_eq(item_insert(&key, &val, 0, time_sec2ms(time_now() + TTL)), ITEM_OK);
+
+    ck_assert_int_eq(metric_histo_count(&metrics.item_key_size), 2);
+    ck_assert_int_eq(metric_histo_percentile(&metrics.item_key_size, 50),
+            sizeof(KEY) - 1);
+    ck_assert_int_eq(metric_histo_count(&metrics.item_val_size), 2);
+    ck_assert_int_eq(metric_histo_percentile(&metrics.item_val_size, 50),
+            sizeof(VAL) - 1);
+    /* items that never expire have no ttl to record */
+    ck_assert_int_eq(metric_histo_count(&metrics.item_ttl), 1);
+    ck_assert_int_eq(metric_histo_percentile(&metrics.item_ttl, 50), TTL);
+#undef KEY
+#undef VAL
+#undef TTL
+}
+END_TEST
+
+START_TEST(test_print_stats)
+{
+#define KEY "key"
+#define VAL "val"
+#define BUF_LEN 1024
+    struct bstring key = str2bstr(KEY), val = str2bstr(VAL);
+    char buf[BUF_LEN], expect[BUF_LEN];
+    size_t len;
+    uint8_t id;
+
+    test_reset();
+
+    ck_assert_int_eq(slab_print_stats(buf, BUF_LEN, "%s %s\n"), 0);
+
+    ck_assert_int_eq(item_insert(&key, &val, 0, 0), ITEM_OK);
+    id = item_slabid(sizeof(KEY) - 1, sizeof(VAL) - 1);
+    len = slab_print_items(buf, BUF_LEN, "%s %s\n");
+    ck_assert_int_eq(len, strlen(buf));
+    snprintf(expect, BUF_LEN, "%u:number 1\n%u:keyval_byte 6\n%u:alloc 1\n"
+            "%u:evicted 0\n", id, id, id, id);
+    ck_assert_str_eq(buf, expect);
+
+    len = slab_print_stats(buf, BUF_LEN, "%s %s\n");
+    ck_assert_int_eq(len, strlen(buf));
+    snprintf(expect, BUF_LEN, "%u:total_slabs 1\n%u:total_chunks ", id, id);
+    ck_assert_ptr_ne(strstr(buf, expect), NULL);
+    snprintf(expect, BUF_LEN, "%u:used_chunks 1\n", id);
+    ck_assert_ptr_ne(strstr(buf, expect), NULL);
+    snprintf(expect, BUF_LEN, "%u:alloc_ex 0\n", id);
+    ck_assert_ptr_ne(strstr(buf, expect), NULL);
+#undef KEY
+#undef VAL
+#undef BUF_LEN
+}
+END_TEST
+
 /*
  * test suite
  */
@@ -510,9 +623,12 @@ slab_suite(void)
     tcase_add_test(tc_basic_req, test_prepend_basic);
     tcase_add_test(tc_basic_req, test_annex_sequence);
     tcase_add_test(tc_basic_req, test_delete_basic);
+    tcase_add_test(tc_basic_req, test_expire_ms);
     tcase_add_test(tc_basic_req, test_update_basic);
     tcase_add_test(tc_basic_req, test_flush_basic);
     tcase_add_test(tc_basic_req, test_evict_lru_basic);
+    tcase_add_test(tc_basic_req, test_size_histogram);
+    tcase_add_test(tc_basic_req, test_print_stats);
 
     return s;
 }